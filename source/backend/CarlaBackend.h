@@ -69,6 +69,24 @@ static const uint MAX_PATCHBAY_PLUGINS = 255;
  */
 static const uint MAX_DEFAULT_PARAMETERS = 200;
 
+/*!
+ * Maximum number of extra process threads.
+ * @see ENGINE_OPTION_PROCESS_THREADS
+ */
+static const uint MAX_PROCESS_THREADS = 32;
+
+/*!
+ * Maximum number of rack pipeline stages.
+ * @see ENGINE_OPTION_RACK_PIPELINE_STAGES
+ */
+static const uint MAX_RACK_PIPELINE_STAGES = 16;
+
+/*!
+ * Maximum number of threads used to load plugins from a project.
+ * @see ENGINE_OPTION_LOAD_THREADS
+ */
+static const uint MAX_LOAD_THREADS = 16;
+
 /* ------------------------------------------------------------------------------------------------------------
  * Engine Driver Device Hints */
 
@@ -1072,7 +1090,72 @@ typedef enum {
     /*!
      * Set frontend winId, used to define as parent window for plugin UIs.
      */
-    ENGINE_OPTION_FRONTEND_WIN_ID = 17
+    ENGINE_OPTION_FRONTEND_WIN_ID = 17,
+
+    /*!
+     * Number of extra realtime threads used for plugin processing in ENGINE_PROCESS_MODE_PATCHBAY.
+     * Default is 0, which keeps all processing in the audio thread.
+     * Independent plugins are processed in parallel, without adding latency.
+     * @see ENGINE_OPTION_RACK_PIPELINE_STAGES
+     * @note Cannot be changed while the engine is running
+     */
+    ENGINE_OPTION_PROCESS_THREADS = 18,
+
+    /*!
+     * Run plugin bridges asynchronously, one buffer behind the engine.
+     * Bridges are started at the end of a cycle and their results collected in the next one,
+     * so several bridge processes can run in parallel at the cost of one buffer of latency each.
+     * @note Only applies to bridges loaded after the option is set
+     */
+    ENGINE_OPTION_PIPELINED_BRIDGES = 19,
+
+    /*!
+     * Number of threads used to load plugins when loading a project.
+     * Default is 0, which loads plugins one after another in the calling thread.
+     *
+     * Plugins that are safe to instantiate outside the main thread (bridges, LADSPA, DSSI and SF2 files)
+     * are created and restored concurrently, the others are still loaded in the calling thread.
+     * Plugins are always added to the engine in project file order.
+     */
+    ENGINE_OPTION_LOAD_THREADS = 20,
+
+    /*!
+     * Save large plugin chunks as raw binary data in a separate file instead of inline as base64.
+     * The chunk file is named after the project file with a ".chunks" suffix and memory-mapped on load.
+     * @note Only applies to carla_save_project(), plugin and preset states always use base64
+     */
+    ENGINE_OPTION_SAVE_CHUNKS_AS_BINARY = 21,
+
+    /*!
+     * Number of unused plugin libraries kept loaded after their last plugin is removed.
+     * The most recently closed ones are kept, so removing and adding the same plugin again does not reload its binary.
+     * Default is 0, which unloads libraries as soon as they are unused.
+     * @note Some plugins expect their global state to be reset when all instances are removed
+     */
+    ENGINE_OPTION_LIBRARY_KEEP_ALIVE = 22,
+
+    /*!
+     * Open the plugin binaries of a project in a background thread while the project is being loaded.
+     * Only applies to native LADSPA, DSSI and VST2 plugins.
+     */
+    ENGINE_OPTION_PRELOAD_LIBRARIES = 23,
+
+    /*!
+     * Maximum rate, in Hz, at which changed output parameter values are sent to plugin UIs and OSC.
+     * Default is 0, which sends changes on every engine idle cycle.
+     */
+    ENGINE_OPTION_PARAMETER_OUTPUT_RATE = 24,
+
+    /*!
+     * Number of pipeline stages the rack is split into in ENGINE_PROCESS_MODE_CONTINUOUS_RACK.
+     * Default is 0, which processes the whole rack in the audio thread.
+     *
+     * Each stage after the first gets its own realtime thread and adds one buffer of latency,
+     * which is reported by CarlaEngine::getLatency().
+     * The pipeline is flushed, and its output silenced for a few buffers, whenever plugins are added, removed or moved.
+     * @note Cannot be changed while the engine is running
+     */
+    ENGINE_OPTION_RACK_PIPELINE_STAGES = 25
 
 } EngineOption;
 
@@ -25,7 +25,9 @@ struct CarlaOscData;
 #endif
 
 namespace juce {
+class File;
 class MemoryOutputStream;
+class OutputStream;
 class XmlDocument;
 }
 
@@ -217,6 +219,90 @@ struct CARLA_API EngineEvent {
     void fillFromMidiData(const uint8_t size, const uint8_t* const data, const uint8_t midiPortOffset) noexcept;
 };
 
+/*!
+ * Engine event buffer.
+ * An array of events where only the first @a count are valid.
+ * Events are appended in order, clearing the buffer only resets the count.
+ * MIDI messages longer than EngineMidiEvent::kDataSize are copied into a per-block arena and referenced by dataExt.
+ */
+struct CARLA_API EngineEventBuffer {
+    EngineEvent* data;  //!< Event storage
+    uint32_t count;     //!< Number of valid events in @a data
+    uint32_t capacity;  //!< Maximum number of events in @a data
+
+    uint8_t* arena;     //!< Storage for long MIDI messages
+    uint32_t arenaUsed; //!< Number of bytes used in @a arena
+    uint32_t arenaSize; //!< Size of @a arena in bytes
+
+#ifndef DOXYGEN
+    EngineEventBuffer() noexcept;
+    ~EngineEventBuffer() noexcept;
+#endif
+
+    /*!
+     * Allocate the event storage, or grow it to fit blocks of @a bufferSize frames.
+     * Does nothing if the buffer is already big enough, otherwise all events are lost.
+     * @note Not RT safe, call it on init or when the engine buffer size changes.
+     */
+    bool allocate(const uint32_t bufferSize) noexcept;
+
+    /*!
+     * Free the event storage.
+     */
+    void deallocate() noexcept;
+
+    /*!
+     * Remove all events.
+     * @note RT call
+     */
+    void clear() noexcept
+    {
+        count     = 0;
+        arenaUsed = 0;
+    }
+
+    /*!
+     * Get the next free event, or null if the buffer is full.
+     * The returned event is counted as valid and must be filled by the caller.
+     * @note RT call
+     */
+    EngineEvent* append() noexcept;
+
+    /*!
+     * Append an event from raw MIDI data, see EngineEvent::fillFromMidiData().
+     * Long messages are copied into the arena, so @a data does not need to outlive this buffer.
+     * Returns null if the buffer is full or the data is not valid MIDI.
+     * @note RT call
+     */
+    EngineEvent* appendFromMidiData(const uint32_t time, const uint8_t size, const uint8_t* const data, const uint8_t midiPortOffset) noexcept;
+
+    /*!
+     * Copy @a size bytes into the arena, returning the copy or null if there is no space left.
+     * The copy stays valid until the next clear().
+     * @note RT call
+     */
+    const uint8_t* appendData(const uint8_t* const data, const uint32_t size) noexcept;
+
+    /*!
+     * Replace the contents of this buffer with the ones from @a other.
+     * Long messages stored in the arena of @a other are copied too.
+     * @note RT call
+     */
+    void copyFrom(const EngineEventBuffer& other) noexcept;
+
+    /*!
+     * Merge the events of @a other into this buffer, keeping them ordered by time.
+     * Both buffers must already be ordered, events with the same time keep ours first.
+     * If there is not enough space the latest events of @a other are dropped.
+     * @note RT call
+     */
+    void mergeFrom(const EngineEventBuffer& other) noexcept;
+
+#ifndef DOXYGEN
+    CARLA_DECLARE_NON_COPY_STRUCT(EngineEventBuffer)
+#endif
+};
+
 // -----------------------------------------------------------------------
 
 /*!
@@ -253,6 +339,15 @@ struct CARLA_API EngineOptions {
     bool preventBadBehaviour;
     uintptr_t frontendWinId;
 
+    uint processThreads;
+    bool pipelinedBridges;
+    uint loadThreads;
+    bool saveChunksAsBinary;
+    uint libraryKeepAlive;
+    bool preloadLibraries;
+    uint parameterOutputRate;
+    uint rackPipelineStages;
+
 #ifndef DOXYGEN
     EngineOptions() noexcept;
     ~EngineOptions() noexcept;
@@ -306,6 +401,22 @@ struct CARLA_API EngineTimeInfo {
 #endif
 };
 
+/*!
+ * Engine worker pool statistics.
+ * Latency is the time between a job request and a worker picking it up, in milliseconds.
+ */
+struct CARLA_API EngineWorkerStats {
+    uint queueDepth;    //!< jobs waiting or running
+    uint maxQueueDepth; //!< highest queue depth seen
+    uint32_t jobsDone;  //!< number of jobs done
+    float lastLatency;
+    float maxLatency;
+
+#ifndef DOXYGEN
+    EngineWorkerStats() noexcept;
+#endif
+};
+
 // -----------------------------------------------------------------------
 
 /*!
@@ -402,6 +513,20 @@ public:
         return fBuffer;
     }
 
+    /*!
+     * Make the port use external memory as its buffer, e.g. the shared memory of a plugin bridge.
+     * The internal patchbay reads and writes such buffers directly, without intermediate copies.
+     * The buffer must hold a full period and stay valid while the plugin is enabled.
+     * Pass null to go back to engine-provided buffers.
+     * Changing the buffer requires the plugin's master lock, as the patchbay uses it while processing.
+     * @note Only useful for the internal patchbay, ports that get their buffer from an external client (e.g. JACK)
+     *       replace it on the next initBuffer() call.
+     */
+    void setExternalBuffer(float* const buffer) noexcept
+    {
+        fBuffer = buffer;
+    }
+
 #ifndef DOXYGEN
 protected:
     float* fBuffer;
@@ -532,13 +657,21 @@ public:
     /*!
      * Write a MIDI event into the buffer.
      * Arguments are the same as in the EngineMidiEvent struct.
+     * Messages longer than EngineMidiEvent::kDataSize (SysEx) are copied into the buffer too.
      * @note You must only call this for output ports.
      */
     virtual bool writeMidiEvent(const uint32_t time, const uint8_t channel, const uint8_t size, const uint8_t* const data) noexcept;
 
+    /*!
+     * Make the port use @a buffer instead of the engine internal event buffer, until the next initBuffer().
+     * Used by the rack pipeline, where each block in flight has its own event buffers.
+     * @note Only valid in rack mode.
+     */
+    void setInternalEventBuffer(EngineEventBuffer* const buffer) noexcept;
+
 #ifndef DOXYGEN
 protected:
-    EngineEvent* fBuffer;
+    EngineEventBuffer* fBuffer;
     const EngineProcessMode kProcessMode;
     friend class CarlaPluginInstance;
 
@@ -887,6 +1020,11 @@ public:
      */
     double getSampleRate() const noexcept;
 
+    /*!
+     * Get the current latency added by the internal graph, in samples.
+     */
+    uint32_t getLatency() const noexcept;
+
     /*!
      * Get the current engine name.
      */
@@ -1008,6 +1146,17 @@ public:
      */
     void setAboutToClose() noexcept;
 
+    /*!
+     * Request the engine worker pool to call CarlaPlugin::runWorkerJobs() for plugin @a id.
+     * This function is realtime safe.
+     */
+    void scheduleWorkerJob(const uint id) noexcept;
+
+    /*!
+     * Get the current engine worker pool statistics.
+     */
+    void getWorkerStats(EngineWorkerStats& stats) const noexcept;
+
     // -------------------------------------------------------------------
     // Options
 
@@ -1048,7 +1197,7 @@ public:
      * Return internal data, needed for EventPorts when used in Rack, Patchbay and Bridge modes.
      * @note RT call
      */
-    EngineEvent* getInternalEventBuffer(const bool isInput) const noexcept;
+    EngineEventBuffer* getInternalEventBuffer(const bool isInput) const noexcept;
 
 #ifndef BUILD_BRIDGE
     /*!
@@ -1073,11 +1222,13 @@ protected:
     friend class CarlaPluginInstance;
     friend class EngineInternalGraph;
     friend class PendingRtEventsRunner;
+    friend class ProjectPluginLoader;
     friend class ScopedActionLock;
     friend class ScopedEngineEnvironmentLocker;
     friend class ScopedThreadStopper;
     friend struct PatchbayGraph;
     friend struct RackGraph;
+    friend class RackPipeline;
 
     // -------------------------------------------------------------------
     // Internal stuff
@@ -1104,15 +1255,25 @@ protected:
      */
     void setPluginPeaks(const uint pluginId, float const inPeaks[2], float const outPeaks[2]) noexcept;
 
+    /*!
+     * Create a new plugin with id 'id', without adding it to the engine.
+     * Returns null on failure, see getLastError().
+     * @see addPlugin()
+     */
+    CarlaPlugin* createPlugin(const uint id, const BinaryType btype, const PluginType ptype,
+                              const char* const filename, const char* const name, const char* const label, const int64_t uniqueId,
+                              const void* const extra, const uint options);
+
     /*!
      * Common save project function for main engine and plugin.
      */
-    void saveProjectInternal(juce::MemoryOutputStream& outStrm) const;
+    void saveProjectInternal(juce::MemoryOutputStream& outStrm, juce::OutputStream* const chunkStream = nullptr,
+                             const char* const chunkFilename = nullptr, const char* const chunkFileId = nullptr) const;
 
     /*!
      * Common load project function for main engine and plugin.
      */
-    bool loadProjectInternal(juce::XmlDocument& xmlDoc);
+    bool loadProjectInternal(juce::XmlDocument& xmlDoc, const juce::File* const projectFile = nullptr);
 
 #ifndef BUILD_BRIDGE
     // -------------------------------------------------------------------
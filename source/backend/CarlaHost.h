@@ -268,6 +268,97 @@ typedef struct _CarlaTransportInfo {
 
 } CarlaTransportInfo;
 
+/*!
+ * Current version of the CarlaEngineSnapshot struct.
+ * @see CarlaEngineSnapshot::version
+ */
+static const uint32_t ENGINE_SNAPSHOT_VERSION = 1;
+
+/*!
+ * Snapshot of the engine state that frontends need to poll regularly.
+ * All arrays are owned by the caller, so everything can be refreshed in a single call.
+ * @see carla_get_engine_snapshot()
+ */
+typedef struct _CarlaEngineSnapshot {
+    /*!
+     * Struct version, must be set to ENGINE_SNAPSHOT_VERSION by the caller.
+     */
+    uint32_t version;
+
+    /*!
+     * Number of plugins the peak arrays have space for.
+     */
+    uint32_t maxPlugins;
+
+    /*!
+     * Input peaks, left and right values per plugin.
+     * Must have space for 2 * maxPlugins values.
+     */
+    float* inputPeaks;
+
+    /*!
+     * Output peaks, left and right values per plugin.
+     * Must have space for 2 * maxPlugins values.
+     */
+    float* outputPeaks;
+
+    /*!
+     * Number of changes the parameter arrays have space for.
+     */
+    uint32_t maxParameterChanges;
+
+    /*!
+     * Plugin of each changed parameter.
+     */
+    uint32_t* parameterPluginIds;
+
+    /*!
+     * Index of each changed parameter.
+     */
+    uint32_t* parameterIds;
+
+    /*!
+     * Current value of each changed parameter.
+     */
+    float* parameterValues;
+
+    /*!
+     * Sequence number of the last snapshot, or 0 to get all parameter values.
+     * Updated on return, so the next call only reports parameters that changed since this one.
+     * If not all changes fit into the parameter arrays the sequence is not updated.
+     */
+    uint64_t sequence;
+
+    /*!
+     * Number of loaded plugins, set on return.
+     * Peaks are filled for the first maxPlugins of them.
+     */
+    uint32_t pluginCount;
+
+    /*!
+     * Number of changed parameters filled into the parameter arrays, set on return.
+     */
+    uint32_t parameterChangeCount;
+
+    /*!
+     * Whether some parameter changes did not fit into the parameter arrays, set on return.
+     */
+    bool parameterChangesTruncated;
+
+    /*!
+     * Engine transport information, set on return.
+     */
+    CarlaTransportInfo transport;
+
+#ifdef __cplusplus
+    /*!
+     * C++ constructor.
+     */
+    CARLA_API _CarlaEngineSnapshot() noexcept;
+#endif
+
+} CarlaEngineSnapshot;
+
 /* ------------------------------------------------------------------------------------------------------------
  * Carla Host API (C functions) */
 
@@ -708,6 +799,14 @@ CARLA_EXPORT float carla_get_input_peak_value(uint pluginId, bool isLeft);
  */
 CARLA_EXPORT float carla_get_output_peak_value(uint pluginId, bool isLeft);
 
+/*!
+ * Get peaks, changed parameter values and transport information in a single call.
+ * Meant for frontends and remote controllers that refresh their state from a timer.
+ * @param snapshot Snapshot to fill, see CarlaEngineSnapshot for which fields must be set before calling
+ * @note Several pollers can keep their own snapshot and sequence, but all must call this from the same thread.
+ */
+CARLA_EXPORT bool carla_get_engine_snapshot(CarlaEngineSnapshot* snapshot);
+
 /*!
  * Enable or disable a plugin.
  * @param pluginId Plugin
@@ -96,6 +96,21 @@ _CarlaTransportInfo::_CarlaTransportInfo() noexcept
       tick(0),
       bpm(0.0) {}
 
+_CarlaEngineSnapshot::_CarlaEngineSnapshot() noexcept
+    : version(ENGINE_SNAPSHOT_VERSION),
+      maxPlugins(0),
+      inputPeaks(nullptr),
+      outputPeaks(nullptr),
+      maxParameterChanges(0),
+      parameterPluginIds(nullptr),
+      parameterIds(nullptr),
+      parameterValues(nullptr),
+      sequence(0),
+      pluginCount(0),
+      parameterChangeCount(0),
+      parameterChangesTruncated(false),
+      transport() {}
+
 // -------------------------------------------------------------------------------------------------------------------
 
 const char* carla_get_library_filename()
@@ -49,6 +49,20 @@ class CarlaEngineCVPort;
 class CarlaEngineEventPort;
 struct CarlaStateSave;
 
+/*!
+ * Plugin bridge wait statistics, counted while waiting for the bridge process to finish a request.
+ * @see CarlaPlugin::getBridgeWaitStats()
+ */
+struct CARLA_API PluginBridgeWaitStats {
+    uint64_t spinHits; //!< waits that ended while spinning
+    uint64_t sleeps;   //!< waits that had to sleep on the semaphore
+    uint64_t timeouts; //!< waits that timed out
+
+#ifndef DOXYGEN
+    PluginBridgeWaitStats() noexcept;
+#endif
+};
+
 // -----------------------------------------------------------------------
 
 /*!
@@ -390,10 +404,12 @@ public:
     /*!
      * Get the plugin's save state.
      * The plugin will automatically call prepareForSave() if requested.
+     * If @a rawChunk is true the chunk is not converted to base64, see CarlaStateSave::chunkData.
+     * It is then only valid until the next call to getChunkData().
      *
      * @see loadStateSave()
      */
-    const CarlaStateSave& getStateSave(const bool callPrepareForSave = true);
+    const CarlaStateSave& getStateSave(const bool callPrepareForSave = true, const bool rawChunk = false);
 
     /*!
      * Get the plugin's save state.
@@ -670,6 +686,26 @@ public:
      */
     virtual void idle();
 
+    /*!
+     * Run pending background jobs, called from one of the engine worker threads.
+     * Jobs are requested from the audio thread with CarlaEngine::scheduleWorkerJob().
+     * Returns the number of jobs done.
+     */
+    virtual uint runWorkerJobs();
+
+    /*!
+     * Get the output parameters that changed since the last call, up to @a maxCount of them.
+     * Returns how many parameter ids were written into @a parameterIds, the others are kept for the next call.
+     * @note: Only one thread should collect changes, usually the engine idle thread.
+     */
+    uint32_t getChangedParameterOutputs(uint32_t* const parameterIds, const uint32_t maxCount) noexcept;
+
+    /*!
+     * Mark all output parameters as changed, so their current values are collected again.
+     * Used when a UI or OSC client appears that has not seen them yet.
+     */
+    void setParameterOutputsChanged() noexcept;
+
     /*!
      * Try to lock the plugin's master mutex.
      * @param forcedOffline When true, always locks and returns true
@@ -841,6 +877,12 @@ public:
      */
     virtual uintptr_t getUiBridgeProcessId() const noexcept;
 
+    /*!
+     * Get the wait statistics of the plugin bridge process, since it was started.
+     * Returns false if this plugin is not a bridge.
+     */
+    virtual bool getBridgeWaitStats(PluginBridgeWaitStats& stats) const noexcept;
+
     // -------------------------------------------------------------------
 
     /*!
@@ -903,6 +945,10 @@ public:
     static CarlaPlugin* newFileGIG(const Initializer& init, const bool use16Outs);
     static CarlaPlugin* newFileSF2(const Initializer& init, const bool use16Outs);
     static CarlaPlugin* newFileSFZ(const Initializer& init);
+
+    // open plugin binaries ahead of time in a background thread, see LibCounter::preload()
+    static void preloadLibraries(const char* const* const filenames);
+    static void releasePreloadedLibraries(const uint keepAlive);
 #endif
 
     // -------------------------------------------------------------------
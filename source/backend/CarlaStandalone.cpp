@@ -56,6 +56,94 @@ struct CarlaBackendStandalone {
 
     CarlaString lastError;
 
+    // parameter values last seen by carla_get_engine_snapshot(), with the sequence they changed at
+    struct SnapshotCache {
+        struct PluginValues {
+            uint32_t  count;
+            float*    values;
+            uint64_t* changed;
+        };
+
+        PluginValues* plugins;
+        uint32_t      pluginCount;
+        uint64_t      sequence;
+
+        SnapshotCache() noexcept
+            : plugins(nullptr),
+              pluginCount(0),
+              sequence(0) {}
+
+        ~SnapshotCache() noexcept
+        {
+            clear();
+        }
+
+        bool init(const uint32_t maxPluginNumber) noexcept
+        {
+            if (plugins != nullptr && pluginCount == maxPluginNumber)
+                return true;
+
+            clear();
+
+            try {
+                plugins = new PluginValues[maxPluginNumber];
+            } CARLA_SAFE_EXCEPTION_RETURN("SnapshotCache::init", false);
+
+            carla_zeroStructs(plugins, maxPluginNumber);
+            pluginCount = maxPluginNumber;
+            return true;
+        }
+
+        bool resize(PluginValues& plugin, const uint32_t count) noexcept
+        {
+            clear(plugin);
+
+            if (count == 0)
+                return true;
+
+            try {
+                plugin.values  = new float[count];
+                plugin.changed = new uint64_t[count];
+            } CARLA_SAFE_EXCEPTION_RETURN("SnapshotCache::resize", false);
+
+            plugin.count = count;
+            return true;
+        }
+
+        // the sequence is kept, so callers can't mistake a new engine session for an old one
+        void clear() noexcept
+        {
+            if (plugins == nullptr)
+                return;
+
+            for (uint32_t i=0; i < pluginCount; ++i)
+                clear(plugins[i]);
+
+            delete[] plugins;
+            plugins = nullptr;
+            pluginCount = 0;
+        }
+
+        static void clear(PluginValues& plugin) noexcept
+        {
+            if (plugin.values != nullptr)
+            {
+                delete[] plugin.values;
+                plugin.values = nullptr;
+            }
+
+            if (plugin.changed != nullptr)
+            {
+                delete[] plugin.changed;
+                plugin.changed = nullptr;
+            }
+
+            plugin.count = 0;
+        }
+
+        CARLA_DECLARE_NON_COPY_STRUCT(SnapshotCache)
+    } snapshotCache;
+
     CarlaBackendStandalone() noexcept
         : engine(nullptr),
           engineCallback(nullptr),
@@ -65,7 +153,8 @@ struct CarlaBackendStandalone {
 #endif
           fileCallback(nullptr),
           fileCallbackPtr(nullptr),
-          lastError() {}
+          lastError(),
+          snapshotCache() {}
 
     ~CarlaBackendStandalone() noexcept
     {
@@ -251,6 +340,14 @@ static void carla_engine_init_common()
         gStandalone.engine->setOption(CB::ENGINE_OPTION_PATH_RESOURCES,    0, gStandalone.engineOptions.resourceDir);
 
     gStandalone.engine->setOption(CB::ENGINE_OPTION_PREVENT_BAD_BEHAVIOUR,    gStandalone.engineOptions.preventBadBehaviour ? 1 : 0,  nullptr);
+    gStandalone.engine->setOption(CB::ENGINE_OPTION_PROCESS_THREADS,          static_cast<int>(gStandalone.engineOptions.processThreads), nullptr);
+    gStandalone.engine->setOption(CB::ENGINE_OPTION_PIPELINED_BRIDGES,        gStandalone.engineOptions.pipelinedBridges ? 1 : 0,     nullptr);
+    gStandalone.engine->setOption(CB::ENGINE_OPTION_LOAD_THREADS,             static_cast<int>(gStandalone.engineOptions.loadThreads), nullptr);
+    gStandalone.engine->setOption(CB::ENGINE_OPTION_SAVE_CHUNKS_AS_BINARY,    gStandalone.engineOptions.saveChunksAsBinary ? 1 : 0,   nullptr);
+    gStandalone.engine->setOption(CB::ENGINE_OPTION_LIBRARY_KEEP_ALIVE,       static_cast<int>(gStandalone.engineOptions.libraryKeepAlive), nullptr);
+    gStandalone.engine->setOption(CB::ENGINE_OPTION_PRELOAD_LIBRARIES,        gStandalone.engineOptions.preloadLibraries ? 1 : 0,     nullptr);
+    gStandalone.engine->setOption(CB::ENGINE_OPTION_PARAMETER_OUTPUT_RATE,    static_cast<int>(gStandalone.engineOptions.parameterOutputRate), nullptr);
+    gStandalone.engine->setOption(CB::ENGINE_OPTION_RACK_PIPELINE_STAGES,     static_cast<int>(gStandalone.engineOptions.rackPipelineStages), nullptr);
 
     if (gStandalone.engineOptions.frontendWinId != 0)
     {
@@ -399,6 +496,8 @@ bool carla_engine_close()
     delete gStandalone.engine;
     gStandalone.engine = nullptr;
 
+    gStandalone.snapshotCache.clear();
+
     return closed;
 }
 
@@ -584,6 +683,43 @@ void carla_set_engine_option(EngineOption option, int value, const char* valueSt
         gStandalone.engineOptions.preventBadBehaviour = (value != 0);
         break;
 
+    case CB::ENGINE_OPTION_PROCESS_THREADS:
+        CARLA_SAFE_ASSERT_RETURN(value >= 0 && value <= static_cast<int>(CB::MAX_PROCESS_THREADS),);
+        gStandalone.engineOptions.processThreads = static_cast<uint>(value);
+        break;
+
+    case CB::ENGINE_OPTION_PIPELINED_BRIDGES:
+        gStandalone.engineOptions.pipelinedBridges = (value != 0);
+        break;
+
+    case CB::ENGINE_OPTION_LOAD_THREADS:
+        CARLA_SAFE_ASSERT_RETURN(value >= 0 && value <= static_cast<int>(CB::MAX_LOAD_THREADS),);
+        gStandalone.engineOptions.loadThreads = static_cast<uint>(value);
+        break;
+
+    case CB::ENGINE_OPTION_SAVE_CHUNKS_AS_BINARY:
+        gStandalone.engineOptions.saveChunksAsBinary = (value != 0);
+        break;
+
+    case CB::ENGINE_OPTION_LIBRARY_KEEP_ALIVE:
+        CARLA_SAFE_ASSERT_RETURN(value >= 0,);
+        gStandalone.engineOptions.libraryKeepAlive = static_cast<uint>(value);
+        break;
+
+    case CB::ENGINE_OPTION_PRELOAD_LIBRARIES:
+        gStandalone.engineOptions.preloadLibraries = (value != 0);
+        break;
+
+    case CB::ENGINE_OPTION_PARAMETER_OUTPUT_RATE:
+        CARLA_SAFE_ASSERT_RETURN(value >= 0,);
+        gStandalone.engineOptions.parameterOutputRate = static_cast<uint>(value);
+        break;
+
+    case CB::ENGINE_OPTION_RACK_PIPELINE_STAGES:
+        CARLA_SAFE_ASSERT_RETURN(value >= 0 && value <= static_cast<int>(CB::MAX_RACK_PIPELINE_STAGES),);
+        gStandalone.engineOptions.rackPipelineStages = static_cast<uint>(value);
+        break;
+
     case CB::ENGINE_OPTION_FRONTEND_WIN_ID:
         CARLA_SAFE_ASSERT_RETURN(valueStr != nullptr && valueStr[0] != '\0',);
         const long long winId(std::strtoll(valueStr, nullptr, 16));
@@ -649,6 +785,34 @@ bool carla_save_project(const char* filename)
     return false;
 }
 
+// -------------------------------------------------------------------------------------------------------------------
+
+static void carla_fill_transport_info(CarlaTransportInfo& info)
+{
+    // reset
+    info.playing = false;
+    info.frame   = 0;
+    info.bar     = 0;
+    info.beat    = 0;
+    info.tick    = 0;
+    info.bpm     = 0.0;
+
+    CARLA_SAFE_ASSERT_RETURN(gStandalone.engine != nullptr && gStandalone.engine->isRunning(),);
+
+    const CB::EngineTimeInfo& timeInfo(gStandalone.engine->getTimeInfo());
+
+    info.playing = timeInfo.playing;
+    info.frame   = timeInfo.frame;
+
+    if (timeInfo.valid & CB::EngineTimeInfo::kValidBBT)
+    {
+        info.bar  = timeInfo.bbt.bar;
+        info.beat = timeInfo.bbt.beat;
+        info.tick = timeInfo.bbt.tick;
+        info.bpm  = timeInfo.bbt.beatsPerMinute;
+    }
+}
+
 #ifndef BUILD_BRIDGE
 // -------------------------------------------------------------------------------------------------------------------
 
@@ -726,28 +890,7 @@ const CarlaTransportInfo* carla_get_transport_info()
 {
     static CarlaTransportInfo retInfo;
 
-    // reset
-    retInfo.playing = false;
-    retInfo.frame   = 0;
-    retInfo.bar     = 0;
-    retInfo.beat    = 0;
-    retInfo.tick    = 0;
-    retInfo.bpm     = 0.0;
-
-    CARLA_SAFE_ASSERT_RETURN(gStandalone.engine != nullptr && gStandalone.engine->isRunning(), &retInfo);
-
-    const CB::EngineTimeInfo& timeInfo(gStandalone.engine->getTimeInfo());
-
-    retInfo.playing = timeInfo.playing;
-    retInfo.frame   = timeInfo.frame;
-
-    if (timeInfo.valid & CB::EngineTimeInfo::kValidBBT)
-    {
-        retInfo.bar  = timeInfo.bbt.bar;
-        retInfo.beat = timeInfo.bbt.beat;
-        retInfo.tick = timeInfo.bbt.tick;
-        retInfo.bpm  = timeInfo.bbt.beatsPerMinute;
-    }
+    carla_fill_transport_info(retInfo);
 
     return &retInfo;
 }
@@ -1550,6 +1693,108 @@ float carla_get_output_peak_value(uint pluginId, bool isLeft)
     return gStandalone.engine->getOutputPeak(pluginId, isLeft);
 }
 
+bool carla_get_engine_snapshot(CarlaEngineSnapshot* snapshot)
+{
+    CARLA_SAFE_ASSERT_RETURN(snapshot != nullptr, false);
+    CARLA_SAFE_ASSERT_RETURN(snapshot->version == ENGINE_SNAPSHOT_VERSION, false);
+    CARLA_SAFE_ASSERT_RETURN(snapshot->maxPlugins == 0 || (snapshot->inputPeaks != nullptr && snapshot->outputPeaks != nullptr), false);
+    CARLA_SAFE_ASSERT_RETURN(snapshot->maxParameterChanges == 0 || (snapshot->parameterPluginIds != nullptr &&
+                                                                   snapshot->parameterIds       != nullptr &&
+                                                                   snapshot->parameterValues    != nullptr), false);
+
+    snapshot->pluginCount               = 0;
+    snapshot->parameterChangeCount      = 0;
+    snapshot->parameterChangesTruncated = false;
+
+    carla_fill_transport_info(snapshot->transport);
+
+    CARLA_SAFE_ASSERT_RETURN(gStandalone.engine != nullptr && gStandalone.engine->isRunning(), false);
+
+    CarlaEngine* const engine(gStandalone.engine);
+    CarlaBackendStandalone::SnapshotCache& cache(gStandalone.snapshotCache);
+
+    const uint32_t pluginCount(engine->getCurrentPluginCount());
+    snapshot->pluginCount = pluginCount;
+
+    // peaks
+    for (uint32_t i=0, count=std::min(pluginCount, snapshot->maxPlugins); i < count; ++i)
+    {
+        snapshot->inputPeaks [i*2  ] = engine->getInputPeak (i, true);
+        snapshot->inputPeaks [i*2+1] = engine->getInputPeak (i, false);
+        snapshot->outputPeaks[i*2  ] = engine->getOutputPeak(i, true);
+        snapshot->outputPeaks[i*2+1] = engine->getOutputPeak(i, false);
+    }
+
+    // parameters, compared against the last values seen by any caller
+    if (! cache.init(engine->getMaxPluginNumber()))
+        return false;
+
+    // a sequence from before the cache was reset means the caller knows nothing
+    const uint64_t since((snapshot->sequence <= cache.sequence) ? snapshot->sequence : 0);
+    const uint64_t next(cache.sequence + 1);
+
+    bool     anyChanged = false;
+    uint32_t changeCount = 0;
+
+    for (uint32_t i=0, count=std::min(pluginCount, cache.pluginCount); i < count; ++i)
+    {
+        CarlaPlugin* const plugin(engine->getPlugin(i));
+        CARLA_SAFE_ASSERT_CONTINUE(plugin != nullptr);
+
+        CarlaBackendStandalone::SnapshotCache::PluginValues& values(cache.plugins[i]);
+
+        const uint32_t paramCount(plugin->getParameterCount());
+
+        // new or reloaded plugin, everything changed
+        if (values.count != paramCount)
+        {
+            if (! cache.resize(values, paramCount))
+                continue;
+
+            for (uint32_t j=0; j < paramCount; ++j)
+            {
+                values.values [j] = plugin->getParameterValue(j);
+                values.changed[j] = next;
+            }
+
+            anyChanged = true;
+        }
+
+        for (uint32_t j=0; j < paramCount; ++j)
+        {
+            const float value(plugin->getParameterValue(j));
+
+            if (carla_isNotEqual(value, values.values[j]))
+            {
+                values.values [j] = value;
+                values.changed[j] = next;
+                anyChanged = true;
+            }
+
+            if (values.changed[j] <= since)
+                continue;
+
+            if (changeCount == snapshot->maxParameterChanges)
+            {
+                snapshot->parameterChangesTruncated = true;
+                continue;
+            }
+
+            snapshot->parameterPluginIds[changeCount] = i;
+            snapshot->parameterIds      [changeCount] = j;
+            snapshot->parameterValues   [changeCount] = value;
+            ++changeCount;
+        }
+    }
+
+    if (anyChanged)
+        cache.sequence = next;
+
+    snapshot->parameterChangeCount = changeCount;
+    snapshot->sequence = snapshot->parameterChangesTruncated ? since : cache.sequence;
+    return true;
+}
+
 // -------------------------------------------------------------------------------------------------------------------
 
 void carla_set_active(uint pluginId, bool onOff)
@@ -1827,7 +2072,13 @@ void carla_show_custom_ui(uint pluginId, bool yesNo)
     carla_debug("carla_show_custom_ui(%i, %s)", pluginId, bool2str(yesNo));
 
     if (CarlaPlugin* const plugin = gStandalone.engine->getPlugin(pluginId))
+    {
+        // the UI has not seen the current output values
+        if (yesNo)
+            plugin->setParameterOutputsChanged();
+
         return plugin->showCustomUI(yesNo);
+    }
 
     carla_stderr2("carla_show_custom_ui(%i, %s) - could not find plugin", pluginId, bool2str(yesNo));
 }
@@ -676,7 +676,7 @@ public:
 
     const char* readlineblock(const uint timeout) noexcept
     {
-        return CarlaPipeClient::_readlineblock(timeout);
+        return CarlaPipeClient::_readlineblock(true, timeout);
     }
 
     bool msgReceived(const char* const msg) noexcept
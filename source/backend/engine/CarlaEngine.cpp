@@ -47,6 +47,15 @@ using juce::XmlElement;
 
 CARLA_BACKEND_START_NAMESPACE
 
+#ifndef BUILD_BRIDGE
+// Error string of the plugin being loaded by the current thread, see ProjectPluginLoader.
+// While set, errors go there instead of the engine and the plugin is hidden from callbacks and OSC.
+static __thread CarlaString* tPluginLoadError = nullptr;
+
+// Time info of the block being processed by the current thread, see ScopedThreadTimeInfo.
+static __thread const EngineTimeInfo* tTimeInfo = nullptr;
+#endif
+
 // -----------------------------------------------------------------------
 // Carla Engine
 
@@ -318,6 +327,50 @@ CarlaEngineClient* CarlaEngine::addClient(CarlaPlugin* const)
 // -----------------------------------------------------------------------
 // Plugin management
 
+// Get the full path to the bridge binary for 'btype', empty if not available.
+static CarlaString getBridgeBinary(const char* const binaryDir, const BinaryType btype)
+{
+    CarlaString bridgeBinary(binaryDir);
+
+    if (bridgeBinary.isNotEmpty())
+    {
+        if (btype == BINARY_NATIVE)
+        {
+#ifdef CARLA_OS_WIN
+            bridgeBinary += CARLA_OS_SEP_STR "carla-bridge-native.exe";
+#else
+            bridgeBinary += CARLA_OS_SEP_STR "carla-bridge-native";
+#endif
+        }
+        else
+        {
+            switch (btype)
+            {
+            case BINARY_POSIX32:
+                bridgeBinary += CARLA_OS_SEP_STR "carla-bridge-posix32";
+                break;
+            case BINARY_POSIX64:
+                bridgeBinary += CARLA_OS_SEP_STR "carla-bridge-posix64";
+                break;
+            case BINARY_WIN32:
+                bridgeBinary += CARLA_OS_SEP_STR "carla-bridge-win32.exe";
+                break;
+            case BINARY_WIN64:
+                bridgeBinary += CARLA_OS_SEP_STR "carla-bridge-win64.exe";
+                break;
+            default:
+                bridgeBinary.clear();
+                break;
+            }
+        }
+
+        if (! File(bridgeBinary.buffer()).existsAsFile())
+            bridgeBinary.clear();
+    }
+
+    return bridgeBinary;
+}
+
 bool CarlaEngine::addPlugin(const BinaryType btype, const PluginType ptype,
                             const char* const filename, const char* const name, const char* const label, const int64_t uniqueId,
                             const void* const extra, const uint options)
@@ -359,6 +412,75 @@ bool CarlaEngine::addPlugin(const BinaryType btype, const PluginType ptype,
         CARLA_SAFE_ASSERT_RETURN_ERR(pData->plugins[id].plugin == nullptr, "Invalid engine internal data");
     }
 
+    CarlaPlugin* const plugin(createPlugin(id, btype, ptype, filename, name, label, uniqueId, extra, options));
+
+    if (plugin == nullptr)
+        return false;
+
+#if defined(HAVE_LIBLO) && ! defined(BUILD_BRIDGE)
+    plugin->registerToOscClient();
+#endif
+
+    EnginePluginData& pluginData(pData->plugins[id]);
+    pluginData.plugin      = plugin;
+    pluginData.insPeak[0]  = 0.0f;
+    pluginData.insPeak[1]  = 0.0f;
+    pluginData.outsPeak[0] = 0.0f;
+    pluginData.outsPeak[1] = 0.0f;
+
+#ifndef BUILD_BRIDGE
+    if (oldPlugin != nullptr)
+    {
+        __sync_add_and_fetch(&pData->pluginsVersion, 1);
+
+        const ScopedThreadStopper sts(this);
+
+        if (pData->options.processMode == ENGINE_PROCESS_MODE_PATCHBAY)
+            pData->graph.replacePlugin(oldPlugin, plugin);
+
+        const bool  wasActive = oldPlugin->getInternalParameterValue(PARAMETER_ACTIVE) >= 0.5f;
+        const float oldDryWet = oldPlugin->getInternalParameterValue(PARAMETER_DRYWET);
+        const float oldVolume = oldPlugin->getInternalParameterValue(PARAMETER_VOLUME);
+
+        delete oldPlugin;
+
+        if (plugin->getHints() & PLUGIN_CAN_DRYWET)
+            plugin->setDryWet(oldDryWet, true, true);
+
+        if (plugin->getHints() & PLUGIN_CAN_VOLUME)
+            plugin->setVolume(oldVolume, true, true);
+
+        plugin->setActive(wasActive, true, true);
+
+        callback(ENGINE_CALLBACK_RELOAD_ALL, id, 0, 0, 0.0f, nullptr);
+    }
+    else
+#endif
+    {
+        plugin->setActive(true, true, false);
+
+        ++pData->curPluginCount;
+        __sync_add_and_fetch(&pData->pluginsVersion, 1);
+        callback(ENGINE_CALLBACK_PLUGIN_ADDED, id, 0, 0, 0.0f, plugin->getName());
+
+#ifndef BUILD_BRIDGE
+        if (pData->options.processMode == ENGINE_PROCESS_MODE_PATCHBAY)
+            pData->graph.addPlugin(plugin);
+#endif
+    }
+
+    return true;
+}
+
+bool CarlaEngine::addPlugin(const PluginType ptype, const char* const filename, const char* const name, const char* const label, const int64_t uniqueId, const void* const extra)
+{
+    return addPlugin(BINARY_NATIVE, ptype, filename, name, label, uniqueId, extra, 0x0);
+}
+
+CarlaPlugin* CarlaEngine::createPlugin(const uint id, const BinaryType btype, const PluginType ptype,
+                                      const char* const filename, const char* const name, const char* const label, const int64_t uniqueId,
+                                      const void* const extra, const uint options)
+{
     CarlaPlugin::Initializer initializer = {
         this,
         id,
@@ -372,43 +494,7 @@ bool CarlaEngine::addPlugin(const BinaryType btype, const PluginType ptype,
     CarlaPlugin* plugin = nullptr;
 
 #ifndef BRIDGE_PLUGIN
-    CarlaString bridgeBinary(pData->options.binaryDir);
-
-    if (bridgeBinary.isNotEmpty())
-    {
-        if (btype == BINARY_NATIVE)
-        {
-#ifdef CARLA_OS_WIN
-            bridgeBinary += CARLA_OS_SEP_STR "carla-bridge-native.exe";
-#else
-            bridgeBinary += CARLA_OS_SEP_STR "carla-bridge-native";
-#endif
-        }
-        else
-        {
-            switch (btype)
-            {
-            case BINARY_POSIX32:
-                bridgeBinary += CARLA_OS_SEP_STR "carla-bridge-posix32";
-                break;
-            case BINARY_POSIX64:
-                bridgeBinary += CARLA_OS_SEP_STR "carla-bridge-posix64";
-                break;
-            case BINARY_WIN32:
-                bridgeBinary += CARLA_OS_SEP_STR "carla-bridge-win32.exe";
-                break;
-            case BINARY_WIN64:
-                bridgeBinary += CARLA_OS_SEP_STR "carla-bridge-win64.exe";
-                break;
-            default:
-                bridgeBinary.clear();
-                break;
-            }
-        }
-
-        if (! File(bridgeBinary.buffer()).existsAsFile())
-            bridgeBinary.clear();
-    }
+    const CarlaString bridgeBinary(getBridgeBinary(pData->options.binaryDir, btype));
 
     if (ptype != PLUGIN_INTERNAL && (btype != BINARY_NATIVE || (pData->options.preferPluginBridges && bridgeBinary.isNotEmpty())))
     {
@@ -444,7 +530,7 @@ bool CarlaEngine::addPlugin(const BinaryType btype, const PluginType ptype,
         else
         {
             setLastError("This Carla build cannot handle this binary");
-            return false;
+            return nullptr;
         }
     }
     else
@@ -523,7 +609,7 @@ bool CarlaEngine::addPlugin(const BinaryType btype, const PluginType ptype,
     }
 
     if (plugin == nullptr)
-        return false;
+        return nullptr;
 
     plugin->reload();
 
@@ -559,64 +645,10 @@ bool CarlaEngine::addPlugin(const BinaryType btype, const PluginType ptype,
     if (! canRun)
     {
         delete plugin;
-        return false;
-    }
-
-#if defined(HAVE_LIBLO) && ! defined(BUILD_BRIDGE)
-    plugin->registerToOscClient();
-#endif
-
-    EnginePluginData& pluginData(pData->plugins[id]);
-    pluginData.plugin      = plugin;
-    pluginData.insPeak[0]  = 0.0f;
-    pluginData.insPeak[1]  = 0.0f;
-    pluginData.outsPeak[0] = 0.0f;
-    pluginData.outsPeak[1] = 0.0f;
-
-#ifndef BUILD_BRIDGE
-    if (oldPlugin != nullptr)
-    {
-        const ScopedThreadStopper sts(this);
-
-        if (pData->options.processMode == ENGINE_PROCESS_MODE_PATCHBAY)
-            pData->graph.replacePlugin(oldPlugin, plugin);
-
-        const bool  wasActive = oldPlugin->getInternalParameterValue(PARAMETER_ACTIVE) >= 0.5f;
-        const float oldDryWet = oldPlugin->getInternalParameterValue(PARAMETER_DRYWET);
-        const float oldVolume = oldPlugin->getInternalParameterValue(PARAMETER_VOLUME);
-
-        delete oldPlugin;
-
-        if (plugin->getHints() & PLUGIN_CAN_DRYWET)
-            plugin->setDryWet(oldDryWet, true, true);
-
-        if (plugin->getHints() & PLUGIN_CAN_VOLUME)
-            plugin->setVolume(oldVolume, true, true);
-
-        plugin->setActive(wasActive, true, true);
-
-        callback(ENGINE_CALLBACK_RELOAD_ALL, id, 0, 0, 0.0f, nullptr);
-    }
-    else
-#endif
-    {
-        plugin->setActive(true, true, false);
-
-        ++pData->curPluginCount;
-        callback(ENGINE_CALLBACK_PLUGIN_ADDED, id, 0, 0, 0.0f, plugin->getName());
-
-#ifndef BUILD_BRIDGE
-        if (pData->options.processMode == ENGINE_PROCESS_MODE_PATCHBAY)
-            pData->graph.addPlugin(plugin);
-#endif
+        return nullptr;
     }
 
-    return true;
-}
-
-bool CarlaEngine::addPlugin(const PluginType ptype, const char* const filename, const char* const name, const char* const label, const int64_t uniqueId, const void* const extra)
-{
-    return addPlugin(BINARY_NATIVE, ptype, filename, name, label, uniqueId, extra, 0x0);
+    return plugin;
 }
 
 bool CarlaEngine::removePlugin(const uint id)
@@ -657,6 +689,7 @@ bool CarlaEngine::removePlugin(const uint id)
 # endif
 #else
     pData->curPluginCount = 0;
+    pData->workers.removeAllPlugins();
     carla_zeroStructs(pData->plugins, 1);
 #endif
 
@@ -952,6 +985,83 @@ const char* CarlaEngine::getUniquePluginName(const char* const name) const
 // -----------------------------------------------------------------------
 // Project management
 
+// Binary chunk file, see ENGINE_OPTION_SAVE_CHUNKS_AS_BINARY.
+// Starts with the magic and the id of the save, followed by the raw chunks referenced by <ChunkRef> elements.
+// The same id is written in <ChunkFile>, so a chunk file left over from another save is not used.
+static const char kProjectChunkFileMagic[16] = "CARLA-CHUNKS-02";
+static const char kProjectChunkFileSuffix[]  = ".chunks";
+static const std::size_t kProjectChunkFileIdSize     = 16;
+static const std::size_t kProjectChunkFileHeaderSize = sizeof(kProjectChunkFileMagic) + kProjectChunkFileIdSize;
+
+static String getNewProjectChunkFileId()
+{
+    return String::toHexString(juce::Random::getSystemRandom().nextInt64()).paddedLeft('0', static_cast<int>(kProjectChunkFileIdSize));
+}
+
+static juce::MemoryMappedFile* openProjectChunkFile(const File& file, const String& id)
+{
+    ScopedPointer<juce::MemoryMappedFile> chunkFile(new juce::MemoryMappedFile(file, juce::MemoryMappedFile::readOnly));
+
+    if (chunkFile->getData() == nullptr)
+    {
+        carla_stderr2("Failed to open project chunk file \"%s\"", file.getFullPathName().toRawUTF8());
+        return nullptr;
+    }
+
+    const char* const header(static_cast<const char*>(chunkFile->getData()));
+
+    if (chunkFile->getSize() < kProjectChunkFileHeaderSize ||
+        std::memcmp(header, kProjectChunkFileMagic, sizeof(kProjectChunkFileMagic)) != 0)
+    {
+        carla_stderr2("Invalid project chunk file \"%s\"", file.getFullPathName().toRawUTF8());
+        return nullptr;
+    }
+
+    if (id.length() != static_cast<int>(kProjectChunkFileIdSize) ||
+        std::memcmp(header + sizeof(kProjectChunkFileMagic), id.toRawUTF8(), kProjectChunkFileIdSize) != 0)
+    {
+        carla_stderr2("Project chunk file \"%s\" belongs to a different save of the project", file.getFullPathName().toRawUTF8());
+        return nullptr;
+    }
+
+    return chunkFile.release();
+}
+
+// Point the <ChunkRef> of 'stateSave' to its data inside the mapped chunk file.
+static void setStateSaveChunkFromFile(CarlaStateSave& stateSave, const juce::MemoryMappedFile* const chunkFile)
+{
+    if (stateSave.chunkSize == 0 || stateSave.chunkData != nullptr)
+        return;
+
+    if (chunkFile == nullptr)
+    {
+        carla_stderr2("Chunk of plugin \"%s\" is stored in a chunk file that is not available", stateSave.name);
+        stateSave.chunkSize = 0;
+        return;
+    }
+
+    const uint64_t fileSize(chunkFile->getSize());
+
+    if (stateSave.chunkOffset < kProjectChunkFileHeaderSize || stateSave.chunkOffset > fileSize ||
+        stateSave.chunkSize > fileSize - stateSave.chunkOffset)
+    {
+        carla_stderr2("Chunk of plugin \"%s\" is out of the chunk file bounds", stateSave.name);
+        stateSave.chunkSize = 0;
+        return;
+    }
+
+    const uint8_t* const chunkData(static_cast<const uint8_t*>(chunkFile->getData()) + stateSave.chunkOffset);
+
+    if (getChunkChecksum(chunkData, stateSave.chunkSize) != stateSave.chunkChecksum)
+    {
+        carla_stderr2("Chunk of plugin \"%s\" does not match its checksum", stateSave.name);
+        stateSave.chunkSize = 0;
+        return;
+    }
+
+    stateSave.chunkData = chunkData;
+}
+
 bool CarlaEngine::loadFile(const char* const filename)
 {
     CARLA_SAFE_ASSERT_RETURN_ERR(pData->isIdling == 0, "An operation is still being processed, please wait for it to finish");
@@ -1057,7 +1167,7 @@ bool CarlaEngine::loadProject(const char* const filename)
     CARLA_SAFE_ASSERT_RETURN_ERR(file.existsAsFile(), "Requested file does not exist or is not a readable file");
 
     XmlDocument xml(file);
-    return loadProjectInternal(xml);
+    return loadProjectInternal(xml, &file);
 }
 
 bool CarlaEngine::saveProject(const char* const filename)
@@ -1065,37 +1175,91 @@ bool CarlaEngine::saveProject(const char* const filename)
     CARLA_SAFE_ASSERT_RETURN_ERR(filename != nullptr && filename[0] != '\0', "Invalid filename");
     carla_debug("CarlaEngine::saveProject(\"%s\")", filename);
 
-    MemoryOutputStream out;
-    saveProjectInternal(out);
-
     const String jfilename = String(CharPointer_UTF8(filename));
     File file(jfilename);
 
-    if (file.replaceWithData(out.getData(), out.getDataSize()))
-        return true;
+    MemoryOutputStream out;
 
-    setLastError("Failed to write file");
-    return false;
-}
+    const File chunkFile(file.getFullPathName() + kProjectChunkFileSuffix);
+    juce::TemporaryFile tmpChunkFile(chunkFile);
+    bool hasChunks = false;
 
-// -----------------------------------------------------------------------
-// Information (base)
+    if (pData->options.saveChunksAsBinary)
+    {
+        ScopedPointer<juce::FileOutputStream> chunkStream(tmpChunkFile.getFile().createOutputStream());
+        CARLA_SAFE_ASSERT_RETURN_ERR(chunkStream != nullptr && chunkStream->openedOk(), "Failed to create chunk file");
 
-uint CarlaEngine::getHints() const noexcept
-{
-    return pData->hints;
-}
+        const String chunkFileId(getNewProjectChunkFileId());
 
-uint32_t CarlaEngine::getBufferSize() const noexcept
-{
-    return pData->bufferSize;
-}
+        chunkStream->write(kProjectChunkFileMagic, sizeof(kProjectChunkFileMagic));
+        chunkStream->write(chunkFileId.toRawUTF8(), kProjectChunkFileIdSize);
+        saveProjectInternal(out, chunkStream, chunkFile.getFileName().toRawUTF8(), chunkFileId.toRawUTF8());
 
-double CarlaEngine::getSampleRate() const noexcept
+        hasChunks = chunkStream->getPosition() > static_cast<juce::int64>(kProjectChunkFileHeaderSize);
+        chunkStream->flush();
+
+        if (chunkStream->getStatus().failed())
+        {
+            setLastError("Failed to write chunk file");
+            return false;
+        }
+    }
+    else
+    {
+        saveProjectInternal(out);
+    }
+
+    if (! file.replaceWithData(out.getData(), out.getDataSize()))
+    {
+        setLastError("Failed to write file");
+        return false;
+    }
+
+    // only replace the chunks once the project pointing to them is written
+    if (hasChunks)
+    {
+        if (! tmpChunkFile.overwriteTargetFileWithTemporary())
+        {
+            setLastError("Failed to write chunk file");
+            return false;
+        }
+    }
+    // the project no longer uses a chunk file, remove the one of a previous save
+    else if (chunkFile.existsAsFile() && ! chunkFile.deleteFile())
+    {
+        carla_stderr("CarlaEngine::saveProject(\"%s\") - failed to remove old chunk file", filename);
+    }
+
+    return true;
+}
+
+// -----------------------------------------------------------------------
+// Information (base)
+
+uint CarlaEngine::getHints() const noexcept
+{
+    return pData->hints;
+}
+
+uint32_t CarlaEngine::getBufferSize() const noexcept
+{
+    return pData->bufferSize;
+}
+
+double CarlaEngine::getSampleRate() const noexcept
 {
     return pData->sampleRate;
 }
 
+uint32_t CarlaEngine::getLatency() const noexcept
+{
+#ifndef BUILD_BRIDGE
+    if (pData->graph.isReady())
+        return pData->graph.getLatency();
+#endif
+    return 0;
+}
+
 const char* CarlaEngine::getName() const noexcept
 {
     return pData->name;
@@ -1113,9 +1277,30 @@ const EngineOptions& CarlaEngine::getOptions() const noexcept
 
 const EngineTimeInfo& CarlaEngine::getTimeInfo() const noexcept
 {
+#ifndef BUILD_BRIDGE
+    if (tTimeInfo != nullptr)
+        return *tTimeInfo;
+#endif
+
     return pData->timeInfo;
 }
 
+#ifndef BUILD_BRIDGE
+// -----------------------------------------------------------------------
+// ScopedThreadTimeInfo
+
+ScopedThreadTimeInfo::ScopedThreadTimeInfo(const EngineTimeInfo& timeInfo) noexcept
+    : fOldTimeInfo(tTimeInfo)
+{
+    tTimeInfo = &timeInfo;
+}
+
+ScopedThreadTimeInfo::~ScopedThreadTimeInfo() noexcept
+{
+    tTimeInfo = fOldTimeInfo;
+}
+#endif
+
 // -----------------------------------------------------------------------
 // Information (peaks)
 
@@ -1143,6 +1328,12 @@ void CarlaEngine::callback(const EngineCallbackOpcode action, const uint pluginI
         carla_debug("CarlaEngine::callback(%i:%s, %i, %i, %i, %f, \"%s\")", action, EngineCallbackOpcode2Str(action), pluginId, value1, value2, value3, valueStr);
 #endif
 
+#ifndef BUILD_BRIDGE
+    // plugin is not added to the engine yet
+    if (tPluginLoadError != nullptr)
+        return;
+#endif
+
 #ifdef BUILD_BRIDGE
     if (pData->isIdling)
 #else
@@ -1231,6 +1422,14 @@ const char* CarlaEngine::getLastError() const noexcept
 
 void CarlaEngine::setLastError(const char* const error) const noexcept
 {
+#ifndef BUILD_BRIDGE
+    if (tPluginLoadError != nullptr)
+    {
+        *tPluginLoadError = error;
+        return;
+    }
+#endif
+
     pData->lastError = error;
 }
 
@@ -1241,6 +1440,16 @@ void CarlaEngine::setAboutToClose() noexcept
     pData->aboutToClose = true;
 }
 
+void CarlaEngine::scheduleWorkerJob(const uint id) noexcept
+{
+    pData->workers.schedule(id);
+}
+
+void CarlaEngine::getWorkerStats(EngineWorkerStats& stats) const noexcept
+{
+    pData->workers.getStats(stats);
+}
+
 // -----------------------------------------------------------------------
 // Global options
 
@@ -1248,7 +1457,7 @@ void CarlaEngine::setOption(const EngineOption option, const int value, const ch
 {
     carla_debug("CarlaEngine::setOption(%i:%s, %i, \"%s\")", option, EngineOption2Str(option), value, valueStr);
 
-    if (isRunning() && (option == ENGINE_OPTION_PROCESS_MODE || option == ENGINE_OPTION_AUDIO_NUM_PERIODS || option == ENGINE_OPTION_AUDIO_DEVICE))
+    if (isRunning() && (option == ENGINE_OPTION_PROCESS_MODE || option == ENGINE_OPTION_AUDIO_NUM_PERIODS || option == ENGINE_OPTION_AUDIO_DEVICE || option == ENGINE_OPTION_PROCESS_THREADS || option == ENGINE_OPTION_RACK_PIPELINE_STAGES))
         return carla_stderr("CarlaEngine::setOption(%i:%s, %i, \"%s\") - Cannot set this option while engine is running!", option, EngineOption2Str(option), value, valueStr);
 
     // do not un-force stereo for rack mode
@@ -1437,6 +1646,43 @@ void CarlaEngine::setOption(const EngineOption option, const int value, const ch
 #endif
         break;
 
+    case ENGINE_OPTION_PROCESS_THREADS:
+        CARLA_SAFE_ASSERT_RETURN(value >= 0 && value <= static_cast<int>(MAX_PROCESS_THREADS),);
+        pData->options.processThreads = static_cast<uint>(value);
+        break;
+
+    case ENGINE_OPTION_PIPELINED_BRIDGES:
+        pData->options.pipelinedBridges = (value != 0);
+        break;
+
+    case ENGINE_OPTION_LOAD_THREADS:
+        CARLA_SAFE_ASSERT_RETURN(value >= 0 && value <= static_cast<int>(MAX_LOAD_THREADS),);
+        pData->options.loadThreads = static_cast<uint>(value);
+        break;
+
+    case ENGINE_OPTION_SAVE_CHUNKS_AS_BINARY:
+        pData->options.saveChunksAsBinary = (value != 0);
+        break;
+
+    case ENGINE_OPTION_LIBRARY_KEEP_ALIVE:
+        CARLA_SAFE_ASSERT_RETURN(value >= 0,);
+        pData->options.libraryKeepAlive = static_cast<uint>(value);
+        break;
+
+    case ENGINE_OPTION_PRELOAD_LIBRARIES:
+        pData->options.preloadLibraries = (value != 0);
+        break;
+
+    case ENGINE_OPTION_PARAMETER_OUTPUT_RATE:
+        CARLA_SAFE_ASSERT_RETURN(value >= 0,);
+        pData->options.parameterOutputRate = static_cast<uint>(value);
+        break;
+
+    case ENGINE_OPTION_RACK_PIPELINE_STAGES:
+        CARLA_SAFE_ASSERT_RETURN(value >= 0 && value <= static_cast<int>(MAX_RACK_PIPELINE_STAGES),);
+        pData->options.rackPipelineStages = static_cast<uint>(value);
+        break;
+
     case ENGINE_OPTION_FRONTEND_WIN_ID:
         CARLA_SAFE_ASSERT_RETURN(valueStr != nullptr && valueStr[0] != '\0',);
         const long long winId(std::strtoll(valueStr, nullptr, 16));
@@ -1453,6 +1699,10 @@ void CarlaEngine::setOption(const EngineOption option, const int value, const ch
 # ifndef BUILD_BRIDGE
 bool CarlaEngine::isOscControlRegistered() const noexcept
 {
+    // plugin is not added to the engine yet
+    if (tPluginLoadError != nullptr)
+        return false;
+
     return pData->osc.isControlRegistered();
 }
 # endif
@@ -1476,9 +1726,9 @@ const char* CarlaEngine::getOscServerPathUDP() const noexcept
 // -----------------------------------------------------------------------
 // Helper functions
 
-EngineEvent* CarlaEngine::getInternalEventBuffer(const bool isInput) const noexcept
+EngineEventBuffer* CarlaEngine::getInternalEventBuffer(const bool isInput) const noexcept
 {
-    return isInput ? pData->events.in : pData->events.out;
+    return isInput ? &pData->events.in : &pData->events.out;
 }
 
 // -----------------------------------------------------------------------
@@ -1488,6 +1738,11 @@ void CarlaEngine::bufferSizeChanged(const uint32_t newBufferSize)
 {
     carla_debug("CarlaEngine::bufferSizeChanged(%i)", newBufferSize);
 
+    if (pData->events.in.data != nullptr)
+        pData->events.in.allocate(newBufferSize);
+    if (pData->events.out.data != nullptr)
+        pData->events.out.allocate(newBufferSize);
+
 #ifndef BUILD_BRIDGE
     if (pData->options.processMode == ENGINE_PROCESS_MODE_CONTINUOUS_RACK ||
         pData->options.processMode == ENGINE_PROCESS_MODE_PATCHBAY)
@@ -1561,7 +1816,7 @@ void CarlaEngine::setPluginPeaks(const uint pluginId, float const inPeaks[2], fl
     pluginData.outsPeak[1] = outPeaks[1];
 }
 
-void CarlaEngine::saveProjectInternal(juce::MemoryOutputStream& outStream) const
+void CarlaEngine::saveProjectInternal(juce::MemoryOutputStream& outStream, juce::OutputStream* const chunkStream, const char* const chunkFilename, const char* const chunkFileId) const
 {
     // send initial prepareForSave first, giving time for bridges to act
     for (uint i=0; i < pData->curPluginCount; ++i)
@@ -1619,6 +1874,8 @@ void CarlaEngine::saveProjectInternal(juce::MemoryOutputStream& outStream) const
 
     char strBuf[STR_MAX+1];
 
+    const juce::int64 chunkStreamStart(chunkStream != nullptr ? chunkStream->getPosition() : 0);
+
     for (uint i=0; i < pData->curPluginCount; ++i)
     {
         CarlaPlugin* const plugin(pData->plugins[i].plugin);
@@ -1626,7 +1883,7 @@ void CarlaEngine::saveProjectInternal(juce::MemoryOutputStream& outStream) const
         if (plugin != nullptr && plugin->isEnabled())
         {
             MemoryOutputStream outPlugin(4096), streamPlugin;
-            plugin->getStateSave(false).dumpToMemoryStream(streamPlugin);
+            plugin->getStateSave(false, chunkStream != nullptr).dumpToMemoryStream(streamPlugin, chunkStream);
 
             outPlugin << "\n";
 
@@ -1643,6 +1900,13 @@ void CarlaEngine::saveProjectInternal(juce::MemoryOutputStream& outStream) const
         }
     }
 
+    if (chunkStream != nullptr && chunkStream->getPosition() > chunkStreamStart)
+    {
+        CARLA_SAFE_ASSERT(chunkFilename != nullptr && chunkFilename[0] != '\0');
+        CARLA_SAFE_ASSERT(chunkFileId != nullptr && chunkFileId[0] != '\0');
+        outStream << "\n <ChunkFile Id='" << chunkFileId << "'>" << xmlSafeString(chunkFilename, true) << "</ChunkFile>\n";
+    }
+
 #ifndef BUILD_BRIDGE
     // tell bridges we're done saving
     for (uint i=0; i < pData->curPluginCount; ++i)
@@ -1728,7 +1992,490 @@ void CarlaEngine::saveProjectInternal(juce::MemoryOutputStream& outStream) const
     outStream << "</CARLA-PROJECT>\n";
 }
 
-bool CarlaEngine::loadProjectInternal(juce::XmlDocument& xmlDoc)
+// -----------------------------------------------------------------------
+// Project plugin loading
+
+// GIG and SF2 plugins using 16 outputs are saved with a label suffix
+static const void* getPluginExtraFromStateSave(const CarlaStateSave& stateSave, const PluginType ptype)
+{
+    static const char kUse16OutsSuffix[] = " (16 outs)";
+
+    if ((ptype == PLUGIN_GIG || ptype == PLUGIN_SF2) && CarlaString(stateSave.label).endsWith(kUse16OutsSuffix))
+        return "true";
+
+    return nullptr;
+}
+
+#ifndef BUILD_BRIDGE
+// Get the binaries of a project that will be opened through a plain dlopen, in project order.
+static void getProjectLibraries(const EngineOptions& options, const XmlElement* const xmlElement, juce::StringArray& filenames)
+{
+    if (options.preferPluginBridges)
+        return;
+
+    for (XmlElement* elem = xmlElement->getFirstChildElement(); elem != nullptr; elem = elem->getNextElement())
+    {
+        if (! elem->getTagName().equalsIgnoreCase("plugin"))
+            continue;
+
+        const XmlElement* const xmlInfo(elem->getChildByName("Info"));
+        CARLA_SAFE_ASSERT_CONTINUE(xmlInfo != nullptr);
+
+        const XmlElement* const xmlType(xmlInfo->getChildByName("Type"));
+        const XmlElement* const xmlBinary(xmlInfo->getChildByName("Binary"));
+
+        if (xmlType == nullptr || xmlBinary == nullptr)
+            continue;
+
+        const String type(xmlSafeString(xmlType->getAllSubText().trim(), false));
+        const String binary(xmlSafeString(xmlBinary->getAllSubText().trim(), false));
+
+        if (binary.isEmpty() || filenames.contains(binary))
+            continue;
+
+        switch (getPluginTypeFromString(type.toRawUTF8()))
+        {
+        case PLUGIN_LADSPA:
+        case PLUGIN_DSSI:
+#ifndef CARLA_OS_MAC
+        case PLUGIN_VST2:
+#endif
+            if (getBinaryTypeFromFile(binary.toRawUTF8()) == BINARY_NATIVE)
+                filenames.add(binary);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+// Check if a plugin can be created and restored outside the main thread, concurrently with others.
+static bool isPluginThreadSafeToLoad(const EngineOptions& options, const BinaryType btype, const PluginType ptype)
+{
+    // internal plugins might share global state
+    if (ptype == PLUGIN_INTERNAL)
+        return false;
+
+    if (btype != BINARY_NATIVE || options.preferPluginBridges)
+    {
+        // bridges run in their own process
+        if (getBridgeBinary(options.binaryDir, btype).isNotEmpty())
+            return true;
+
+        // dssi-vst fallback changes the environment
+        if (btype != BINARY_NATIVE)
+            return false;
+    }
+
+    switch (ptype)
+    {
+    case PLUGIN_LADSPA:
+    case PLUGIN_DSSI:
+    case PLUGIN_SF2:
+        return true;
+    default:
+        // LV2 world lookups are not thread-safe, LinuxSampler is shared,
+        // VST and AU plugins expect to be created in the main thread
+        return false;
+    }
+}
+
+// -----------------------------------------------------------------------
+// ProjectPluginLoader
+
+/*
+ * Loads the plugins of a project using extra threads, see ENGINE_OPTION_LOAD_THREADS.
+ *
+ * Plugins are loaded in batches. Within a batch, plugins that are thread-safe to load are created
+ * and restored by the load threads, while the calling thread loads the others and then helps them.
+ * It keeps calling idle until the last load thread signals it is done.
+ * Once the whole batch is done its plugins are added to the engine in file order.
+ *
+ * A plugin without a saved name, or with the same name as one before it, gets a batch of its own
+ * so that getUniquePluginName() sees every plugin already added.
+ */
+class ProjectPluginLoader
+{
+public:
+    ProjectPluginLoader(CarlaEngine* const engine, const XmlElement* const xmlElement,
+                        const juce::MemoryMappedFile* const chunkFile, const uint numThreads)
+        : kEngine(engine),
+          fJobs(nullptr),
+          fJobCount(0),
+          fThreadCount(0),
+          fBatch(nullptr),
+          fBatchSafeCount(0),
+          fNextSafeJob(0),
+          fThreadsDone(),
+          fThreadsRunning(0)
+    {
+        carla_sem_create2(fThreadsDone);
+
+        CARLA_SAFE_ASSERT_RETURN(xmlElement != nullptr,);
+        CARLA_SAFE_ASSERT_RETURN(numThreads > 0 && numThreads <= MAX_LOAD_THREADS,);
+
+        for (const XmlElement* elem = xmlElement->getFirstChildElement(); elem != nullptr; elem = elem->getNextElement())
+        {
+            if (elem->getTagName().equalsIgnoreCase("plugin"))
+                ++fJobCount;
+        }
+
+        if (fJobCount == 0)
+            return;
+
+        fJobs  = new Job[fJobCount];
+        fBatch = new uint[fJobCount];
+
+        const EngineOptions& options(engine->getOptions());
+        uint i = 0;
+
+        for (const XmlElement* elem = xmlElement->getFirstChildElement(); elem != nullptr; elem = elem->getNextElement())
+        {
+            if (! elem->getTagName().equalsIgnoreCase("plugin"))
+                continue;
+
+            Job& job(fJobs[i++]);
+            job.stateSave.fillFromXmlElement(elem);
+            setStateSaveChunkFromFile(job.stateSave, chunkFile);
+
+            if (job.stateSave.type == nullptr)
+            {
+                job.error = "Invalid plugin type";
+                continue;
+            }
+
+            job.btype      = getBinaryTypeFromFile(job.stateSave.binary);
+            job.ptype      = getPluginTypeFromString(job.stateSave.type);
+            job.extra      = getPluginExtraFromStateSave(job.stateSave, job.ptype);
+            job.threadSafe = isPluginThreadSafeToLoad(options, job.btype, job.ptype);
+        }
+
+        for (; fThreadCount < numThreads; ++fThreadCount)
+            fThreads[fThreadCount] = new LoadThread(this, fThreadCount+1);
+    }
+
+    ~ProjectPluginLoader()
+    {
+        for (uint i=0; i < fThreadCount; ++i)
+            delete fThreads[i];
+
+        if (fJobs != nullptr)
+        {
+            // only set if never committed
+            for (uint i=0; i < fJobCount; ++i)
+                delete fJobs[i].plugin;
+
+            delete[] fJobs;
+        }
+
+        delete[] fBatch;
+
+        carla_sem_destroy2(fThreadsDone);
+    }
+
+    void load()
+    {
+        CARLA_SAFE_ASSERT_RETURN(kEngine->pData->nextAction.opcode == kEnginePostActionNull,);
+
+#ifdef DEBUG
+        const double startTime(juce::Time::getMillisecondCounterHiRes());
+#endif
+        uint loaded = 0;
+
+        for (uint first=0, last; first < fJobCount; first = last)
+        {
+            last = first + 1;
+
+            if (! needsOwnBatch(first, first))
+            {
+                for (; last < fJobCount && ! needsOwnBatch(last, first); ++last) {}
+            }
+
+            runBatch(first, last);
+            loaded += commitBatch(first, last);
+        }
+
+#ifdef DEBUG
+        carla_debug("Loaded %u of %u plugins in %.1f ms, using %u load threads",
+                    loaded, fJobCount, juce::Time::getMillisecondCounterHiRes() - startTime, fThreadCount);
+#endif
+    }
+
+private:
+    struct Job {
+        CarlaStateSave stateSave;
+        BinaryType  btype;
+        PluginType  ptype;
+        const void* extra;
+        bool        threadSafe;
+
+        // results
+        CarlaPlugin* plugin;
+        CarlaString  error;
+        uint   id;
+        uint   thread; // 0 for the calling thread
+        double instantiateTime;
+        double restoreTime;
+
+        Job() noexcept
+            : stateSave(),
+              btype(BINARY_NONE),
+              ptype(PLUGIN_NONE),
+              extra(nullptr),
+              threadSafe(false),
+              plugin(nullptr),
+              error(),
+              id(0),
+              thread(0),
+              instantiateTime(0.0),
+              restoreTime(0.0) {}
+
+        CARLA_DECLARE_NON_COPY_STRUCT(Job)
+    };
+
+    class LoadThread : public CarlaThread
+    {
+    public:
+        LoadThread(ProjectPluginLoader* const loader, const uint index) noexcept
+            : CarlaThread("CarlaProjectLoader"),
+              kLoader(loader),
+              kIndex(index) {}
+
+    protected:
+        void run() noexcept override
+        {
+            kLoader->runThread(kIndex);
+        }
+
+    private:
+        ProjectPluginLoader* const kLoader;
+        const uint kIndex;
+
+        CARLA_DECLARE_NON_COPY_CLASS(LoadThread)
+    };
+
+    CarlaEngine* const kEngine;
+
+    Job* fJobs;
+    uint fJobCount;
+
+    LoadThread* fThreads[MAX_LOAD_THREADS];
+    uint fThreadCount;
+
+    // thread-safe jobs of the current batch
+    uint* fBatch;
+    uint  fBatchSafeCount;
+    volatile int fNextSafeJob;
+
+    // posted by the last load thread to finish its jobs
+    carla_sem_t  fThreadsDone;
+    volatile int fThreadsRunning;
+
+    bool needsOwnBatch(const uint index, const uint batchStart) const noexcept
+    {
+        const char* const name(fJobs[index].stateSave.name);
+
+        if (name == nullptr || name[0] == '\0')
+            return true;
+
+        for (uint i=0; i < kEngine->pData->curPluginCount; ++i)
+        {
+            const CarlaPlugin* const plugin(kEngine->pData->plugins[i].plugin);
+            CARLA_SAFE_ASSERT_CONTINUE(plugin != nullptr);
+
+            if (const char* const pluginName = plugin->getName())
+            {
+                if (std::strcmp(name, pluginName) == 0)
+                    return true;
+            }
+        }
+
+        for (uint i=batchStart; i < index; ++i)
+        {
+            const char* const otherName(fJobs[i].stateSave.name);
+
+            if (otherName != nullptr && std::strcmp(name, otherName) == 0)
+                return true;
+        }
+
+        return false;
+    }
+
+    void runBatch(const uint first, const uint last) noexcept
+    {
+        const uint curPluginCount(kEngine->pData->curPluginCount);
+        const uint maxPluginNumber(kEngine->pData->maxPluginNumber);
+
+        fBatchSafeCount = 0;
+        fNextSafeJob    = 0;
+
+        for (uint i=first; i < last; ++i)
+        {
+            Job& job(fJobs[i]);
+
+            if (job.ptype == PLUGIN_NONE)
+                continue;
+
+            // final id might be lower if a plugin before this one fails
+            job.id = curPluginCount + (i - first);
+
+            if (job.id >= maxPluginNumber)
+            {
+                job.ptype = PLUGIN_NONE;
+                job.error = "Maximum number of plugins reached";
+                continue;
+            }
+
+            if (job.threadSafe)
+                fBatch[fBatchSafeCount++] = i;
+        }
+
+        const uint numThreads(fBatchSafeCount < fThreadCount ? fBatchSafeCount : fThreadCount);
+
+        fThreadsRunning = static_cast<int>(numThreads);
+
+        for (uint i=0; i < numThreads; ++i)
+        {
+            if (! fThreads[i]->startThread())
+                threadDone();
+        }
+
+        for (uint i=first; i < last; ++i)
+        {
+            Job& job(fJobs[i]);
+
+            if (job.ptype == PLUGIN_NONE || job.threadSafe)
+                continue;
+
+            kEngine->callback(ENGINE_CALLBACK_IDLE, 0, 0, 0, 0.0f, nullptr);
+            runJob(job, 0);
+        }
+
+        // help with what the load threads did not pick up yet
+        runSafeJobs(0);
+
+        // keep the host responsive while the load threads finish, the last one posts
+        for (; numThreads > 0 && ! carla_sem_timedwait(fThreadsDone, 50);)
+            kEngine->callback(ENGINE_CALLBACK_IDLE, 0, 0, 0, 0.0f, nullptr);
+
+        // threads are past their last job, let them exit so the next batch can start them again
+        for (uint i=0; i < numThreads; ++i)
+            fThreads[i]->stopThread(-1);
+
+        // make sure we see everything the load threads wrote
+        __sync_synchronize();
+    }
+
+    void runThread(const uint index) noexcept
+    {
+        runSafeJobs(index);
+        threadDone();
+    }
+
+    void runSafeJobs(const uint thread) noexcept
+    {
+        for (int next; (next = __sync_fetch_and_add(&fNextSafeJob, 1)) < static_cast<int>(fBatchSafeCount);)
+            runJob(fJobs[fBatch[next]], thread);
+    }
+
+    void threadDone() noexcept
+    {
+        if (__sync_sub_and_fetch(&fThreadsRunning, 1) == 0)
+            carla_sem_post(fThreadsDone);
+    }
+
+    void runJob(Job& job, const uint thread) noexcept
+    {
+        const CarlaStateSave& stateSave(job.stateSave);
+
+        tPluginLoadError = &job.error;
+        job.thread = thread;
+
+        const double startTime(juce::Time::getMillisecondCounterHiRes());
+
+        try {
+            job.plugin = kEngine->createPlugin(job.id, job.btype, job.ptype, stateSave.binary, stateSave.name, stateSave.label,
+                                               stateSave.uniqueId, job.extra, stateSave.options);
+        } CARLA_SAFE_EXCEPTION("ProjectPluginLoader createPlugin");
+
+        const double createdTime(juce::Time::getMillisecondCounterHiRes());
+
+        if (job.plugin != nullptr)
+        {
+            try {
+                // deactivate bridge client-side ping check, since some plugins block during load
+                if ((job.plugin->getHints() & PLUGIN_IS_BRIDGE) != 0)
+                    job.plugin->setCustomData(CUSTOM_DATA_TYPE_STRING, "__CarlaPingOnOff__", "false", false);
+
+                // same as addPlugin(), the saved state might deactivate it again
+                job.plugin->setActive(true, true, false);
+                job.plugin->loadStateSave(stateSave);
+            } CARLA_SAFE_EXCEPTION("ProjectPluginLoader loadStateSave");
+        }
+
+        job.instantiateTime = createdTime - startTime;
+        job.restoreTime     = juce::Time::getMillisecondCounterHiRes() - createdTime;
+
+        tPluginLoadError = nullptr;
+    }
+
+    uint commitBatch(const uint first, const uint last)
+    {
+        CarlaEngine::ProtectedData* const pData(kEngine->pData);
+        uint committed = 0;
+
+        for (uint i=first; i < last; ++i)
+        {
+            Job& job(fJobs[i]);
+
+            if (job.plugin == nullptr)
+            {
+                carla_stderr2("Failed to load a plugin, error was:\n%s", job.error.buffer());
+                kEngine->setLastError(job.error.buffer());
+                continue;
+            }
+
+            CarlaPlugin* const plugin(job.plugin);
+            job.plugin = nullptr;
+
+            const uint id(pData->curPluginCount);
+            CARLA_SAFE_ASSERT(id <= job.id);
+
+            if (plugin->getId() != id)
+                plugin->setId(id);
+
+# ifdef HAVE_LIBLO
+            plugin->registerToOscClient();
+# endif
+
+            EnginePluginData& pluginData(pData->plugins[id]);
+            pluginData.plugin      = plugin;
+            pluginData.insPeak[0]  = 0.0f;
+            pluginData.insPeak[1]  = 0.0f;
+            pluginData.outsPeak[0] = 0.0f;
+            pluginData.outsPeak[1] = 0.0f;
+
+            ++pData->curPluginCount;
+            kEngine->callback(ENGINE_CALLBACK_PLUGIN_ADDED, id, 0, 0, 0.0f, plugin->getName());
+
+            if (pData->options.processMode == ENGINE_PROCESS_MODE_PATCHBAY)
+                pData->graph.addPlugin(plugin);
+
+            carla_debug("Loaded plugin %u \"%s\" in %.1f ms (instantiate %.1f ms, restore %.1f ms, thread %u)",
+                        id, plugin->getName(), job.instantiateTime + job.restoreTime, job.instantiateTime, job.restoreTime, job.thread);
+            ++committed;
+        }
+
+        return committed;
+    }
+
+    CARLA_DECLARE_NON_COPY_CLASS(ProjectPluginLoader)
+};
+#endif
+
+// -----------------------------------------------------------------------
+
+bool CarlaEngine::loadProjectInternal(juce::XmlDocument& xmlDoc, const juce::File* const projectFile)
 {
     ScopedPointer<XmlElement> xmlElement(xmlDoc.getDocumentElement(true));
     CARLA_SAFE_ASSERT_RETURN_ERR(xmlElement != nullptr, "Failed to parse project file");
@@ -1858,7 +2605,51 @@ bool CarlaEngine::loadProjectInternal(juce::XmlDocument& xmlDoc)
         break;
     }
 
+    // binary chunks, see saveProject()
+    ScopedPointer<juce::MemoryMappedFile> chunkFile;
+
+    for (XmlElement* elem = xmlElement->getFirstChildElement(); elem != nullptr && projectFile != nullptr; elem = elem->getNextElement())
+    {
+        if (! elem->getTagName().equalsIgnoreCase("chunkfile"))
+            continue;
+
+        const String text(elem->getAllSubText().trim());
+        chunkFile = openProjectChunkFile(projectFile->getSiblingFile(xmlSafeString(text, false)), elem->getStringAttribute("Id"));
+        break;
+    }
+
+#ifndef BUILD_BRIDGE
+    // open plugin binaries in the background while the first plugins load
+    bool preloadingLibraries = false;
+
+    if (pData->options.preloadLibraries && ! isPreset)
+    {
+        juce::StringArray filenames;
+        getProjectLibraries(pData->options, xmlElement.get(), filenames);
+
+        if (filenames.size() > 1)
+        {
+            juce::HeapBlock<const char*> filenamesPtr(filenames.size()+1);
+
+            for (int i=0; i < filenames.size(); ++i)
+                filenamesPtr[i] = filenames[i].toRawUTF8();
+            filenamesPtr[filenames.size()] = nullptr;
+
+            CarlaPlugin::preloadLibraries(filenamesPtr);
+            preloadingLibraries = true;
+        }
+    }
+#endif
+
     // handle plugins first
+#ifndef BUILD_BRIDGE
+    if (pData->options.loadThreads > 0 && ! isPreset)
+    {
+        ProjectPluginLoader loader(this, xmlElement.get(), chunkFile, pData->options.loadThreads);
+        loader.load();
+    }
+    else
+#endif
     for (XmlElement* elem = xmlElement->getFirstChildElement(); elem != nullptr; elem = elem->getNextElement())
     {
         const String& tagName(elem->getTagName());
@@ -1867,24 +2658,17 @@ bool CarlaEngine::loadProjectInternal(juce::XmlDocument& xmlDoc)
         {
             CarlaStateSave stateSave;
             stateSave.fillFromXmlElement(isPreset ? xmlElement.get() : elem);
+            setStateSaveChunkFromFile(stateSave, chunkFile);
 
             callback(ENGINE_CALLBACK_IDLE, 0, 0, 0, 0.0f, nullptr);
 
             CARLA_SAFE_ASSERT_CONTINUE(stateSave.type != nullptr);
 
-            const void* extraStuff = nullptr;
-
-            // check if using GIG or SF2 16outs
-            static const char kUse16OutsSuffix[] = " (16 outs)";
-
             const BinaryType btype(getBinaryTypeFromFile(stateSave.binary));
             const PluginType ptype(getPluginTypeFromString(stateSave.type));
 
-            if (CarlaString(stateSave.label).endsWith(kUse16OutsSuffix))
-            {
-                if (ptype == PLUGIN_GIG || ptype == PLUGIN_SF2)
-                    extraStuff = "true";
-            }
+            // check if using GIG or SF2 16outs
+            const void* const extraStuff(getPluginExtraFromStateSave(stateSave, ptype));
 
             // TODO - proper find&load plugins
 
@@ -1911,6 +2695,10 @@ bool CarlaEngine::loadProjectInternal(juce::XmlDocument& xmlDoc)
     }
 
 #ifndef BUILD_BRIDGE
+    // plugins hold their own references now
+    if (preloadingLibraries)
+        CarlaPlugin::releasePreloadedLibraries(pData->options.libraryKeepAlive);
+
     // tell bridges we're done loading
     for (uint i=0; i < pData->curPluginCount; ++i)
     {
@@ -1144,7 +1144,10 @@ public:
 
             case kPluginBridgeNonRtClientShowUI:
                 if (plugin != nullptr && plugin->isEnabled())
+                {
+                    plugin->setParameterOutputsChanged();
                     plugin->showCustomUI(true);
+                }
                 break;
 
             case kPluginBridgeNonRtClientHideUI:
@@ -1345,8 +1348,13 @@ protected:
 
                         if (size > EngineMidiEvent::kDataSize)
                         {
-                            event->midi.dataExt = data;
+                            // data is on the stack, keep a copy until the next process
+                            event->midi.dataExt = pData->events.in.appendData(data, size);
                             std::memset(event->midi.data, 0, sizeof(uint8_t)*EngineMidiEvent::kDataSize);
+
+                            // no space left, drop it
+                            if (event->midi.dataExt == nullptr)
+                                event->type = kEngineEventTypeNull;
                         }
                         else
                         {
@@ -1423,17 +1431,13 @@ protected:
                     carla_zeroBytes(midiData, kBridgeRtClientDataMidiOutSize);
                     std::size_t curMidiDataPos = 0;
 
-                    if (pData->events.in[0].type != kEngineEventTypeNull)
-                        carla_zeroStructs(pData->events.in,  kMaxEngineEventInternalCount);
+                    pData->events.in.clear();
 
-                    if (pData->events.out[0].type != kEngineEventTypeNull)
+                    if (pData->events.out.count != 0)
                     {
-                        for (ushort i=0; i < kMaxEngineEventInternalCount; ++i)
+                        for (uint32_t i=0; i < pData->events.out.count; ++i)
                         {
-                            const EngineEvent& event(pData->events.out[i]);
-
-                            if (event.type == kEngineEventTypeNull)
-                                break;
+                            const EngineEvent& event(pData->events.out.data[i]);
 
                             if (event.type == kEngineEventTypeControl)
                             {
@@ -1484,7 +1488,7 @@ protected:
                             }
                         }
 
-                        carla_zeroStructs(pData->events.out, kMaxEngineEventInternalCount);
+                        pData->events.out.clear();
                     }
 
                 }   break;
@@ -1515,14 +1519,7 @@ protected:
     // called from process thread above
     EngineEvent* getNextFreeInputEvent() const noexcept
     {
-        for (ushort i=0; i < kMaxEngineEventInternalCount; ++i)
-        {
-            EngineEvent* const event(&pData->events.in[i]);
-
-            if (event->type == kEngineEventTypeNull)
-                return event;
-        }
-        return nullptr;
+        return pData->events.in.append();
     }
 
     // -------------------------------------------------------------------
@@ -16,6 +16,7 @@
  */
 
 #include "CarlaEngine.hpp"
+#include "CarlaEngineUtils.hpp"
 #include "CarlaMathUtils.hpp"
 #include "CarlaMIDI.h"
 
@@ -86,12 +87,12 @@ void EngineControlEvent::convertToMidiData(const uint8_t channel, uint8_t& size,
 
 void EngineEvent::fillFromMidiData(const uint8_t size, const uint8_t* const data, const uint8_t midiPortOffset) noexcept
 {
+    // invalid unless filled below, the event might be a reused buffer slot
+    type    = kEngineEventTypeNull;
+    channel = 0;
+
     if (size == 0 || data == nullptr || data[0] < MIDI_STATUS_NOTE_OFF)
-    {
-        type    = kEngineEventTypeNull;
-        channel = 0;
         return;
-    }
 
     // get channel
     channel = uint8_t(MIDI_GET_CHANNEL_FROM_DATA(data));
@@ -179,6 +180,215 @@ void EngineEvent::fillFromMidiData(const uint8_t size, const uint8_t* const data
     }
 }
 
+// -----------------------------------------------------------------------
+// EngineEventBuffer
+
+EngineEventBuffer::EngineEventBuffer() noexcept
+    : data(nullptr),
+      count(0),
+      capacity(0),
+      arena(nullptr),
+      arenaUsed(0),
+      arenaSize(0) {}
+
+EngineEventBuffer::~EngineEventBuffer() noexcept
+{
+    CARLA_SAFE_ASSERT(data == nullptr);
+    CARLA_SAFE_ASSERT(arena == nullptr);
+}
+
+bool EngineEventBuffer::allocate(const uint32_t bufferSize) noexcept
+{
+    // enough for one event per frame, and some room for SysEx on each
+    const uint32_t newCapacity(bufferSize > kMaxEngineEventInternalCount ? bufferSize : kMaxEngineEventInternalCount);
+    const uint32_t newArenaSize(newCapacity*32 > kMinEngineEventArenaSize ? newCapacity*32 : kMinEngineEventArenaSize);
+
+    if (data != nullptr && arena != nullptr && newCapacity <= capacity && newArenaSize <= arenaSize)
+        return true;
+
+    EngineEvent* newData;
+    uint8_t*     newArena;
+
+    try {
+        newData = new EngineEvent[newCapacity];
+    } CARLA_SAFE_EXCEPTION_RETURN("EngineEventBuffer::allocate", false);
+
+    try {
+        newArena = new uint8_t[newArenaSize];
+    } catch(...) {
+        carla_safe_exception("EngineEventBuffer::allocate", __FILE__, __LINE__);
+        delete[] newData;
+        return false;
+    }
+
+    deallocate();
+
+    data      = newData;
+    capacity  = newCapacity;
+    arena     = newArena;
+    arenaSize = newArenaSize;
+    return true;
+}
+
+void EngineEventBuffer::deallocate() noexcept
+{
+    count     = 0;
+    capacity  = 0;
+    arenaUsed = 0;
+    arenaSize = 0;
+
+    if (data != nullptr)
+    {
+        delete[] data;
+        data = nullptr;
+    }
+
+    if (arena != nullptr)
+    {
+        delete[] arena;
+        arena = nullptr;
+    }
+}
+
+EngineEvent* EngineEventBuffer::append() noexcept
+{
+    if (count >= capacity)
+        return nullptr;
+
+    // slots are reused, don't let the caller see the type of a previous event
+    EngineEvent* const event(&data[count++]);
+    event->type = kEngineEventTypeNull;
+    return event;
+}
+
+EngineEvent* EngineEventBuffer::appendFromMidiData(const uint32_t time, const uint8_t size, const uint8_t* const midiData, const uint8_t midiPortOffset) noexcept
+{
+    EngineEvent* const event(append());
+
+    if (event == nullptr)
+        return nullptr;
+
+    event->time = time;
+    event->fillFromMidiData(size, midiData, midiPortOffset);
+
+    if (event->type == kEngineEventTypeNull)
+    {
+        --count;
+        return nullptr;
+    }
+
+    if (event->type == kEngineEventTypeMidi && event->midi.dataExt != nullptr)
+    {
+        event->midi.dataExt = appendData(event->midi.dataExt, event->midi.size);
+
+        // no space left for the long message, drop it
+        if (event->midi.dataExt == nullptr)
+        {
+            --count;
+            return nullptr;
+        }
+    }
+
+    return event;
+}
+
+const uint8_t* EngineEventBuffer::appendData(const uint8_t* const bytes, const uint32_t size) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(bytes != nullptr && size > 0, nullptr);
+
+    if (size > arenaSize - arenaUsed)
+        return nullptr;
+
+    uint8_t* const dest(arena + arenaUsed);
+    std::memcpy(dest, bytes, size);
+
+    arenaUsed += size;
+    return dest;
+}
+
+void EngineEventBuffer::copyFrom(const EngineEventBuffer& other) noexcept
+{
+    const uint32_t newCount(other.count < capacity ? other.count : capacity);
+    const uint32_t newArenaUsed(other.arenaUsed < arenaSize ? other.arenaUsed : arenaSize);
+
+    carla_copyStructs(data, other.data, newCount);
+    count = newCount;
+
+    if (newArenaUsed > 0)
+        std::memcpy(arena, other.arena, newArenaUsed);
+    arenaUsed = newArenaUsed;
+
+    if (other.arenaUsed == 0)
+        return;
+
+    // long messages need to point to our own arena now
+    for (uint32_t i=0; i < count; ++i)
+    {
+        EngineEvent& event(data[i]);
+
+        if (event.type != kEngineEventTypeMidi || event.midi.dataExt == nullptr)
+            continue;
+
+        const uint8_t* const otherArenaEnd(other.arena + other.arenaUsed);
+
+        if (event.midi.dataExt < other.arena || event.midi.dataExt >= otherArenaEnd)
+            continue;
+
+        const std::size_t offset(static_cast<std::size_t>(event.midi.dataExt - other.arena));
+
+        if (offset + event.midi.size <= arenaUsed)
+        {
+            event.midi.dataExt = arena + offset;
+        }
+        else
+        {
+            // did not fit, drop the message
+            event.type = kEngineEventTypeNull;
+        }
+    }
+}
+
+void EngineEventBuffer::mergeFrom(const EngineEventBuffer& other) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(&other != this,);
+    CARLA_SAFE_ASSERT_RETURN(count <= capacity,);
+
+    const uint32_t otherCount(other.count < capacity - count ? other.count : capacity - count);
+
+    if (otherCount == 0)
+        return;
+
+    const uint8_t* const otherArenaEnd(other.arena + other.arenaUsed);
+
+    // merge from the back, so no temporary storage is needed
+    uint32_t i = count, j = otherCount, k = count + otherCount;
+
+    for (; j > 0;)
+    {
+        if (i > 0 && data[i-1].time > other.data[j-1].time)
+        {
+            data[--k] = data[--i];
+            continue;
+        }
+
+        EngineEvent& event(data[--k]);
+        event = other.data[--j];
+
+        if (event.type != kEngineEventTypeMidi || event.midi.dataExt == nullptr)
+            continue;
+        if (event.midi.dataExt < other.arena || event.midi.dataExt >= otherArenaEnd)
+            continue;
+
+        // long messages need to move into our own arena
+        event.midi.dataExt = appendData(event.midi.dataExt, event.midi.size);
+
+        if (event.midi.dataExt == nullptr)
+            event.type = kEngineEventTypeNull;
+    }
+
+    count += otherCount;
+}
+
 // -----------------------------------------------------------------------
 // EngineOptions
 
@@ -215,7 +425,15 @@ EngineOptions::EngineOptions() noexcept
       binaryDir(nullptr),
       resourceDir(nullptr),
       preventBadBehaviour(false),
-      frontendWinId(0) {}
+      frontendWinId(0),
+      processThreads(0),
+      pipelinedBridges(false),
+      loadThreads(0),
+      saveChunksAsBinary(false),
+      libraryKeepAlive(0),
+      preloadLibraries(false),
+      parameterOutputRate(0),
+      rackPipelineStages(0) {}
 
 EngineOptions::~EngineOptions() noexcept
 {
@@ -333,6 +551,16 @@ bool EngineTimeInfo::operator!=(const EngineTimeInfo& timeInfo) const noexcept
     return !operator==(timeInfo);
 }
 
+// -----------------------------------------------------------------------
+// EngineWorkerStats
+
+EngineWorkerStats::EngineWorkerStats() noexcept
+    : queueDepth(0),
+      maxQueueDepth(0),
+      jobsDone(0),
+      lastLatency(0.0f),
+      maxLatency(0.0f) {}
+
 // -----------------------------------------------------------------------
 
 CARLA_BACKEND_END_NAMESPACE
@@ -21,13 +21,21 @@
 
 #include "CarlaMathUtils.hpp"
 #include "CarlaMIDI.h"
+#include "CarlaSemUtils.hpp"
+#include "CarlaThread.hpp"
 
 using juce::AudioPluginInstance;
 using juce::AudioProcessor;
 using juce::AudioProcessorEditor;
+using juce::Array;
 using juce::FloatVectorOperations;
+using juce::HashMap;
+using juce::HeapBlock;
 using juce::MemoryBlock;
+using juce::OwnedArray;
 using juce::PluginDescription;
+using juce::ReferenceCountedObject;
+using juce::ReferenceCountedObjectPtr;
 using juce::String;
 using juce::jmin;
 using juce::jmax;
@@ -552,6 +560,232 @@ bool ExternalGraph::getGroupAndPortIdFromFullName(const char* const fullPortName
     return false;
 }
 
+// -----------------------------------------------------------------------
+// Graph worker threads, used by the parallel process modes
+//
+// The audio thread opens a cycle and wakes the workers, which only join it while it is still open.
+// Closing a cycle only waits for workers that joined it, so a worker that wakes up late (or failed
+// to start) never blocks the audio thread, which takes over the work that was not picked up.
+
+class GraphWorkerCallback
+{
+public:
+    virtual ~GraphWorkerCallback() {}
+    virtual void runGraphWorker(const uint index) noexcept = 0;
+};
+
+class GraphWorkerPool;
+
+class GraphWorkerThread : public CarlaThread
+{
+public:
+    GraphWorkerThread(GraphWorkerPool* const pool, const uint index) noexcept
+        : CarlaThread("GraphWorker"),
+          kPool(pool),
+          kIndex(index),
+          fSem(),
+          fWakePending(0),
+          fPriority(0),
+          fAppliedPriority(0)
+    {
+        carla_sem_create2(fSem);
+    }
+
+    ~GraphWorkerThread() override
+    {
+        carla_sem_destroy2(fSem);
+    }
+
+    void wakeUp() noexcept
+    {
+        // still pending if the previous wake up was not handled yet
+        if (__sync_bool_compare_and_swap(&fWakePending, 0, 1))
+            carla_sem_post(fSem);
+    }
+
+    // applied by the worker itself on its next wake up
+    void setRealtimePriority(const int priority) noexcept
+    {
+        fPriority = priority;
+    }
+
+    void signalToStop() noexcept
+    {
+        signalThreadShouldExit();
+        wakeUp();
+    }
+
+protected:
+    void run() override;
+
+private:
+    GraphWorkerPool* const kPool;
+    const uint kIndex;
+    carla_sem_t fSem;
+    volatile int fWakePending;
+    volatile int fPriority;
+    int fAppliedPriority;
+
+    CARLA_DECLARE_NON_COPY_CLASS(GraphWorkerThread)
+};
+
+class GraphWorkerPool
+{
+public:
+    GraphWorkerPool(GraphWorkerCallback* const callback, const uint numThreads)
+        : kCallback(callback),
+          fWorkers(),
+          fCycleOpen(0),
+          fWorkersActive(0),
+          fDeadline(0),
+          fHasAudioThread(false),
+          fAudioThread()
+    {
+        for (uint i=0; i<numThreads; ++i)
+        {
+            GraphWorkerThread* const worker(new GraphWorkerThread(this, static_cast<uint>(fWorkers.size())));
+
+            if (! worker->startThread())
+            {
+                carla_stderr2("GraphWorkerPool() - failed to start worker thread %u of %u", i+1, numThreads);
+                delete worker;
+                continue;
+            }
+
+            fWorkers.add(worker);
+        }
+    }
+
+    ~GraphWorkerPool()
+    {
+        for (int i=fWorkers.size(); --i >= 0;)
+            fWorkers.getUnchecked(i)->signalToStop();
+
+        for (int i=fWorkers.size(); --i >= 0;)
+            fWorkers.getUnchecked(i)->stopThread(-1);
+
+        fWorkers.clear();
+    }
+
+    // only threads that actually started are counted
+    int getNumWorkers() const noexcept
+    {
+        return fWorkers.size();
+    }
+
+    // -------------------------------------------------------------------
+    // realtime calls, audio thread
+
+    // the deadline is the duration of the block, after that workers get no new work
+    void beginCycle(const int frames, const double sampleRate) noexcept
+    {
+        updateRealtimePriority();
+
+        const double seconds(sampleRate > 0.0 ? static_cast<double>(frames) / sampleRate : 0.0);
+        fDeadline = juce::Time::getHighResolutionTicks() + static_cast<juce::int64>(seconds * static_cast<double>(juce::Time::getHighResolutionTicksPerSecond()));
+
+        __sync_bool_compare_and_swap(&fCycleOpen, 0, 1);
+
+        for (int i=fWorkers.size(); --i >= 0;)
+            fWorkers.getUnchecked(i)->wakeUp();
+    }
+
+    // to be called while the audio thread has nothing left to do but wait for workers
+    void waitForWorkers() noexcept
+    {
+        if (juce::Time::getHighResolutionTicks() < fDeadline)
+            return;
+
+        // too late, take over the remaining work and let busy workers run in case they share our CPU
+        __sync_bool_compare_and_swap(&fCycleOpen, 1, 0);
+        sched_yield();
+    }
+
+    // returns once all workers that joined this cycle are done
+    void endCycle() noexcept
+    {
+        __sync_bool_compare_and_swap(&fCycleOpen, 1, 0);
+
+        for (; __sync_fetch_and_add(&fWorkersActive, 0) != 0;)
+            waitForWorkers();
+    }
+
+    // workers should stop taking new work when this returns false
+    bool isCycleOpen() const noexcept
+    {
+        return (fCycleOpen != 0);
+    }
+
+    // -------------------------------------------------------------------
+    // worker threads
+
+    void runWorker(const uint index) noexcept
+    {
+        __sync_add_and_fetch(&fWorkersActive, 1);
+
+        if (__sync_fetch_and_add(&fCycleOpen, 0) != 0)
+            kCallback->runGraphWorker(index);
+
+        __sync_sub_and_fetch(&fWorkersActive, 1);
+    }
+
+private:
+    GraphWorkerCallback* const kCallback;
+    OwnedArray<GraphWorkerThread> fWorkers;
+
+    volatile int fCycleOpen;
+    volatile int fWorkersActive;
+    juce::int64 fDeadline;
+
+    // workers use the same priority as the engine audio thread
+    bool fHasAudioThread;
+    pthread_t fAudioThread;
+
+    void updateRealtimePriority() noexcept
+    {
+        const pthread_t self(pthread_self());
+
+        if (fHasAudioThread && pthread_equal(self, fAudioThread))
+            return;
+
+        fHasAudioThread = true;
+        fAudioThread = self;
+
+        const int priority(CarlaThread::getCurrentThreadRealtimePriority());
+
+        for (int i=fWorkers.size(); --i >= 0;)
+            fWorkers.getUnchecked(i)->setRealtimePriority(priority);
+    }
+
+    CARLA_DECLARE_NON_COPY_CLASS(GraphWorkerPool)
+};
+
+void GraphWorkerThread::run()
+{
+    for (; ! shouldThreadExit();)
+    {
+        if (! carla_sem_timedwait(fSem, 1000))
+            continue;
+
+        __sync_lock_release(&fWakePending);
+
+        if (shouldThreadExit())
+            break;
+
+        if (fAppliedPriority != fPriority)
+        {
+            const int priority(fPriority);
+
+            if (! CarlaThread::setCurrentThreadRealtimePriority(priority))
+                carla_stderr("GraphWorkerThread::run() - failed to set realtime priority %i", priority);
+
+            fAppliedPriority = priority;
+        }
+
+        kPool->runWorker(kIndex);
+    }
+}
+
 // -----------------------------------------------------------------------
 // RackGraph Buffers
 
@@ -564,12 +798,14 @@ RackGraph::Buffers::Buffers() noexcept
 #ifdef CARLA_PROPER_CPP11_SUPPORT
     , inBuf{nullptr, nullptr},
       inBufTmp{nullptr, nullptr},
-      outBuf{nullptr, nullptr} {}
+      outBuf{nullptr, nullptr},
+      outBufTmp{nullptr, nullptr} {}
 #else
     {
-        inBuf[0]    = inBuf[1]    = nullptr;
-        inBufTmp[0] = inBufTmp[1] = nullptr;
-        outBuf[0]   = outBuf[1]   = nullptr;
+        inBuf[0]     = inBuf[1]     = nullptr;
+        inBufTmp[0]  = inBufTmp[1]  = nullptr;
+        outBuf[0]    = outBuf[1]    = nullptr;
+        outBufTmp[0] = outBufTmp[1] = nullptr;
     }
 #endif
 
@@ -577,12 +813,14 @@ RackGraph::Buffers::~Buffers() noexcept
 {
     const CarlaRecursiveMutexLocker cml(mutex);
 
-    if (inBuf[0]    != nullptr) { delete[] inBuf[0];    inBuf[0]    = nullptr; }
-    if (inBuf[1]    != nullptr) { delete[] inBuf[1];    inBuf[1]    = nullptr; }
-    if (inBufTmp[0] != nullptr) { delete[] inBufTmp[0]; inBufTmp[0] = nullptr; }
-    if (inBufTmp[1] != nullptr) { delete[] inBufTmp[1]; inBufTmp[1] = nullptr; }
-    if (outBuf[0]   != nullptr) { delete[] outBuf[0];   outBuf[0]   = nullptr; }
-    if (outBuf[1]   != nullptr) { delete[] outBuf[1];   outBuf[1]   = nullptr; }
+    if (inBuf[0]     != nullptr) { delete[] inBuf[0];     inBuf[0]     = nullptr; }
+    if (inBuf[1]     != nullptr) { delete[] inBuf[1];     inBuf[1]     = nullptr; }
+    if (inBufTmp[0]  != nullptr) { delete[] inBufTmp[0];  inBufTmp[0]  = nullptr; }
+    if (inBufTmp[1]  != nullptr) { delete[] inBufTmp[1];  inBufTmp[1]  = nullptr; }
+    if (outBuf[0]    != nullptr) { delete[] outBuf[0];    outBuf[0]    = nullptr; }
+    if (outBuf[1]    != nullptr) { delete[] outBuf[1];    outBuf[1]    = nullptr; }
+    if (outBufTmp[0] != nullptr) { delete[] outBufTmp[0]; outBufTmp[0] = nullptr; }
+    if (outBufTmp[1] != nullptr) { delete[] outBufTmp[1]; outBufTmp[1] = nullptr; }
 
     connectedIn1.clear();
     connectedIn2.clear();
@@ -596,18 +834,22 @@ void RackGraph::Buffers::setBufferSize(const uint32_t bufferSize, const bool cre
 
     const CarlaRecursiveMutexLocker cml(mutex);
 
-    if (inBuf[0]    != nullptr) { delete[] inBuf[0];    inBuf[0]    = nullptr; }
-    if (inBuf[1]    != nullptr) { delete[] inBuf[1];    inBuf[1]    = nullptr; }
-    if (inBufTmp[0] != nullptr) { delete[] inBufTmp[0]; inBufTmp[0] = nullptr; }
-    if (inBufTmp[1] != nullptr) { delete[] inBufTmp[1]; inBufTmp[1] = nullptr; }
-    if (outBuf[0]   != nullptr) { delete[] outBuf[0];   outBuf[0]   = nullptr; }
-    if (outBuf[1]   != nullptr) { delete[] outBuf[1];   outBuf[1]   = nullptr; }
+    if (inBuf[0]     != nullptr) { delete[] inBuf[0];     inBuf[0]     = nullptr; }
+    if (inBuf[1]     != nullptr) { delete[] inBuf[1];     inBuf[1]     = nullptr; }
+    if (inBufTmp[0]  != nullptr) { delete[] inBufTmp[0];  inBufTmp[0]  = nullptr; }
+    if (inBufTmp[1]  != nullptr) { delete[] inBufTmp[1];  inBufTmp[1]  = nullptr; }
+    if (outBuf[0]    != nullptr) { delete[] outBuf[0];    outBuf[0]    = nullptr; }
+    if (outBuf[1]    != nullptr) { delete[] outBuf[1];    outBuf[1]    = nullptr; }
+    if (outBufTmp[0] != nullptr) { delete[] outBufTmp[0]; outBufTmp[0] = nullptr; }
+    if (outBufTmp[1] != nullptr) { delete[] outBufTmp[1]; outBufTmp[1] = nullptr; }
 
     CARLA_SAFE_ASSERT_RETURN(bufferSize > 0,);
 
     try {
-        inBufTmp[0] = new float[bufferSize];
-        inBufTmp[1] = new float[bufferSize];
+        inBufTmp[0]  = new float[bufferSize];
+        inBufTmp[1]  = new float[bufferSize];
+        outBufTmp[0] = new float[bufferSize];
+        outBufTmp[1] = new float[bufferSize];
 
         if (createBuffers)
         {
@@ -618,8 +860,10 @@ void RackGraph::Buffers::setBufferSize(const uint32_t bufferSize, const bool cre
         }
     }
     catch(...) {
-        if (inBufTmp[0] != nullptr) { delete[] inBufTmp[0]; inBufTmp[0] = nullptr; }
-        if (inBufTmp[1] != nullptr) { delete[] inBufTmp[1]; inBufTmp[1] = nullptr; }
+        if (inBufTmp[0]  != nullptr) { delete[] inBufTmp[0];  inBufTmp[0]  = nullptr; }
+        if (inBufTmp[1]  != nullptr) { delete[] inBufTmp[1];  inBufTmp[1]  = nullptr; }
+        if (outBufTmp[0] != nullptr) { delete[] outBufTmp[0]; outBufTmp[0] = nullptr; }
+        if (outBufTmp[1] != nullptr) { delete[] outBufTmp[1]; outBufTmp[1] = nullptr; }
 
         if (createBuffers)
         {
@@ -631,8 +875,10 @@ void RackGraph::Buffers::setBufferSize(const uint32_t bufferSize, const bool cre
         return;
     }
 
-    FloatVectorOperations::clear(inBufTmp[0], bufferSizei);
-    FloatVectorOperations::clear(inBufTmp[1], bufferSizei);
+    FloatVectorOperations::clear(inBufTmp[0],  bufferSizei);
+    FloatVectorOperations::clear(inBufTmp[1],  bufferSizei);
+    FloatVectorOperations::clear(outBufTmp[0], bufferSizei);
+    FloatVectorOperations::clear(outBufTmp[1], bufferSizei);
 
     if (createBuffers)
     {
@@ -643,6 +889,256 @@ void RackGraph::Buffers::setBufferSize(const uint32_t bufferSize, const bool cre
     }
 }
 
+// -----------------------------------------------------------------------
+// RackGraph pipeline
+//
+// Each stage runs a contiguous slice of the rack in its own thread (stage 0 in the audio thread).
+// A block enters the first stage and moves one stage further per engine cycle, so all stages
+// are busy with different blocks at the same time, at the cost of one buffer of latency per extra stage.
+// All blocks in flight share the same plugin list, the pipeline is flushed when it changes.
+
+struct RackGraph::ProcessState {
+    float* audioIn[2];
+    float* audioOut[2];
+    float* audioTmp[2];
+    EngineEventBuffer* eventsIn;
+    EngineEventBuffer* eventsOut;
+    uint32_t oldMidiOutCount;
+    bool processed;
+};
+
+struct RackPipelineBlock {
+    RackGraph::ProcessState state;
+    HeapBlock<float> audio;
+    EngineEventBuffer eventsIn;
+    EngineEventBuffer eventsOut;
+    uint32_t frames;
+    bool valid;
+
+    // rack and transport as they were when the block entered
+    CarlaPlugin* plugins[MAX_RACK_PLUGINS];
+    uint pluginCount;
+    EngineTimeInfo timeInfo;
+
+    RackPipelineBlock() noexcept
+        : audio(),
+          eventsIn(),
+          eventsOut(),
+          frames(0),
+          valid(false),
+          pluginCount(0),
+          timeInfo()
+    {
+        carla_zeroStruct(state);
+        carla_zeroStructs(plugins, MAX_RACK_PLUGINS);
+    }
+
+    ~RackPipelineBlock() noexcept
+    {
+        eventsIn.deallocate();
+        eventsOut.deallocate();
+    }
+
+    CARLA_DECLARE_NON_COPY_STRUCT(RackPipelineBlock)
+};
+
+class RackPipeline : public GraphWorkerCallback
+{
+public:
+    // stages without a worker thread are run by the audio thread, the latency stays the same
+    RackPipeline(RackGraph* const rack, const uint numStages)
+        : kRack(rack),
+          fWorkers(this, numStages-1),
+          kNumStages(numStages),
+          fBlocks(),
+          fStageClaims(),
+          fData(nullptr),
+          fCycle(0),
+          fPluginsVersion(0)
+    {
+        for (uint i=0; i<kNumStages; ++i)
+            fBlocks.add(new RackPipelineBlock());
+
+        fStageClaims.calloc(kNumStages);
+    }
+
+    // -------------------------------------------------------------------
+    // non-realtime calls
+
+    void setBufferSize(const uint32_t bufferSize)
+    {
+        for (int i=fBlocks.size(); --i >= 0;)
+        {
+            RackPipelineBlock* const block(fBlocks.getUnchecked(i));
+
+            block->valid = false;
+            block->audio.calloc(bufferSize*6);
+            block->eventsIn.allocate(bufferSize);
+            block->eventsOut.allocate(bufferSize);
+
+            block->state.audioIn[0]  = block->audio;
+            block->state.audioIn[1]  = block->audio + bufferSize;
+            block->state.audioOut[0] = block->audio + bufferSize*2;
+            block->state.audioOut[1] = block->audio + bufferSize*3;
+            block->state.audioTmp[0] = block->audio + bufferSize*4;
+            block->state.audioTmp[1] = block->audio + bufferSize*5;
+            block->state.eventsIn    = &block->eventsIn;
+            block->state.eventsOut   = &block->eventsOut;
+        }
+    }
+
+    uint32_t getLatency(const uint32_t bufferSize) const noexcept
+    {
+        return (kNumStages-1)*bufferSize;
+    }
+
+    // -------------------------------------------------------------------
+    // realtime calls
+
+    void process(CarlaEngine::ProtectedData* const data, const float* inBuf[2], float* outBuf[2], const uint32_t frames) noexcept
+    {
+        const int iframes(static_cast<int>(frames));
+
+        fData = data;
+        fCycle = (fCycle+1) % kNumStages;
+
+        // first stage takes a new block
+        {
+            RackPipelineBlock* const block(fBlocks.getUnchecked(static_cast<int>(fCycle)));
+            RackGraph::ProcessState& state(block->state);
+
+            block->pluginCount = jmin(data->curPluginCount, MAX_RACK_PLUGINS);
+
+            for (uint i=0; i < block->pluginCount; ++i)
+                block->plugins[i] = data->plugins[i].plugin;
+
+            // blocks still in flight may use plugins that are gone, and their stage ranges no longer match
+            if (pluginsChanged(data, block))
+            {
+                for (int i=fBlocks.size(); --i >= 0;)
+                {
+                    if (i != static_cast<int>(fCycle))
+                        fBlocks.getUnchecked(i)->valid = false;
+                }
+            }
+
+            block->timeInfo = data->timeInfo;
+
+            FloatVectorOperations::copy(state.audioIn[0], inBuf[0], iframes);
+            FloatVectorOperations::copy(state.audioIn[1], inBuf[1], iframes);
+            state.eventsIn->copyFrom(data->events.in);
+            state.eventsOut->clear();
+
+            state.oldMidiOutCount = 0;
+            state.processed = false;
+
+            block->frames = frames;
+            block->valid  = true;
+        }
+
+        for (uint i=0; i<kNumStages; ++i)
+            fStageClaims[i] = 0;
+
+        fWorkers.beginCycle(iframes, data->sampleRate);
+
+        // first stage runs here, followed by any stage that a worker did not pick up yet
+        for (uint i=0; i<kNumStages; ++i)
+            runStage(i);
+
+        fWorkers.endCycle();
+
+        // last stage has finished the oldest block
+        const RackPipelineBlock* const block(fBlocks.getUnchecked(static_cast<int>((fCycle+1) % kNumStages)));
+
+        if (block->valid && block->frames == frames)
+        {
+            if (block->state.processed)
+            {
+                FloatVectorOperations::copy(outBuf[0], block->state.audioOut[0], iframes);
+                FloatVectorOperations::copy(outBuf[1], block->state.audioOut[1], iframes);
+            }
+            else
+            {
+                FloatVectorOperations::clear(outBuf[0], iframes);
+                FloatVectorOperations::clear(outBuf[1], iframes);
+            }
+
+            data->events.out.copyFrom(*block->state.eventsOut);
+        }
+        else
+        {
+            FloatVectorOperations::clear(outBuf[0], iframes);
+            FloatVectorOperations::clear(outBuf[1], iframes);
+            data->events.out.clear();
+        }
+    }
+
+protected:
+    void runGraphWorker(const uint index) noexcept override
+    {
+        runStage(index+1);
+    }
+
+private:
+    void runStage(const uint stage) noexcept
+    {
+        if (! __sync_bool_compare_and_swap(&fStageClaims[stage], 0, 1))
+            return;
+
+        RackPipelineBlock* const block(fBlocks.getUnchecked(static_cast<int>((fCycle + kNumStages - stage) % kNumStages)));
+
+        if (! block->valid)
+            return;
+
+        const uint count(block->pluginCount);
+        const uint first(stage*count/kNumStages);
+        const uint last((stage+1)*count/kNumStages);
+
+        const ScopedThreadTimeInfo stti(block->timeInfo);
+
+        kRack->processPlugins(fData, block->state, block->plugins + first, last - first, block->frames);
+    }
+
+    // compares the new block against the previous one, a new plugin can have the address of a deleted one,
+    // so the engine plugins version is checked too
+    bool pluginsChanged(CarlaEngine::ProtectedData* const data, const RackPipelineBlock* const newBlock) noexcept
+    {
+        const uint pluginsVersion(__sync_fetch_and_add(&data->pluginsVersion, 0));
+
+        if (pluginsVersion != fPluginsVersion)
+        {
+            fPluginsVersion = pluginsVersion;
+            return true;
+        }
+
+        const RackPipelineBlock* const block(fBlocks.getUnchecked(static_cast<int>((fCycle + kNumStages - 1) % kNumStages)));
+
+        if (block->pluginCount != newBlock->pluginCount)
+            return true;
+
+        for (uint i=0; i < block->pluginCount; ++i)
+        {
+            if (block->plugins[i] != newBlock->plugins[i])
+                return true;
+        }
+
+        return false;
+    }
+
+    RackGraph* const kRack;
+    GraphWorkerPool fWorkers;
+    const uint kNumStages;
+
+    OwnedArray<RackPipelineBlock> fBlocks;
+    HeapBlock<int> fStageClaims;
+
+    CarlaEngine::ProtectedData* fData;
+    uint fCycle;
+    uint fPluginsVersion;
+
+    CARLA_DECLARE_NON_COPY_CLASS(RackPipeline)
+};
+
 // -----------------------------------------------------------------------
 // RackGraph
 
@@ -651,20 +1147,43 @@ RackGraph::RackGraph(CarlaEngine* const engine, const uint32_t ins, const uint32
       inputs(ins),
       outputs(outs),
       isOffline(false),
+      pipeline(nullptr),
       audioBuffers(),
       kEngine(engine)
 {
+    const uint pipelineStages(engine->getOptions().rackPipelineStages);
+
+    if (pipelineStages > 1)
+    {
+        try {
+            pipeline = new RackPipeline(this, pipelineStages);
+        } CARLA_SAFE_EXCEPTION("RackPipeline");
+    }
+
     setBufferSize(engine->getBufferSize());
 }
 
 RackGraph::~RackGraph() noexcept
 {
+    if (pipeline != nullptr)
+    {
+        delete pipeline;
+        pipeline = nullptr;
+    }
+
     extGraph.clear();
 }
 
 void RackGraph::setBufferSize(const uint32_t bufferSize) noexcept
 {
     audioBuffers.setBufferSize(bufferSize, (inputs > 0 || outputs > 0));
+
+    if (pipeline != nullptr && bufferSize > 0)
+    {
+        try {
+            pipeline->setBufferSize(bufferSize);
+        } CARLA_SAFE_EXCEPTION("RackPipeline::setBufferSize");
+    }
 }
 
 void RackGraph::setOffline(const bool offline) noexcept
@@ -672,6 +1191,14 @@ void RackGraph::setOffline(const bool offline) noexcept
     isOffline = offline;
 }
 
+uint32_t RackGraph::getLatency() const noexcept
+{
+    if (pipeline == nullptr)
+        return 0;
+
+    return pipeline->getLatency(kEngine->getBufferSize());
+}
+
 bool RackGraph::connect(const uint groupA, const uint portA, const uint groupB, const uint portB) noexcept
 {
     return extGraph.connect(groupA, portA, groupB, portB, true);
@@ -770,84 +1297,161 @@ bool RackGraph::getGroupAndPortIdFromFullName(const char* const fullPortName, ui
 void RackGraph::process(CarlaEngine::ProtectedData* const data, const float* inBufReal[2], float* outBuf[2], const uint32_t frames)
 {
     CARLA_SAFE_ASSERT_RETURN(data != nullptr,);
-    CARLA_SAFE_ASSERT_RETURN(data->events.in != nullptr,);
-    CARLA_SAFE_ASSERT_RETURN(data->events.out != nullptr,);
 
+    if (pipeline != nullptr)
+        return pipeline->process(data, inBufReal, outBuf, frames);
+
+    CARLA_SAFE_ASSERT_RETURN(audioBuffers.inBufTmp[1] != nullptr,);
+    CARLA_SAFE_ASSERT_RETURN(frames <= kEngine->getBufferSize(),);
+
+    const int iframes(static_cast<int>(frames));
+
+    // safe copy, input and output might be the same buffers
+    FloatVectorOperations::copy(audioBuffers.inBufTmp[0], inBufReal[0], iframes);
+    FloatVectorOperations::copy(audioBuffers.inBufTmp[1], inBufReal[1], iframes);
+
+    processBuffers(data, audioBuffers.inBufTmp, outBuf, frames);
+}
+
+void RackGraph::processBuffers(CarlaEngine::ProtectedData* const data, float* inBuf[2], float* outBuf[2], const uint32_t frames)
+{
+    CARLA_SAFE_ASSERT_RETURN(data != nullptr,);
+    CARLA_SAFE_ASSERT_RETURN(data->events.in.data != nullptr,);
+    CARLA_SAFE_ASSERT_RETURN(data->events.out.data != nullptr,);
+    CARLA_SAFE_ASSERT_RETURN(audioBuffers.outBufTmp[1] != nullptr,);
+
+    // initialize event outputs
+    data->events.out.clear();
+
+    ProcessState state;
+    state.audioIn[0]  = inBuf[0];
+    state.audioIn[1]  = inBuf[1];
+    state.audioOut[0] = outBuf[0];
+    state.audioOut[1] = outBuf[1];
+    state.audioTmp[0] = audioBuffers.outBufTmp[0];
+    state.audioTmp[1] = audioBuffers.outBufTmp[1];
+    state.eventsIn    = &data->events.in;
+    state.eventsOut   = &data->events.out;
+    state.oldMidiOutCount = 0;
+    state.processed = false;
+
+    CarlaPlugin* plugins[MAX_RACK_PLUGINS];
+    const uint pluginCount(jmin(data->curPluginCount, MAX_RACK_PLUGINS));
+
+    for (uint i=0; i < pluginCount; ++i)
+        plugins[i] = data->plugins[i].plugin;
+
+    processPlugins(data, state, plugins, pluginCount, frames);
+
+    // nothing ran, output is silent
+    if (! state.processed)
+    {
+        FloatVectorOperations::clear(outBuf[0], static_cast<int>(frames));
+        FloatVectorOperations::clear(outBuf[1], static_cast<int>(frames));
+    }
+}
+
+void RackGraph::processPlugins(CarlaEngine::ProtectedData* const data, ProcessState& state, CarlaPlugin* const* const plugins, const uint count, const uint32_t frames)
+{
     const int iframes(static_cast<int>(frames));
 
-    // safe copy
-    float inBuf0[frames];
-    float inBuf1[frames];
-    const float* inBuf[2] = { inBuf0, inBuf1 };
+    // Audio ping-pongs between buffers instead of being copied from one plugin to the next.
+    // The plugins that will run are counted first, so that the last one writes straight into audioOut.
+    uint remaining = 0;
 
-    // initialize audio inputs
-    FloatVectorOperations::copy(inBuf0, inBufReal[0], iframes);
-    FloatVectorOperations::copy(inBuf1, inBufReal[1], iframes);
+    for (uint i=0; i < count; ++i)
+    {
+        CarlaPlugin* const plugin = plugins[i];
 
-    // initialize audio outputs (zero)
-    FloatVectorOperations::clear(outBuf[0], iframes);
-    FloatVectorOperations::clear(outBuf[1], iframes);
+        if (plugin != nullptr && plugin->isEnabled())
+            ++remaining;
+    }
 
-    // initialize event outputs (zero)
-    carla_zeroStructs(data->events.out, kMaxEngineEventInternalCount);
+    // buffers holding the current signal
+    float** curBuf(state.processed ? state.audioOut : state.audioIn);
 
     uint32_t oldAudioInCount  = 0;
     uint32_t oldAudioOutCount = 0;
-    uint32_t oldMidiOutCount  = 0;
-    bool processed = false;
     juce::Range<float> range;
 
     // process plugins
-    for (uint i=0; i < data->curPluginCount; ++i)
+    for (uint i=0; i < count; ++i)
     {
-        CarlaPlugin* const plugin = data->plugins[i].plugin;
+        CarlaPlugin* const plugin = plugins[i];
 
-        if (plugin == nullptr || ! plugin->isEnabled() || ! plugin->tryLock(isOffline))
+        if (plugin == nullptr || ! plugin->isEnabled())
             continue;
 
-        if (processed)
-        {
-            // initialize audio inputs (from previous outputs)
-            FloatVectorOperations::copy(inBuf0, outBuf[0], iframes);
-            FloatVectorOperations::copy(inBuf1, outBuf[1], iframes);
+        --remaining;
 
-            // initialize audio outputs (zero)
-            FloatVectorOperations::clear(outBuf[0], iframes);
-            FloatVectorOperations::clear(outBuf[1], iframes);
+        if (! plugin->tryLock(isOffline))
+            continue;
+
+        // pick the buffers to write into, never the ones being read
+        float** outBuf;
+
+        if (remaining % 2 == 0 && curBuf != state.audioOut)
+            outBuf = state.audioOut;
+        else if (curBuf == state.audioIn)
+            outBuf = state.audioTmp;
+        else
+            outBuf = state.audioIn;
 
-            // if plugin has no midi out, add previous events
-            if (oldMidiOutCount == 0 && data->events.in[0].type != kEngineEventTypeNull)
+        const float* inBuf[2] = { curBuf[0], curBuf[1] };
+
+        if (state.processed)
+        {
+            // if plugin has no midi out, pass its input events through, merged with anything it did write
+            if (state.oldMidiOutCount == 0 && state.eventsIn->count != 0)
             {
-                if (data->events.out[0].type != kEngineEventTypeNull)
+                if (state.eventsOut->count != 0)
                 {
-                    // TODO: carefully add to input, sorted events
+                    state.eventsIn->mergeFrom(*state.eventsOut);
+                    state.eventsOut->clear();
                 }
                 // else nothing needed
             }
             else
             {
                 // initialize event inputs from previous outputs
-                carla_copyStructs(data->events.in, data->events.out, kMaxEngineEventInternalCount);
+                state.eventsIn->copyFrom(*state.eventsOut);
 
-                // initialize event outputs (zero)
-                carla_zeroStructs(data->events.out, kMaxEngineEventInternalCount);
+                // initialize event outputs
+                state.eventsOut->clear();
             }
         }
 
         oldAudioInCount  = plugin->getAudioInCount();
         oldAudioOutCount = plugin->getAudioOutCount();
-        oldMidiOutCount  = plugin->getMidiOutCount();
+        state.oldMidiOutCount = plugin->getMidiOutCount();
+
+        // plugins write all of their outputs, the rest needs to be silent
+        if (oldAudioOutCount == 0)
+        {
+            FloatVectorOperations::clear(outBuf[0], iframes);
+            FloatVectorOperations::clear(outBuf[1], iframes);
+        }
 
         // process
         plugin->initBuffers();
-        plugin->process(inBuf, outBuf, nullptr, nullptr, frames);
+
+        // pipeline blocks have their own event buffers
+        if (state.eventsIn != &data->events.in)
+        {
+            if (CarlaEngineEventPort* const port = plugin->getDefaultEventInPort())
+                port->setInternalEventBuffer(state.eventsIn);
+            if (CarlaEngineEventPort* const port = plugin->getDefaultEventOutPort())
+                port->setInternalEventBuffer(state.eventsOut);
+        }
+
+        plugin->process(inBuf, outBuf, nullptr, nullptr, frames);
         plugin->unlock();
 
         // if plugin has no audio inputs, add input buffer
         if (oldAudioInCount == 0)
         {
-            FloatVectorOperations::add(outBuf[0], inBuf0, iframes);
-            FloatVectorOperations::add(outBuf[1], inBuf1, iframes);
+            FloatVectorOperations::add(outBuf[0], inBuf[0], iframes);
+            FloatVectorOperations::add(outBuf[1], inBuf[1], iframes);
         }
 
         // if plugin only has 1 output, copy it to the 2nd
@@ -856,16 +1460,19 @@ void RackGraph::process(CarlaEngine::ProtectedData* const data, const float* inB
             FloatVectorOperations::copy(outBuf[1], outBuf[0], iframes);
         }
 
-        // set peaks
+        // set peaks, by id since pipeline blocks keep their own list of plugins
+        const uint id(plugin->getId());
+
+        if (id < data->curPluginCount && data->plugins[id].plugin == plugin)
         {
-            EnginePluginData& pluginData(data->plugins[i]);
+            EnginePluginData& pluginData(data->plugins[id]);
 
             if (oldAudioInCount > 0)
             {
-                range = FloatVectorOperations::findMinAndMax(inBuf0, iframes);
+                range = FloatVectorOperations::findMinAndMax(inBuf[0], iframes);
                 pluginData.insPeak[0] = carla_maxLimited<float>(std::abs(range.getStart()), std::abs(range.getEnd()), 1.0f);
 
-                range = FloatVectorOperations::findMinAndMax(inBuf1, iframes);
+                range = FloatVectorOperations::findMinAndMax(inBuf[1], iframes);
                 pluginData.insPeak[1] = carla_maxLimited<float>(std::abs(range.getStart()), std::abs(range.getEnd()), 1.0f);
             }
             else
@@ -889,7 +1496,15 @@ void RackGraph::process(CarlaEngine::ProtectedData* const data, const float* inB
             }
         }
 
-        processed = true;
+        curBuf = outBuf;
+        state.processed = true;
+    }
+
+    // a busy plugin was skipped, signal ended up elsewhere
+    if (state.processed && curBuf != state.audioOut)
+    {
+        FloatVectorOperations::copy(state.audioOut[0], curBuf[0], iframes);
+        FloatVectorOperations::copy(state.audioOut[1], curBuf[1], iframes);
     }
 }
 
@@ -954,11 +1569,11 @@ void RackGraph::processHelper(CarlaEngine::ProtectedData* const data, const floa
         FloatVectorOperations::clear(audioBuffers.inBuf[1], iframes);
     }
 
-    FloatVectorOperations::clear(audioBuffers.outBuf[0], iframes);
-    FloatVectorOperations::clear(audioBuffers.outBuf[1], iframes);
-
-    // process
-    process(data, const_cast<const float**>(audioBuffers.inBuf), audioBuffers.outBuf, frames);
+    // process, our own input buffers can be used as scratch space
+    if (pipeline != nullptr)
+        pipeline->process(data, const_cast<const float**>(audioBuffers.inBuf), audioBuffers.outBuf, frames);
+    else
+        processBuffers(data, audioBuffers.inBuf, audioBuffers.outBuf, frames);
 
     // connect output buffers
     if (audioBuffers.connectedOut1.count() != 0)
@@ -1067,268 +1682,1218 @@ void addNodeToPatchbay(CarlaEngine* const engine, const uint32_t groupId, const
     CARLA_SAFE_ASSERT_RETURN(engine != nullptr,);
     CARLA_SAFE_ASSERT_RETURN(proc != nullptr,);
 
-    const int icon((clientId >= 0) ? PATCHBAY_ICON_PLUGIN : PATCHBAY_ICON_HARDWARE);
-    engine->callback(ENGINE_CALLBACK_PATCHBAY_CLIENT_ADDED, groupId, icon, clientId, 0.0f, proc->getName().toRawUTF8());
+    const int icon((clientId >= 0) ? PATCHBAY_ICON_PLUGIN : PATCHBAY_ICON_HARDWARE);
+    engine->callback(ENGINE_CALLBACK_PATCHBAY_CLIENT_ADDED, groupId, icon, clientId, 0.0f, proc->getName().toRawUTF8());
+
+    for (int i=0, numInputs=proc->getNumInputChannels(); i<numInputs; ++i)
+    {
+        engine->callback(ENGINE_CALLBACK_PATCHBAY_PORT_ADDED, groupId, static_cast<int>(kAudioInputPortOffset)+i,
+                         PATCHBAY_PORT_TYPE_AUDIO|PATCHBAY_PORT_IS_INPUT, 0.0f, proc->getInputChannelName(i).toRawUTF8());
+    }
+
+    for (int i=0, numOutputs=proc->getNumOutputChannels(); i<numOutputs; ++i)
+    {
+        engine->callback(ENGINE_CALLBACK_PATCHBAY_PORT_ADDED, groupId, static_cast<int>(kAudioOutputPortOffset)+i,
+                         PATCHBAY_PORT_TYPE_AUDIO, 0.0f, proc->getOutputChannelName(i).toRawUTF8());
+    }
+
+    if (proc->acceptsMidi())
+    {
+        engine->callback(ENGINE_CALLBACK_PATCHBAY_PORT_ADDED, groupId, static_cast<int>(kMidiInputPortOffset),
+                         PATCHBAY_PORT_TYPE_MIDI|PATCHBAY_PORT_IS_INPUT, 0.0f, "events-in");
+    }
+
+    if (proc->producesMidi())
+    {
+        engine->callback(ENGINE_CALLBACK_PATCHBAY_PORT_ADDED, groupId, static_cast<int>(kMidiOutputPortOffset),
+                         PATCHBAY_PORT_TYPE_MIDI, 0.0f, "events-out");
+    }
+}
+
+static inline
+void removeNodeFromPatchbay(CarlaEngine* const engine, const uint32_t groupId, const AudioProcessor* const proc)
+{
+    CARLA_SAFE_ASSERT_RETURN(engine != nullptr,);
+    CARLA_SAFE_ASSERT_RETURN(proc != nullptr,);
+
+    for (int i=0, numInputs=proc->getNumInputChannels(); i<numInputs; ++i)
+    {
+        engine->callback(ENGINE_CALLBACK_PATCHBAY_PORT_REMOVED, groupId, static_cast<int>(kAudioInputPortOffset)+i,
+                         0, 0.0f, nullptr);
+    }
+
+    for (int i=0, numOutputs=proc->getNumOutputChannels(); i<numOutputs; ++i)
+    {
+        engine->callback(ENGINE_CALLBACK_PATCHBAY_PORT_REMOVED, groupId, static_cast<int>(kAudioOutputPortOffset)+i,
+                         0, 0.0f, nullptr);
+    }
+
+    if (proc->acceptsMidi())
+    {
+        engine->callback(ENGINE_CALLBACK_PATCHBAY_PORT_REMOVED, groupId, static_cast<int>(kMidiInputPortOffset),
+                         0, 0.0f, nullptr);
+    }
+
+    if (proc->producesMidi())
+    {
+        engine->callback(ENGINE_CALLBACK_PATCHBAY_PORT_REMOVED, groupId, static_cast<int>(kMidiOutputPortOffset),
+                         0, 0.0f, nullptr);
+    }
+
+    engine->callback(ENGINE_CALLBACK_PATCHBAY_CLIENT_REMOVED, groupId, 0, 0, 0.0f, nullptr);
+}
+
+// -----------------------------------------------------------------------
+
+class CarlaPluginInstance : public AudioPluginInstance
+{
+public:
+    CarlaPluginInstance(CarlaEngine* const engine, CarlaPlugin* const plugin)
+        : kEngine(engine),
+          fPlugin(plugin)
+    {
+        setPlayConfigDetails(static_cast<int>(fPlugin->getAudioInCount()),
+                             static_cast<int>(fPlugin->getAudioOutCount()),
+                             getSampleRate(), getBlockSize());
+    }
+
+    ~CarlaPluginInstance() override
+    {
+    }
+
+    void invalidatePlugin() noexcept
+    {
+        fPlugin = nullptr;
+    }
+
+    // -------------------------------------------------------------------
+
+    void* getPlatformSpecificData() noexcept override
+    {
+        return fPlugin;
+    }
+
+    void fillInPluginDescription(PluginDescription& d) const override
+    {
+        d.pluginFormatName = "Carla";
+        d.category = "Carla Plugin";
+        d.version = "1.0";
+
+        CARLA_SAFE_ASSERT_RETURN(fPlugin != nullptr,);
+
+        char strBuf[STR_MAX+1];
+        strBuf[STR_MAX] = '\0';
+
+        fPlugin->getRealName(strBuf);
+        d.name = strBuf;
+
+        fPlugin->getLabel(strBuf);
+        d.descriptiveName = strBuf;
+
+        fPlugin->getMaker(strBuf);
+        d.manufacturerName = strBuf;
+
+        d.uid = d.name.hashCode();
+        d.isInstrument = (fPlugin->getHints() & PLUGIN_IS_SYNTH);
+
+        d.numInputChannels  = static_cast<int>(fPlugin->getAudioInCount());
+        d.numOutputChannels = static_cast<int>(fPlugin->getAudioOutCount());
+        //d.hasSharedContainer = true;
+    }
+
+    // -------------------------------------------------------------------
+
+    const String getName() const override
+    {
+        return fPlugin->getName();
+    }
+
+    void processBlock(AudioSampleBuffer& audio, MidiBuffer& midi)
+    {
+        if (fPlugin == nullptr || ! fPlugin->isEnabled())
+        {
+            audio.clear();
+            midi.clear();
+            return;
+        }
+
+        if (! fPlugin->tryLock(kEngine->isOffline()))
+        {
+            audio.clear();
+            midi.clear();
+            return;
+        }
+
+        const int numChan(audio.getNumChannels());
+        float* audioBuffers[numChan > 0 ? numChan : 1];
+
+        for (int i=0; i<numChan; ++i)
+            audioBuffers[i] = audio.getWritePointer(i);
+
+        processLocked(audioBuffers, audioBuffers, numChan, audio.getNumSamples(), midi);
+
+        fPlugin->unlock();
+    }
+
+    // the plugin must be enabled and locked by the caller, audio is processed in-place if inBuf == outBuf
+    void processLocked(float** const inBuf, float** const outBuf, const int numChan, const int numSamples, MidiBuffer& midi)
+    {
+        fPlugin->initBuffers();
+
+        if (CarlaEngineEventPort* const port = fPlugin->getDefaultEventInPort())
+        {
+            EngineEventBuffer* const engineEvents(port->fBuffer);
+            CARLA_SAFE_ASSERT_RETURN(engineEvents != nullptr,);
+
+            engineEvents->clear();
+            fillEngineEventsFromJuceMidiBuffer(*engineEvents, midi);
+        }
+
+        midi.clear();
+
+        // TODO - CV support
+
+        if (numChan > 0)
+        {
+            if (fPlugin->getAudioInCount() == 0)
+            {
+                for (int i=0; i<numChan; ++i)
+                    FloatVectorOperations::clear(inBuf[i], numSamples);
+            }
+
+            float inPeaks[2] = { 0.0f };
+            float outPeaks[2] = { 0.0f };
+            juce::Range<float> range;
+
+            for (int i=jmin(fPlugin->getAudioInCount(), 2U); --i>=0;)
+            {
+                range = FloatVectorOperations::findMinAndMax(inBuf[i], numSamples);
+                inPeaks[i] = carla_maxLimited<float>(std::abs(range.getStart()), std::abs(range.getEnd()), 1.0f);
+            }
+
+            fPlugin->process(const_cast<const float**>(inBuf), outBuf, nullptr, nullptr, static_cast<uint32_t>(numSamples));
+
+            for (int i=jmin(fPlugin->getAudioOutCount(), 2U); --i>=0;)
+            {
+                range = FloatVectorOperations::findMinAndMax(outBuf[i], numSamples);
+                outPeaks[i] = carla_maxLimited<float>(std::abs(range.getStart()), std::abs(range.getEnd()), 1.0f);
+            }
+
+            kEngine->setPluginPeaks(fPlugin->getId(), inPeaks, outPeaks);
+        }
+        else
+        {
+            fPlugin->process(nullptr, nullptr, nullptr, nullptr, static_cast<uint32_t>(numSamples));
+        }
+
+        midi.clear();
+
+        if (CarlaEngineEventPort* const port = fPlugin->getDefaultEventOutPort())
+        {
+            EngineEventBuffer* const engineEvents(port->fBuffer);
+            CARLA_SAFE_ASSERT_RETURN(engineEvents != nullptr,);
+
+            fillJuceMidiBufferFromEngineEvents(midi, *engineEvents);
+            engineEvents->clear();
+        }
+    }
+
+    CarlaPlugin* getPlugin() const noexcept
+    {
+        return fPlugin;
+    }
+
+    const String getInputChannelName(int i)  const override
+    {
+        CARLA_SAFE_ASSERT_RETURN(i >= 0, String());
+        CarlaEngineClient* const client(fPlugin->getEngineClient());
+        return client->getAudioPortName(true, static_cast<uint>(i));
+    }
+
+    const String getOutputChannelName(int i) const override
+    {
+        CARLA_SAFE_ASSERT_RETURN(i >= 0, String());
+        CarlaEngineClient* const client(fPlugin->getEngineClient());
+        return client->getAudioPortName(false, static_cast<uint>(i));
+    }
+
+    void prepareToPlay(double, int samplesPerBlock) override
+    {
+        CARLA_SAFE_ASSERT_RETURN(samplesPerBlock > 0,);
+
+        // event capacity grows with the buffer size
+        if (CarlaEngineEventPort* const port = fPlugin->getDefaultEventInPort())
+            if (port->fBuffer != nullptr)
+                port->fBuffer->allocate(static_cast<uint32_t>(samplesPerBlock));
+
+        if (CarlaEngineEventPort* const port = fPlugin->getDefaultEventOutPort())
+            if (port->fBuffer != nullptr)
+                port->fBuffer->allocate(static_cast<uint32_t>(samplesPerBlock));
+    }
+
+    void releaseResources() override {}
+
+    const String getParameterName(int)         override { return String(); }
+          String getParameterName(int, int)    override { return String(); }
+    const String getParameterText(int)         override { return String(); }
+          String getParameterText(int, int)    override { return String(); }
+    const String getProgramName(int)           override { return String(); }
+
+    double getTailLengthSeconds()        const override { return 0.0;  }
+    float  getParameter(int)                   override { return 0.0f; }
+
+    bool isInputChannelStereoPair(int)   const override { return false; }
+    bool isOutputChannelStereoPair(int)  const override { return false; }
+    bool silenceInProducesSilenceOut()   const override { return true;  }
+    bool acceptsMidi()                   const override { return fPlugin->getDefaultEventInPort()  != nullptr; }
+    bool producesMidi()                  const override { return fPlugin->getDefaultEventOutPort() != nullptr; }
+
+    void setParameter(int, float)              override {}
+    void setCurrentProgram(int)                override {}
+    void changeProgramName(int, const String&) override {}
+    void getStateInformation(MemoryBlock&)     override {}
+    void setStateInformation(const void*, int) override {}
+
+    int getNumParameters()                     override { return 0; }
+    int getNumPrograms()                       override { return 0; }
+    int getCurrentProgram()                    override { return 0; }
+
+#ifndef JUCE_AUDIO_PROCESSOR_NO_GUI
+    bool hasEditor()                     const override { return false; }
+    AudioProcessorEditor* createEditor()       override { return nullptr; }
+#endif
+
+    // -------------------------------------------------------------------
+
+private:
+    CarlaEngine* const kEngine;
+    CarlaPlugin* fPlugin;
+
+    CARLA_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CarlaPluginInstance)
+};
+
+// -----------------------------------------------------------------------
+// Patchbay Graph processing
+//
+// Carla runs the patchbay from its own process plan instead of the juce rendering ops.
+// The topological order of nodes is updated incrementally on every graph change (Pearce-Kelly),
+// and the resulting plan is published to the audio thread with an atomic pointer swap.
+// Old plans are reclaimed on a later change, once the audio thread is no longer using them,
+// so editing the graph never blocks processing.
+//
+// Each node has its own buffers, which lets independent nodes run in parallel when
+// ENGINE_OPTION_PROCESS_THREADS is set. Inputs are summed in connection order, so the result
+// does not depend on how many threads are used or on their timing.
+// Graphs with feedback loops have no topological order, the juce graph is used for those.
+// juce keeps updating its own rendering sequence, so it can take over at any time.
+
+enum PatchbayNodeType {
+    kPatchbayNodePlugin      = 0,
+    kPatchbayNodeAudioInput  = 1,
+    kPatchbayNodeAudioOutput = 2,
+    kPatchbayNodeMidiInput   = 3,
+    kPatchbayNodeMidiOutput  = 4
+};
+
+struct PatchbayNodeState : public ReferenceCountedObject {
+    typedef ReferenceCountedObjectPtr<PatchbayNodeState> Ptr;
+
+    struct Input {
+        PatchbayNodeState* source;
+        int sourceChannel;
+        int targetChannel;
+    };
+
+    const AudioProcessorGraph::Node::Ptr node;
+    CarlaPluginInstance* const instance; // null for io nodes
+    const PatchbayNodeType type;
+    const int numInputs;
+    const int numOutputs;
+
+    // audio is processed in-place, like in juce
+    const int numChannels;
+    HeapBlock<float>  buffer;
+    HeapBlock<float*> channels;
+    HeapBlock<bool>   channelsUsed;
+    MidiBuffer midi;
+
+    // where inputs are summed to and outputs are read from during a cycle.
+    // usually the same as 'channels', but plugins can provide their own port buffers (e.g. bridge shared memory)
+    HeapBlock<float*> inChannels;
+    HeapBlock<float*> outChannels;
+
+    // topology, only used in non-realtime calls
+    Array<Input> inputs;
+    Array<PatchbayNodeState*> outputs; // one entry per connection
+    int order;
+    int planIndex;
+    bool visited;
+
+    PatchbayNodeState(AudioProcessorGraph::Node* const n, const PatchbayNodeType t, const int ins, const int outs, const int bufferSize)
+        : node(n),
+          instance(dynamic_cast<CarlaPluginInstance*>(n->getProcessor())),
+          type(t),
+          numInputs(ins),
+          numOutputs(outs),
+          numChannels(jmax(1, jmax(ins, outs))),
+          buffer(),
+          channels(),
+          channelsUsed(),
+          midi(),
+          inChannels(),
+          outChannels(),
+          inputs(),
+          outputs(),
+          order(0),
+          planIndex(0),
+          visited(false)
+    {
+        buffer.calloc(static_cast<size_t>(numChannels*bufferSize));
+        channels.calloc(static_cast<size_t>(numChannels));
+        channelsUsed.calloc(static_cast<size_t>(numChannels));
+        inChannels.calloc(static_cast<size_t>(numChannels));
+        outChannels.calloc(static_cast<size_t>(numChannels));
+
+        for (int i=0; i<numChannels; ++i)
+            channels[i] = inChannels[i] = outChannels[i] = buffer + i*bufferSize;
+
+        midi.ensureSize(kMaxEngineEventInternalCount*2);
+    }
+
+    CARLA_DECLARE_NON_COPY_STRUCT(PatchbayNodeState)
+};
+
+struct PatchbayPlanNode {
+    const PatchbayNodeState::Ptr state;
+    Array<PatchbayNodeState::Input> inputs;
+
+    // nodes that need this one to finish first
+    Array<int> dependents;
+    int numDependencies;
+    volatile int pendingDependencies;
+
+    PatchbayPlanNode(PatchbayNodeState* const s)
+        : state(s),
+          inputs(s->inputs),
+          dependents(),
+          numDependencies(0),
+          pendingDependencies(0) {}
+
+    CARLA_DECLARE_NON_COPY_STRUCT(PatchbayPlanNode)
+};
+
+struct PatchbayProcessPlan {
+    OwnedArray<PatchbayPlanNode> nodes; // in topological order
+    Array<int> rootNodes;
+    HeapBlock<int> readyQueue;
+    PatchbayNodeState* audioOutput;
+    PatchbayNodeState* midiOutput;
+    const int bufferSize;
+
+    PatchbayProcessPlan(const int bufSize)
+        : nodes(),
+          rootNodes(),
+          readyQueue(),
+          audioOutput(nullptr),
+          midiOutput(nullptr),
+          bufferSize(bufSize) {}
+
+    CARLA_DECLARE_NON_COPY_STRUCT(PatchbayProcessPlan)
+};
+
+// -----------------------------------------------------------------------
+
+class PatchbayProcessor : public GraphWorkerCallback
+{
+public:
+    PatchbayProcessor(const uint numThreads, const uint32_t inputs, const uint32_t outputs)
+        : kInputs(static_cast<int>(inputs)),
+          kOutputs(static_cast<int>(outputs)),
+          fNodes(),
+          fBufferSize(0),
+          fIsAcyclic(true),
+          fPlan(nullptr),
+          fPlanInUse(nullptr),
+          fRetiredPlans(),
+          fWorkers(this, numThreads),
+          fCurrentPlan(nullptr),
+          fInBuf(nullptr),
+          fMidiIn(nullptr),
+          fFrames(0),
+          fQueueRead(0),
+          fQueueWrite(0),
+          fNodesLeft(0) {}
+
+    ~PatchbayProcessor() override
+    {
+        // audio thread is stopped by now
+        if (fPlan != nullptr)
+        {
+            delete fPlan;
+            fPlan = nullptr;
+        }
+
+        fPlanInUse = nullptr;
+        reclaimPlans();
+
+        clearTopology();
+    }
+
+    // -------------------------------------------------------------------
+    // non-realtime calls, graph changes
+
+    // recreate everything from the juce graph, needed when buffer size changes or connections are validated
+    void rebuild(AudioProcessorGraph& graph, const int bufferSize)
+    {
+        CARLA_SAFE_ASSERT_RETURN(bufferSize > 0,);
+
+        clearTopology();
+        fBufferSize = bufferSize;
+
+        for (int i=0, count=graph.getNumNodes(); i<count; ++i)
+        {
+            if (AudioProcessorGraph::Node* const node = graph.getNode(i))
+                addNode(node);
+        }
+
+        for (int i=0, count=graph.getNumConnections(); i<count; ++i)
+        {
+            const AudioProcessorGraph::Connection* const conn(graph.getConnection(i));
+            CARLA_SAFE_ASSERT_CONTINUE(conn != nullptr);
+
+            PatchbayNodeState* const source(findNode(conn->sourceNodeId));
+            PatchbayNodeState* const target(findNode(conn->destNodeId));
+            CARLA_SAFE_ASSERT_CONTINUE(source != nullptr && target != nullptr);
+
+            if (isValidConnection(source, conn->sourceChannelIndex, target, conn->destChannelIndex))
+                addEdge(source, conn->sourceChannelIndex, target, conn->destChannelIndex);
+        }
+
+        computeOrder();
+    }
+
+    void addNode(AudioProcessorGraph::Node* const node)
+    {
+        CARLA_SAFE_ASSERT_RETURN(node != nullptr,);
+        CARLA_SAFE_ASSERT_RETURN(fBufferSize > 0,);
+
+        AudioProcessor* const proc(node->getProcessor());
+        CARLA_SAFE_ASSERT_RETURN(proc != nullptr,);
+
+        PatchbayNodeType type = kPatchbayNodePlugin;
+        int numInputs  = proc->getNumInputChannels();
+        int numOutputs = proc->getNumOutputChannels();
+
+        // io nodes only know their channel count after juce prepares them
+        if (AudioProcessorGraph::AudioGraphIOProcessor* const ioProc = dynamic_cast<AudioProcessorGraph::AudioGraphIOProcessor*>(proc))
+        {
+            numInputs = numOutputs = 0;
+
+            switch (ioProc->getType())
+            {
+            case AudioProcessorGraph::AudioGraphIOProcessor::audioInputNode:
+                type = kPatchbayNodeAudioInput;
+                numOutputs = kInputs;
+                break;
+            case AudioProcessorGraph::AudioGraphIOProcessor::audioOutputNode:
+                type = kPatchbayNodeAudioOutput;
+                numInputs = kOutputs;
+                break;
+            case AudioProcessorGraph::AudioGraphIOProcessor::midiInputNode:
+                type = kPatchbayNodeMidiInput;
+                break;
+            case AudioProcessorGraph::AudioGraphIOProcessor::midiOutputNode:
+                type = kPatchbayNodeMidiOutput;
+                break;
+            }
+        }
+
+        // new nodes have no connections yet, so they can go last
+        PatchbayNodeState* const state(new PatchbayNodeState(node, type, numInputs, numOutputs, fBufferSize));
+        state->incReferenceCount();
+        state->order = fNodes.size();
+        fNodes.add(state);
+    }
+
+    void removeNode(const uint32_t nodeId)
+    {
+        PatchbayNodeState* const state(findNode(nodeId));
+        CARLA_SAFE_ASSERT_RETURN(state != nullptr,);
+
+        // juce removes the node connections too
+        for (int i=state->inputs.size(); --i >= 0;)
+        {
+            PatchbayNodeState* const source(state->inputs.getReference(i).source);
+            source->outputs.removeFirstMatchingValue(state);
+        }
+
+        for (int i=state->outputs.size(); --i >= 0;)
+        {
+            PatchbayNodeState* const target(state->outputs.getUnchecked(i));
+
+            for (int j=target->inputs.size(); --j >= 0;)
+            {
+                if (target->inputs.getReference(j).source == state)
+                    target->inputs.remove(j);
+            }
+        }
+
+        state->inputs.clear();
+        state->outputs.clear();
+
+        // removing keeps the order valid
+        fNodes.remove(state->order);
+
+        for (int i=state->order, count=fNodes.size(); i<count; ++i)
+            fNodes.getUnchecked(i)->order = i;
+
+        // plans might still use it
+        state->decReferenceCount();
+
+        if (! fIsAcyclic)
+            computeOrder();
+    }
+
+    void addConnection(const uint32_t sourceNodeId, const int sourceChannel, const uint32_t targetNodeId, const int targetChannel)
+    {
+        PatchbayNodeState* const source(findNode(sourceNodeId));
+        PatchbayNodeState* const target(findNode(targetNodeId));
+        CARLA_SAFE_ASSERT_RETURN(source != nullptr && target != nullptr,);
+
+        if (! isValidConnection(source, sourceChannel, target, targetChannel))
+            return;
+
+        addEdge(source, sourceChannel, target, targetChannel);
+
+        if (fIsAcyclic)
+            fIsAcyclic = reorderForEdge(source, target);
+    }
+
+    void removeConnection(const uint32_t sourceNodeId, const int sourceChannel, const uint32_t targetNodeId, const int targetChannel)
+    {
+        PatchbayNodeState* const source(findNode(sourceNodeId));
+        PatchbayNodeState* const target(findNode(targetNodeId));
+        CARLA_SAFE_ASSERT_RETURN(source != nullptr && target != nullptr,);
+
+        for (int i=target->inputs.size(); --i >= 0;)
+        {
+            const PatchbayNodeState::Input& input(target->inputs.getReference(i));
+
+            if (input.source != source || input.sourceChannel != sourceChannel || input.targetChannel != targetChannel)
+                continue;
+
+            target->inputs.remove(i);
+            source->outputs.removeFirstMatchingValue(target);
+
+            // removing keeps the order valid, but might break a loop
+            if (! fIsAcyclic)
+                computeOrder();
+            return;
+        }
+    }
+
+    // make the current topology visible to the audio thread
+    // without a usable plan (feedback loops) juce processing is used
+    void publish()
+    {
+        PatchbayProcessPlan* plan(nullptr);
+
+        if (fIsAcyclic && fBufferSize > 0)
+        {
+            plan = new PatchbayProcessPlan(fBufferSize);
+
+            for (int i=0, count=fNodes.size(); i<count; ++i)
+            {
+                PatchbayNodeState* const state(fNodes.getUnchecked(i));
+                state->planIndex = i;
+                plan->nodes.add(new PatchbayPlanNode(state));
+
+                if (state->type == kPatchbayNodeAudioOutput)
+                    plan->audioOutput = state;
+                else if (state->type == kPatchbayNodeMidiOutput)
+                    plan->midiOutput = state;
+            }
+
+            for (int i=0, count=fNodes.size(); i<count; ++i)
+            {
+                const PatchbayNodeState* const state(fNodes.getUnchecked(i));
+                PatchbayPlanNode* const planNode(plan->nodes.getUnchecked(i));
+
+                for (int j=0, numOutputs=state->outputs.size(); j<numOutputs; ++j)
+                {
+                    const int dependent(state->outputs.getUnchecked(j)->planIndex);
+
+                    if (planNode->dependents.contains(dependent))
+                        continue;
+
+                    planNode->dependents.add(dependent);
+                    ++plan->nodes.getUnchecked(dependent)->numDependencies;
+                }
+            }
+
+            for (int i=0, count=plan->nodes.size(); i<count; ++i)
+            {
+                if (plan->nodes.getUnchecked(i)->numDependencies == 0)
+                    plan->rootNodes.add(i);
+            }
+
+            plan->readyQueue.calloc(static_cast<size_t>(jmax(1, plan->nodes.size())));
+
+            if (plan->audioOutput == nullptr || plan->midiOutput == nullptr)
+            {
+                delete plan;
+                plan = nullptr;
+            }
+        }
+        else if (! fIsAcyclic)
+        {
+            carla_stderr("PatchbayProcessor::publish() - graph has feedback loops, using juce processing");
+        }
+
+        PatchbayProcessPlan* const oldPlan(__sync_lock_test_and_set(&fPlan, plan));
+        __sync_synchronize();
+
+        if (oldPlan != nullptr)
+            fRetiredPlans.add(oldPlan);
+
+        reclaimPlans();
+    }
+
+    // -------------------------------------------------------------------
+    // realtime calls
+
+    // returns false if there's no usable plan, in which case the caller should use juce processing
+    bool process(const float* const* const inBuf, const uint32_t inputs, float* const* const outBuf, const uint32_t outputs, MidiBuffer& midi, const int frames, const double sampleRate) noexcept
+    {
+        PatchbayProcessPlan* plan;
+
+        // mark the plan as used before the writer can retire it
+        for (;;)
+        {
+            plan = fPlan;
+            fPlanInUse = plan;
+            __sync_synchronize();
+
+            if (plan == fPlan)
+                break;
+        }
+
+        if (plan == nullptr || frames > plan->bufferSize)
+        {
+            __sync_lock_release(&fPlanInUse);
+            return false;
+        }
+
+        fCurrentPlan = plan;
+        fInBuf  = inBuf;
+        fInputs = inputs;
+        fMidiIn = &midi;
+        fFrames = frames;
+
+        const int numNodes(plan->nodes.size());
+
+        if (fWorkers.getNumWorkers() == 0)
+        {
+            for (int i=0; i<numNodes; ++i)
+                processNode(*plan->nodes.getUnchecked(i));
+        }
+        else
+        {
+            for (int i=0; i<numNodes; ++i)
+            {
+                PatchbayPlanNode* const node(plan->nodes.getUnchecked(i));
+                node->pendingDependencies = node->numDependencies;
+                plan->readyQueue[i] = -1;
+            }
+
+            fQueueRead  = 0;
+            fQueueWrite = 0;
+            fNodesLeft  = numNodes;
+
+            for (int i=0, count=plan->rootNodes.size(); i<count; ++i)
+                pushReadyNode(plan->rootNodes.getUnchecked(i));
+
+            fWorkers.beginCycle(frames, sampleRate);
+
+            // the calling thread works too, and finishes what workers do not pick up in time
+            runNodes(true);
+
+            // wait for workers to leave this cycle, so the next one can safely reset the queue
+            fWorkers.endCycle();
+        }
+
+        const PatchbayNodeState* const audioOut(plan->audioOutput);
+
+        for (uint32_t i=0; i < outputs; ++i)
+        {
+            if (static_cast<int>(i) < audioOut->numChannels)
+                FloatVectorOperations::copy(outBuf[i], audioOut->channels[i], frames);
+            else
+                FloatVectorOperations::clear(outBuf[i], frames);
+        }
+
+        midi.clear();
+        midi.addEvents(plan->midiOutput->midi, 0, frames, 0);
+
+        fCurrentPlan = nullptr;
+        __sync_lock_release(&fPlanInUse);
+        return true;
+    }
+
+protected:
+    void runGraphWorker(const uint) noexcept override
+    {
+        runNodes(false);
+    }
+
+private:
+    // -------------------------------------------------------------------
+    // topology
+
+    PatchbayNodeState* findNode(const uint32_t nodeId) const noexcept
+    {
+        for (int i=0, count=fNodes.size(); i<count; ++i)
+        {
+            PatchbayNodeState* const state(fNodes.getUnchecked(i));
+
+            if (state->node->nodeId == nodeId)
+                return state;
+        }
+
+        return nullptr;
+    }
+
+    // ignore connections juce would not render either
+    static bool isValidConnection(const PatchbayNodeState* const source, const int sourceChannel,
+                                  const PatchbayNodeState* const target, const int targetChannel) noexcept
+    {
+        if (sourceChannel == AudioProcessorGraph::midiChannelIndex)
+            return (targetChannel == AudioProcessorGraph::midiChannelIndex);
+
+        return (sourceChannel >= 0 && sourceChannel < source->numOutputs &&
+                targetChannel >= 0 && targetChannel < target->numInputs);
+    }
+
+    static void addEdge(PatchbayNodeState* const source, const int sourceChannel, PatchbayNodeState* const target, const int targetChannel)
+    {
+        const PatchbayNodeState::Input input = { source, sourceChannel, targetChannel };
+
+        target->inputs.add(input);
+        source->outputs.add(target);
+    }
+
+    void clearTopology()
+    {
+        // nodes reference each other, break the links first
+        for (int i=fNodes.size(); --i >= 0;)
+        {
+            PatchbayNodeState* const state(fNodes.getUnchecked(i));
+            state->inputs.clear();
+            state->outputs.clear();
+            state->decReferenceCount();
+        }
+
+        fNodes.clear();
+        fIsAcyclic = true;
+    }
+
+    // full sort, only needed after loops
+    void computeOrder()
+    {
+        const int numNodes(fNodes.size());
+
+        Array<int> pending;
+        Array<PatchbayNodeState*> ready, sorted;
+
+        for (int i=0; i<numNodes; ++i)
+        {
+            PatchbayNodeState* const state(fNodes.getUnchecked(i));
+            pending.add(state->inputs.size());
+
+            if (state->inputs.size() == 0)
+                ready.add(state);
+        }
+
+        // take ready nodes in their current order, keeps things stable
+        for (int i=0; i < ready.size(); ++i)
+        {
+            PatchbayNodeState* const state(ready.getUnchecked(i));
+            sorted.add(state);
+
+            for (int j=0, count=state->outputs.size(); j<count; ++j)
+            {
+                PatchbayNodeState* const target(state->outputs.getUnchecked(j));
+
+                if (--pending.getReference(target->order) == 0)
+                    ready.add(target);
+            }
+        }
+
+        fIsAcyclic = (sorted.size() == numNodes);
+
+        if (! fIsAcyclic)
+            return;
+
+        for (int i=0; i<numNodes; ++i)
+        {
+            PatchbayNodeState* const state(sorted.getUnchecked(i));
+            state->order = i;
+            fNodes.set(i, state);
+        }
+    }
+
+    // Pearce-Kelly, only touches the nodes between source and target in the current order
+    bool reorderForEdge(PatchbayNodeState* const source, PatchbayNodeState* const target)
+    {
+        if (source == target)
+            return false;
+
+        const int lowerBound(target->order);
+        const int upperBound(source->order);
+
+        if (upperBound < lowerBound)
+            return true;
+
+        Array<PatchbayNodeState*> forward, backward, stack;
+        bool hasLoop = false;
+
+        // everything reachable from target that is not yet after source
+        stack.add(target);
+        target->visited = true;
+
+        for (; stack.size() > 0 && ! hasLoop;)
+        {
+            PatchbayNodeState* const state(stack.getLast());
+            stack.removeLast();
+            forward.add(state);
+
+            for (int i=0, count=state->outputs.size(); i<count; ++i)
+            {
+                PatchbayNodeState* const next(state->outputs.getUnchecked(i));
+
+                if (next == source)
+                {
+                    hasLoop = true;
+                    break;
+                }
+
+                if (next->visited || next->order > upperBound)
+                    continue;
+
+                next->visited = true;
+                stack.add(next);
+            }
+        }
+
+        if (! hasLoop)
+        {
+            // everything that reaches source and is not yet before target
+            stack.add(source);
+            source->visited = true;
+
+            for (; stack.size() > 0;)
+            {
+                PatchbayNodeState* const state(stack.getLast());
+                stack.removeLast();
+                backward.add(state);
+
+                for (int i=0, count=state->inputs.size(); i<count; ++i)
+                {
+                    PatchbayNodeState* const prev(state->inputs.getReference(i).source);
+
+                    if (prev->visited || prev->order < lowerBound)
+                        continue;
+
+                    prev->visited = true;
+                    stack.add(prev);
+                }
+            }
+        }
+
+        for (int i=forward.size();  --i >= 0;) forward.getUnchecked(i)->visited  = false;
+        for (int i=backward.size(); --i >= 0;) backward.getUnchecked(i)->visited = false;
+        for (int i=stack.size();    --i >= 0;) stack.getUnchecked(i)->visited    = false;
+
+        if (hasLoop)
+            return false;
+
+        // backward nodes go first, then forward ones, reusing the same order slots
+        OrderSorter sorter;
+        forward.sort(sorter);
+        backward.sort(sorter);
+
+        Array<int> slots;
+
+        for (int i=0, count=backward.size(); i<count; ++i)
+            slots.add(backward.getUnchecked(i)->order);
+        for (int i=0, count=forward.size(); i<count; ++i)
+            slots.add(forward.getUnchecked(i)->order);
 
-    for (int i=0, numInputs=proc->getNumInputChannels(); i<numInputs; ++i)
-    {
-        engine->callback(ENGINE_CALLBACK_PATCHBAY_PORT_ADDED, groupId, static_cast<int>(kAudioInputPortOffset)+i,
-                         PATCHBAY_PORT_TYPE_AUDIO|PATCHBAY_PORT_IS_INPUT, 0.0f, proc->getInputChannelName(i).toRawUTF8());
-    }
+        juce::DefaultElementComparator<int> slotSorter;
+        slots.sort(slotSorter);
+        backward.addArray(forward);
 
-    for (int i=0, numOutputs=proc->getNumOutputChannels(); i<numOutputs; ++i)
-    {
-        engine->callback(ENGINE_CALLBACK_PATCHBAY_PORT_ADDED, groupId, static_cast<int>(kAudioOutputPortOffset)+i,
-                         PATCHBAY_PORT_TYPE_AUDIO, 0.0f, proc->getOutputChannelName(i).toRawUTF8());
-    }
+        for (int i=0, count=backward.size(); i<count; ++i)
+        {
+            PatchbayNodeState* const state(backward.getUnchecked(i));
+            state->order = slots.getUnchecked(i);
+            fNodes.set(state->order, state);
+        }
 
-    if (proc->acceptsMidi())
-    {
-        engine->callback(ENGINE_CALLBACK_PATCHBAY_PORT_ADDED, groupId, static_cast<int>(kMidiInputPortOffset),
-                         PATCHBAY_PORT_TYPE_MIDI|PATCHBAY_PORT_IS_INPUT, 0.0f, "events-in");
+        return true;
     }
 
-    if (proc->producesMidi())
-    {
-        engine->callback(ENGINE_CALLBACK_PATCHBAY_PORT_ADDED, groupId, static_cast<int>(kMidiOutputPortOffset),
-                         PATCHBAY_PORT_TYPE_MIDI, 0.0f, "events-out");
-    }
-}
+    struct OrderSorter {
+        static int compareElements(const PatchbayNodeState* const a, const PatchbayNodeState* const b) noexcept
+        {
+            return a->order - b->order;
+        }
+    };
 
-static inline
-void removeNodeFromPatchbay(CarlaEngine* const engine, const uint32_t groupId, const AudioProcessor* const proc)
-{
-    CARLA_SAFE_ASSERT_RETURN(engine != nullptr,);
-    CARLA_SAFE_ASSERT_RETURN(proc != nullptr,);
+    // -------------------------------------------------------------------
+    // plan handling
 
-    for (int i=0, numInputs=proc->getNumInputChannels(); i<numInputs; ++i)
+    void reclaimPlans()
     {
-        engine->callback(ENGINE_CALLBACK_PATCHBAY_PORT_REMOVED, groupId, static_cast<int>(kAudioInputPortOffset)+i,
-                         0, 0.0f, nullptr);
-    }
+        for (int i=fRetiredPlans.size(); --i >= 0;)
+        {
+            PatchbayProcessPlan* const plan(fRetiredPlans.getUnchecked(i));
 
-    for (int i=0, numOutputs=proc->getNumOutputChannels(); i<numOutputs; ++i)
-    {
-        engine->callback(ENGINE_CALLBACK_PATCHBAY_PORT_REMOVED, groupId, static_cast<int>(kAudioOutputPortOffset)+i,
-                         0, 0.0f, nullptr);
-    }
+            if (plan == fPlanInUse)
+                continue;
 
-    if (proc->acceptsMidi())
-    {
-        engine->callback(ENGINE_CALLBACK_PATCHBAY_PORT_REMOVED, groupId, static_cast<int>(kMidiInputPortOffset),
-                         0, 0.0f, nullptr);
+            fRetiredPlans.remove(i);
+            delete plan;
+        }
     }
 
-    if (proc->producesMidi())
+    void pushReadyNode(const int index) noexcept
     {
-        engine->callback(ENGINE_CALLBACK_PATCHBAY_PORT_REMOVED, groupId, static_cast<int>(kMidiOutputPortOffset),
-                         0, 0.0f, nullptr);
+        volatile int* const queue(fCurrentPlan->readyQueue);
+
+        const int slot(__sync_fetch_and_add(&fQueueWrite, 1));
+        queue[slot] = index;
+        __sync_synchronize();
     }
 
-    engine->callback(ENGINE_CALLBACK_PATCHBAY_CLIENT_REMOVED, groupId, 0, 0, 0.0f, nullptr);
-}
+    int popReadyNode() noexcept
+    {
+        volatile int* const queue(fCurrentPlan->readyQueue);
 
-// -----------------------------------------------------------------------
+        for (;;)
+        {
+            const int slot(fQueueRead);
 
-class CarlaPluginInstance : public AudioPluginInstance
-{
-public:
-    CarlaPluginInstance(CarlaEngine* const engine, CarlaPlugin* const plugin)
-        : kEngine(engine),
-          fPlugin(plugin)
-    {
-        setPlayConfigDetails(static_cast<int>(fPlugin->getAudioInCount()),
-                             static_cast<int>(fPlugin->getAudioOutCount()),
-                             getSampleRate(), getBlockSize());
-    }
+            if (slot >= fQueueWrite)
+                return -1;
 
-    ~CarlaPluginInstance() override
-    {
-    }
+            if (! __sync_bool_compare_and_swap(&fQueueRead, slot, slot+1))
+                continue;
 
-    void invalidatePlugin() noexcept
-    {
-        fPlugin = nullptr;
-    }
+            // the slot might be reserved but not written yet
+            for (;;)
+            {
+                const int index(queue[slot]);
 
-    // -------------------------------------------------------------------
+                if (index >= 0)
+                    return index;
 
-    void* getPlatformSpecificData() noexcept override
-    {
-        return fPlugin;
+                __sync_synchronize();
+            }
+        }
     }
 
-    void fillInPluginDescription(PluginDescription& d) const override
+    void runNodes(const bool isAudioThread) noexcept
     {
-        d.pluginFormatName = "Carla";
-        d.category = "Carla Plugin";
-        d.version = "1.0";
+        PatchbayProcessPlan* const plan(fCurrentPlan);
 
-        CARLA_SAFE_ASSERT_RETURN(fPlugin != nullptr,);
+        for (;;)
+        {
+            // late workers leave the rest to the audio thread
+            if (! (isAudioThread || fWorkers.isCycleOpen()))
+                return;
 
-        char strBuf[STR_MAX+1];
-        strBuf[STR_MAX] = '\0';
+            const int index(popReadyNode());
 
-        fPlugin->getRealName(strBuf);
-        d.name = strBuf;
+            if (index < 0)
+            {
+                if (__sync_fetch_and_add(&fNodesLeft, 0) == 0)
+                    return;
 
-        fPlugin->getLabel(strBuf);
-        d.descriptiveName = strBuf;
+                // other threads are still busy with our dependencies
+                if (isAudioThread)
+                    fWorkers.waitForWorkers();
 
-        fPlugin->getMaker(strBuf);
-        d.manufacturerName = strBuf;
+                continue;
+            }
 
-        d.uid = d.name.hashCode();
-        d.isInstrument = (fPlugin->getHints() & PLUGIN_IS_SYNTH);
+            PatchbayPlanNode* const node(plan->nodes.getUnchecked(index));
 
-        d.numInputChannels  = static_cast<int>(fPlugin->getAudioInCount());
-        d.numOutputChannels = static_cast<int>(fPlugin->getAudioOutCount());
-        //d.hasSharedContainer = true;
-    }
+            processNode(*node);
 
-    // -------------------------------------------------------------------
+            for (int i=0, count=node->dependents.size(); i<count; ++i)
+            {
+                const int dependent(node->dependents.getUnchecked(i));
 
-    const String getName() const override
-    {
-        return fPlugin->getName();
+                if (__sync_sub_and_fetch(&plan->nodes.getUnchecked(dependent)->pendingDependencies, 1) == 0)
+                    pushReadyNode(dependent);
+            }
+
+            __sync_sub_and_fetch(&fNodesLeft, 1);
+        }
     }
 
-    void processBlock(AudioSampleBuffer& audio, MidiBuffer& midi)
+    void processNode(PatchbayPlanNode& planNode) noexcept
     {
-        if (fPlugin == nullptr || ! fPlugin->isEnabled())
-        {
-            audio.clear();
-            midi.clear();
-            return;
-        }
+        PatchbayNodeState& node(*planNode.state);
+        const int frames(fFrames);
 
-        if (! fPlugin->tryLock(kEngine->isOffline()))
-        {
-            audio.clear();
-            midi.clear();
-            return;
-        }
+        // keep the plugin locked from input mixing until processing is done, its port buffers must not change
+        CarlaPlugin* const plugin(node.instance != nullptr ? node.instance->getPlugin() : nullptr);
+        const bool locked(plugin != nullptr && plugin->isEnabled() && plugin->tryLock(plugin->getEngine()->isOffline()));
 
-        fPlugin->initBuffers();
+        if (locked)
+            setupDirectChannels(node, plugin);
 
-        if (CarlaEngineEventPort* const port = fPlugin->getDefaultEventInPort())
-        {
-            EngineEvent* const engineEvents(port->fBuffer);
-            CARLA_SAFE_ASSERT_RETURN(engineEvents != nullptr,);
+        // audio from connected outputs
+        carla_zeroStructs(node.channelsUsed.getData(), static_cast<size_t>(node.numChannels));
 
-            carla_zeroStructs(engineEvents, kMaxEngineEventInternalCount);
-            fillEngineEventsFromJuceMidiBuffer(engineEvents, midi);
-        }
+        for (int i=0, count=planNode.inputs.size(); i<count; ++i)
+        {
+            const PatchbayNodeState::Input& input(planNode.inputs.getReference(i));
 
-        midi.clear();
+            if (input.targetChannel == AudioProcessorGraph::midiChannelIndex)
+                continue;
 
-        // TODO - CV support
+            const float* const sourceBuf(input.source->outChannels[input.sourceChannel]);
 
-        const int numSamples(audio.getNumSamples());
+            if (node.channelsUsed[input.targetChannel])
+            {
+                FloatVectorOperations::add(node.inChannels[input.targetChannel], sourceBuf, frames);
+            }
+            else
+            {
+                FloatVectorOperations::copy(node.inChannels[input.targetChannel], sourceBuf, frames);
+                node.channelsUsed[input.targetChannel] = true;
+            }
+        }
 
-        if (const int numChan = audio.getNumChannels())
+        for (int i=0; i<node.numChannels; ++i)
         {
-            if (fPlugin->getAudioInCount() == 0)
-                audio.clear();
+            if (! node.channelsUsed[i])
+                FloatVectorOperations::clear(node.inChannels[i], frames);
+        }
 
-            float* audioBuffers[numChan];
+        // events from connected outputs
+        node.midi.clear();
 
-            for (int i=0; i<numChan; ++i)
-                audioBuffers[i] = audio.getWritePointer(i);
+        for (int i=0, count=planNode.inputs.size(); i<count; ++i)
+        {
+            const PatchbayNodeState::Input& input(planNode.inputs.getReference(i));
 
-            float inPeaks[2] = { 0.0f };
-            float outPeaks[2] = { 0.0f };
-            juce::Range<float> range;
+            if (input.targetChannel == AudioProcessorGraph::midiChannelIndex)
+                node.midi.addEvents(input.source->midi, 0, frames, 0);
+        }
 
-            for (int i=jmin(fPlugin->getAudioInCount(), 2U); --i>=0;)
+        switch (node.type)
+        {
+        case kPatchbayNodePlugin:
+            if (locked)
             {
-                range = FloatVectorOperations::findMinAndMax(audioBuffers[i], numSamples);
-                inPeaks[i] = carla_maxLimited<float>(std::abs(range.getStart()), std::abs(range.getEnd()), 1.0f);
+                node.instance->processLocked(node.inChannels, node.outChannels, node.numChannels, frames, node.midi);
+                plugin->unlock();
             }
+            else
+            {
+                resetDirectChannels(node);
 
-            fPlugin->process(const_cast<const float**>(audioBuffers), audioBuffers, nullptr, nullptr, static_cast<uint32_t>(numSamples));
+                AudioSampleBuffer audio(node.channels, node.numChannels, frames);
+                node.node->getProcessor()->processBlock(audio, node.midi);
+            }
+            break;
 
-            for (int i=jmin(fPlugin->getAudioOutCount(), 2U); --i>=0;)
+        case kPatchbayNodeAudioInput:
+            for (int i=0; i<node.numChannels; ++i)
             {
-                range = FloatVectorOperations::findMinAndMax(audioBuffers[i], numSamples);
-                outPeaks[i] = carla_maxLimited<float>(std::abs(range.getStart()), std::abs(range.getEnd()), 1.0f);
+                if (i < static_cast<int>(fInputs))
+                    FloatVectorOperations::copy(node.channels[i], fInBuf[i], frames);
             }
+            break;
 
-            kEngine->setPluginPeaks(fPlugin->getId(), inPeaks, outPeaks);
-        }
-        else
-        {
-            fPlugin->process(nullptr, nullptr, nullptr, nullptr, static_cast<uint32_t>(numSamples));
+        case kPatchbayNodeMidiInput:
+            node.midi.addEvents(*fMidiIn, 0, frames, 0);
+            break;
+
+        case kPatchbayNodeAudioOutput:
+        case kPatchbayNodeMidiOutput:
+            // inputs are the result
+            break;
         }
+    }
 
-        midi.clear();
+    // use the plugin's own port buffers where available, they are only valid while the plugin is locked
+    void setupDirectChannels(PatchbayNodeState& node, CarlaPlugin* const plugin) const noexcept
+    {
+        // port buffers are sized for a full period
+        if (fFrames != fBufferSize)
+            return resetDirectChannels(node);
 
-        if (CarlaEngineEventPort* const port = fPlugin->getDefaultEventOutPort())
+        const int numIns(jmin(node.numInputs, static_cast<int>(plugin->getAudioInCount())));
+        const int numOuts(jmin(node.numOutputs, static_cast<int>(plugin->getAudioOutCount())));
+
+        for (int i=0; i<node.numChannels; ++i)
         {
-            /*const*/ EngineEvent* const engineEvents(port->fBuffer);
-            CARLA_SAFE_ASSERT_RETURN(engineEvents != nullptr,);
+            float* inBuf  = nullptr;
+            float* outBuf = nullptr;
 
-            fillJuceMidiBufferFromEngineEvents(midi, engineEvents);
-            carla_zeroStructs(engineEvents, kMaxEngineEventInternalCount);
-        }
+            if (i < numIns)
+                if (CarlaEngineAudioPort* const port = plugin->getAudioInPort(static_cast<uint32_t>(i)))
+                    inBuf = port->getBuffer();
 
-        fPlugin->unlock();
-    }
+            if (i < numOuts)
+                if (CarlaEngineAudioPort* const port = plugin->getAudioOutPort(static_cast<uint32_t>(i)))
+                    outBuf = port->getBuffer();
 
-    const String getInputChannelName(int i)  const override
-    {
-        CARLA_SAFE_ASSERT_RETURN(i >= 0, String());
-        CarlaEngineClient* const client(fPlugin->getEngineClient());
-        return client->getAudioPortName(true, static_cast<uint>(i));
+            node.inChannels[i]  = (inBuf  != nullptr) ? inBuf  : node.channels[i];
+            node.outChannels[i] = (outBuf != nullptr) ? outBuf : node.channels[i];
+        }
     }
 
-    const String getOutputChannelName(int i) const override
+    static void resetDirectChannels(PatchbayNodeState& node) noexcept
     {
-        CARLA_SAFE_ASSERT_RETURN(i >= 0, String());
-        CarlaEngineClient* const client(fPlugin->getEngineClient());
-        return client->getAudioPortName(false, static_cast<uint>(i));
+        for (int i=0; i<node.numChannels; ++i)
+            node.inChannels[i] = node.outChannels[i] = node.channels[i];
     }
 
-    void prepareToPlay(double, int) override {}
-    void releaseResources() override {}
-
-    const String getParameterName(int)         override { return String(); }
-          String getParameterName(int, int)    override { return String(); }
-    const String getParameterText(int)         override { return String(); }
-          String getParameterText(int, int)    override { return String(); }
-    const String getProgramName(int)           override { return String(); }
-
-    double getTailLengthSeconds()        const override { return 0.0;  }
-    float  getParameter(int)                   override { return 0.0f; }
+    // -------------------------------------------------------------------
 
-    bool isInputChannelStereoPair(int)   const override { return false; }
-    bool isOutputChannelStereoPair(int)  const override { return false; }
-    bool silenceInProducesSilenceOut()   const override { return true;  }
-    bool acceptsMidi()                   const override { return fPlugin->getDefaultEventInPort()  != nullptr; }
-    bool producesMidi()                  const override { return fPlugin->getDefaultEventOutPort() != nullptr; }
+    const int kInputs;
+    const int kOutputs;
 
-    void setParameter(int, float)              override {}
-    void setCurrentProgram(int)                override {}
-    void changeProgramName(int, const String&) override {}
-    void getStateInformation(MemoryBlock&)     override {}
-    void setStateInformation(const void*, int) override {}
+    // non-realtime topology, in order, each node has a reference
+    Array<PatchbayNodeState*> fNodes;
+    int  fBufferSize;
+    bool fIsAcyclic;
 
-    int getNumParameters()                     override { return 0; }
-    int getNumPrograms()                       override { return 0; }
-    int getCurrentProgram()                    override { return 0; }
+    // plan publishing
+    PatchbayProcessPlan* volatile fPlan;
+    PatchbayProcessPlan* volatile fPlanInUse;
+    Array<PatchbayProcessPlan*> fRetiredPlans;
 
-#ifndef JUCE_AUDIO_PROCESSOR_NO_GUI
-    bool hasEditor()                     const override { return false; }
-    AudioProcessorEditor* createEditor()       override { return nullptr; }
-#endif
+    GraphWorkerPool fWorkers;
 
-    // -------------------------------------------------------------------
+    // valid during process()
+    PatchbayProcessPlan* fCurrentPlan;
+    const float* const* fInBuf;
+    uint32_t    fInputs;
+    MidiBuffer* fMidiIn;
+    int fFrames;
 
-private:
-    CarlaEngine* const kEngine;
-    CarlaPlugin* fPlugin;
+    volatile int fQueueRead;
+    volatile int fQueueWrite;
+    volatile int fNodesLeft;
 
-    CARLA_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CarlaPluginInstance)
+    CARLA_DECLARE_NON_COPY_CLASS(PatchbayProcessor)
 };
 
 // -----------------------------------------------------------------------
@@ -1344,6 +2909,7 @@ PatchbayGraph::PatchbayGraph(CarlaEngine* const engine, const uint32_t ins, cons
       retCon(),
       usingExternal(false),
       extGraph(engine),
+      processor(nullptr),
       kEngine(engine)
 {
     const int    bufferSize(static_cast<int>(engine->getBufferSize()));
@@ -1400,10 +2966,20 @@ PatchbayGraph::PatchbayGraph(CarlaEngine* const engine, const uint32_t ins, cons
         node->properties.set("isMIDI", true);
         node->properties.set("isOSC", false);
     }
+
+    processor = new PatchbayProcessor(engine->getOptions().processThreads, inputs, outputs);
+    processor->rebuild(graph, bufferSize);
+    updateProcessOrder();
 }
 
 PatchbayGraph::~PatchbayGraph()
 {
+    if (processor != nullptr)
+    {
+        delete processor;
+        processor = nullptr;
+    }
+
     connections.clear();
     extGraph.clear();
 
@@ -1419,6 +2995,10 @@ void PatchbayGraph::setBufferSize(const uint32_t bufferSize)
     graph.releaseResources();
     graph.prepareToPlay(kEngine->getSampleRate(), bufferSizei);
     audioBuffer.setSize(audioBuffer.getNumChannels(), bufferSizei);
+
+    if (processor != nullptr)
+        processor->rebuild(graph, bufferSizei);
+    updateProcessOrder();
 }
 
 void PatchbayGraph::setSampleRate(const double sampleRate)
@@ -1448,6 +3028,14 @@ void PatchbayGraph::addPlugin(CarlaPlugin* const plugin)
 
     if (! usingExternal)
         addNodeToPatchbay(plugin->getEngine(), node->nodeId, static_cast<int>(plugin->getId()), instance);
+
+    if (processor != nullptr)
+    {
+        // juce prepares new nodes asynchronously, our plan might run them first
+        instance->prepareToPlay(kEngine->getSampleRate(), static_cast<int>(kEngine->getBufferSize()));
+        processor->addNode(node);
+    }
+    updateProcessOrder();
 }
 
 void PatchbayGraph::replacePlugin(CarlaPlugin* const oldPlugin, CarlaPlugin* const newPlugin)
@@ -1468,6 +3056,8 @@ void PatchbayGraph::replacePlugin(CarlaPlugin* const oldPlugin, CarlaPlugin* con
 
     ((CarlaPluginInstance*)oldNode->getProcessor())->invalidatePlugin();
 
+    if (processor != nullptr)
+        processor->removeNode(oldNode->nodeId);
     graph.removeNode(oldNode->nodeId);
 
     CarlaPluginInstance* const instance(new CarlaPluginInstance(kEngine, newPlugin));
@@ -1481,6 +3071,14 @@ void PatchbayGraph::replacePlugin(CarlaPlugin* const oldPlugin, CarlaPlugin* con
 
     if (! usingExternal)
         addNodeToPatchbay(newPlugin->getEngine(), node->nodeId, static_cast<int>(newPlugin->getId()), instance);
+
+    if (processor != nullptr)
+    {
+        // juce prepares new nodes asynchronously, our plan might run them first
+        instance->prepareToPlay(kEngine->getSampleRate(), static_cast<int>(kEngine->getBufferSize()));
+        processor->addNode(node);
+    }
+    updateProcessOrder();
 }
 
 void PatchbayGraph::removePlugin(CarlaPlugin* const plugin)
@@ -1512,7 +3110,12 @@ void PatchbayGraph::removePlugin(CarlaPlugin* const plugin)
         }
     }
 
-    CARLA_SAFE_ASSERT_RETURN(graph.removeNode(node->nodeId),);
+    if (processor != nullptr)
+        processor->removeNode(node->nodeId);
+
+    CARLA_SAFE_ASSERT(graph.removeNode(node->nodeId));
+
+    updateProcessOrder();
 }
 
 void PatchbayGraph::removeAllPlugins()
@@ -1535,8 +3138,12 @@ void PatchbayGraph::removeAllPlugins()
 
         ((CarlaPluginInstance*)node->getProcessor())->invalidatePlugin();
 
+        if (processor != nullptr)
+            processor->removeNode(node->nodeId);
         graph.removeNode(node->nodeId);
     }
+
+    updateProcessOrder();
 }
 
 bool PatchbayGraph::connect(const bool external, const uint groupA, const uint portA, const uint groupB, const uint portB, const bool sendCallback)
@@ -1569,6 +3176,10 @@ bool PatchbayGraph::connect(const bool external, const uint groupA, const uint p
         kEngine->callback(ENGINE_CALLBACK_PATCHBAY_CONNECTION_ADDED, connectionToId.id, 0, 0, 0.0f, strBuf);
 
     connections.list.append(connectionToId);
+
+    if (processor != nullptr)
+        processor->addConnection(groupA, static_cast<int>(adjustedPortA), groupB, static_cast<int>(adjustedPortB));
+    updateProcessOrder();
     return true;
 }
 
@@ -1602,6 +3213,11 @@ bool PatchbayGraph::disconnect(const uint connectionId)
         kEngine->callback(ENGINE_CALLBACK_PATCHBAY_CONNECTION_REMOVED, connectionToId.id, 0, 0, 0.0f, nullptr);
 
         connections.list.remove(it);
+
+        if (processor != nullptr)
+            processor->removeConnection(connectionToId.groupA, static_cast<int>(adjustedPortA),
+                                        connectionToId.groupB, static_cast<int>(adjustedPortB));
+        updateProcessOrder();
         return true;
     }
 
@@ -1705,6 +3321,10 @@ void PatchbayGraph::refresh(const char* const deviceName)
 
         connections.list.append(connectionToId);
     }
+
+    if (processor != nullptr)
+        processor->rebuild(graph, static_cast<int>(kEngine->getBufferSize()));
+    updateProcessOrder();
 }
 
 const char* const* PatchbayGraph::getConnections(const bool external) const
@@ -1809,11 +3429,19 @@ bool PatchbayGraph::getGroupAndPortIdFromFullName(const bool external, const cha
     return false;
 }
 
+void PatchbayGraph::updateProcessOrder()
+{
+    if (processor == nullptr)
+        return;
+
+    processor->publish();
+}
+
 void PatchbayGraph::process(CarlaEngine::ProtectedData* const data, const float* const* const inBuf, float* const* const outBuf, const int frames)
 {
     CARLA_SAFE_ASSERT_RETURN(data != nullptr,);
-    CARLA_SAFE_ASSERT_RETURN(data->events.in != nullptr,);
-    CARLA_SAFE_ASSERT_RETURN(data->events.out != nullptr,);
+    CARLA_SAFE_ASSERT_RETURN(data->events.in.data != nullptr,);
+    CARLA_SAFE_ASSERT_RETURN(data->events.out.data != nullptr,);
     CARLA_SAFE_ASSERT_RETURN(frames > 0,);
 
     // put events in juce buffer
@@ -1834,17 +3462,22 @@ void PatchbayGraph::process(CarlaEngine::ProtectedData* const data, const float*
             audioBuffer.clear(i, 0, frames);
     }
 
-    graph.processBlock(audioBuffer, midiBuffer);
-
-    // put juce audio in carla buffer
+    if (processor != nullptr && processor->process(inBuf, inputs, outBuf, outputs, midiBuffer, frames, data->sampleRate))
+    {
+        // audio and events are already in place
+    }
+    else
     {
+        graph.processBlock(audioBuffer, midiBuffer);
+
+        // put juce audio in carla buffer
         for (int i=0; i < static_cast<int>(outputs); ++i)
             FloatVectorOperations::copy(outBuf[i], audioBuffer.getReadPointer(i), frames);
     }
 
     // put juce events in carla buffer
     {
-        carla_zeroStructs(data->events.out, kMaxEngineEventInternalCount);
+        data->events.out.clear();
         fillEngineEventsFromJuceMidiBuffer(data->events.out, midiBuffer);
         midiBuffer.clear();
     }
@@ -1871,6 +3504,10 @@ void EngineInternalGraph::create(const uint32_t inputs, const uint32_t outputs)
 {
     fIsRack = (kEngine->getOptions().processMode == ENGINE_PROCESS_MODE_CONTINUOUS_RACK);
 
+    // engine events were allocated before the buffer size was known
+    kEngine->pData->events.in.allocate(kEngine->getBufferSize());
+    kEngine->pData->events.out.allocate(kEngine->getBufferSize());
+
     if (fIsRack)
     {
         CARLA_SAFE_ASSERT_RETURN(fRack == nullptr,);
@@ -1961,6 +3598,17 @@ bool EngineInternalGraph::isReady() const noexcept
     return fIsReady;
 }
 
+uint32_t EngineInternalGraph::getLatency() const noexcept
+{
+    if (fIsRack)
+    {
+        CARLA_SAFE_ASSERT_RETURN(fRack != nullptr, 0);
+        return fRack->getLatency();
+    }
+
+    return 0;
+}
+
 RackGraph* EngineInternalGraph::getRackGraph() const noexcept
 {
     CARLA_SAFE_ASSERT_RETURN(fIsRack, nullptr);
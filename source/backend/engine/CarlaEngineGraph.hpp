@@ -96,12 +96,20 @@ struct ExternalGraph {
 // -----------------------------------------------------------------------
 // RackGraph
 
+class RackPipeline;
+
 struct RackGraph {
     ExternalGraph extGraph;
     const uint32_t inputs;
     const uint32_t outputs;
     bool isOffline;
 
+    // audio and events passed from one plugin to the next
+    struct ProcessState;
+
+    // only used when ENGINE_OPTION_RACK_PIPELINE_STAGES > 1
+    RackPipeline* pipeline;
+
     struct Buffers {
         CarlaRecursiveMutex mutex;
         LinkedList<uint> connectedIn1;
@@ -111,6 +119,7 @@ struct RackGraph {
         float* inBuf[2];
         float* inBufTmp[2];
         float* outBuf[2];
+        float* outBufTmp[2];
         Buffers() noexcept;
         ~Buffers() noexcept;
         void setBufferSize(const uint32_t bufferSize, const bool createBuffers) noexcept;
@@ -124,6 +133,8 @@ struct RackGraph {
     void setBufferSize(const uint32_t bufferSize) noexcept;
     void setOffline(const bool offline) noexcept;
 
+    uint32_t getLatency() const noexcept;
+
     bool connect(const uint groupA, const uint portA, const uint groupB, const uint portB) noexcept;
     bool disconnect(const uint connectionId) noexcept;
     void refresh(const char* const deviceName);
@@ -134,6 +145,12 @@ struct RackGraph {
     // the base, where plugins run
     void process(CarlaEngine::ProtectedData* const data, const float* inBufReal[2], float* outBuf[2], const uint32_t frames);
 
+    // runs all plugins, inBuf is used as scratch space
+    void processBuffers(CarlaEngine::ProtectedData* const data, float* inBuf[2], float* outBuf[2], const uint32_t frames);
+
+    // runs @a count plugins in order, used by process() and the pipeline stages
+    void processPlugins(CarlaEngine::ProtectedData* const data, ProcessState& state, CarlaPlugin* const* const plugins, const uint count, const uint32_t frames);
+
     // extended, will call process() in the middle
     void processHelper(CarlaEngine::ProtectedData* const data, const float* const* const inBuf, float* const* const outBuf, const uint32_t frames);
 
@@ -144,6 +161,8 @@ struct RackGraph {
 // -----------------------------------------------------------------------
 // PatchbayGraph
 
+class PatchbayProcessor;
+
 struct PatchbayGraph {
     PatchbayConnectionList connections;
     AudioProcessorGraph graph;
@@ -156,6 +175,9 @@ struct PatchbayGraph {
 
     ExternalGraph extGraph;
 
+    // runs the graph, with ENGINE_OPTION_PROCESS_THREADS extra threads, juce is still used for feedback loops
+    PatchbayProcessor* processor;
+
     PatchbayGraph(CarlaEngine* const engine, const uint32_t inputs, const uint32_t outputs);
     ~PatchbayGraph();
 
@@ -176,6 +198,9 @@ struct PatchbayGraph {
     const char* const* getConnections(const bool external) const;
     bool getGroupAndPortIdFromFullName(const bool external, const char* const fullPortName, uint& groupId, uint& portId) const;
 
+    // publishes graph edits to the processor, if used
+    void updateProcessOrder();
+
     void process(CarlaEngine::ProtectedData* const data, const float* const* const inBuf, float* const* const outBuf, const int frames);
 
     CarlaEngine* const kEngine;
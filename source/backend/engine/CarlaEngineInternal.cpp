@@ -30,28 +30,19 @@ CARLA_BACKEND_START_NAMESPACE
 // InternalEvents
 
 EngineInternalEvents::EngineInternalEvents() noexcept
-    : in(nullptr),
-      out(nullptr) {}
+    : in(),
+      out() {}
 
 EngineInternalEvents::~EngineInternalEvents() noexcept
 {
-    CARLA_SAFE_ASSERT(in == nullptr);
-    CARLA_SAFE_ASSERT(out == nullptr);
+    CARLA_SAFE_ASSERT(in.data == nullptr);
+    CARLA_SAFE_ASSERT(out.data == nullptr);
 }
 
 void EngineInternalEvents::clear() noexcept
 {
-    if (in != nullptr)
-    {
-        delete[] in;
-        in = nullptr;
-    }
-
-    if (out != nullptr)
-    {
-        delete[] out;
-        out = nullptr;
-    }
+    in.deallocate();
+    out.deallocate();
 }
 
 // -----------------------------------------------------------------------
@@ -95,6 +86,7 @@ void EngineNextAction::clearAndReset() noexcept
 
 CarlaEngine::ProtectedData::ProtectedData(CarlaEngine* const engine) noexcept
     : thread(engine),
+      workers(engine),
 #ifdef HAVE_LIBLO
       osc(engine),
       oscData(nullptr),
@@ -111,6 +103,7 @@ CarlaEngine::ProtectedData::ProtectedData(CarlaEngine* const engine) noexcept
       curPluginCount(0),
       maxPluginNumber(0),
       nextPluginId(0),
+      pluginsVersion(0),
       envMutex(),
       lastError(),
       name(),
@@ -150,8 +143,8 @@ bool CarlaEngine::ProtectedData::init(const char* const clientName)
 #ifdef HAVE_LIBLO
     CARLA_SAFE_ASSERT_RETURN_INTERNAL_ERR(oscData == nullptr, "Invalid engine internal data (err #2)");
 #endif
-    CARLA_SAFE_ASSERT_RETURN_INTERNAL_ERR(events.in  == nullptr, "Invalid engine internal data (err #4)");
-    CARLA_SAFE_ASSERT_RETURN_INTERNAL_ERR(events.out == nullptr, "Invalid engine internal data (err #5)");
+    CARLA_SAFE_ASSERT_RETURN_INTERNAL_ERR(events.in.data  == nullptr, "Invalid engine internal data (err #4)");
+    CARLA_SAFE_ASSERT_RETURN_INTERNAL_ERR(events.out.data == nullptr, "Invalid engine internal data (err #5)");
     CARLA_SAFE_ASSERT_RETURN_INTERNAL_ERR(clientName != nullptr && clientName[0] != '\0', "Invalid client name");
 #ifndef BUILD_BRIDGE
     CARLA_SAFE_ASSERT_RETURN_INTERNAL_ERR(plugins == nullptr, "Invalid engine internal data (err #3)");
@@ -183,8 +176,13 @@ bool CarlaEngine::ProtectedData::init(const char* const clientName)
     case ENGINE_PROCESS_MODE_CONTINUOUS_RACK:
     case ENGINE_PROCESS_MODE_PATCHBAY:
     case ENGINE_PROCESS_MODE_BRIDGE:
-        events.in  = new EngineEvent[kMaxEngineEventInternalCount];
-        events.out = new EngineEvent[kMaxEngineEventInternalCount];
+        // grows later on if the engine buffer size is bigger
+        if (! events.in.allocate(options.audioBufferSize) || ! events.out.allocate(options.audioBufferSize))
+        {
+            events.clear();
+            lastError = "Failed to allocate engine event buffers";
+            return false;
+        }
         break;
     default:
         break;
@@ -211,6 +209,8 @@ bool CarlaEngine::ProtectedData::init(const char* const clientName)
 
     nextAction.ready();
     thread.startThread();
+    workers.clearStats();
+    workers.start();
 
     return true;
 }
@@ -225,6 +225,7 @@ void CarlaEngine::ProtectedData::close()
     aboutToClose = true;
 
     thread.stopThread(500);
+    workers.stop();
     nextAction.ready();
 
 #ifdef HAVE_LIBLO
@@ -256,6 +257,7 @@ void CarlaEngine::ProtectedData::doPluginRemove() noexcept
 {
     CARLA_SAFE_ASSERT_RETURN(curPluginCount > 0,);
     CARLA_SAFE_ASSERT_RETURN(nextAction.pluginId < curPluginCount,);
+    workers.removePlugin(nextAction.pluginId, curPluginCount);
     --curPluginCount;
 
     // move all plugins 1 spot backwards
@@ -296,6 +298,8 @@ void CarlaEngine::ProtectedData::doPluginsSwitch() noexcept
     CARLA_SAFE_ASSERT_RETURN(plugins[idA].plugin != nullptr,);
     CARLA_SAFE_ASSERT_RETURN(plugins[idB].plugin != nullptr,);
 
+    workers.switchPlugins(idA, idB);
+
 #if 0
     std::swap(plugins[idA].plugin, plugins[idB].plugin);
 #else
@@ -315,6 +319,7 @@ void CarlaEngine::ProtectedData::doNextPluginAction(const bool unlock) noexcept
         break;
     case kEnginePostActionZeroCount:
         curPluginCount = 0;
+        workers.removeAllPlugins();
         break;
 #ifndef BUILD_BRIDGE
     case kEnginePostActionRemovePlugin:
@@ -326,6 +331,9 @@ void CarlaEngine::ProtectedData::doNextPluginAction(const bool unlock) noexcept
 #endif
     }
 
+    if (nextAction.opcode != kEnginePostActionNull)
+        __sync_add_and_fetch(&pluginsVersion, 1);
+
     nextAction.opcode   = kEnginePostActionNull;
     nextAction.pluginId = 0;
     nextAction.value    = 0;
@@ -401,12 +409,16 @@ ScopedThreadStopper::ScopedThreadStopper(CarlaEngine* const e) noexcept
       pData(e->pData)
 {
     pData->thread.stopThread(500);
+    pData->workers.stop();
 }
 
 ScopedThreadStopper::~ScopedThreadStopper() noexcept
 {
     if (engine->isRunning() && ! pData->aboutToClose)
+    {
         pData->thread.startThread();
+        pData->workers.start();
+    }
 }
 
 // -----------------------------------------------------------------------
@@ -20,6 +20,7 @@
 
 #include "CarlaEngineOsc.hpp"
 #include "CarlaEngineThread.hpp"
+#include "CarlaEngineWorkers.hpp"
 #include "CarlaEngineUtils.hpp"
 
 // FIXME only use CARLA_PREVENT_HEAP_ALLOCATION for structs
@@ -40,8 +41,8 @@ CARLA_BACKEND_START_NAMESPACE
 // InternalEvents
 
 struct EngineInternalEvents {
-    EngineEvent* in;
-    EngineEvent* out;
+    EngineEventBuffer in;
+    EngineEventBuffer out;
 
     EngineInternalEvents() noexcept;
     ~EngineInternalEvents() noexcept;
@@ -71,6 +72,7 @@ public:
     void setOffline(const bool offline);
 
     bool isReady() const noexcept;
+    uint32_t getLatency() const noexcept;
 
     RackGraph*     getRackGraph() const noexcept;
     PatchbayGraph* getPatchbayGraph() const noexcept;
@@ -156,7 +158,8 @@ struct EnginePluginData {
 // CarlaEngineProtectedData
 
 struct CarlaEngine::ProtectedData {
-    CarlaEngineThread thread;
+    CarlaEngineThread  thread;
+    CarlaEngineWorkers workers;
 
 #ifdef HAVE_LIBLO
     CarlaEngineOsc osc;
@@ -182,6 +185,7 @@ struct CarlaEngine::ProtectedData {
     uint curPluginCount;  // number of plugins loaded (0...max)
     uint maxPluginNumber; // number of plugins allowed (0, 16, 99 or 255)
     uint nextPluginId;    // invalid if == maxPluginNumber
+    uint pluginsVersion;  // changed whenever plugins are added, removed, replaced or moved
 
     CarlaMutex     envMutex;
     CarlaString    lastError;
@@ -274,6 +278,25 @@ private:
 
 // -----------------------------------------------------------------------
 
+#ifndef BUILD_BRIDGE
+// Makes CarlaEngine::getTimeInfo() return @a timeInfo in the current thread while in scope.
+// Used by the rack pipeline, where later stages process blocks that entered in previous cycles.
+class ScopedThreadTimeInfo
+{
+public:
+    ScopedThreadTimeInfo(const EngineTimeInfo& timeInfo) noexcept;
+    ~ScopedThreadTimeInfo() noexcept;
+
+private:
+    const EngineTimeInfo* const fOldTimeInfo;
+
+    CARLA_PREVENT_HEAP_ALLOCATION
+    CARLA_DECLARE_NON_COPY_CLASS(ScopedThreadTimeInfo)
+};
+
+// -----------------------------------------------------------------------
+#endif
+
 CARLA_BACKEND_END_NAMESPACE
 
 #endif // CARLA_ENGINE_INTERNAL_HPP_INCLUDED
@@ -1551,8 +1551,8 @@ protected:
         else if (pData->options.processMode == ENGINE_PROCESS_MODE_CONTINUOUS_RACK ||
                  pData->options.processMode == ENGINE_PROCESS_MODE_PATCHBAY)
         {
-            CARLA_SAFE_ASSERT_RETURN(pData->events.in  != nullptr,);
-            CARLA_SAFE_ASSERT_RETURN(pData->events.out != nullptr,);
+            CARLA_SAFE_ASSERT_RETURN(pData->events.in.data  != nullptr,);
+            CARLA_SAFE_ASSERT_RETURN(pData->events.out.data != nullptr,);
 
             // get buffers from jack
             float* const audioIn1  = (float*)jackbridge_port_get_buffer(fRackPorts[kRackPortAudioIn1], nframes);
@@ -1577,12 +1577,10 @@ protected:
             /**/  float* outBuf[2] = { audioOut1, audioOut2 };
 
             // initialize events
-            carla_zeroStructs(pData->events.in,  kMaxEngineEventInternalCount);
-            carla_zeroStructs(pData->events.out, kMaxEngineEventInternalCount);
+            pData->events.in.clear();
+            pData->events.out.clear();
 
             {
-                ushort engineEventIndex = 0;
-
                 jack_midi_event_t jackEvent;
                 const uint32_t jackEventCount(jackbridge_midi_get_event_count(eventIn));
 
@@ -1593,13 +1591,7 @@ protected:
 
                     CARLA_SAFE_ASSERT_CONTINUE(jackEvent.size < 0xFF /* uint8_t max */);
 
-                    EngineEvent& engineEvent(pData->events.in[engineEventIndex++]);
-
-                    engineEvent.time = jackEvent.time;
-                    engineEvent.fillFromMidiData(static_cast<uint8_t>(jackEvent.size), jackEvent.buffer, 0);
-
-                    if (engineEventIndex >= kMaxEngineEventInternalCount)
-                        break;
+                    pData->events.in.appendFromMidiData(jackEvent.time, static_cast<uint8_t>(jackEvent.size), jackEvent.buffer, 0);
                 }
             }
 
@@ -1616,14 +1608,11 @@ protected:
                 uint8_t        data[3] = { 0, 0, 0 };
                 const uint8_t* dataPtr = data;
 
-                for (ushort i=0; i < kMaxEngineEventInternalCount; ++i)
+                for (uint32_t i=0; i < pData->events.out.count; ++i)
                 {
-                    const EngineEvent& engineEvent(pData->events.out[i]);
-
-                    if (engineEvent.type == kEngineEventTypeNull)
-                        break;
+                    const EngineEvent& engineEvent(pData->events.out.data[i]);
 
-                    else if (engineEvent.type == kEngineEventTypeControl)
+                    if (engineEvent.type == kEngineEventTypeControl)
                     {
                         const EngineControlEvent& ctrlEvent(engineEvent.ctrl);
                         ctrlEvent.convertToMidiData(engineEvent.channel, size, data);
@@ -1653,9 +1642,43 @@ protected:
 #endif // ! BUILD_BRIDGE
     }
 
-    void handleJackLatencyCallback(const jack_latency_callback_mode_t /*mode*/)
+    void handleJackLatencyCallback(const jack_latency_callback_mode_t mode)
     {
-        // TODO
+#ifndef BUILD_BRIDGE
+        if (pData->options.processMode != ENGINE_PROCESS_MODE_CONTINUOUS_RACK)
+            return;
+        if (fRackPorts[kRackPortAudioIn1] == nullptr)
+            return;
+
+        // pipelined rack delays audio by a few buffers
+        const uint32_t latency(getLatency());
+
+        jack_latency_range_t range;
+
+        if (mode == JackCaptureLatency)
+        {
+            for (uint i=0; i<2; ++i)
+            {
+                jackbridge_port_get_latency_range(fRackPorts[kRackPortAudioIn1+i], mode, &range);
+                range.min += latency;
+                range.max += latency;
+                jackbridge_port_set_latency_range(fRackPorts[kRackPortAudioOut1+i], mode, &range);
+            }
+        }
+        else
+        {
+            for (uint i=0; i<2; ++i)
+            {
+                jackbridge_port_get_latency_range(fRackPorts[kRackPortAudioOut1+i], mode, &range);
+                range.min += latency;
+                range.max += latency;
+                jackbridge_port_set_latency_range(fRackPorts[kRackPortAudioIn1+i], mode, &range);
+            }
+        }
+#else
+        // unused
+        (void)mode;
+#endif
     }
 
 #ifndef BUILD_BRIDGE
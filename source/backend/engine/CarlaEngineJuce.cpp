@@ -429,35 +429,31 @@ protected:
             FloatVectorOperations::clear(outputChannelData[i], numSamples);
 
         // initialize events
-        carla_zeroStructs(pData->events.in,  kMaxEngineEventInternalCount);
-        carla_zeroStructs(pData->events.out, kMaxEngineEventInternalCount);
+        pData->events.in.clear();
+        pData->events.out.clear();
 
         if (fMidiInEvents.mutex.tryLock())
         {
-            uint32_t engineEventIndex = 0;
             fMidiInEvents.splice();
 
             for (LinkedList<RtMidiEvent>::Itenerator it = fMidiInEvents.data.begin2(); it.valid(); it.next())
             {
                 const RtMidiEvent& midiEvent(it.getValue());
-                EngineEvent&       engineEvent(pData->events.in[engineEventIndex++]);
+                uint32_t time;
 
                 if (midiEvent.time < pData->timeInfo.frame)
                 {
-                    engineEvent.time = 0;
+                    time = 0;
                 }
                 else if (midiEvent.time >= pData->timeInfo.frame + nframes)
                 {
-                    carla_stderr("MIDI Event in the future!, %i vs %i", engineEvent.time, pData->timeInfo.frame);
-                    engineEvent.time = static_cast<uint32_t>(pData->timeInfo.frame) + nframes - 1;
+                    carla_stderr("MIDI Event in the future!, " P_UINT64 " vs " P_UINT64, midiEvent.time, pData->timeInfo.frame);
+                    time = static_cast<uint32_t>(pData->timeInfo.frame) + nframes - 1;
                 }
                 else
-                    engineEvent.time = static_cast<uint32_t>(midiEvent.time - pData->timeInfo.frame);
+                    time = static_cast<uint32_t>(midiEvent.time - pData->timeInfo.frame);
 
-                engineEvent.fillFromMidiData(midiEvent.size, midiEvent.data, 0);
-
-                if (engineEventIndex >= kMaxEngineEventInternalCount)
-                    break;
+                pData->events.in.appendFromMidiData(time, midiEvent.size, midiEvent.data, 0);
             }
 
             fMidiInEvents.data.clear();
@@ -474,14 +470,11 @@ protected:
             uint8_t        data[3] = { 0, 0, 0 };
             const uint8_t* dataPtr = data;
 
-            for (ushort i=0; i < kMaxEngineEventInternalCount; ++i)
+            for (uint32_t i=0; i < pData->events.out.count; ++i)
             {
-                const EngineEvent& engineEvent(pData->events.out[i]);
-
-                if (engineEvent.type == kEngineEventTypeNull)
-                    break;
+                const EngineEvent& engineEvent(pData->events.out.data[i]);
 
-                else if (engineEvent.type == kEngineEventTypeControl)
+                if (engineEvent.type == kEngineEventTypeControl)
                 {
                     const EngineControlEvent& ctrlEvent(engineEvent.ctrl);
                     ctrlEvent.convertToMidiData(engineEvent.channel, size, data);
@@ -534,7 +534,12 @@ protected:
             CARLA_SAFE_ASSERT_RETURN(readNextLineAsBool(yesNo), true);
 
             if (CarlaPlugin* const plugin = fEngine->getPlugin(pluginId))
+            {
+                if (yesNo)
+                    plugin->setParameterOutputsChanged();
+
                 plugin->showCustomUI(yesNo);
+            }
         }
         else
         {
@@ -1359,26 +1364,17 @@ protected:
         // ---------------------------------------------------------------
         // initialize events
 
-        carla_zeroStructs(pData->events.in,  kMaxEngineEventInternalCount);
-        carla_zeroStructs(pData->events.out, kMaxEngineEventInternalCount);
+        pData->events.in.clear();
+        pData->events.out.clear();
 
         // ---------------------------------------------------------------
         // events input (before processing)
 
+        for (uint32_t i=0; i < midiEventCount; ++i)
         {
-            uint32_t engineEventIndex = 0;
-
-            for (uint32_t i=0; i < midiEventCount && engineEventIndex < kMaxEngineEventInternalCount; ++i)
-            {
-                const NativeMidiEvent& midiEvent(midiEvents[i]);
-                EngineEvent&           engineEvent(pData->events.in[engineEventIndex++]);
+            const NativeMidiEvent& midiEvent(midiEvents[i]);
 
-                engineEvent.time = midiEvent.time;
-                engineEvent.fillFromMidiData(midiEvent.size, midiEvent.data, 0);
-
-                if (engineEventIndex >= kMaxEngineEventInternalCount)
-                    break;
-            }
+            pData->events.in.appendFromMidiData(midiEvent.time, midiEvent.size, midiEvent.data, 0);
         }
 
         if (kIsPatchbay)
@@ -1405,17 +1401,17 @@ protected:
         // ---------------------------------------------------------------
         // events output (after processing)
 
-        carla_zeroStructs(pData->events.in, kMaxEngineEventInternalCount);
+        pData->events.in.clear();
 
         {
             NativeMidiEvent midiEvent;
 
-            for (uint32_t i=0; i < kMaxEngineEventInternalCount; ++i)
+            for (uint32_t i=0; i < pData->events.out.count; ++i)
             {
-                const EngineEvent& engineEvent(pData->events.out[i]);
+                const EngineEvent& engineEvent(pData->events.out.data[i]);
 
                 if (engineEvent.type == kEngineEventTypeNull)
-                    break;
+                    continue;
 
                 midiEvent.time = engineEvent.time;
 
@@ -1634,6 +1630,8 @@ protected:
         // stopped during removeAllPlugins()
         if (! pData->thread.isThreadRunning())
             pData->thread.startThread();
+        if (! pData->workers.isRunning())
+            pData->workers.start();
 
         fOptionsForced = true;
         const String state(data);
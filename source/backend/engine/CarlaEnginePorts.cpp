@@ -91,7 +91,15 @@ CarlaEngineEventPort::CarlaEngineEventPort(const CarlaEngineClient& client, cons
     carla_debug("CarlaEngineEventPort::CarlaEngineEventPort(%s)", bool2str(isInputPort));
 
     if (kProcessMode == ENGINE_PROCESS_MODE_PATCHBAY)
-        fBuffer = new EngineEvent[kMaxEngineEventInternalCount];
+    {
+        fBuffer = new EngineEventBuffer();
+
+        if (! fBuffer->allocate(client.getEngine().getBufferSize()))
+        {
+            delete fBuffer;
+            fBuffer = nullptr;
+        }
+    }
 }
 
 CarlaEngineEventPort::~CarlaEngineEventPort() noexcept
@@ -102,7 +110,8 @@ CarlaEngineEventPort::~CarlaEngineEventPort() noexcept
     {
         CARLA_SAFE_ASSERT_RETURN(fBuffer != nullptr,);
 
-        delete[] fBuffer;
+        fBuffer->deallocate();
+        delete fBuffer;
         fBuffer = nullptr;
     }
 }
@@ -111,8 +120,16 @@ void CarlaEngineEventPort::initBuffer() noexcept
 {
     if (kProcessMode == ENGINE_PROCESS_MODE_CONTINUOUS_RACK || kProcessMode == ENGINE_PROCESS_MODE_BRIDGE)
         fBuffer = kClient.getEngine().getInternalEventBuffer(kIsInput);
-    else if (kProcessMode == ENGINE_PROCESS_MODE_PATCHBAY && ! kIsInput)
-        carla_zeroStructs(fBuffer, kMaxEngineEventInternalCount);
+    else if (kProcessMode == ENGINE_PROCESS_MODE_PATCHBAY && ! kIsInput && fBuffer != nullptr)
+        fBuffer->clear();
+}
+
+void CarlaEngineEventPort::setInternalEventBuffer(EngineEventBuffer* const buffer) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(buffer != nullptr,);
+    CARLA_SAFE_ASSERT_RETURN(kProcessMode == ENGINE_PROCESS_MODE_CONTINUOUS_RACK,);
+
+    fBuffer = buffer;
 }
 
 uint32_t CarlaEngineEventPort::getEventCount() const noexcept
@@ -121,15 +138,7 @@ uint32_t CarlaEngineEventPort::getEventCount() const noexcept
     CARLA_SAFE_ASSERT_RETURN(fBuffer != nullptr, 0);
     CARLA_SAFE_ASSERT_RETURN(kProcessMode != ENGINE_PROCESS_MODE_SINGLE_CLIENT && kProcessMode != ENGINE_PROCESS_MODE_MULTIPLE_CLIENTS, 0);
 
-    uint32_t i=0;
-
-    for (; i < kMaxEngineEventInternalCount; ++i)
-    {
-        if (fBuffer[i].type == kEngineEventTypeNull)
-            break;
-    }
-
-    return i;
+    return fBuffer->count;
 }
 
 const EngineEvent& CarlaEngineEventPort::getEvent(const uint32_t index) const noexcept
@@ -137,14 +146,14 @@ const EngineEvent& CarlaEngineEventPort::getEvent(const uint32_t index) const no
     CARLA_SAFE_ASSERT_RETURN(kIsInput, kFallbackEngineEvent);
     CARLA_SAFE_ASSERT_RETURN(fBuffer != nullptr, kFallbackEngineEvent);
     CARLA_SAFE_ASSERT_RETURN(kProcessMode != ENGINE_PROCESS_MODE_SINGLE_CLIENT && kProcessMode != ENGINE_PROCESS_MODE_MULTIPLE_CLIENTS, kFallbackEngineEvent);
-    CARLA_SAFE_ASSERT_RETURN(index < kMaxEngineEventInternalCount, kFallbackEngineEvent);
+    CARLA_SAFE_ASSERT_RETURN(index < fBuffer->count, kFallbackEngineEvent);
 
-    return fBuffer[index];
+    return fBuffer->data[index];
 }
 
 const EngineEvent& CarlaEngineEventPort::getEventUnchecked(const uint32_t index) const noexcept
 {
-    return fBuffer[index];
+    return fBuffer->data[index];
 }
 
 bool CarlaEngineEventPort::writeControlEvent(const uint32_t time, const uint8_t channel, const EngineControlEvent& ctrl) noexcept
@@ -165,26 +174,23 @@ bool CarlaEngineEventPort::writeControlEvent(const uint32_t time, const uint8_t
         CARLA_SAFE_ASSERT(! MIDI_IS_CONTROL_BANK_SELECT(param));
     }
 
-    for (uint32_t i=0; i < kMaxEngineEventInternalCount; ++i)
-    {
-        EngineEvent& event(fBuffer[i]);
+    EngineEvent* const event(fBuffer->append());
 
-        if (event.type != kEngineEventTypeNull)
-            continue;
+    if (event == nullptr)
+    {
+        carla_stderr2("CarlaEngineEventPort::writeControlEvent() - buffer full");
+        return false;
+    }
 
-        event.type    = kEngineEventTypeControl;
-        event.time    = time;
-        event.channel = channel;
+    event->type    = kEngineEventTypeControl;
+    event->time    = time;
+    event->channel = channel;
 
-        event.ctrl.type  = type;
-        event.ctrl.param = param;
-        event.ctrl.value = carla_fixedValue<float>(0.0f, 1.0f, value);
+    event->ctrl.type  = type;
+    event->ctrl.param = param;
+    event->ctrl.value = carla_fixedValue<float>(0.0f, 1.0f, value);
 
-        return true;
-    }
-
-    carla_stderr2("CarlaEngineEventPort::writeControlEvent() - buffer full");
-    return false;
+    return true;
 }
 
 bool CarlaEngineEventPort::writeMidiEvent(const uint32_t time, const uint8_t size, const uint8_t* const data) noexcept
@@ -204,88 +210,112 @@ bool CarlaEngineEventPort::writeMidiEvent(const uint32_t time, const uint8_t cha
     CARLA_SAFE_ASSERT_RETURN(fBuffer != nullptr, false);
     CARLA_SAFE_ASSERT_RETURN(kProcessMode != ENGINE_PROCESS_MODE_SINGLE_CLIENT && kProcessMode != ENGINE_PROCESS_MODE_MULTIPLE_CLIENTS, false);
     CARLA_SAFE_ASSERT_RETURN(channel < MAX_MIDI_CHANNELS, false);
-    CARLA_SAFE_ASSERT_RETURN(size > 0 && size <= EngineMidiEvent::kDataSize, false);
+    CARLA_SAFE_ASSERT_RETURN(size > 0, false);
     CARLA_SAFE_ASSERT_RETURN(data != nullptr, false);
 
-    for (uint32_t i=0; i < kMaxEngineEventInternalCount; ++i)
-    {
-        EngineEvent& event(fBuffer[i]);
+    const uint8_t status(uint8_t(MIDI_GET_STATUS_FROM_DATA(data)));
 
-        if (event.type != kEngineEventTypeNull)
-            continue;
+    // validate before taking a slot, so bad messages do not leave holes in the buffer
+    if (status == MIDI_STATUS_CONTROL_CHANGE) {
+        CARLA_SAFE_ASSERT_RETURN(size >= 3, true);
+    } else if (status == MIDI_STATUS_PROGRAM_CHANGE) {
+        CARLA_SAFE_ASSERT_RETURN(size == 2, true);
+    }
 
-        event.time    = time;
-        event.channel = channel;
+    // long messages (SysEx) go into the buffer arena
+    const uint8_t* dataExt = nullptr;
 
-        const uint8_t status(uint8_t(MIDI_GET_STATUS_FROM_DATA(data)));
+    if (size > EngineMidiEvent::kDataSize)
+    {
+        dataExt = fBuffer->appendData(data, size);
 
-        if (status == MIDI_STATUS_CONTROL_CHANGE)
+        if (dataExt == nullptr)
         {
-            CARLA_SAFE_ASSERT_RETURN(size >= 3, true);
-
-            switch (data[1])
-            {
-            case MIDI_CONTROL_BANK_SELECT:
-            case MIDI_CONTROL_BANK_SELECT__LSB:
-                event.type       = kEngineEventTypeControl;
-                event.ctrl.type  = kEngineControlEventTypeMidiBank;
-                event.ctrl.param = data[2];
-                event.ctrl.value = 0.0f;
-                return true;
-
-            case MIDI_CONTROL_ALL_SOUND_OFF:
-                event.type       = kEngineEventTypeControl;
-                event.ctrl.type  = kEngineControlEventTypeAllSoundOff;
-                event.ctrl.param = 0;
-                event.ctrl.value = 0.0f;
-                return true;
-
-            case MIDI_CONTROL_ALL_NOTES_OFF:
-                event.type       = kEngineEventTypeControl;
-                event.ctrl.type  = kEngineControlEventTypeAllNotesOff;
-                event.ctrl.param = 0;
-                event.ctrl.value = 0.0f;
-                return true;
-            }
+            carla_stderr2("CarlaEngineEventPort::writeMidiEvent() - no space left for %u bytes", size);
+            return false;
         }
+    }
 
-        if (status == MIDI_STATUS_PROGRAM_CHANGE)
-        {
-            CARLA_SAFE_ASSERT_RETURN(size == 2, true);
+    EngineEvent* const eventPtr(fBuffer->append());
+
+    if (eventPtr == nullptr)
+    {
+        carla_stderr2("CarlaEngineEventPort::writeMidiEvent() - buffer full");
+        return false;
+    }
 
+    EngineEvent& event(*eventPtr);
+
+    event.time    = time;
+    event.channel = channel;
+
+    if (status == MIDI_STATUS_CONTROL_CHANGE)
+    {
+        switch (data[1])
+        {
+        case MIDI_CONTROL_BANK_SELECT:
+        case MIDI_CONTROL_BANK_SELECT__LSB:
             event.type       = kEngineEventTypeControl;
             event.ctrl.type  = kEngineControlEventTypeMidiBank;
-            event.ctrl.param = data[1];
+            event.ctrl.param = data[2];
             event.ctrl.value = 0.0f;
             return true;
-        }
 
-        event.type      = kEngineEventTypeMidi;
-        event.midi.size = size;
+        case MIDI_CONTROL_ALL_SOUND_OFF:
+            event.type       = kEngineEventTypeControl;
+            event.ctrl.type  = kEngineControlEventTypeAllSoundOff;
+            event.ctrl.param = 0;
+            event.ctrl.value = 0.0f;
+            return true;
 
-        if (kIndexOffset < 0xFF /* uint8_t max */)
-        {
-            event.midi.port = kIndexOffset;
-        }
-        else
-        {
-            event.midi.port = 0;
-            carla_safe_assert_int("kIndexOffset < 0xFF", __FILE__, __LINE__, kIndexOffset);
+        case MIDI_CONTROL_ALL_NOTES_OFF:
+            event.type       = kEngineEventTypeControl;
+            event.ctrl.type  = kEngineControlEventTypeAllNotesOff;
+            event.ctrl.param = 0;
+            event.ctrl.value = 0.0f;
+            return true;
         }
+    }
 
-        event.midi.data[0] = status;
+    if (status == MIDI_STATUS_PROGRAM_CHANGE)
+    {
+        event.type       = kEngineEventTypeControl;
+        event.ctrl.type  = kEngineControlEventTypeMidiBank;
+        event.ctrl.param = data[1];
+        event.ctrl.value = 0.0f;
+        return true;
+    }
 
-        uint8_t j=1;
-        for (; j < size; ++j)
-            event.midi.data[j] = data[j];
-        for (; j < EngineMidiEvent::kDataSize; ++j)
-            event.midi.data[j] = 0;
+    event.type      = kEngineEventTypeMidi;
+    event.midi.size = size;
 
+    if (kIndexOffset < 0xFF /* uint8_t max */)
+    {
+        event.midi.port = kIndexOffset;
+    }
+    else
+    {
+        event.midi.port = 0;
+        carla_safe_assert_int("kIndexOffset < 0xFF", __FILE__, __LINE__, kIndexOffset);
+    }
+
+    if (dataExt != nullptr)
+    {
+        event.midi.dataExt = dataExt;
+        std::memset(event.midi.data, 0, sizeof(uint8_t)*EngineMidiEvent::kDataSize);
         return true;
     }
 
-    carla_stderr2("CarlaEngineEventPort::writeMidiEvent() - buffer full");
-    return false;
+    event.midi.data[0] = status;
+
+    uint8_t j=1;
+    for (; j < size; ++j)
+        event.midi.data[j] = data[j];
+    for (; j < EngineMidiEvent::kDataSize; ++j)
+        event.midi.data[j] = 0;
+
+    event.midi.dataExt = nullptr;
+    return true;
 }
 
 // -----------------------------------------------------------------------
@@ -19,8 +19,13 @@
 #include "CarlaEngineThread.hpp"
 #include "CarlaPlugin.hpp"
 
+#include "juce_core.h"
+
 CARLA_BACKEND_START_NAMESPACE
 
+// max output parameter changes collected at once
+static const uint32_t kMaxChangedOutputs = 64;
+
 // -----------------------------------------------------------------------
 
 CarlaEngineThread::CarlaEngineThread(CarlaEngine* const engine) noexcept
@@ -50,6 +55,9 @@ void CarlaEngineThread::run() noexcept
     const bool isPlugin(kEngine->getType() == kEngineTypePlugin);
 #endif
     float value;
+    uint32_t changedOutputs[kMaxChangedOutputs];
+    uint32_t lastOutputTime = 0;
+    bool oscWasRegistered = false;
 
 #ifdef BUILD_BRIDGE
     for (; /*kEngine->isRunning() &&*/ ! shouldThreadExit();)
@@ -63,11 +71,36 @@ void CarlaEngineThread::run() noexcept
         const bool oscRegisted = false;
 #endif
 
+        // a new OSC client needs all output values, not only the ones changed from now on
+        if (oscRegisted && ! oscWasRegistered)
+        {
+            for (uint i=0, count = kEngine->getCurrentPluginCount(); i < count; ++i)
+            {
+                if (CarlaPlugin* const plugin = kEngine->getPluginUnchecked(i))
+                    plugin->setParameterOutputsChanged();
+            }
+        }
+
+        oscWasRegistered = oscRegisted;
+
 #ifdef HAVE_LIBLO
         if (isPlugin)
             kEngine->idleOsc();
 #endif
 
+        // limit output parameter updates, changes are kept until the next time
+        bool sendOutputs = true;
+
+        if (const uint outputRate = kEngine->getOptions().parameterOutputRate)
+        {
+            const uint32_t now(juce::Time::getMillisecondCounter());
+
+            if (now - lastOutputTime < 1000/outputRate)
+                sendOutputs = false;
+            else
+                lastOutputTime = now;
+        }
+
         for (uint i=0, count = kEngine->getCurrentPluginCount(); i < count; ++i)
         {
             CarlaPlugin* const plugin(kEngine->getPluginUnchecked(i));
@@ -91,23 +124,27 @@ void CarlaEngineThread::run() noexcept
             if (oscRegisted || updateUI)
             {
                 // -------------------------------------------------------
-                // Update parameter outputs
+                // Update parameter outputs, only those that changed
 
-                for (uint32_t j=0, pcount=plugin->getParameterCount(); j < pcount; ++j)
+                for (uint32_t changedCount = kMaxChangedOutputs; sendOutputs && changedCount == kMaxChangedOutputs;)
                 {
-                    if (! plugin->isParameterOutput(j))
-                        continue;
+                    changedCount = plugin->getChangedParameterOutputs(changedOutputs, kMaxChangedOutputs);
+
+                    for (uint32_t k=0; k < changedCount; ++k)
+                    {
+                        const uint32_t j(changedOutputs[k]);
 
-                    value = plugin->getParameterValue(j);
+                        value = plugin->getParameterValue(j);
 
 #if defined(HAVE_LIBLO) && ! defined(BUILD_BRIDGE)
-                    // Update OSC engine client
-                    if (oscRegisted)
-                        kEngine->oscSend_control_set_parameter_value(i, static_cast<int32_t>(j), value);
+                        // Update OSC engine client
+                        if (oscRegisted)
+                            kEngine->oscSend_control_set_parameter_value(i, static_cast<int32_t>(j), value);
 #endif
-                    // Update UI
-                    if (updateUI)
-                        plugin->uiParameterChange(j, value);
+                        // Update UI
+                        if (updateUI)
+                            plugin->uiParameterChange(j, value);
+                    }
                 }
 
                 if (updateUI)
@@ -0,0 +1,339 @@
+/*
+ * Carla Plugin Host
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the doc/GPL.txt file.
+ */
+
+#include "CarlaEngine.hpp"
+#include "CarlaEngineWorkers.hpp"
+#include "CarlaPlugin.hpp"
+
+#include "CarlaThread.hpp"
+
+#include "juce_core.h"
+
+CARLA_BACKEND_START_NAMESPACE
+
+// -----------------------------------------------------------------------
+
+// monotonic time in microseconds, wraps around but only differences are used
+static uint32_t getTimeInUsecs() noexcept
+{
+    const juce::int64 ticks(juce::Time::getHighResolutionTicks());
+    const juce::int64 ticksPerSec(juce::Time::getHighResolutionTicksPerSecond());
+
+    const uint32_t usecs(static_cast<uint32_t>(ticks / ticksPerSec * 1000000 + (ticks % ticksPerSec) * 1000000 / ticksPerSec));
+
+    // 0 is reserved for "nothing pending"
+    return (usecs != 0) ? usecs : 1;
+}
+
+// -----------------------------------------------------------------------
+
+class CarlaEngineWorkers::WorkerThread : public CarlaThread
+{
+public:
+    WorkerThread(CarlaEngineWorkers* const workers) noexcept
+        : CarlaThread("CarlaEngineWorker"),
+          kWorkers(workers) {}
+
+protected:
+    void run() noexcept override
+    {
+        kWorkers->runWorker(this);
+    }
+
+private:
+    CarlaEngineWorkers* const kWorkers;
+
+    CARLA_DECLARE_NON_COPY_CLASS(WorkerThread)
+};
+
+// -----------------------------------------------------------------------
+
+CarlaEngineWorkers::CarlaEngineWorkers(CarlaEngine* const engine) noexcept
+    : kEngine(engine),
+      fSem(),
+      fSignaled(0),
+      fQueueDepth(0),
+      fMaxQueueDepth(0),
+      fJobsDone(0),
+      fLastLatency(0),
+      fMaxLatency(0)
+{
+    CARLA_SAFE_ASSERT(engine != nullptr);
+    carla_debug("CarlaEngineWorkers::CarlaEngineWorkers(%p)", engine);
+
+    carla_sem_create2(fSem);
+
+    for (uint i=0; i < MAX_PATCHBAY_PLUGINS; ++i)
+    {
+        fPending[i]  = 0;
+        fRequests[i] = 0;
+        fBusy[i]     = 0;
+    }
+
+    for (uint i=0; i < kNumWorkers; ++i)
+    {
+        fThreads[i] = nullptr;
+
+        try {
+            fThreads[i] = new WorkerThread(this);
+        } CARLA_SAFE_EXCEPTION("WorkerThread");
+    }
+}
+
+CarlaEngineWorkers::~CarlaEngineWorkers() noexcept
+{
+    carla_debug("CarlaEngineWorkers::~CarlaEngineWorkers()");
+
+    stop();
+
+    for (uint i=0; i < kNumWorkers; ++i)
+    {
+        delete fThreads[i];
+        fThreads[i] = nullptr;
+    }
+
+    carla_sem_destroy2(fSem);
+}
+
+// -----------------------------------------------------------------------
+
+void CarlaEngineWorkers::start() noexcept
+{
+    carla_debug("CarlaEngineWorkers::start()");
+
+    for (uint i=0; i < kNumWorkers; ++i)
+    {
+        CARLA_SAFE_ASSERT_CONTINUE(fThreads[i] != nullptr);
+
+        if (! fThreads[i]->isThreadRunning())
+            fThreads[i]->startThread();
+    }
+
+    // requests scheduled while we were stopped are still pending
+    signal();
+}
+
+void CarlaEngineWorkers::stop() noexcept
+{
+    carla_debug("CarlaEngineWorkers::stop()");
+
+    for (uint i=0; i < kNumWorkers; ++i)
+    {
+        CARLA_SAFE_ASSERT_CONTINUE(fThreads[i] != nullptr);
+        fThreads[i]->signalThreadShouldExit();
+    }
+
+    signal();
+
+    // jobs can take a long time (e.g. loading files), give them a few seconds to finish
+    for (uint i=0; i < kNumWorkers; ++i)
+    {
+        CARLA_SAFE_ASSERT_CONTINUE(fThreads[i] != nullptr);
+        fThreads[i]->stopThread(5000);
+    }
+}
+
+bool CarlaEngineWorkers::isRunning() const noexcept
+{
+    for (uint i=0; i < kNumWorkers; ++i)
+    {
+        if (fThreads[i] != nullptr && fThreads[i]->isThreadRunning())
+            return true;
+    }
+
+    return false;
+}
+
+// -----------------------------------------------------------------------
+
+void CarlaEngineWorkers::schedule(const uint pluginId) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(pluginId < MAX_PATCHBAY_PLUGINS,);
+
+    const int depth(__sync_add_and_fetch(&fQueueDepth, 1));
+
+    for (int maxDepth = fMaxQueueDepth; depth > maxDepth; maxDepth = fMaxQueueDepth)
+    {
+        if (__sync_bool_compare_and_swap(&fMaxQueueDepth, maxDepth, depth))
+            break;
+    }
+
+    __sync_add_and_fetch(&fRequests[pluginId], 1);
+
+    // keep the oldest request time if already pending
+    __sync_bool_compare_and_swap(&fPending[pluginId], 0, getTimeInUsecs());
+
+    signal();
+}
+
+void CarlaEngineWorkers::removePlugin(const uint pluginId, const uint pluginCount) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(pluginId < pluginCount && pluginCount <= MAX_PATCHBAY_PLUGINS,);
+
+    // requests of the removed plugin leave the queue
+    __sync_sub_and_fetch(&fQueueDepth, __sync_lock_test_and_set(&fRequests[pluginId], 0));
+
+    for (uint i=pluginId+1; i < pluginCount; ++i)
+    {
+        fPending[i-1]  = fPending[i];
+        fRequests[i-1] = fRequests[i];
+        fBusy[i-1]     = fBusy[i];
+    }
+
+    fPending[pluginCount-1]  = 0;
+    fRequests[pluginCount-1] = 0;
+    fBusy[pluginCount-1]     = 0;
+}
+
+void CarlaEngineWorkers::removeAllPlugins() noexcept
+{
+    for (uint i=0; i < MAX_PATCHBAY_PLUGINS; ++i)
+    {
+        fPending[i]  = 0;
+        fRequests[i] = 0;
+        fBusy[i]     = 0;
+    }
+
+    fQueueDepth = 0;
+}
+
+void CarlaEngineWorkers::switchPlugins(const uint idA, const uint idB) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(idA < MAX_PATCHBAY_PLUGINS && idB < MAX_PATCHBAY_PLUGINS,);
+
+    const uint32_t pending(fPending[idA]);
+    fPending[idA] = fPending[idB];
+    fPending[idB] = pending;
+
+    const int requests(fRequests[idA]);
+    fRequests[idA] = fRequests[idB];
+    fRequests[idB] = requests;
+
+    const int busy(fBusy[idA]);
+    fBusy[idA] = fBusy[idB];
+    fBusy[idB] = busy;
+}
+
+void CarlaEngineWorkers::signal() noexcept
+{
+    // the semaphore can only be posted once, the waking worker resets the flag
+    if (__sync_bool_compare_and_swap(&fSignaled, 0, 1))
+        carla_sem_post(fSem);
+}
+
+// -----------------------------------------------------------------------
+
+void CarlaEngineWorkers::getStats(EngineWorkerStats& stats) const noexcept
+{
+    const int depth(fQueueDepth);
+
+    stats.queueDepth    = depth > 0 ? static_cast<uint>(depth) : 0;
+    stats.maxQueueDepth = static_cast<uint>(fMaxQueueDepth);
+    stats.jobsDone      = fJobsDone;
+    stats.lastLatency   = static_cast<float>(fLastLatency) / 1000.0f;
+    stats.maxLatency    = static_cast<float>(fMaxLatency) / 1000.0f;
+}
+
+void CarlaEngineWorkers::clearStats() noexcept
+{
+    fMaxQueueDepth = 0;
+    fJobsDone      = 0;
+    fLastLatency   = 0;
+    fMaxLatency    = 0;
+}
+
+// -----------------------------------------------------------------------
+
+void CarlaEngineWorkers::runWorker(WorkerThread* const thread) noexcept
+{
+    carla_debug("CarlaEngineWorkers::runWorker(%p)", thread);
+
+    for (; ! thread->shouldThreadExit();)
+    {
+        if (! carla_sem_timedwait(fSem, 100))
+            continue;
+
+        // allow new requests to wake up another worker while we are busy
+        __sync_bool_compare_and_swap(&fSignaled, 1, 0);
+
+        if (thread->shouldThreadExit())
+        {
+            // let the other workers see the exit request too
+            signal();
+            break;
+        }
+
+        for (uint i=0, count=kEngine->getCurrentPluginCount(); i < count && i < MAX_PATCHBAY_PLUGINS; ++i)
+        {
+            if (fPending[i] == 0)
+                continue;
+
+            runPluginJobs(i);
+        }
+    }
+}
+
+void CarlaEngineWorkers::runPluginJobs(const uint pluginId) noexcept
+{
+    // another worker is running jobs for this plugin, it will check again when done
+    if (! __sync_bool_compare_and_swap(&fBusy[pluginId], 0, 1))
+        return;
+
+    const uint32_t requestTime(__sync_lock_test_and_set(&fPending[pluginId], 0));
+
+    // every request taken here leaves the queue, whether the plugin had jobs for it or not
+    const int requests(__sync_lock_test_and_set(&fRequests[pluginId], 0));
+    __sync_sub_and_fetch(&fQueueDepth, requests);
+
+    if (requestTime != 0)
+    {
+        const uint32_t latency(getTimeInUsecs() - requestTime);
+
+        fLastLatency = latency;
+
+        if (latency > fMaxLatency)
+            fMaxLatency = latency;
+
+        // more work waiting, wake up another worker
+        if (fQueueDepth > 0)
+            signal();
+
+        if (CarlaPlugin* const plugin = kEngine->getPluginUnchecked(pluginId))
+        {
+            uint jobs = 0;
+
+            if (plugin->isEnabled())
+            {
+                try {
+                    jobs = plugin->runWorkerJobs();
+                } CARLA_SAFE_EXCEPTION("runWorkerJobs");
+            }
+
+            __sync_add_and_fetch(&fJobsDone, jobs);
+        }
+    }
+
+    __sync_lock_release(&fBusy[pluginId]);
+
+    // a request might have arrived while we were busy
+    if (fPending[pluginId] != 0)
+        signal();
+}
+
+// -----------------------------------------------------------------------
+
+CARLA_BACKEND_END_NAMESPACE
@@ -0,0 +1,93 @@
+/*
+ * Carla Plugin Host
+ * Copyright (C) 2011-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the doc/GPL.txt file.
+ */
+
+#ifndef CARLA_ENGINE_WORKERS_HPP_INCLUDED
+#define CARLA_ENGINE_WORKERS_HPP_INCLUDED
+
+#include "CarlaBackend.h"
+#include "CarlaJuceUtils.hpp"
+#include "CarlaSemUtils.hpp"
+
+CARLA_BACKEND_START_NAMESPACE
+
+struct EngineWorkerStats;
+
+// -----------------------------------------------------------------------
+// CarlaEngineWorkers
+
+/*
+ * Pool of non-realtime threads used to run plugin background jobs (e.g. LV2 worker).
+ * The audio thread calls schedule() with a plugin id, which only sets a flag and
+ * wakes up one of the workers; the worker then calls CarlaPlugin::runWorkerJobs().
+ * A plugin never runs jobs in more than one worker at the same time.
+ */
+class CarlaEngineWorkers
+{
+public:
+    static const uint kNumWorkers = 2;
+
+    CarlaEngineWorkers(CarlaEngine* const engine) noexcept;
+    ~CarlaEngineWorkers() noexcept;
+
+    void start() noexcept;
+    void stop() noexcept;
+    bool isRunning() const noexcept;
+
+    // realtime safe
+    void schedule(const uint pluginId) noexcept;
+
+    // pending requests follow the plugins when the engine renumbers them, workers must be stopped
+    void removePlugin(const uint pluginId, const uint pluginCount) noexcept;
+    void removeAllPlugins() noexcept;
+    void switchPlugins(const uint idA, const uint idB) noexcept;
+
+    void getStats(EngineWorkerStats& stats) const noexcept;
+    void clearStats() noexcept;
+
+private:
+    class WorkerThread;
+
+    CarlaEngine* const kEngine;
+    WorkerThread* fThreads[kNumWorkers];
+
+    carla_sem_t fSem;
+    volatile int fSignaled;
+
+    // request time in usecs per plugin, 0 if nothing is pending
+    volatile uint32_t fPending[MAX_PATCHBAY_PLUGINS];
+    volatile int      fRequests[MAX_PATCHBAY_PLUGINS];
+    volatile int      fBusy[MAX_PATCHBAY_PLUGINS];
+
+    // stats, the queue depth is the sum of fRequests
+    volatile int      fQueueDepth;
+    volatile int      fMaxQueueDepth;
+    volatile uint32_t fJobsDone;
+    volatile uint32_t fLastLatency;
+    volatile uint32_t fMaxLatency;
+
+    void signal() noexcept;
+    void runWorker(WorkerThread* const thread) noexcept;
+    void runPluginJobs(const uint pluginId) noexcept;
+
+    CARLA_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CarlaEngineWorkers)
+};
+
+// -----------------------------------------------------------------------
+
+CARLA_BACKEND_END_NAMESPACE
+
+#endif // CARLA_ENGINE_WORKERS_HPP_INCLUDED
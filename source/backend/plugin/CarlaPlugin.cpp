@@ -74,6 +74,14 @@ struct ParamSymbol {
 #endif
 };
 
+// -------------------------------------------------------------------
+// PluginBridgeWaitStats
+
+PluginBridgeWaitStats::PluginBridgeWaitStats() noexcept
+    : spinHits(0),
+      sleeps(0),
+      timeouts(0) {}
+
 // -------------------------------------------------------------------
 // Constructor and destructor
 
@@ -476,7 +484,7 @@ void CarlaPlugin::randomizeParameters() noexcept
     }
 }
 
-const CarlaStateSave& CarlaPlugin::getStateSave(const bool callPrepareForSave)
+const CarlaStateSave& CarlaPlugin::getStateSave(const bool callPrepareForSave, const bool rawChunk)
 {
     if (callPrepareForSave)
         prepareForSave();
@@ -528,7 +536,15 @@ const CarlaStateSave& CarlaPlugin::getStateSave(const bool callPrepareForSave)
 
         if (data != nullptr && dataSize > 0)
         {
-            pData->stateSave.chunk = CarlaString::asBase64(data, dataSize).dup();
+            if (rawChunk)
+            {
+                pData->stateSave.chunkData = data;
+                pData->stateSave.chunkSize = dataSize;
+            }
+            else
+            {
+                pData->stateSave.chunk = CarlaString::asBase64(data, dataSize).dup();
+            }
 
             if (pluginType != PLUGIN_INTERNAL)
                 usingChunk = true;
@@ -834,10 +850,17 @@ void CarlaPlugin::loadStateSave(const CarlaStateSave& stateSave)
     // ---------------------------------------------------------------
     // Part 6 - set chunk
 
-    if (stateSave.chunk != nullptr && (pData->options & PLUGIN_OPTION_USE_CHUNKS) != 0)
+    if ((pData->options & PLUGIN_OPTION_USE_CHUNKS) != 0)
     {
-        std::vector<uint8_t> chunk(carla_getChunkFromBase64String(stateSave.chunk));
-        setChunkData(chunk.data(), chunk.size());
+        if (stateSave.chunkData != nullptr && stateSave.chunkSize > 0)
+        {
+            setChunkData(stateSave.chunkData, stateSave.chunkSize);
+        }
+        else if (stateSave.chunk != nullptr)
+        {
+            std::vector<uint8_t> chunk(carla_getChunkFromBase64String(stateSave.chunk));
+            setChunkData(chunk.data(), chunk.size());
+        }
     }
 
 #ifndef BUILD_BRIDGE
@@ -1212,7 +1235,11 @@ void CarlaPlugin::setParameterMidiChannel(const uint32_t parameterId, const uint
     CARLA_SAFE_ASSERT_RETURN(parameterId < pData->param.count,);
     CARLA_SAFE_ASSERT_RETURN(channel < MAX_MIDI_CHANNELS,);
 
-    pData->param.data[parameterId].midiChannel = channel;
+    if (pData->param.data[parameterId].midiChannel != channel)
+    {
+        pData->param.data[parameterId].midiChannel = channel;
+        pData->midiControlMap.update(pData->param);
+    }
 
 #ifndef BUILD_BRIDGE
 # ifdef HAVE_LIBLO
@@ -1236,7 +1263,11 @@ void CarlaPlugin::setParameterMidiCC(const uint32_t parameterId, const int16_t c
     CARLA_SAFE_ASSERT_RETURN(parameterId < pData->param.count,);
     CARLA_SAFE_ASSERT_RETURN(cc >= -1 && cc < MAX_MIDI_CONTROL,);
 
-    pData->param.data[parameterId].midiCC = cc;
+    if (pData->param.data[parameterId].midiCC != cc)
+    {
+        pData->param.data[parameterId].midiCC = cc;
+        pData->midiControlMap.update(pData->param);
+    }
 
 #ifndef BUILD_BRIDGE
 # ifdef HAVE_LIBLO
@@ -1407,6 +1438,65 @@ void CarlaPlugin::offlineModeChanged(const bool)
 // -------------------------------------------------------------------
 // Misc
 
+uint32_t CarlaPlugin::getChangedParameterOutputs(uint32_t* const parameterIds, const uint32_t maxCount) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(parameterIds != nullptr, 0);
+    CARLA_SAFE_ASSERT_RETURN(maxCount > 0, 0);
+
+    PluginParameterData& param(pData->param);
+
+    if (param.count == 0)
+        return 0;
+
+    // plugin does not report changes itself
+    if (! param.tracksOutputs)
+    {
+        for (uint32_t i=0; i < param.count; ++i)
+        {
+            if (param.data[i].type == PARAMETER_OUTPUT)
+                param.setOutputValue(i, getParameterValue(i));
+        }
+    }
+
+    uint32_t found = 0;
+
+    for (uint32_t i=0, wordCount=(param.count+31)/32; i < wordCount && found < maxCount; ++i)
+    {
+        if (param.outputChanges[i] == 0)
+            continue;
+
+        uint32_t changes(__sync_fetch_and_and(&param.outputChanges[i], 0U));
+
+        for (; changes != 0;)
+        {
+            if (found == maxCount)
+            {
+                // no more space, keep the rest for later
+                __sync_fetch_and_or(&param.outputChanges[i], changes);
+                break;
+            }
+
+            const uint32_t bit(static_cast<uint32_t>(__builtin_ctz(changes)));
+            const uint32_t parameterId(i*32 + bit);
+
+            changes &= ~(1U << bit);
+
+            if (parameterId < param.count && param.data[parameterId].type == PARAMETER_OUTPUT)
+                parameterIds[found++] = parameterId;
+        }
+    }
+
+    return found;
+}
+
+void CarlaPlugin::setParameterOutputsChanged() noexcept
+{
+    PluginParameterData& param(pData->param);
+
+    for (uint32_t i=0, wordCount=(param.count+31)/32; i < wordCount; ++i)
+        __sync_fetch_and_or(&param.outputChanges[i], 0xffffffff);
+}
+
 void CarlaPlugin::idle()
 {
     if (! pData->enabled)
@@ -1429,11 +1519,13 @@ void CarlaPlugin::idle()
         pData->latency.recreateBuffers(pData->latency.channels, latency);
     }
 
-    const CarlaMutexLocker sl(pData->postRtEvents.mutex);
+    if (const uint32_t dropped = pData->postRtEvents.beginTake())
+        carla_stderr2("CarlaPlugin::idle() - %u events from the audio thread were dropped", dropped);
 
-    for (RtLinkedList<PluginPostRtEvent>::Itenerator it = pData->postRtEvents.data.begin2(); it.valid(); it.next())
+    PluginPostRtEvent event;
+
+    for (; pData->postRtEvents.take(event);)
     {
-        const PluginPostRtEvent& event(it.getValue(kPluginPostRtEventFallback));
         CARLA_SAFE_ASSERT_CONTINUE(event.type != kPluginPostRtEventNull);
 
         switch (event.type)
@@ -1596,8 +1688,11 @@ void CarlaPlugin::idle()
         } break;
         }
     }
+}
 
-    pData->postRtEvents.data.clear();
+uint CarlaPlugin::runWorkerJobs()
+{
+    return 0;
 }
 
 bool CarlaPlugin::tryLock(const bool forcedOffline) noexcept
@@ -1973,6 +2068,11 @@ uintptr_t CarlaPlugin::getUiBridgeProcessId() const noexcept
     return 0;
 }
 
+bool CarlaPlugin::getBridgeWaitStats(PluginBridgeWaitStats&) const noexcept
+{
+    return false;
+}
+
 // -------------------------------------------------------------------
 
 uint32_t CarlaPlugin::getPatchbayNodeId() const noexcept
@@ -2012,6 +2112,10 @@ CarlaPlugin::ScopedDisabler::~ScopedDisabler() noexcept
     CARLA_SAFE_ASSERT_RETURN(fPlugin->pData->client != nullptr,);
     carla_debug("CarlaPlugin::~ScopedDisabler()");
 
+    // parameters might have changed
+    fPlugin->pData->midiControlMap.update(fPlugin->pData->param);
+    fPlugin->pData->postRtEvents.setParameterCount(fPlugin->pData->param.count);
+
     fPlugin->pData->enabled = true;
     fPlugin->pData->client->activate();
     fPlugin->pData->masterMutex.unlock();
@@ -128,23 +128,49 @@ struct BridgeAudioPool {
 
 // -------------------------------------------------------------------------------------------------------------------
 
+// max time spent spinning before sleeping on the semaphore
+static const uint kBridgeMaxSpinUsecs = 50;
+
+// spinning is worth retrying after this many sleeps in a row
+static const uint kBridgeSpinRetryPeriod = 64;
+
+static inline
+void bridgeSpinPause() noexcept
+{
+#if defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#endif
+}
+
 struct BridgeRtClientControl : public CarlaRingBufferControl<SmallStackBuffer> {
     BridgeRtClientData* data;
     CarlaString filename;
     bool needsSemDestroy;
     carla_shm_t shm;
 
+    // spin-then-sleep wait for the client, see waitForClientResult()
+    uint spinMax;
+    uint spinLimit;
+    uint sleepsInRow;
+
+    PluginBridgeWaitStats stats;
+
     BridgeRtClientControl()
         : data(nullptr),
           filename(),
-          needsSemDestroy(false)
+          needsSemDestroy(false),
 #ifdef CARLA_PROPER_CPP11_SUPPORT
-        , shm(carla_shm_t_INIT) {}
-#else
+          shm(carla_shm_t_INIT),
+#endif
+          spinMax(0),
+          spinLimit(0),
+          sleepsInRow(0),
+          stats()
     {
+#ifndef CARLA_PROPER_CPP11_SUPPORT
         carla_shm_init(shm);
-    }
 #endif
+    }
 
     ~BridgeRtClientControl() noexcept override
     {
@@ -192,6 +218,11 @@ struct BridgeRtClientControl : public CarlaRingBufferControl<SmallStackBuffer> {
 
         filename = tmpFileBase;
         needsSemDestroy = true;
+
+        spinMax     = calibrateSpinCount();
+        spinLimit   = spinMax;
+        sleepsInRow = 0;
+        stats = PluginBridgeWaitStats();
         return true;
     }
 
@@ -246,7 +277,83 @@ struct BridgeRtClientControl : public CarlaRingBufferControl<SmallStackBuffer> {
 
         jackbridge_sem_post(&data->sem.server);
 
-        return jackbridge_sem_timedwait(&data->sem.client, msecs);
+        return waitForClientResult(msecs);
+    }
+
+    // split version of waitForClient, used for pipelined processing
+    void kickClient() noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(data != nullptr,);
+
+        jackbridge_sem_post(&data->sem.server);
+    }
+
+    bool waitForClientResult(const uint msecs) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(data != nullptr, false);
+
+        // clients usually answer within microseconds, spin on the shared counter first
+        for (uint i=0; i < spinLimit; ++i)
+        {
+            if (jackbridge_sem_trywait(&data->sem.client))
+            {
+                ++stats.spinHits;
+                sleepsInRow = 0;
+
+                // keep some headroom over the last answer time
+                if (i*2 > spinLimit)
+                    spinLimit = std::min(i*2, spinMax);
+
+                return true;
+            }
+
+            bridgeSpinPause();
+        }
+
+        // spinning did not pay off, do less of it until it is time to probe again
+        ++stats.sleeps;
+
+        if (++sleepsInRow % kBridgeSpinRetryPeriod == 0)
+            spinLimit = spinMax;
+        else
+            spinLimit /= 2;
+
+        if (jackbridge_sem_timedwait(&data->sem.client, msecs))
+            return true;
+
+        ++stats.timeouts;
+        return false;
+    }
+
+    // number of spin iterations that fit in kBridgeMaxSpinUsecs, 0 if spinning makes no sense
+    static uint calibrateSpinCount() noexcept
+    {
+        if (sysconf(_SC_NPROCESSORS_ONLN) <= 1)
+            return 0;
+
+        BridgeSemaphore tmp;
+        carla_zeroStruct(tmp);
+        CARLA_SAFE_ASSERT_RETURN(jackbridge_sem_init(&tmp.server), 0);
+
+        static const uint kIterations = 1000;
+
+        const int64_t start(Time::getHighResolutionTicks());
+
+        for (uint i=0; i < kIterations; ++i)
+        {
+            if (jackbridge_sem_trywait(&tmp.server))
+                break;
+            bridgeSpinPause();
+        }
+
+        const double usecs(Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start) * 1000000.0);
+
+        jackbridge_sem_destroy(&tmp.server);
+
+        if (usecs <= 0.0)
+            return kIterations;
+
+        return static_cast<uint>(std::min(double(kIterations) * kBridgeMaxSpinUsecs / usecs, 1000000.0));
     }
 
     void writeOpcode(const PluginBridgeRtClientOpcode opcode) noexcept
@@ -739,6 +846,9 @@ public:
           fTimedOut(false),
           fTimedError(false),
           fProcWaitTime(0),
+          fPipelined(engine->getOptions().pipelinedBridges),
+          fPipelinePending(false),
+          fPipelineFrames(0),
           fLastPongTime(-1),
           fBridgeBinary(),
           fBridgeThread(engine, this),
@@ -753,6 +863,11 @@ public:
         carla_debug("CarlaPluginBridge::CarlaPluginBridge(%p, %i, %s, %s)", engine, id, BinaryType2Str(btype), PluginType2Str(ptype));
 
         pData->hints |= PLUGIN_IS_BRIDGE;
+
+        // output values are received in handleNonRtData()
+        pData->param.tracksOutputs = true;
+
+        carla_zeroBytes(fPipelineMidiOut, kBridgeRtClientDataMidiOutSize);
     }
 
     ~CarlaPluginBridge() override
@@ -789,6 +904,8 @@ public:
 
         fBridgeThread.stopThread(3000);
 
+        setAudioPortsInPool(0);
+
         fShmNonRtServerControl.clear();
         fShmNonRtClientControl.clear();
         fShmRtClientControl.clear();
@@ -1644,8 +1761,6 @@ public:
                 }
             }
 
-            pData->postRtEvents.trySplice();
-
         } // End of Event Input
 
         if (! processSingle(audioIn, audioOut, cvIn, cvOut, frames))
@@ -1672,7 +1787,7 @@ public:
 
             uint8_t size;
             uint32_t time;
-            const uint8_t* midiData(fShmRtClientControl.data->midiOut);
+            const uint8_t* midiData(isPipelined() ? fPipelineMidiOut : fShmRtClientControl.data->midiOut);
 
             for (std::size_t read=0; read<kBridgeRtClientDataMidiOutSize;)
             {
@@ -1742,11 +1857,115 @@ public:
             return false;
         }
 
+        const int iframes(static_cast<int>(frames));
+
+        if (isPipelined())
+        {
+            // ----------------------------------------------------------------------------------------------------
+            // Collect the cycle started in the previous process call
+
+            bool ready = false;
+
+            if (fPipelinePending)
+            {
+                const bool sameFrames(fPipelineFrames == frames);
+
+                if (! waitForPipelinedProcess(fProcWaitTime))
+                {
+                    pData->singleMutex.unlock();
+                    return false;
+                }
+
+                ready = sameFrames;
+            }
+
+            if (ready)
+            {
+                // the previous inputs are still in the pool, use them as dry signal
+                const float* dryIn[fInfo.aIns > 0 ? fInfo.aIns : 1];
+
+                for (uint32_t i=0; i < fInfo.aIns; ++i)
+                    dryIn[i] = fShmAudioPool.data + (i * frames);
+
+                for (uint32_t i=0; i < fInfo.aOuts; ++i)
+                    FloatVectorOperations::copy(audioOut[i], fShmAudioPool.data + ((i + fInfo.aIns) * frames), iframes);
+
+                if (fInfo.mOuts > 0)
+                    carla_copy<uint8_t>(fPipelineMidiOut, fShmRtClientControl.data->midiOut, kBridgeRtClientDataMidiOutSize);
+
+                postProcess(dryIn, audioOut, frames);
+            }
+            else
+            {
+                for (uint32_t i=0; i < pData->audioOut.count; ++i)
+                    FloatVectorOperations::clear(audioOut[i], iframes);
+
+                fPipelineMidiOut[0] = 0;
+            }
+
+            // ----------------------------------------------------------------------------------------------------
+            // Start the next cycle, the bridge runs while the engine does other work
+
+            startProcess(audioIn, frames);
+            fShmRtClientControl.kickClient();
+
+            fPipelinePending = true;
+            fPipelineFrames  = frames;
+
+            pData->singleMutex.unlock();
+            return true;
+        }
+
+        // switching from pipelined mode, drop the pending result
+        if (fPipelinePending && ! waitForPipelinedProcess(fProcWaitTime))
+        {
+            pData->singleMutex.unlock();
+            return false;
+        }
+
+        // --------------------------------------------------------------------------------------------------------
+        // Run plugin
+
+        startProcess(audioIn, frames);
+
+        waitForClient("process", fProcWaitTime);
+
+        if (fTimedOut)
+        {
+            pData->singleMutex.unlock();
+            return false;
+        }
+
+        for (uint32_t i=0; i < fInfo.aOuts; ++i)
+        {
+            const float* const poolBuf(fShmAudioPool.data + ((i + fInfo.aIns) * frames));
+
+            if (audioOut[i] != poolBuf)
+                FloatVectorOperations::copy(audioOut[i], poolBuf, iframes);
+        }
+
+        postProcess(audioIn, audioOut, frames);
+
+        // --------------------------------------------------------------------------------------------------------
+
+        pData->singleMutex.unlock();
+        return true;
+    }
+
+    // copy inputs and time info to the bridge and queue a process request
+    void startProcess(const float** const audioIn, const uint32_t frames) noexcept
+    {
         // --------------------------------------------------------------------------------------------------------
         // Reset audio buffers
 
         for (uint32_t i=0; i < fInfo.aIns; ++i)
-            FloatVectorOperations::copy(fShmAudioPool.data + (i * frames), audioIn[i], static_cast<int>(frames));
+        {
+            float* const poolBuf(fShmAudioPool.data + (i * frames));
+
+            // the engine might have written directly into the pool
+            if (audioIn[i] != poolBuf)
+                FloatVectorOperations::copy(poolBuf, audioIn[i], static_cast<int>(frames));
+        }
 
         // --------------------------------------------------------------------------------------------------------
         // TimeInfo
@@ -1774,99 +1993,37 @@ public:
         }
 
         // --------------------------------------------------------------------------------------------------------
-        // Run plugin
-
-        {
-            fShmRtClientControl.writeOpcode(kPluginBridgeRtClientProcess);
-            fShmRtClientControl.commitWrite();
-        }
+        // Process request
 
-        waitForClient("process", fProcWaitTime);
-
-        if (fTimedOut)
-        {
-            pData->singleMutex.unlock();
-            return false;
-        }
-
-        for (uint32_t i=0; i < fInfo.aOuts; ++i)
-            FloatVectorOperations::copy(audioOut[i], fShmAudioPool.data + ((i + fInfo.aIns) * frames), static_cast<int>(frames));
+        fShmRtClientControl.writeOpcode(kPluginBridgeRtClientProcess);
+        fShmRtClientControl.commitWrite();
+    }
 
+    void postProcess(const float** const audioIn, float** const audioOut, const uint32_t frames) noexcept
+    {
 #ifndef BUILD_BRIDGE
         // --------------------------------------------------------------------------------------------------------
         // Post-processing (dry/wet, volume and balance)
 
-        {
-            const bool doVolume  = (pData->hints & PLUGIN_CAN_VOLUME) != 0 && carla_isNotEqual(pData->postProc.volume, 1.0f);
-            const bool doDryWet  = (pData->hints & PLUGIN_CAN_DRYWET) != 0 && carla_isNotEqual(pData->postProc.dryWet, 1.0f);
-            const bool doBalance = (pData->hints & PLUGIN_CAN_BALANCE) != 0 && ! (carla_isEqual(pData->postProc.balanceLeft, -1.0f) && carla_isEqual(pData->postProc.balanceRight, 1.0f));
-
-            bool isPair;
-            float bufValue, oldBufLeft[doBalance ? frames : 1];
-
-            for (uint32_t i=0; i < pData->audioOut.count; ++i)
-            {
-                // Dry/Wet
-                if (doDryWet)
-                {
-                    for (uint32_t k=0; k < frames; ++k)
-                    {
-                        bufValue        = audioIn[(pData->audioIn.count == 1) ? 0 : i][k];
-                        audioOut[i][k] = (audioOut[i][k] * pData->postProc.dryWet) + (bufValue * (1.0f - pData->postProc.dryWet));
-                    }
-                }
-
-                // Balance
-                if (doBalance)
-                {
-                    isPair = (i % 2 == 0);
-
-                    if (isPair)
-                    {
-                        CARLA_ASSERT(i+1 < pData->audioOut.count);
-                        FloatVectorOperations::copy(oldBufLeft, audioOut[i], static_cast<int>(frames));
-                    }
-
-                    float balRangeL = (pData->postProc.balanceLeft  + 1.0f)/2.0f;
-                    float balRangeR = (pData->postProc.balanceRight + 1.0f)/2.0f;
-
-                    for (uint32_t k=0; k < frames; ++k)
-                    {
-                        if (isPair)
-                        {
-                            // left
-                            audioOut[i][k]  = oldBufLeft[k]     * (1.0f - balRangeL);
-                            audioOut[i][k] += audioOut[i+1][k] * (1.0f - balRangeR);
-                        }
-                        else
-                        {
-                            // right
-                            audioOut[i][k]  = audioOut[i][k] * balRangeR;
-                            audioOut[i][k] += oldBufLeft[k]   * balRangeL;
-                        }
-                    }
-                }
-
-                // Volume (and buffer copy)
-                if (doVolume)
-                {
-                    for (uint32_t k=0; k < frames; ++k)
-                        audioOut[i][k] *= pData->postProc.volume;
-                }
-            }
-
-        } // End of Post-processing
-
+        pData->postProcessRT(audioIn, audioOut, nullptr, nullptr, 0, frames, false);
+#else
+        // unused
+        (void)audioIn;
+        (void)audioOut;
+        (void)frames;
 #endif // BUILD_BRIDGE
+    }
 
-        // --------------------------------------------------------------------------------------------------------
-
-        pData->singleMutex.unlock();
-        return true;
+    uint32_t getLatencyInFrames() const noexcept override
+    {
+        // results arrive one buffer later when pipelined
+        return isPipelined() ? pData->engine->getBufferSize() : 0;
     }
 
     void bufferSizeChanged(const uint32_t newBufferSize) override
     {
+        const ScopedSingleProcessLocker spl(this, true);
+
         resizeAudioPool(newBufferSize);
 
         {
@@ -1884,6 +2041,8 @@ public:
 
     void sampleRateChanged(const double newSampleRate) override
     {
+        const ScopedSingleProcessLocker spl(this, true);
+
         {
             const CarlaMutexLocker _cml(fShmNonRtClientControl.mutex);
             fShmNonRtClientControl.writeOpcode(kPluginBridgeNonRtClientSetSampleRate);
@@ -1899,6 +2058,8 @@ public:
 
     void offlineModeChanged(const bool isOffline) override
     {
+        const ScopedSingleProcessLocker spl(this, true);
+
         {
             const CarlaMutexLocker _cml(fShmNonRtClientControl.mutex);
             fShmNonRtClientControl.writeOpcode(isOffline ? kPluginBridgeNonRtClientSetOffline : kPluginBridgeNonRtClientSetOnline);
@@ -2224,6 +2385,9 @@ public:
                 {
                     const float fixedValue(pData->param.getFixedValue(index, value));
                     fParams[index].value = fixedValue;
+
+                    if (pData->param.data[index].type == PARAMETER_OUTPUT)
+                        pData->param.setOutputValue(index, fixedValue);
                 }
             }   break;
 
@@ -2420,6 +2584,13 @@ public:
         return fBridgeThread.getProcessPID();
     }
 
+    // counted by the audio thread, values might be one wait behind
+    bool getBridgeWaitStats(PluginBridgeWaitStats& stats) const noexcept override
+    {
+        stats = fShmRtClientControl.stats;
+        return true;
+    }
+
     const void* getExtraStuff() const noexcept override
     {
         return fBridgeBinary.isNotEmpty() ? fBridgeBinary.buffer() : nullptr;
@@ -2612,6 +2783,12 @@ private:
     bool fTimedError;
     uint fProcWaitTime;
 
+    // pipelined processing, see ENGINE_OPTION_PIPELINED_BRIDGES
+    const bool fPipelined;
+    bool       fPipelinePending;
+    uint32_t   fPipelineFrames;
+    uint8_t    fPipelineMidiOut[kBridgeRtClientDataMidiOutSize];
+
     int64_t fLastPongTime;
 
     CarlaString             fBridgeBinary;
@@ -2654,8 +2831,16 @@ private:
 
     BridgeParamInfo* fParams;
 
+    // needs the process lock, see waitForPipelinedProcess()
     void resizeAudioPool(const uint32_t bufferSize)
     {
+        // the bridge might still be using the old pool
+        waitForPipelinedProcess(5000);
+
+        // the internal patchbay uses our port buffers with the master lock held,
+        // keep it while the pool they point into is replaced
+        const CarlaMutexLocker cml(pData->masterMutex);
+
         fShmAudioPool.resize(bufferSize, fInfo.aIns+fInfo.aOuts, fInfo.cvIns+fInfo.cvOuts);
 
         fShmRtClientControl.writeOpcode(kPluginBridgeRtClientSetAudioPool);
@@ -2663,13 +2848,39 @@ private:
         fShmRtClientControl.commitWrite();
 
         waitForClient("resize-pool", 5000);
+
+        setAudioPortsInPool(bufferSize);
     }
 
+    // Let the internal patchbay use the shared audio pool as our port buffers, so it writes our inputs and
+    // reads our outputs directly. Not used when pipelined, as the pool is then busy during the engine cycle.
+    void setAudioPortsInPool(const uint32_t bufferSize) noexcept
+    {
+        const bool direct(bufferSize > 0 && fShmAudioPool.data != nullptr && ! fPipelined &&
+                          pData->engine->getProccessMode() == ENGINE_PROCESS_MODE_PATCHBAY);
+
+        for (uint32_t i=0; i < pData->audioIn.count; ++i)
+        {
+            if (CarlaEngineAudioPort* const port = pData->audioIn.ports[i].port)
+                port->setExternalBuffer(direct && i < fInfo.aIns ? fShmAudioPool.data + (i * bufferSize) : nullptr);
+        }
+
+        for (uint32_t i=0; i < pData->audioOut.count; ++i)
+        {
+            if (CarlaEngineAudioPort* const port = pData->audioOut.ports[i].port)
+                port->setExternalBuffer(direct && i < fInfo.aOuts ? fShmAudioPool.data + ((i + fInfo.aIns) * bufferSize) : nullptr);
+        }
+    }
+
+    // needs the process lock, see waitForPipelinedProcess()
     void waitForClient(const char* const action, const uint msecs)
     {
         CARLA_SAFE_ASSERT_RETURN(! fTimedOut,);
         CARLA_SAFE_ASSERT_RETURN(! fTimedError,);
 
+        if (! waitForPipelinedProcess(msecs))
+            return;
+
         if (fShmRtClientControl.waitForClient(msecs))
             return;
 
@@ -2677,6 +2888,28 @@ private:
         carla_stderr("waitForClient(%s) timed out", action);
     }
 
+    bool isPipelined() const noexcept
+    {
+        return fPipelined && ! pData->engine->isOffline();
+    }
+
+    // wait for the process request sent in the previous cycle, if any.
+    // the audio thread uses the same semaphore, so this must only be called with pData->singleMutex locked.
+    bool waitForPipelinedProcess(const uint msecs) noexcept
+    {
+        if (! fPipelinePending)
+            return true;
+
+        fPipelinePending = false;
+
+        if (fShmRtClientControl.waitForClientResult(msecs))
+            return true;
+
+        fTimedOut = true;
+        carla_stderr("waitForClient(process) timed out");
+        return false;
+    }
+
     CARLA_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CarlaPluginBridge)
 };
 
@@ -181,7 +181,10 @@ PluginParameterData::PluginParameterData() noexcept
     : count(0),
       data(nullptr),
       ranges(nullptr),
-      special(nullptr) {}
+      special(nullptr),
+      outputValues(nullptr),
+      outputChanges(nullptr),
+      tracksOutputs(false) {}
 
 PluginParameterData::~PluginParameterData() noexcept
 {
@@ -189,6 +192,8 @@ PluginParameterData::~PluginParameterData() noexcept
     CARLA_SAFE_ASSERT(data == nullptr);
     CARLA_SAFE_ASSERT(ranges == nullptr);
     CARLA_SAFE_ASSERT(special == nullptr);
+    CARLA_SAFE_ASSERT(outputValues == nullptr);
+    CARLA_SAFE_ASSERT(outputChanges == nullptr);
 }
 
 void PluginParameterData::createNew(const uint32_t newCount, const bool withSpecial)
@@ -218,6 +223,15 @@ void PluginParameterData::createNew(const uint32_t newCount, const bool withSpec
         carla_zeroStructs(special, newCount);
     }
 
+    outputValues = new float[newCount];
+    carla_zeroFloats(outputValues, newCount);
+
+    // everything starts as changed, so the first values get sent
+    const uint32_t wordCount((newCount+31)/32);
+    uint32_t* const changes(new uint32_t[wordCount]);
+    carla_fill<uint32_t>(changes, 0xffffffff, wordCount);
+    outputChanges = changes;
+
     count = newCount;
 }
 
@@ -241,6 +255,18 @@ void PluginParameterData::clear() noexcept
         special = nullptr;
     }
 
+    if (outputValues != nullptr)
+    {
+        delete[] outputValues;
+        outputValues = nullptr;
+    }
+
+    if (outputChanges != nullptr)
+    {
+        delete[] outputChanges;
+        outputChanges = nullptr;
+    }
+
     count = 0;
 }
 
@@ -266,6 +292,17 @@ float PluginParameterData::getFixedValue(const uint32_t parameterId, const float
     return paramRanges.getFixedValue(value);
 }
 
+void PluginParameterData::setOutputValue(const uint32_t parameterId, const float value) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(parameterId < count,);
+
+    if (carla_isEqual(outputValues[parameterId], value))
+        return;
+
+    outputValues[parameterId] = value;
+    __sync_fetch_and_or(&outputChanges[parameterId/32], 1U << (parameterId%32));
+}
+
 // -----------------------------------------------------------------------
 // PluginProgramData
 
@@ -469,38 +506,215 @@ void CarlaPlugin::ProtectedData::Latency::recreateBuffers(const uint32_t newChan
 // -----------------------------------------------------------------------
 // ProtectedData::PostRtEvents
 
+// number of special parameter slots, PARAMETER_MAX+1 is slot 0
+static const int32_t kPostRtSpecialParameters = -static_cast<int32_t>(PARAMETER_MAX) - 1;
+
+void CarlaPlugin::ProtectedData::PostRtEvents::deleteParameters(Parameters* params) noexcept
+{
+    for (; params != nullptr;)
+    {
+        Parameters* const next(params->nextRetired);
+
+        delete[] params->values;
+        delete[] params->changed;
+        delete[] params->notify;
+        delete params;
+
+        params = next;
+    }
+}
+
 CarlaPlugin::ProtectedData::PostRtEvents::PostRtEvents() noexcept
-    : mutex(),
-      dataPool(128, 128),
-      data(dataPool),
-      dataPendingRT(dataPool) {}
+    : ringHead(0),
+      ringTail(0),
+      params(nullptr),
+      retired(nullptr),
+      dropped(0),
+      coalesced(0),
+      takeParams(nullptr),
+      takeWord(0),
+      takeNextWord(0),
+      takeBits(0),
+      takeNotify(0),
+      takeRingEnd(0),
+      droppedReported(0)
+{
+    carla_zeroStructs(ring, kRingSize);
+}
 
 CarlaPlugin::ProtectedData::PostRtEvents::~PostRtEvents() noexcept
 {
-    clear();
+    deleteParameters(params);
+    deleteParameters(retired);
+    params  = nullptr;
+    retired = nullptr;
 }
 
 void CarlaPlugin::ProtectedData::PostRtEvents::appendRT(const PluginPostRtEvent& e) noexcept
 {
-    dataPendingRT.append(e);
+    if (e.type == kPluginPostRtEventParameterChange)
+    {
+        Parameters* const p(params);
+        const int32_t slot(e.value1 + kPostRtSpecialParameters);
+
+        if (p != nullptr && slot >= 0 && static_cast<uint32_t>(slot) < p->count)
+        {
+            const uint32_t index(static_cast<uint32_t>(slot));
+            const uint32_t mask(1U << (index % 32));
+
+            p->values[index] = e.value3;
+
+            if (e.value2 != 1)
+                __sync_fetch_and_or(&p->notify[index/32], mask);
+
+            if (__sync_fetch_and_or(&p->changed[index/32], mask) & mask)
+                __sync_fetch_and_add(&coalesced, 1U);
+
+            return;
+        }
+    }
+
+    const uint32_t head(ringHead);
+
+    if (head - ringTail >= kRingSize)
+    {
+        __sync_fetch_and_add(&dropped, 1U);
+        return;
+    }
+
+    ring[head % kRingSize] = e;
+
+    __sync_synchronize();
+    ringHead = head + 1;
 }
 
-void CarlaPlugin::ProtectedData::PostRtEvents::trySplice() noexcept
+void CarlaPlugin::ProtectedData::PostRtEvents::setParameterCount(const uint32_t count) noexcept
 {
-    if (mutex.tryLock())
+    const uint32_t slots(count + static_cast<uint32_t>(kPostRtSpecialParameters));
+
+    if (params != nullptr && params->count == slots)
+        return;
+
+    const uint32_t words((slots+31)/32);
+    Parameters* newParams;
+
+    try {
+        newParams = new Parameters;
+    } CARLA_SAFE_EXCEPTION_RETURN("PostRtEvents::setParameterCount",);
+
+    newParams->count       = slots;
+    newParams->values      = nullptr;
+    newParams->changed     = nullptr;
+    newParams->notify      = nullptr;
+    newParams->nextRetired = nullptr;
+
+    try {
+        newParams->values  = new float[slots];
+        newParams->changed = new uint32_t[words];
+        newParams->notify  = new uint32_t[words];
+    }
+    catch(...) {
+        deleteParameters(newParams);
+        carla_safe_exception("PostRtEvents::setParameterCount", __FILE__, __LINE__);
+        return;
+    }
+
+    carla_zeroFloats(newParams->values, slots);
+
+    for (uint32_t i=0; i < words; ++i)
+        newParams->changed[i] = newParams->notify[i] = 0;
+
+    Parameters* const old(params);
+
+    __sync_synchronize();
+    params = newParams;
+
+    // the old slots might be in use by idle, free them on the next one
+    if (old != nullptr)
     {
-        if (dataPendingRT.count() > 0)
-            dataPendingRT.moveTo(data, true);
-        mutex.unlock();
+        for (;;)
+        {
+            Parameters* const head(retired);
+            old->nextRetired = head;
+
+            if (__sync_bool_compare_and_swap(&retired, head, old))
+                break;
+        }
     }
 }
 
-void CarlaPlugin::ProtectedData::PostRtEvents::clear() noexcept
+uint32_t CarlaPlugin::ProtectedData::PostRtEvents::beginTake() noexcept
 {
-    mutex.lock();
-    data.clear();
-    dataPendingRT.clear();
-    mutex.unlock();
+    for (;;)
+    {
+        Parameters* const old(retired);
+
+        if (__sync_bool_compare_and_swap(&retired, old, nullptr))
+        {
+            deleteParameters(old);
+            break;
+        }
+    }
+
+    takeParams   = params;
+    takeWord     = 0;
+    takeNextWord = 0;
+    takeBits     = 0;
+    takeNotify   = 0;
+    takeRingEnd  = ringHead;
+    __sync_synchronize();
+
+    const uint32_t newDropped(dropped);
+    const uint32_t ret(newDropped - droppedReported);
+    droppedReported = newDropped;
+
+    return ret;
+}
+
+bool CarlaPlugin::ProtectedData::PostRtEvents::take(PluginPostRtEvent& event) noexcept
+{
+    if (Parameters* const p = takeParams)
+    {
+        const uint32_t words((p->count+31)/32);
+
+        for (;;)
+        {
+            if (takeBits != 0)
+            {
+                const uint32_t bit(static_cast<uint32_t>(__builtin_ctz(takeBits)));
+                const uint32_t mask(1U << bit);
+                const uint32_t index(takeWord*32 + bit);
+
+                takeBits &= ~mask;
+
+                event.type   = kPluginPostRtEventParameterChange;
+                event.value1 = static_cast<int32_t>(index) - kPostRtSpecialParameters;
+                event.value2 = (takeNotify & mask) ? 0 : 1;
+                event.value3 = p->values[index];
+                return true;
+            }
+
+            if (takeNextWord >= words)
+                break;
+
+            takeWord   = takeNextWord++;
+            takeBits   = __sync_fetch_and_and(&p->changed[takeWord], 0U);
+            takeNotify = __sync_fetch_and_and(&p->notify[takeWord], ~takeBits) & takeBits;
+        }
+
+        takeParams = nullptr;
+    }
+
+    const uint32_t tail(ringTail);
+
+    if (tail == takeRingEnd)
+        return false;
+
+    event = ring[tail % kRingSize];
+
+    __sync_synchronize();
+    ringTail = tail + 1;
+    return true;
 }
 
 // -----------------------------------------------------------------------
@@ -529,6 +743,156 @@ void CarlaPlugin::ProtectedData::PostUiEvents::clear() noexcept
     mutex.unlock();
 }
 
+// -----------------------------------------------------------------------
+// ProtectedData::MidiControlMap
+
+static const uint32_t kMidiControlSlots = MAX_MIDI_CHANNELS*MAX_MIDI_CONTROL;
+
+static bool isMidiControlled(const ParameterData& paramData) noexcept
+{
+    if (paramData.type != PARAMETER_INPUT || (paramData.hints & PARAMETER_IS_AUTOMABLE) == 0)
+        return false;
+    if (paramData.midiCC < 0 || paramData.midiCC >= MAX_MIDI_CONTROL)
+        return false;
+
+    return paramData.midiChannel < MAX_MIDI_CHANNELS;
+}
+
+CarlaPlugin::ProtectedData::MidiControlMap::Table* CarlaPlugin::ProtectedData::MidiControlMap::exchange(Table* volatile& ptr, Table* const value) noexcept
+{
+    for (;;)
+    {
+        Table* const old(ptr);
+
+        if (__sync_bool_compare_and_swap(&ptr, old, value))
+            return old;
+    }
+}
+
+void CarlaPlugin::ProtectedData::MidiControlMap::deleteTables(Table* table) noexcept
+{
+    for (; table != nullptr;)
+    {
+        Table* const next(table->nextRetired);
+
+        delete[] table->offsets;
+        delete[] table->parameters;
+        delete table;
+
+        table = next;
+    }
+}
+
+CarlaPlugin::ProtectedData::MidiControlMap::MidiControlMap() noexcept
+    : pending(nullptr),
+      retired(nullptr),
+      active(nullptr) {}
+
+CarlaPlugin::ProtectedData::MidiControlMap::~MidiControlMap() noexcept
+{
+    deleteTables(exchange(pending, nullptr));
+    deleteTables(exchange(retired, nullptr));
+    deleteTables(active);
+    active = nullptr;
+}
+
+void CarlaPlugin::ProtectedData::MidiControlMap::update(const PluginParameterData& param) noexcept
+{
+    Table* table;
+
+    try {
+        table = new Table;
+    } CARLA_SAFE_EXCEPTION_RETURN("MidiControlMap::update",);
+
+    table->offsets     = nullptr;
+    table->parameters  = nullptr;
+    table->nextRetired = nullptr;
+
+    uint32_t count = 0;
+
+    for (uint32_t i=0; i < param.count; ++i)
+    {
+        if (isMidiControlled(param.data[i]))
+            ++count;
+    }
+
+    if (count > 0)
+    {
+        try {
+            table->offsets    = new uint32_t[kMidiControlSlots+1];
+            table->parameters = new uint32_t[count];
+        }
+        catch(...) {
+            deleteTables(table);
+            carla_safe_exception("MidiControlMap::update", __FILE__, __LINE__);
+            return;
+        }
+
+        carla_zeroStructs(table->offsets, kMidiControlSlots+1);
+
+        // count per slot, then turn counts into start offsets, then fill in parameter order
+        for (uint32_t i=0; i < param.count; ++i)
+        {
+            const ParameterData& paramData(param.data[i]);
+
+            if (! isMidiControlled(paramData))
+                continue;
+
+            ++table->offsets[paramData.midiChannel*MAX_MIDI_CONTROL + static_cast<uint32_t>(paramData.midiCC) + 1];
+        }
+
+        for (uint32_t i=1; i <= kMidiControlSlots; ++i)
+            table->offsets[i] += table->offsets[i-1];
+
+        for (uint32_t i=0; i < param.count; ++i)
+        {
+            const ParameterData& paramData(param.data[i]);
+
+            if (! isMidiControlled(paramData))
+                continue;
+
+            // moves each slot start to its end, shifted back into place below
+            table->parameters[table->offsets[paramData.midiChannel*MAX_MIDI_CONTROL + static_cast<uint32_t>(paramData.midiCC)]++] = i;
+        }
+
+        for (uint32_t i=kMidiControlSlots; i > 0; --i)
+            table->offsets[i] = table->offsets[i-1];
+
+        table->offsets[0] = 0;
+    }
+
+    // a table that was never picked up can go right away
+    deleteTables(exchange(pending, table));
+
+    // so can the ones the audio thread has replaced
+    deleteTables(exchange(retired, nullptr));
+}
+
+const CarlaPlugin::ProtectedData::MidiControlMap::Table* CarlaPlugin::ProtectedData::MidiControlMap::getTableRT() noexcept
+{
+    if (pending != nullptr)
+    {
+        if (Table* const table = exchange(pending, nullptr))
+        {
+            if (Table* const old = active)
+            {
+                for (;;)
+                {
+                    Table* const head(retired);
+                    old->nextRetired = head;
+
+                    if (__sync_bool_compare_and_swap(&retired, head, old))
+                        break;
+                }
+            }
+
+            active = table;
+        }
+    }
+
+    return active;
+}
+
 #ifndef BUILD_BRIDGE
 // -----------------------------------------------------------------------
 // ProtectedData::PostProc
@@ -538,7 +902,11 @@ CarlaPlugin::ProtectedData::PostProc::PostProc() noexcept
       volume(1.0f),
       balanceLeft(-1.0f),
       balanceRight(1.0f),
-      panning(0.0f) {}
+      panning(0.0f),
+      prevDryWet(1.0f),
+      prevVolume(1.0f),
+      prevBalanceLeft(-1.0f),
+      prevBalanceRight(1.0f) {}
 #endif
 
 // -----------------------------------------------------------------------
@@ -576,7 +944,8 @@ CarlaPlugin::ProtectedData::ProtectedData(CarlaEngine* const eng, const uint idx
       extNotes(),
       latency(),
       postRtEvents(),
-      postUiEvents()
+      postUiEvents(),
+      midiControlMap()
 #ifndef BUILD_BRIDGE
     , postProc()
 #endif
@@ -705,6 +1074,105 @@ void CarlaPlugin::ProtectedData::postponeRtEvent(const PluginPostRtEventType typ
     postRtEvents.appendRT(rtEvent);
 }
 
+#ifndef BUILD_BRIDGE
+// -----------------------------------------------------------------------
+// Post-processing
+
+/*
+ * Apply dry/wet, balance and volume, ramping over the block from the values used in the previous one.
+ *
+ * Result is written to 'outBuffer' from 'timeOffset' on.
+ * The wet signal is read from 'pluginOut' (which is changed too), or from 'outBuffer' if null.
+ * The dry signal is read from 'pluginIn', or from 'inBuffer' at 'timeOffset' if null.
+ * With 'useLatency' the dry signal is delayed by the contents of the latency buffers.
+ * 'pluginIn' and 'pluginOut' always start at 0.
+ */
+void CarlaPlugin::ProtectedData::postProcessRT(const float* const* const inBuffer, float* const* const outBuffer,
+                                               const float* const* const pluginIn, float* const* const pluginOut,
+                                               const uint32_t timeOffset, const uint32_t frames, const bool useLatency) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(outBuffer != nullptr,);
+
+    if (frames == 0)
+        return;
+
+    const float dryWet(postProc.dryWet);
+    const float volume(postProc.volume);
+    const float balanceLeft(postProc.balanceLeft);
+    const float balanceRight(postProc.balanceRight);
+
+    const bool doDryWet  = (hints & PLUGIN_CAN_DRYWET) != 0 && audioIn.count > 0 && (pluginIn != nullptr || inBuffer != nullptr)
+                        && ! (carla_isEqual(dryWet, 1.0f) && carla_isEqual(postProc.prevDryWet, 1.0f));
+    const bool doBalance = (hints & PLUGIN_CAN_BALANCE) != 0
+                        && ! (carla_isEqual(balanceLeft,  -1.0f) && carla_isEqual(postProc.prevBalanceLeft,  -1.0f) &&
+                              carla_isEqual(balanceRight,  1.0f) && carla_isEqual(postProc.prevBalanceRight,  1.0f));
+    const bool doVolume  = (hints & PLUGIN_CAN_VOLUME) != 0
+                        && ! (carla_isEqual(volume, 1.0f) && carla_isEqual(postProc.prevVolume, 1.0f));
+
+    // ramps end at the current values on the last frame
+    const float rampFrames(static_cast<float>(frames));
+    const float dryWetStep((dryWet - postProc.prevDryWet) / rampFrames);
+    const float volumeStep((volume - postProc.prevVolume) / rampFrames);
+    const float balanceLeftStep((balanceLeft - postProc.prevBalanceLeft) / rampFrames);
+    const float balanceRightStep((balanceRight - postProc.prevBalanceRight) / rampFrames);
+
+    const bool isMono(audioIn.count == 1);
+    const uint32_t latencyFrames((useLatency && latency.buffers != nullptr) ? std::min(latency.frames, frames) : 0);
+
+    for (uint32_t i=0; i < audioOut.count; ++i)
+    {
+        float* const wet(pluginOut != nullptr ? pluginOut[i] : outBuffer[i]+timeOffset);
+
+        // Dry/Wet
+        if (doDryWet)
+        {
+            const uint32_t c(isMono ? 0 : i);
+            CARLA_SAFE_ASSERT_CONTINUE(c < audioIn.count);
+
+            const float* const dry(pluginIn != nullptr ? pluginIn[c] : inBuffer[c]+timeOffset);
+            const float mix(postProc.prevDryWet + dryWetStep);
+
+            if (latencyFrames > 0)
+            {
+                CARLA_SAFE_ASSERT_CONTINUE(c < latency.channels);
+                carla_mixFloatsWithRamp(wet, wet, latency.buffers[c], latencyFrames, mix, dryWetStep);
+            }
+
+            if (latencyFrames < frames)
+                carla_mixFloatsWithRamp(wet+latencyFrames, wet+latencyFrames, dry, frames-latencyFrames,
+                                        mix + dryWetStep*static_cast<float>(latencyFrames), dryWetStep);
+        }
+
+        // Balance, by pairs
+        if (doBalance && i % 2 == 1)
+        {
+            float* const wetLeft(pluginOut != nullptr ? pluginOut[i-1] : outBuffer[i-1]+timeOffset);
+
+            carla_balanceFloatsWithRamp(wetLeft, wet, frames,
+                                        postProc.prevBalanceLeft + balanceLeftStep, balanceLeftStep,
+                                        postProc.prevBalanceRight + balanceRightStep, balanceRightStep);
+        }
+    }
+
+    // Volume (and buffer copy)
+    for (uint32_t i=0; i < audioOut.count; ++i)
+    {
+        float* const out(outBuffer[i]+timeOffset);
+        const float* const wet(pluginOut != nullptr ? pluginOut[i] : out);
+
+        if (doVolume)
+            carla_multiplyFloatsWithRamp(out, wet, frames, postProc.prevVolume + volumeStep, volumeStep);
+        else if (wet != out)
+            carla_copyFloats(out, wet, frames);
+    }
+
+    postProc.prevDryWet       = dryWet;
+    postProc.prevVolume       = volume;
+    postProc.prevBalanceLeft  = balanceLeft;
+    postProc.prevBalanceRight = balanceRight;
+}
+#endif
+
 // -----------------------------------------------------------------------
 // Library functions
 
@@ -723,7 +1191,7 @@ bool CarlaPlugin::ProtectedData::libOpen(const char* const fname) noexcept
 
 bool CarlaPlugin::ProtectedData::libClose() noexcept
 {
-    const bool ret = sLibCounter.close(lib);
+    const bool ret = sLibCounter.close(lib, engine->getOptions().libraryKeepAlive);
     lib = nullptr;
     return ret;
 }
@@ -736,11 +1204,21 @@ bool CarlaPlugin::ProtectedData::uiLibOpen(const char* const fname, const bool c
 
 bool CarlaPlugin::ProtectedData::uiLibClose() noexcept
 {
-    const bool ret = sLibCounter.close(uiLib);
+    const bool ret = sLibCounter.close(uiLib, engine->getOptions().libraryKeepAlive);
     uiLib = nullptr;
     return ret;
 }
 
+void CarlaPlugin::preloadLibraries(const char* const* const filenames)
+{
+    sLibCounter.preload(filenames);
+}
+
+void CarlaPlugin::releasePreloadedLibraries(const uint keepAlive)
+{
+    sLibCounter.releasePreloaded(keepAlive);
+}
+
 // -----------------------------------------------------------------------
 
 #ifndef BUILD_BRIDGE
@@ -783,6 +1261,46 @@ void CarlaPlugin::ProtectedData::updateParameterValues(CarlaPlugin* const plugin
     return; (void)sendOsc;
 }
 
+bool CarlaPlugin::ProtectedData::setParametersFromMidiControlRT(CarlaPlugin* const plugin, const uint8_t channel, const uint16_t cc, const float value) noexcept
+{
+    if (channel >= MAX_MIDI_CHANNELS || cc >= MAX_MIDI_CONTROL)
+        return false;
+
+    const MidiControlMap::Table* const table(midiControlMap.getTableRT());
+
+    if (table == nullptr || table->offsets == nullptr)
+        return false;
+
+    const uint32_t slot(channel*MAX_MIDI_CONTROL + cc);
+    bool handled = false;
+
+    for (uint32_t i=table->offsets[slot], end=table->offsets[slot+1]; i < end; ++i)
+    {
+        const uint32_t k(table->parameters[i]);
+        CARLA_SAFE_ASSERT_CONTINUE(k < param.count);
+
+        float paramValue;
+
+        if (param.data[k].hints & PARAMETER_IS_BOOLEAN)
+        {
+            paramValue = (value < 0.5f) ? param.ranges[k].min : param.ranges[k].max;
+        }
+        else
+        {
+            paramValue = param.ranges[k].getUnnormalizedValue(value);
+
+            if (param.data[k].hints & PARAMETER_IS_INTEGER)
+                paramValue = std::rint(paramValue);
+        }
+
+        plugin->setParameterValue(k, paramValue, false, false, false);
+        postponeRtEvent(kPluginPostRtEventParameterChange, static_cast<int32_t>(k), 0, paramValue);
+        handled = true;
+    }
+
+    return handled;
+}
+
 // -----------------------------------------------------------------------
 
 CARLA_BACKEND_END_NAMESPACE
@@ -168,11 +168,19 @@ struct PluginParameterData {
     ParameterRanges* ranges;
     SpecialParameterType* special;
 
+    // output values as last seen by setOutputValue(), and a bitset of the ones changed since collected.
+    // plugins that call setOutputValue() themselves (usually from process) set 'tracksOutputs',
+    // for all others the outputs are polled when collecting changes.
+    float* outputValues;
+    volatile uint32_t* outputChanges;
+    bool tracksOutputs;
+
     PluginParameterData() noexcept;
     ~PluginParameterData() noexcept;
     void createNew(const uint32_t newCount, const bool withSpecial);
     void clear() noexcept;
     float getFixedValue(const uint32_t parameterId, const float& value) const noexcept;
+    void setOutputValue(const uint32_t parameterId, const float value) noexcept;
 
     CARLA_DECLARE_NON_COPY_STRUCT(PluginParameterData)
 };
@@ -282,17 +290,47 @@ struct CarlaPlugin::ProtectedData {
 
     } latency;
 
+    // events from the audio thread, delivered on idle.
+    // parameter changes are coalesced so only the latest value of each is delivered,
+    // everything else goes through a single producer/consumer ring and is dropped if that is full.
     struct PostRtEvents {
-        CarlaMutex mutex;
-        RtLinkedList<PluginPostRtEvent>::Pool dataPool;
-        RtLinkedList<PluginPostRtEvent> data;
-        RtLinkedList<PluginPostRtEvent> dataPendingRT;
+        static const uint32_t kRingSize = 1024;
+
+        // parameter slots, special parameters (negative ids) come first
+        struct Parameters {
+            uint32_t count;
+            float* values;
+            volatile uint32_t* changed; // bitset
+            volatile uint32_t* notify;  // bitset, host and OSC need to know too (value2 != 1)
+            Parameters* nextRetired;
+        };
+
+        PluginPostRtEvent ring[kRingSize];
+        volatile uint32_t ringHead; // written by the audio thread
+        volatile uint32_t ringTail; // written by idle
+
+        Parameters* volatile params;
+        Parameters* volatile retired;
+
+        // statistics
+        volatile uint32_t dropped;   // events that did not fit in the ring
+        volatile uint32_t coalesced; // parameter changes replaced by a newer value before idle
+
+        // idle state
+        Parameters* takeParams;
+        uint32_t takeWord, takeNextWord;
+        uint32_t takeBits, takeNotify;
+        uint32_t takeRingEnd;
+        uint32_t droppedReported;
 
         PostRtEvents() noexcept;
         ~PostRtEvents() noexcept;
         void appendRT(const PluginPostRtEvent& event) noexcept;
-        void trySplice() noexcept;
-        void clear() noexcept;
+        void setParameterCount(const uint32_t count) noexcept;
+        uint32_t beginTake() noexcept;
+        bool take(PluginPostRtEvent& event) noexcept;
+
+        static void deleteParameters(Parameters* params) noexcept;
 
         CARLA_DECLARE_NON_COPY_STRUCT(PostRtEvents)
 
@@ -311,6 +349,30 @@ struct CarlaPlugin::ProtectedData {
 
     } postUiEvents;
 
+    // MIDI CC -> parameter routing, built on the main thread and picked up by the audio thread
+    struct MidiControlMap {
+        struct Table {
+            uint32_t* offsets;    // parameters for channel/CC slot 'i' are in [offsets[i], offsets[i+1]), null if nothing is mapped
+            uint32_t* parameters;
+            Table* nextRetired;
+        };
+
+        Table* volatile pending;
+        Table* volatile retired;
+        Table* active; // audio thread only
+
+        MidiControlMap() noexcept;
+        ~MidiControlMap() noexcept;
+        void update(const PluginParameterData& param) noexcept;
+        const Table* getTableRT() noexcept;
+
+        static Table* exchange(Table* volatile& ptr, Table* const value) noexcept;
+        static void deleteTables(Table* table) noexcept;
+
+        CARLA_DECLARE_NON_COPY_STRUCT(MidiControlMap)
+
+    } midiControlMap;
+
 #ifndef BUILD_BRIDGE
     struct PostProc {
         float dryWet;
@@ -319,6 +381,12 @@ struct CarlaPlugin::ProtectedData {
         float balanceRight;
         float panning;
 
+        // values reached at the end of the last processed block, changes ramp from these (audio thread only)
+        float prevDryWet;
+        float prevVolume;
+        float prevBalanceLeft;
+        float prevBalanceRight;
+
         PostProc() noexcept;
 
         CARLA_DECLARE_NON_COPY_STRUCT(PostProc)
@@ -340,6 +408,15 @@ struct CarlaPlugin::ProtectedData {
     void postponeRtEvent(const PluginPostRtEvent& rtEvent) noexcept;
     void postponeRtEvent(const PluginPostRtEventType type, const int32_t value1, const int32_t value2, const float value3) noexcept;
 
+#ifndef BUILD_BRIDGE
+    // -------------------------------------------------------------------
+    // Post-processing
+
+    void postProcessRT(const float* const* const inBuffer, float* const* const outBuffer,
+                       const float* const* const pluginIn, float* const* const pluginOut,
+                       const uint32_t timeOffset, const uint32_t frames, const bool useLatency) noexcept;
+#endif
+
     // -------------------------------------------------------------------
     // Library functions
 
@@ -370,6 +447,7 @@ struct CarlaPlugin::ProtectedData {
     void tryTransient() noexcept;
 #endif
     void updateParameterValues(CarlaPlugin* const plugin, const bool sendOsc, const bool sendCallback, const bool useDefault) noexcept;
+    bool setParametersFromMidiControlRT(CarlaPlugin* const plugin, const uint8_t channel, const uint16_t cc, const float value) noexcept;
 
     // -------------------------------------------------------------------
 
@@ -805,40 +805,8 @@ public:
                             }
                         }
 #endif
-                        // Control plugin parameters
-                        uint32_t k;
-                        for (k=0; k < pData->param.count; ++k)
-                        {
-                            if (pData->param.data[k].midiChannel != event.channel)
-                                continue;
-                            if (pData->param.data[k].midiCC != ctrlEvent.param)
-                                continue;
-                            if (pData->param.data[k].type != PARAMETER_INPUT)
-                                continue;
-                            if ((pData->param.data[k].hints & PARAMETER_IS_AUTOMABLE) == 0)
-                                continue;
-
-                            float value;
-
-                            if (pData->param.data[k].hints & PARAMETER_IS_BOOLEAN)
-                            {
-                                value = (ctrlEvent.value < 0.5f) ? pData->param.ranges[k].min : pData->param.ranges[k].max;
-                            }
-                            else
-                            {
-                                value = pData->param.ranges[k].getUnnormalizedValue(ctrlEvent.value);
-
-                                if (pData->param.data[k].hints & PARAMETER_IS_INTEGER)
-                                    value = std::rint(value);
-                            }
-
-                            setParameterValue(k, value, false, false, false);
-                            pData->postponeRtEvent(kPluginPostRtEventParameterChange, static_cast<int32_t>(k), 0, value);
-                            break;
-                        }
-
-                        // check if event is already handled
-                        if (k != pData->param.count)
+                        // Control plugin parameters, check if event is already handled
+                        if (pData->setParametersFromMidiControlRT(this, event.channel, ctrlEvent.param, ctrlEvent.value))
                             break;
 
                         if ((pData->options & PLUGIN_OPTION_SEND_CONTROL_CHANGES) != 0 && ctrlEvent.param < MAX_MIDI_CONTROL)
@@ -938,8 +906,6 @@ public:
                 } // switch (event.type)
             }
 
-            pData->postRtEvents.trySplice();
-
         } // End of Event Input
 
         // --------------------------------------------------------------------------------------------------------
@@ -29,6 +29,7 @@
 #include "CarlaPipeUtils.hpp"
 #include "CarlaPluginUI.hpp"
 #include "Lv2AtomRingBuffer.hpp"
+#include "Lv2UridTable.hpp"
 
 #include "../engine/CarlaEngineOsc.hpp"
 #include "../modules/lilv/config/lilv_config.h"
@@ -119,6 +120,20 @@ const uint32_t CARLA_URI_MAP_ID_CARLA_ATOM_WORKER      = 46;
 const uint32_t CARLA_URI_MAP_ID_CARLA_TRANSIENT_WIN_ID = 47;
 const uint32_t CARLA_URI_MAP_ID_COUNT                  = 48;
 
+// URIDs mapped by a bridged UI on its own, before we sent it ours, start here (see handleUridMap)
+const uint32_t CARLA_URI_MAP_ID_UI_LOCAL_BASE          = 0x40000000;
+
+static const Lv2AtomTypeURIDs kLv2AtomTypeURIDs = {
+    CARLA_URI_MAP_ID_ATOM_BLANK,
+    CARLA_URI_MAP_ID_ATOM_OBJECT,
+    CARLA_URI_MAP_ID_ATOM_PROPERTY,
+    CARLA_URI_MAP_ID_ATOM_RESOURCE,
+    CARLA_URI_MAP_ID_ATOM_SEQUENCE,
+    CARLA_URI_MAP_ID_ATOM_TUPLE,
+    CARLA_URI_MAP_ID_ATOM_URID,
+    CARLA_URI_MAP_ID_ATOM_VECTOR
+};
+
 // LV2 Feature Ids
 const uint32_t kFeatureIdBufSizeBounded   =  0;
 const uint32_t kFeatureIdBufSizeFixed     =  1;
@@ -158,6 +173,15 @@ const uint32_t kFeatureCountAll           = 33;
 
 // -----------------------------------------------------
 
+// URIDs are shared by all LV2 plugins, the reserved ones are handled by CarlaPluginLV2 directly
+static Lv2UridTable& getSharedUridTable() noexcept
+{
+    static Lv2UridTable sUridTable(CARLA_URI_MAP_ID_COUNT);
+    return sUridTable;
+}
+
+// -----------------------------------------------------
+
 struct Lv2EventData {
     uint32_t type;
     uint32_t rindex;
@@ -523,12 +547,14 @@ public:
           fLatencyIndex(-1),
           fAtomBufferIn(),
           fAtomBufferOut(),
+          fWorkerQueue(),
           fAtomForge(),
           fEventsIn(),
           fEventsOut(),
           fLv2Options(),
           fPipeServer(engine, this),
-          fCustomURIDs(),
+          fUiUridCount(CARLA_URI_MAP_ID_COUNT),
+          fUiLocalUrids(),
           fFirstActive(true),
           fLastStateChunk(nullptr),
           fLastTimeInfo(),
@@ -539,8 +565,8 @@ public:
 
         carla_zeroPointers(fFeatures, kFeatureCountAll+1);
 
-        for (uint32_t i=0; i < CARLA_URI_MAP_ID_COUNT; ++i)
-            fCustomURIDs.append(nullptr);
+        // see Control Output in process()
+        pData->param.tracksOutputs = true;
 
 #if defined(__clang__)
 # pragma clang diagnostic push
@@ -694,16 +720,6 @@ public:
             }
         }
 
-        for (LinkedList<const char*>::Itenerator it = fCustomURIDs.begin2(); it.valid(); it.next())
-        {
-            const char* const uri(it.getValue());
-
-            if (uri != nullptr)
-                delete[] uri;
-        }
-
-        fCustomURIDs.clear();
-
         if (fLastStateChunk != nullptr)
         {
             std::free(fLastStateChunk);
@@ -1277,8 +1293,9 @@ public:
                     return;
                 }
 
-                for (std::size_t i=CARLA_URI_MAP_ID_COUNT, count=fCustomURIDs.count(); i < count; ++i)
-                    fPipeServer.writeLv2UridMessage(static_cast<uint32_t>(i), fCustomURIDs.getAt(i, nullptr));
+                fUiUridCount = CARLA_URI_MAP_ID_COUNT;
+                fUiLocalUrids.clear();
+                writeUridsToUi(getSharedUridTable().getCount());
 
                 fPipeServer.writeUiOptionsMessage(pData->engine->getSampleRate(), true, true, fLv2Options.windowTitle, frontendWinId);
 
@@ -1479,6 +1496,26 @@ public:
     }
 #endif
 
+    uint runWorkerJobs() override
+    {
+        // the pool checks every plugin it has pending requests for, not only LV2 ones with a worker
+        if (fExt.worker == nullptr || fExt.worker->work == nullptr)
+            return 0;
+
+        uint32_t portIndex;
+        const LV2_Atom* atom;
+        uint jobs = 0;
+
+        // we are the only reader, no need to lock
+        for (; fWorkerQueue.get(atom, portIndex); ++jobs)
+        {
+            CARLA_SAFE_ASSERT_CONTINUE(atom->type == CARLA_URI_MAP_ID_CARLA_ATOM_WORKER);
+            fExt.worker->work(fHandle, carla_lv2_worker_respond, this, atom->size, LV2_ATOM_BODY_CONST(atom));
+        }
+
+        return jobs;
+    }
+
     void uiIdle() override
     {
         if (fAtomBufferOut.isDataAvailableForReading())
@@ -1495,12 +1532,7 @@ public:
 
             for (; tmpRingBuffer.get(atom, portIndex);)
             {
-                if (atom->type == CARLA_URI_MAP_ID_CARLA_ATOM_WORKER)
-                {
-                    CARLA_SAFE_ASSERT_CONTINUE(fExt.worker != nullptr && fExt.worker->work != nullptr);
-                    fExt.worker->work(fHandle, carla_lv2_worker_respond, this, atom->size, LV2_ATOM_BODY_CONST(atom));
-                }
-                else if (fUI.type == UI::TYPE_BRIDGE)
+                if (fUI.type == UI::TYPE_BRIDGE)
                 {
                     if (fPipeServer.isPipeRunning())
                         fPipeServer.writeLv2AtomMessage(portIndex, atom);
@@ -1515,6 +1547,9 @@ public:
 
         if (fPipeServer.isPipeRunning())
         {
+            // keep UI in sync with URIDs mapped by other plugins
+            writeUridsToUi(getSharedUridTable().getCount());
+
             fPipeServer.idlePipe();
 
             switch (fPipeServer.getAndResetUiState())
@@ -2319,9 +2354,12 @@ public:
         if (fExt.worker != nullptr || (fUI.type != UI::TYPE_NULL && fEventsIn.count > 0 && (fEventsIn.data[0].type & CARLA_EVENT_DATA_ATOM) != 0))
             fAtomBufferIn.createBuffer(eventBufferSize);
 
-        if (fExt.worker != nullptr || (fUI.type != UI::TYPE_NULL && fEventsOut.count > 0 && (fEventsOut.data[0].type & CARLA_EVENT_DATA_ATOM) != 0))
+        if (fUI.type != UI::TYPE_NULL && fEventsOut.count > 0 && (fEventsOut.data[0].type & CARLA_EVENT_DATA_ATOM) != 0)
             fAtomBufferOut.createBuffer(eventBufferSize);
 
+        if (fExt.worker != nullptr && fWorkerQueue.getSize() == 0)
+            fWorkerQueue.createBuffer(eventBufferSize);
+
         if (fEventsIn.ctrl != nullptr && fEventsIn.ctrl->port == nullptr)
             fEventsIn.ctrl->port = pData->event.portIn;
 
@@ -2914,8 +2952,6 @@ public:
                 //lv2_atom_buffer_write(&evInAtomIters[i], 0, 0, atom->type, atom->size, LV2_ATOM_BODY_CONST(atom));
             }
 
-            pData->postRtEvents.trySplice();
-
             carla_copyStruct(fLastTimeInfo, timeInfo);
         }
 
@@ -3125,40 +3161,8 @@ public:
                             }
                         }
 #endif
-                        // Control plugin parameters
-                        uint32_t k;
-                        for (k=0; k < pData->param.count; ++k)
-                        {
-                            if (pData->param.data[k].midiChannel != event.channel)
-                                continue;
-                            if (pData->param.data[k].midiCC != ctrlEvent.param)
-                                continue;
-                            if (pData->param.data[k].type != PARAMETER_INPUT)
-                                continue;
-                            if ((pData->param.data[k].hints & PARAMETER_IS_AUTOMABLE) == 0)
-                                continue;
-
-                            float value;
-
-                            if (pData->param.data[k].hints & PARAMETER_IS_BOOLEAN)
-                            {
-                                value = (ctrlEvent.value < 0.5f) ? pData->param.ranges[k].min : pData->param.ranges[k].max;
-                            }
-                            else
-                            {
-                                value = pData->param.ranges[k].getUnnormalizedValue(ctrlEvent.value);
-
-                                if (pData->param.data[k].hints & PARAMETER_IS_INTEGER)
-                                    value = std::rint(value);
-                            }
-
-                            setParameterValue(k, value, false, false, false);
-                            pData->postponeRtEvent(kPluginPostRtEventParameterChange, static_cast<int32_t>(k), 0, value);
-                            break;
-                        }
-
-                        // check if event is already handled
-                        if (k != pData->param.count)
+                        // Control plugin parameters, check if event is already handled
+                        if (pData->setParametersFromMidiControlRT(this, event.channel, ctrlEvent.param, ctrlEvent.value))
                             break;
 
                         if ((pData->options & PLUGIN_OPTION_SEND_CONTROL_CHANGES) != 0 && ctrlEvent.param < MAX_MIDI_CONTROL)
@@ -3344,8 +3348,6 @@ public:
                 } // switch (event.type)
             }
 
-            pData->postRtEvents.trySplice();
-
             if (frames > timeOffset)
                 processSingle(audioIn, audioOut, cvIn, cvOut, frames - timeOffset, timeOffset);
 
@@ -3500,6 +3502,7 @@ public:
                     continue;
 
                 pData->param.ranges[k].fixValue(fParamBuffers[k]);
+                pData->param.setOutputValue(k, fParamBuffers[k]);
 
                 if (pData->param.data[k].midiCC > 0)
                 {
@@ -3616,78 +3619,11 @@ public:
             }
         }
 
-        pData->postRtEvents.trySplice();
-
 #ifndef BUILD_BRIDGE
         // --------------------------------------------------------------------------------------------------------
         // Post-processing (dry/wet, volume and balance)
 
-        {
-            const bool doDryWet  = (pData->hints & PLUGIN_CAN_DRYWET) != 0 && carla_isNotEqual(pData->postProc.dryWet, 1.0f);
-            const bool doBalance = (pData->hints & PLUGIN_CAN_BALANCE) != 0 && ! (carla_isEqual(pData->postProc.balanceLeft, -1.0f) && carla_isEqual(pData->postProc.balanceRight, 1.0f));
-            const bool isMono    = (pData->audioIn.count == 1);
-
-            bool isPair;
-            float bufValue, oldBufLeft[doBalance ? frames : 1];
-
-            for (uint32_t i=0; i < pData->audioOut.count; ++i)
-            {
-                // Dry/Wet
-                if (doDryWet)
-                {
-                    for (uint32_t k=0; k < frames; ++k)
-                    {
-#if 0 // TODO
-                        if (k < pData->latency)
-                            bufValue = pData->latencyBuffers[isMono ? 0 : i][k];
-                        else if (pData->latency < frames)
-                            bufValue = fAudioInBuffers[isMono ? 0 : i][k-pData->latency];
-                        else
-#endif
-                            bufValue = fAudioInBuffers[isMono ? 0 : i][k];
-
-                        fAudioOutBuffers[i][k] = (fAudioOutBuffers[i][k] * pData->postProc.dryWet) + (bufValue * (1.0f - pData->postProc.dryWet));
-                    }
-                }
-
-                // Balance
-                if (doBalance)
-                {
-                    isPair = (i % 2 == 0);
-
-                    if (isPair)
-                    {
-                        CARLA_ASSERT(i+1 < pData->audioOut.count);
-                        FloatVectorOperations::copy(oldBufLeft, fAudioOutBuffers[i], static_cast<int>(frames));
-                    }
-
-                    float balRangeL = (pData->postProc.balanceLeft  + 1.0f)/2.0f;
-                    float balRangeR = (pData->postProc.balanceRight + 1.0f)/2.0f;
-
-                    for (uint32_t k=0; k < frames; ++k)
-                    {
-                        if (isPair)
-                        {
-                            // left
-                            fAudioOutBuffers[i][k]  = oldBufLeft[k]            * (1.0f - balRangeL);
-                            fAudioOutBuffers[i][k] += fAudioOutBuffers[i+1][k] * (1.0f - balRangeR);
-                        }
-                        else
-                        {
-                            // right
-                            fAudioOutBuffers[i][k]  = fAudioOutBuffers[i][k] * balRangeR;
-                            fAudioOutBuffers[i][k] += oldBufLeft[k]          * balRangeL;
-                        }
-                    }
-                }
-
-                // Volume (and buffer copy)
-                {
-                    for (uint32_t k=0; k < frames; ++k)
-                        audioOut[i][k+timeOffset] = fAudioOutBuffers[i][k] * pData->postProc.volume;
-                }
-            }
-        } // End of Post-processing
+        pData->postProcessRT(audioIn, audioOut, fAudioInBuffers, fAudioOutBuffers, timeOffset, frames, false);
 
 #else // BUILD_BRIDGE
         for (uint32_t i=0; i < pData->audioOut.count; ++i)
@@ -4277,19 +4213,10 @@ public:
         CARLA_SAFE_ASSERT_RETURN(uri != nullptr && uri[0] != '\0', CARLA_URI_MAP_ID_NULL);
         carla_debug("CarlaPluginLV2::getCustomURID(\"%s\")", uri);
 
-        for (size_t i=0; i < fCustomURIDs.count(); ++i)
-        {
-            const char* const thisUri(fCustomURIDs.getAt(i, nullptr));
-            if (thisUri != nullptr && std::strcmp(thisUri, uri) == 0)
-                return static_cast<LV2_URID>(i);
-        }
-
-        const LV2_URID urid(static_cast<LV2_URID>(fCustomURIDs.count()));
-
-        fCustomURIDs.append(carla_strdup(uri));
+        const LV2_URID urid(getSharedUridTable().map(uri));
 
         if (fUI.type == UI::TYPE_BRIDGE && fPipeServer.isPipeRunning())
-            fPipeServer.writeLv2UridMessage(urid, uri);
+            writeUridsToUi(urid + 1);
 
         return urid;
     }
@@ -4298,10 +4225,26 @@ public:
     {
         static const char* const sFallback = "urn:null";
         CARLA_SAFE_ASSERT_RETURN(urid != CARLA_URI_MAP_ID_NULL, sFallback);
-        CARLA_SAFE_ASSERT_RETURN(urid < fCustomURIDs.count(), sFallback);
         carla_debug("CarlaPluginLV2::getCustomURIString(%i)", urid);
 
-        return fCustomURIDs.getAt(urid, sFallback);
+        const char* const uri(getSharedUridTable().unmap(urid));
+        CARLA_SAFE_ASSERT_RETURN(uri != nullptr, sFallback);
+
+        return uri;
+    }
+
+    // send URIDs from the last one the UI bridge knows up to 'count'
+    void writeUridsToUi(const uint32_t count)
+    {
+        const Lv2UridTable& uridTable(getSharedUridTable());
+
+        for (; fUiUridCount < count; ++fUiUridCount)
+        {
+            const char* const uri(uridTable.unmap(fUiUridCount));
+            CARLA_SAFE_ASSERT_BREAK(uri != nullptr);
+
+            fPipeServer.writeLv2UridMessage(fUiUridCount, uri);
+        }
     }
 
     // -------------------------------------------------------------------
@@ -4477,7 +4420,12 @@ public:
         atom.size = size;
         atom.type = CARLA_URI_MAP_ID_CARLA_ATOM_WORKER;
 
-        return fAtomBufferOut.putChunk(&atom, data, fEventsOut.ctrlIndex) ? LV2_WORKER_SUCCESS : LV2_WORKER_ERR_NO_SPACE;
+        if (! fWorkerQueue.putChunk(&atom, data, fEventsIn.ctrlIndex))
+            return LV2_WORKER_ERR_NO_SPACE;
+
+        // work() runs in the engine worker pool, its response is handled at the start of the next run()
+        pData->engine->scheduleWorkerJob(pData->id);
+        return LV2_WORKER_SUCCESS;
     }
 
     LV2_Worker_Status handleWorkerRespond(const uint32_t size, const void* const data)
@@ -5498,23 +5446,39 @@ public:
     {
         CARLA_SAFE_ASSERT_RETURN(urid != CARLA_URI_MAP_ID_NULL,);
         CARLA_SAFE_ASSERT_RETURN(uri != nullptr && uri[0] != '\0',);
-        carla_debug("CarlaPluginLV2::handleUridMap(%i v " P_SIZE ", \"%s\")", urid, fCustomURIDs.count()-1, uri);
+        carla_debug("CarlaPluginLV2::handleUridMap(%i v %i, \"%s\")", urid, fUiUridCount, uri);
 
-        if (urid < fCustomURIDs.count())
-        {
-            const char* const ourURI(carla_lv2_urid_unmap(this, urid));
-            CARLA_SAFE_ASSERT_RETURN(ourURI != nullptr,);
+        const LV2_URID ourURID(getSharedUridTable().map(uri));
 
-            if (std::strcmp(ourURI, uri) != 0)
-            {
-                carla_stderr2("PLUGIN :: wrong URI '%s' vs '%s'", ourURI,  uri);
-            }
-        }
-        else
+        // the UI bridge uses our URIDs once we send them, a URI it maps before that gets
+        // an id of its own, which we translate in its atoms from now on
+        if (urid >= CARLA_URI_MAP_ID_UI_LOCAL_BASE)
         {
-            CARLA_SAFE_ASSERT_RETURN(urid == fCustomURIDs.count(),);
-            fCustomURIDs.append(carla_strdup(uri));
+            const std::size_t index(urid - CARLA_URI_MAP_ID_UI_LOCAL_BASE);
+
+            if (index >= fUiLocalUrids.size())
+                fUiLocalUrids.resize(index + 1, CARLA_URI_MAP_ID_NULL);
+
+            fUiLocalUrids[index] = ourURID;
+
+            // send ours back, so that the UI can translate the atoms we send to it
+            writeUridsToUi(getSharedUridTable().getCount());
+            return;
         }
+
+        CARLA_SAFE_ASSERT_RETURN(urid < fUiUridCount,);
+
+        if (ourURID != urid)
+            carla_stderr2("PLUGIN :: wrong URID for '%s', %i vs %i", uri, ourURID, urid);
+    }
+
+    void handleUridsFromUi(LV2_Atom* const atom) const noexcept
+    {
+        if (fUiLocalUrids.size() == 0)
+            return;
+
+        const UiUridTranslator translator = { fUiLocalUrids };
+        lv2_atom_translate_urids(atom, lv2_atom_total_size(atom), kLv2AtomTypeURIDs, translator);
     }
 
     // -------------------------------------------------------------------
@@ -5539,6 +5503,7 @@ private:
 
     Lv2AtomRingBuffer fAtomBufferIn;
     Lv2AtomRingBuffer fAtomBufferOut;
+    Lv2AtomRingBuffer fWorkerQueue; // single reader, see runWorkerJobs()
     LV2_Atom_Forge    fAtomForge;
 
     CarlaPluginLV2EventData fEventsIn;
@@ -5546,7 +5511,21 @@ private:
     CarlaPluginLV2Options   fLv2Options;
     CarlaPipeServerLV2      fPipeServer;
 
-    LinkedList<const char*> fCustomURIDs;
+    uint32_t fUiUridCount; // number of URIDs known by the UI bridge
+    std::vector<LV2_URID> fUiLocalUrids; // our URIDs for the ones the UI bridge mapped on its own
+
+    struct UiUridTranslator {
+        const std::vector<LV2_URID>& urids;
+
+        LV2_URID operator()(const LV2_URID urid) const noexcept
+        {
+            if (urid < CARLA_URI_MAP_ID_UI_LOCAL_BASE)
+                return urid;
+
+            const std::size_t index(urid - CARLA_URI_MAP_ID_UI_LOCAL_BASE);
+            return (index < urids.size() && urids[index] != CARLA_URI_MAP_ID_NULL) ? urids[index] : urid;
+        }
+    };
 
     bool fFirstActive; // first process() call after activate()
     void* fLastStateChunk;
@@ -6149,10 +6128,11 @@ bool CarlaPipeServerLV2::msgReceived(const char* const msg) noexcept
         delete[] base64atom;
         CARLA_SAFE_ASSERT_RETURN(chunk.size() >= sizeof(LV2_Atom), true);
 
-        const LV2_Atom* const atom((const LV2_Atom*)chunk.data());
+        LV2_Atom* const atom((LV2_Atom*)chunk.data());
         CARLA_SAFE_ASSERT_RETURN(lv2_atom_total_size(atom) == chunk.size(), true);
 
         try {
+            kPlugin->handleUridsFromUi(atom);
             kPlugin->handleUIWrite(index, lv2_atom_total_size(atom), CARLA_URI_MAP_ID_ATOM_TRANSFER_EVENT, atom);
         } CARLA_SAFE_EXCEPTION("magReceived atom");
 
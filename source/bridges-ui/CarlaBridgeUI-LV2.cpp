@@ -88,6 +88,20 @@ const uint32_t CARLA_URI_MAP_ID_CARLA_ATOM_WORKER      = 46;
 const uint32_t CARLA_URI_MAP_ID_CARLA_TRANSIENT_WIN_ID = 47;
 const uint32_t CARLA_URI_MAP_ID_COUNT                  = 48;
 
+// URIDs we map before the host sends its own start here (see getCustomURID)
+const uint32_t CARLA_URI_MAP_ID_UI_LOCAL_BASE          = 0x40000000;
+
+static const Lv2AtomTypeURIDs kLv2AtomTypeURIDs = {
+    CARLA_URI_MAP_ID_ATOM_BLANK,
+    CARLA_URI_MAP_ID_ATOM_OBJECT,
+    CARLA_URI_MAP_ID_ATOM_PROPERTY,
+    CARLA_URI_MAP_ID_ATOM_RESOURCE,
+    CARLA_URI_MAP_ID_ATOM_SEQUENCE,
+    CARLA_URI_MAP_ID_ATOM_TUPLE,
+    CARLA_URI_MAP_ID_ATOM_URID,
+    CARLA_URI_MAP_ID_ATOM_VECTOR
+};
+
 // LV2 Feature Ids
 const uint32_t kFeatureIdLogs             =  0;
 const uint32_t kFeatureIdOptions          =  1;
@@ -224,6 +238,8 @@ public:
           fLv2Options(),
           fUiOptions(),
           fCustomURIDs(),
+          fLocalURIDs(),
+          fHostToLocalURIDs(),
           fExt()
     {
         carla_zeroPointers(fFeatures, kFeatureCount+1);
@@ -382,6 +398,16 @@ public:
         }
 
         fCustomURIDs.clear();
+
+        for (LinkedList<const char*>::Itenerator it = fLocalURIDs.begin2(); it.valid(); it.next())
+        {
+            const char* const uri(it.getValue(nullptr));
+
+            if (uri != nullptr)
+                delete[] uri;
+        }
+
+        fLocalURIDs.clear();
     }
 
     // ---------------------------------------------------------------------
@@ -613,15 +639,50 @@ public:
         if (fDescriptor->port_event == nullptr)
             return;
 
-        fDescriptor->port_event(fHandle, portIndex, lv2_atom_total_size(atom), CARLA_URI_MAP_ID_ATOM_TRANSFER_EVENT, atom);
+        const uint32_t atomSize(lv2_atom_total_size(atom));
+
+        if (fHostToLocalURIDs.size() == 0)
+        {
+            fDescriptor->port_event(fHandle, portIndex, atomSize, CARLA_URI_MAP_ID_ATOM_TRANSFER_EVENT, atom);
+            return;
+        }
+
+        // the UI knows some URIs by the ids we gave them before the host did
+        uint8_t atomBuf[atomSize];
+        std::memcpy(atomBuf, atom, atomSize);
+
+        const HostUridTranslator translator = { fHostToLocalURIDs };
+        lv2_atom_translate_urids((LV2_Atom*)atomBuf, atomSize, kLv2AtomTypeURIDs, translator);
+
+        fDescriptor->port_event(fHandle, portIndex, atomSize, CARLA_URI_MAP_ID_ATOM_TRANSFER_EVENT, atomBuf);
     }
 
     void dspURIDReceived(const LV2_URID urid, const char* const uri)
     {
-        CARLA_SAFE_ASSERT_RETURN(urid == fCustomURIDs.count(),);
+        CARLA_SAFE_ASSERT_RETURN(urid >= fCustomURIDs.count() && urid < CARLA_URI_MAP_ID_UI_LOCAL_BASE,);
         CARLA_SAFE_ASSERT_RETURN(uri != nullptr && uri[0] != '\0',);
 
+        // the host might have skipped the URIDs we got meanwhile
+        while (fCustomURIDs.count() < urid)
+            fCustomURIDs.append(nullptr);
+
         fCustomURIDs.append(carla_strdup(uri));
+
+        // keep using our own id if we mapped this URI first
+        uint32_t i=0;
+        for (LinkedList<const char*>::Itenerator it = fLocalURIDs.begin2(); it.valid(); it.next(), ++i)
+        {
+            const char* const localUri(it.getValue(nullptr));
+
+            if (localUri == nullptr || std::strcmp(localUri, uri) != 0)
+                continue;
+
+            if (fHostToLocalURIDs.size() <= urid)
+                fHostToLocalURIDs.resize(urid + 1, CARLA_URI_MAP_ID_NULL);
+
+            fHostToLocalURIDs[urid] = CARLA_URI_MAP_ID_UI_LOCAL_BASE + i;
+            break;
+        }
     }
 
     void uiOptionsChanged(const double sampleRate, const bool useTheme, const bool useThemeColors, const char* const windowTitle, uintptr_t transientWindowId) override
@@ -649,25 +710,28 @@ public:
         CARLA_SAFE_ASSERT_RETURN(uri != nullptr && uri[0] != '\0', CARLA_URI_MAP_ID_NULL);
         carla_debug("CarlaLv2Client::getCustomURID(\"%s\")", uri);
 
-        LV2_URID urid = CARLA_URI_MAP_ID_NULL;
-
-        for (uint32_t i=0, count=static_cast<uint32_t>(fCustomURIDs.count()); i<count; ++i)
+        // ids we gave out ourselves stay valid for as long as the UI lives
+        uint32_t i=0;
+        for (LinkedList<const char*>::Itenerator it = fLocalURIDs.begin2(); it.valid(); it.next(), ++i)
         {
-            const char* const thisUri(fCustomURIDs.getAt(i, nullptr));
+            const char* const thisUri(it.getValue(nullptr));
 
             if (thisUri != nullptr && std::strcmp(thisUri, uri) == 0)
-            {
-                urid = i;
-                break;
-            }
+                return CARLA_URI_MAP_ID_UI_LOCAL_BASE + i;
         }
 
-        if (urid == CARLA_URI_MAP_ID_NULL)
+        for (uint32_t j=0, count=static_cast<uint32_t>(fCustomURIDs.count()); j<count; ++j)
         {
-            urid = static_cast<LV2_URID>(fCustomURIDs.count());
-            fCustomURIDs.append(carla_strdup(uri));
+            const char* const thisUri(fCustomURIDs.getAt(j, nullptr));
+
+            if (thisUri != nullptr && std::strcmp(thisUri, uri) == 0)
+                return j;
         }
 
+        // not known by the host yet, use an id of our own, the host translates it
+        const LV2_URID urid(CARLA_URI_MAP_ID_UI_LOCAL_BASE + static_cast<LV2_URID>(fLocalURIDs.count()));
+        fLocalURIDs.append(carla_strdup(uri));
+
         if (isPipeRunning())
             writeLv2UridMessage(urid, uri);
 
@@ -678,10 +742,18 @@ public:
     {
         static const char* const sFallback = "urn:null";
         CARLA_SAFE_ASSERT_RETURN(urid != CARLA_URI_MAP_ID_NULL, sFallback);
-        CARLA_SAFE_ASSERT_RETURN(urid < fCustomURIDs.count(), sFallback);
         carla_debug("CarlaLv2Client::getCustomURIDString(%i)", urid);
 
-        return fCustomURIDs.getAt(urid, sFallback);
+        if (urid >= CARLA_URI_MAP_ID_UI_LOCAL_BASE)
+        {
+            CARLA_SAFE_ASSERT_RETURN(urid - CARLA_URI_MAP_ID_UI_LOCAL_BASE < fLocalURIDs.count(), sFallback);
+            return fLocalURIDs.getAt(urid - CARLA_URI_MAP_ID_UI_LOCAL_BASE, sFallback);
+        }
+
+        CARLA_SAFE_ASSERT_RETURN(urid < fCustomURIDs.count(), sFallback);
+
+        const char* const uri(fCustomURIDs.getAt(urid, sFallback));
+        return (uri != nullptr) ? uri : sFallback;
     }
 
     // ---------------------------------------------------------------------
@@ -761,7 +833,18 @@ private:
     Lv2PluginOptions          fLv2Options;
 
     Options fUiOptions;
-    LinkedList<const char*> fCustomURIDs;
+    LinkedList<const char*> fCustomURIDs; // host URIDs
+    LinkedList<const char*> fLocalURIDs;  // URIDs we mapped before the host sent them
+    std::vector<LV2_URID>   fHostToLocalURIDs;
+
+    struct HostUridTranslator {
+        const std::vector<LV2_URID>& urids;
+
+        LV2_URID operator()(const LV2_URID urid) const noexcept
+        {
+            return (urid < urids.size() && urids[urid] != CARLA_URI_MAP_ID_NULL) ? urids[urid] : urid;
+        }
+    };
 
     struct Extensions {
         const LV2_Options_Interface* options;
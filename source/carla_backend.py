@@ -155,6 +155,18 @@ MAX_PATCHBAY_PLUGINS = 255
 # @see ENGINE_OPTION_MAX_PARAMETERS
 MAX_DEFAULT_PARAMETERS = 200
 
+# Maximum number of extra process threads.
+# @see ENGINE_OPTION_PROCESS_THREADS
+MAX_PROCESS_THREADS = 32
+
+# Maximum number of rack pipeline stages.
+# @see ENGINE_OPTION_RACK_PIPELINE_STAGES
+MAX_RACK_PIPELINE_STAGES = 16
+
+# Maximum number of threads used to load plugins from a project.
+# @see ENGINE_OPTION_LOAD_THREADS
+MAX_LOAD_THREADS = 16
+
 # ------------------------------------------------------------------------------------------------------------
 # Engine Driver Device Hints
 # Various engine driver device hints.
@@ -782,6 +794,55 @@ ENGINE_OPTION_PREVENT_BAD_BEHAVIOUR = 16
 # Set frontend winId, used to define as parent window for plugin UIs.
 ENGINE_OPTION_FRONTEND_WIN_ID = 17
 
+# Number of extra realtime threads used for plugin processing in ENGINE_PROCESS_MODE_PATCHBAY.
+# Default is 0, which keeps all processing in the audio thread.
+# Independent plugins are processed in parallel, without adding latency.
+# @see ENGINE_OPTION_RACK_PIPELINE_STAGES
+# @note Cannot be changed while the engine is running
+ENGINE_OPTION_PROCESS_THREADS = 18
+
+# Run plugin bridges asynchronously, one buffer behind the engine.
+# Bridges are started at the end of a cycle and their results collected in the next one,
+# so several bridge processes can run in parallel at the cost of one buffer of latency each.
+# @note Only applies to bridges loaded after the option is set
+ENGINE_OPTION_PIPELINED_BRIDGES = 19
+
+# Number of threads used to load plugins when loading a project.
+# Default is 0, which loads plugins one after another in the calling thread.
+#
+# Plugins that are safe to instantiate outside the main thread (bridges, LADSPA, DSSI and SF2 files)
+# are created and restored concurrently, the others are still loaded in the calling thread.
+# Plugins are always added to the engine in project file order.
+ENGINE_OPTION_LOAD_THREADS = 20
+
+# Save large plugin chunks as raw binary data in a separate file instead of inline as base64.
+# The chunk file is named after the project file with a ".chunks" suffix and memory-mapped on load.
+# @note Only applies to carla_save_project(), plugin and preset states always use base64
+ENGINE_OPTION_SAVE_CHUNKS_AS_BINARY = 21
+
+# Number of unused plugin libraries kept loaded after their last plugin is removed.
+# The most recently closed ones are kept, so removing and adding the same plugin again does not reload its binary.
+# Default is 0, which unloads libraries as soon as they are unused.
+# @note Some plugins expect their global state to be reset when all instances are removed
+ENGINE_OPTION_LIBRARY_KEEP_ALIVE = 22
+
+# Open the plugin binaries of a project in a background thread while the project is being loaded.
+# Only applies to native LADSPA, DSSI and VST2 plugins.
+ENGINE_OPTION_PRELOAD_LIBRARIES = 23
+
+# Maximum rate, in Hz, at which changed output parameter values are sent to plugin UIs and OSC.
+# Default is 0, which sends changes on every engine idle cycle.
+ENGINE_OPTION_PARAMETER_OUTPUT_RATE = 24
+
+# Number of pipeline stages the rack is split into in ENGINE_PROCESS_MODE_CONTINUOUS_RACK.
+# Default is 0, which processes the whole rack in the audio thread.
+#
+# Each stage after the first gets its own realtime thread and adds one buffer of latency,
+# which is reported by CarlaEngine::getLatency().
+# The pipeline is flushed, and its output silenced for a few buffers, whenever plugins are added, removed or moved.
+# @note Cannot be changed while the engine is running
+ENGINE_OPTION_RACK_PIPELINE_STAGES = 25
+
 # ------------------------------------------------------------------------------------------------------------
 # Engine Process Mode
 # Engine process mode.
@@ -1133,6 +1194,41 @@ class CarlaTransportInfo(Structure):
         ("bpm", c_double)
     ]
 
+# Current version of the CarlaEngineSnapshot struct.
+ENGINE_SNAPSHOT_VERSION = 1
+
+# Snapshot of the engine state that frontends need to poll regularly.
+# @see carla_get_engine_snapshot()
+class CarlaEngineSnapshot(Structure):
+    _fields_ = [
+        # Struct version, must be set to ENGINE_SNAPSHOT_VERSION.
+        ("version", c_uint32),
+
+        # Number of plugins the peak arrays have space for.
+        ("maxPlugins", c_uint32),
+
+        # Input and output peaks, left and right values per plugin.
+        ("inputPeaks", POINTER(c_float)),
+        ("outputPeaks", POINTER(c_float)),
+
+        # Number of changes the parameter arrays have space for.
+        ("maxParameterChanges", c_uint32),
+
+        # Plugin, index and current value of each changed parameter.
+        ("parameterPluginIds", POINTER(c_uint32)),
+        ("parameterIds", POINTER(c_uint32)),
+        ("parameterValues", POINTER(c_float)),
+
+        # Sequence number of the last snapshot, or 0 to get all parameter values.
+        ("sequence", c_uint64),
+
+        # Values set on return.
+        ("pluginCount", c_uint32),
+        ("parameterChangeCount", c_uint32),
+        ("parameterChangesTruncated", c_bool),
+        ("transport", CarlaTransportInfo)
+    ]
+
 # ------------------------------------------------------------------------------------------------------------
 # Carla Host API (Python compatible stuff)
 
@@ -1182,6 +1278,17 @@ PyCarlaTransportInfo = {
     "bpm": 0.0
 }
 
+# @see CarlaEngineSnapshot
+# parameterChanges is a list of (pluginId, parameterId, value)
+PyCarlaEngineSnapshot = {
+    "sequence": 0,
+    "pluginCount": 0,
+    "inputPeaks": [],
+    "outputPeaks": [],
+    "parameterChanges": [],
+    "transport": PyCarlaTransportInfo
+}
+
 # ------------------------------------------------------------------------------------------------------------
 # Set BINARY_NATIVE
 
@@ -1636,6 +1743,14 @@ class CarlaHostMeta(object):
     def get_output_peak_value(self, pluginId, isLeft):
         raise NotImplementedError
 
+    # Get peaks, changed parameter values and transport information in a single call.
+    # Peaks are lists with left and right values per plugin.
+    # @param sequence Sequence returned by the previous call, or 0 to get all parameter values
+    # @see PyCarlaEngineSnapshot
+    @abstractmethod
+    def get_engine_snapshot(self, sequence):
+        raise NotImplementedError
+
     # Enable a plugin's option.
     # @param pluginId Plugin
     # @param option   An option from PluginOptions
@@ -2007,6 +2122,9 @@ class CarlaHostNull(CarlaHostMeta):
     def get_output_peak_value(self, pluginId, isLeft):
         return 0.0
 
+    def get_engine_snapshot(self, sequence):
+        return PyCarlaEngineSnapshot
+
     def set_option(self, pluginId, option, yesNo):
         return
 
@@ -2092,6 +2210,12 @@ class CarlaHostDLL(CarlaHostMeta):
         # info about this host object
         self.isPlugin = False
 
+        # buffers for get_engine_snapshot(), kept alive here
+        self.fSnapshot = CarlaEngineSnapshot()
+        self.fSnapshot.version = ENGINE_SNAPSHOT_VERSION
+        self.fSnapshotPeaks   = None
+        self.fSnapshotChanges = None
+
         self.lib = cdll.LoadLibrary(libName)
 
         self.lib.carla_get_engine_driver_count.argtypes = None
@@ -2274,6 +2398,9 @@ class CarlaHostDLL(CarlaHostMeta):
         self.lib.carla_get_output_peak_value.argtypes = [c_uint, c_bool]
         self.lib.carla_get_output_peak_value.restype = c_float
 
+        self.lib.carla_get_engine_snapshot.argtypes = [POINTER(CarlaEngineSnapshot)]
+        self.lib.carla_get_engine_snapshot.restype = c_bool
+
         self.lib.carla_set_option.argtypes = [c_uint, c_uint, c_bool]
         self.lib.carla_set_option.restype = None
 
@@ -2542,6 +2669,53 @@ class CarlaHostDLL(CarlaHostMeta):
     def get_output_peak_value(self, pluginId, isLeft):
         return float(self.lib.carla_get_output_peak_value(pluginId, isLeft))
 
+    def _allocate_snapshot_changes(self, maxChanges):
+        snapshot = self.fSnapshot
+        self.fSnapshotChanges = ((c_uint32 * maxChanges)(), (c_uint32 * maxChanges)(), (c_float * maxChanges)())
+        snapshot.maxParameterChanges = maxChanges
+        snapshot.parameterPluginIds  = self.fSnapshotChanges[0]
+        snapshot.parameterIds        = self.fSnapshotChanges[1]
+        snapshot.parameterValues     = self.fSnapshotChanges[2]
+
+    def get_engine_snapshot(self, sequence):
+        snapshot   = self.fSnapshot
+        maxPlugins = int(self.lib.carla_get_max_plugin_number())
+
+        if snapshot.maxPlugins != maxPlugins:
+            self.fSnapshotPeaks = ((c_float * (maxPlugins * 2))(), (c_float * (maxPlugins * 2))())
+            snapshot.maxPlugins  = maxPlugins
+            snapshot.inputPeaks  = self.fSnapshotPeaks[0]
+            snapshot.outputPeaks = self.fSnapshotPeaks[1]
+
+        if snapshot.maxParameterChanges == 0:
+            self._allocate_snapshot_changes(max(maxPlugins, 1) * MAX_DEFAULT_PARAMETERS)
+
+        while True:
+            snapshot.sequence = sequence
+
+            if not self.lib.carla_get_engine_snapshot(pointer(snapshot)):
+                return PyCarlaEngineSnapshot
+
+            if not snapshot.parameterChangesTruncated:
+                break
+
+            # too many changes, grow and ask again
+            self._allocate_snapshot_changes(snapshot.maxParameterChanges * 2)
+
+        pluginCount = min(int(snapshot.pluginCount), maxPlugins)
+        changeCount = int(snapshot.parameterChangeCount)
+
+        return {
+            "sequence": int(snapshot.sequence),
+            "pluginCount": int(snapshot.pluginCount),
+            "inputPeaks": snapshot.inputPeaks[:pluginCount*2],
+            "outputPeaks": snapshot.outputPeaks[:pluginCount*2],
+            "parameterChanges": list(zip(snapshot.parameterPluginIds[:changeCount],
+                                         snapshot.parameterIds[:changeCount],
+                                         snapshot.parameterValues[:changeCount])),
+            "transport": structToDict(snapshot.transport)
+        }
+
     def set_option(self, pluginId, option, yesNo):
         self.lib.carla_set_option(pluginId, option, yesNo)
 
@@ -2877,6 +3051,27 @@ class CarlaHostPlugin(CarlaHostMeta):
     def get_output_peak_value(self, pluginId, isLeft):
         return self.fPluginsInfo[pluginId].peaks[2 if isLeft else 3]
 
+    def get_engine_snapshot(self, sequence):
+        # values are local here, so there is no change tracking and everything is returned
+        inputPeaks  = []
+        outputPeaks = []
+        parameterChanges = []
+
+        for pluginId in range(len(self.fPluginsInfo)):
+            pluginInfo = self.fPluginsInfo[pluginId]
+            inputPeaks  += pluginInfo.peaks[0:2]
+            outputPeaks += pluginInfo.peaks[2:4]
+            parameterChanges += [(pluginId, i, value) for i, value in enumerate(pluginInfo.parameterValues)]
+
+        return {
+            "sequence": sequence,
+            "pluginCount": len(self.fPluginsInfo),
+            "inputPeaks": inputPeaks,
+            "outputPeaks": outputPeaks,
+            "parameterChanges": parameterChanges,
+            "transport": self.fTransportInfo
+        }
+
     def set_option(self, pluginId, option, yesNo):
         self.sendMsg(["set_option", pluginId, option, yesNo])
 
@@ -158,14 +158,11 @@ PyPluginInfo = {
     'parameters.outs': 0
 }
 
-global gDiscoveryProcess
+global gDiscoveryProcess, gDiscoveryIsScan
 gDiscoveryProcess = None
+gDiscoveryIsScan  = False
 
-def runCarlaDiscovery(itype, stype, filename, tool, isWine=False):
-    if not os.path.exists(tool):
-        qWarning("runCarlaDiscovery() - tool '%s' does not exist" % tool)
-        return
-
+def getDiscoveryCommand(tool, isWine):
     command = []
 
     if LINUX or MACOS:
@@ -177,104 +174,130 @@ def runCarlaDiscovery(itype, stype, filename, tool, isWine=False):
             command.append("wine")
 
     command.append(tool)
-    command.append(stype)
-    command.append(filename)
-
-    global gDiscoveryProcess
-    gDiscoveryProcess = Popen(command, stdout=PIPE)
+    return command
 
-    pinfo = None
-    plugins = []
-    fakeLabel = os.path.basename(filename).rsplit(".", 1)[0]
+def getDiscoveryCacheFile(tool, stype):
+    cacheDir = os.path.join(HOME, ".config", "falkTX", "CarlaDiscovery")
+    return os.path.join(cacheDir, "%s.%s.cache" % (os.path.basename(tool), stype))
 
+def readDiscoveryLine():
     while True:
         try:
             line = gDiscoveryProcess.stdout.readline().decode("utf-8", errors="ignore")
         except:
             print("ERROR: discovery readline failed")
-            break
+            return None
 
         # line is valid, strip it
         if line:
-            line = line.strip()
+            return line.strip()
 
         # line is invalid, try poll() again
-        elif gDiscoveryProcess.poll() is None:
+        if gDiscoveryProcess.poll() is None:
             continue
 
         # line is invalid and poll() failed, stop here
+        return None
+
+# Handle one line of discovery output for 'filename', returns the plugin info currently being filled
+def parseDiscoveryLine(line, itype, filename, pinfo, plugins):
+    if line == "carla-discovery::init::-----------":
+        pinfo = deepcopy(PyPluginInfo)
+        pinfo['type']     = itype
+        pinfo['filename'] = filename
+
+    elif line == "carla-discovery::end::------------":
+        if pinfo is not None:
+            plugins.append(pinfo)
+            pinfo = None
+
+    elif line == "Segmentation fault":
+        print("carla-discovery::crash::%s crashed during discovery" % filename)
+
+    elif line.startswith("err:module:import_dll Library"):
+        print(line)
+
+    elif line.startswith("carla-discovery::info::"):
+        print("%s - %s" % (line, filename))
+
+    elif line.startswith("carla-discovery::warning::"):
+        print("%s - %s" % (line, filename))
+
+    elif line.startswith("carla-discovery::error::"):
+        print("%s - %s" % (line, filename))
+
+    elif line.startswith("carla-discovery::crash::"):
+        print("%s - %s" % (line, filename))
+
+    elif line.startswith("carla-discovery::"):
+        if pinfo == None:
+            return None
+
+        try:
+            prop, value = line.replace("carla-discovery::", "").split("::", 1)
+        except:
+            return pinfo
+
+        fakeLabel = os.path.basename(filename).rsplit(".", 1)[0]
+
+        if prop == "build":
+            if value.isdigit(): pinfo['build'] = int(value)
+        elif prop == "name":
+            pinfo['name'] = value if value else fakeLabel
+        elif prop == "label":
+            pinfo['label'] = value if value else fakeLabel
+        elif prop == "maker":
+            pinfo['maker'] = value
+        elif prop == "uniqueId":
+            if value.isdigit(): pinfo['uniqueId'] = int(value)
+        elif prop == "hints":
+            if value.isdigit(): pinfo['hints'] = int(value)
+        elif prop == "audio.ins":
+            if value.isdigit(): pinfo['audio.ins'] = int(value)
+        elif prop == "audio.outs":
+            if value.isdigit(): pinfo['audio.outs'] = int(value)
+        elif prop == "midi.ins":
+            if value.isdigit(): pinfo['midi.ins'] = int(value)
+        elif prop == "midi.outs":
+            if value.isdigit(): pinfo['midi.outs'] = int(value)
+        elif prop == "parameters.ins":
+            if value.isdigit(): pinfo['parameters.ins'] = int(value)
+        elif prop == "parameters.outs":
+            if value.isdigit(): pinfo['parameters.outs'] = int(value)
+        elif prop == "uri":
+            if value:
+                pinfo['label'] = value
+            else:
+                # cannot use empty URIs
+                return None
         else:
+            print("%s - %s (unknown property)" % (line, filename))
+
+    return pinfo
+
+def runCarlaDiscovery(itype, stype, filename, tool, isWine=False):
+    if not os.path.exists(tool):
+        qWarning("runCarlaDiscovery() - tool '%s' does not exist" % tool)
+        return
+
+    command = getDiscoveryCommand(tool, isWine)
+    command.append(stype)
+    command.append(filename)
+
+    global gDiscoveryProcess, gDiscoveryIsScan
+    gDiscoveryProcess = Popen(command, stdout=PIPE)
+    gDiscoveryIsScan  = False
+
+    pinfo = None
+    plugins = []
+
+    while True:
+        line = readDiscoveryLine()
+
+        if line is None:
             break
 
-        if line == "carla-discovery::init::-----------":
-            pinfo = deepcopy(PyPluginInfo)
-            pinfo['type']     = itype
-            pinfo['filename'] = filename
-
-        elif line == "carla-discovery::end::------------":
-            if pinfo is not None:
-                plugins.append(pinfo)
-                del pinfo
-                pinfo = None
-
-        elif line == "Segmentation fault":
-            print("carla-discovery::crash::%s crashed during discovery" % filename)
-
-        elif line.startswith("err:module:import_dll Library"):
-            print(line)
-
-        elif line.startswith("carla-discovery::info::"):
-            print("%s - %s" % (line, filename))
-
-        elif line.startswith("carla-discovery::warning::"):
-            print("%s - %s" % (line, filename))
-
-        elif line.startswith("carla-discovery::error::"):
-            print("%s - %s" % (line, filename))
-
-        elif line.startswith("carla-discovery::"):
-            if pinfo == None:
-                continue
-
-            try:
-                prop, value = line.replace("carla-discovery::", "").split("::", 1)
-            except:
-                continue
-
-            if prop == "build":
-                if value.isdigit(): pinfo['build'] = int(value)
-            elif prop == "name":
-                pinfo['name'] = value if value else fakeLabel
-            elif prop == "label":
-                pinfo['label'] = value if value else fakeLabel
-            elif prop == "maker":
-                pinfo['maker'] = value
-            elif prop == "uniqueId":
-                if value.isdigit(): pinfo['uniqueId'] = int(value)
-            elif prop == "hints":
-                if value.isdigit(): pinfo['hints'] = int(value)
-            elif prop == "audio.ins":
-                if value.isdigit(): pinfo['audio.ins'] = int(value)
-            elif prop == "audio.outs":
-                if value.isdigit(): pinfo['audio.outs'] = int(value)
-            elif prop == "midi.ins":
-                if value.isdigit(): pinfo['midi.ins'] = int(value)
-            elif prop == "midi.outs":
-                if value.isdigit(): pinfo['midi.outs'] = int(value)
-            elif prop == "parameters.ins":
-                if value.isdigit(): pinfo['parameters.ins'] = int(value)
-            elif prop == "parameters.outs":
-                if value.isdigit(): pinfo['parameters.outs'] = int(value)
-            elif prop == "uri":
-                if value:
-                    pinfo['label'] = value
-                else:
-                    # cannot use empty URIs
-                    del pinfo
-                    pinfo = None
-                    continue
-            else:
-                print("%s - %s (unknown property)" % (line, filename))
+        pinfo = parseDiscoveryLine(line, itype, filename, pinfo, plugins)
 
     # FIXME?
     tmp = gDiscoveryProcess
@@ -283,10 +306,71 @@ def runCarlaDiscovery(itype, stype, filename, tool, isWine=False):
 
     return plugins
 
+# Check many files in a single discovery process, which runs several checks in parallel and
+# keeps a cache of previous results. Files that did not change since the last scan are not checked again.
+# 'callback' is called with the index and name of each finished file, returning False stops the scan.
+# Returns a list of plugins for each file, in the same order as 'filenames'.
+def runCarlaDiscoveryScan(itype, stype, filenames, tool, isWine=False, callback=None):
+    if not os.path.exists(tool):
+        qWarning("runCarlaDiscoveryScan() - tool '%s' does not exist" % tool)
+        return []
+
+    if len(filenames) == 0:
+        return []
+
+    command = getDiscoveryCommand(tool, isWine)
+    command.append("--scan")
+    command.append(stype)
+    command.append(getDiscoveryCacheFile(tool, stype))
+
+    global gDiscoveryProcess, gDiscoveryIsScan
+    gDiscoveryProcess = Popen(command, stdin=PIPE, stdout=PIPE)
+    gDiscoveryIsScan  = True
+
+    # the tool reads the full list before writing anything
+    gDiscoveryProcess.stdin.write("\n".join(filenames).encode("utf-8"))
+    gDiscoveryProcess.stdin.close()
+
+    results  = {}
+    filename = None
+    pinfo    = None
+    plugins  = []
+
+    while True:
+        line = readDiscoveryLine()
+
+        if line is None:
+            break
+
+        if line.startswith("carla-discovery::file::"):
+            filename = line.replace("carla-discovery::file::", "", 1)
+            pinfo    = None
+            plugins  = []
+            results[filename] = plugins
+
+            if callback is not None and not callback(len(results)-1, filename):
+                killDiscovery()
+
+        elif filename is not None:
+            pinfo = parseDiscoveryLine(line, itype, filename, pinfo, plugins)
+
+    # FIXME?
+    tmp = gDiscoveryProcess
+    gDiscoveryProcess = None
+    del gDiscoveryProcess, tmp
+
+    return [results.get(filename, []) for filename in filenames]
+
 def killDiscovery():
     global gDiscoveryProcess
 
-    if gDiscoveryProcess is not None:
+    if gDiscoveryProcess is None:
+        return
+
+    # a scan needs to kill its own checks first, it quits right after
+    if gDiscoveryIsScan:
+        gDiscoveryProcess.terminate()
+    else:
         gDiscoveryProcess.kill()
 
 def checkPluginCached(desc, ptype):
@@ -678,17 +762,7 @@ class SearchPluginsThread(QThread):
 
         if not self.fContinueChecking: return
 
-        for i in range(len(ladspaBinaries)):
-            ladspa  = ladspaBinaries[i]
-            percent = ( float(i) / len(ladspaBinaries) ) * self.fCurPercentValue
-            self._pluginLook((self.fLastCheckValue + percent) * 0.9, ladspa)
-
-            plugins = checkPluginLADSPA(ladspa, tool, isWine)
-            if plugins:
-                self.fLadspaPlugins.append(plugins)
-                self.fSomethingChanged = True
-
-            if not self.fContinueChecking: break
+        self._checkFiles(PLUGIN_LADSPA, "LADSPA", ladspaBinaries, tool, isWine, self.fLadspaPlugins, 0.9)
 
         self.fLastCheckValue += self.fCurPercentValue
 
@@ -712,17 +786,7 @@ class SearchPluginsThread(QThread):
 
         if not self.fContinueChecking: return
 
-        for i in range(len(dssiBinaries)):
-            dssi    = dssiBinaries[i]
-            percent = ( float(i) / len(dssiBinaries) ) * self.fCurPercentValue
-            self._pluginLook(self.fLastCheckValue + percent, dssi)
-
-            plugins = checkPluginDSSI(dssi, tool, isWine)
-            if plugins:
-                self.fDssiPlugins.append(plugins)
-                self.fSomethingChanged = True
-
-            if not self.fContinueChecking: break
+        self._checkFiles(PLUGIN_DSSI, "DSSI", dssiBinaries, tool, isWine, self.fDssiPlugins)
 
         self.fLastCheckValue += self.fCurPercentValue
 
@@ -752,17 +816,7 @@ class SearchPluginsThread(QThread):
 
         if not self.fContinueChecking: return
 
-        for i in range(len(vst2Binaries)):
-            vst2    = vst2Binaries[i]
-            percent = ( float(i) / len(vst2Binaries) ) * self.fCurPercentValue
-            self._pluginLook(self.fLastCheckValue + percent, vst2)
-
-            plugins = checkPluginVST2(vst2, tool, isWine)
-            if plugins:
-                self.fVstPlugins.append(plugins)
-                self.fSomethingChanged = True
-
-            if not self.fContinueChecking: break
+        self._checkFiles(PLUGIN_VST2, "VST2", vst2Binaries, tool, isWine, self.fVstPlugins)
 
         self.fLastCheckValue += self.fCurPercentValue
 
@@ -792,17 +846,7 @@ class SearchPluginsThread(QThread):
 
         if not self.fContinueChecking: return
 
-        for i in range(len(vst3Binaries)):
-            vst3    = vst3Binaries[i]
-            percent = ( float(i) / len(vst3Binaries) ) * self.fCurPercentValue
-            self._pluginLook(self.fLastCheckValue + percent, vst3)
-
-            plugins = checkPluginVST3(vst3, tool, isWine)
-            if plugins:
-                self.fVst3Plugins.append(plugins)
-                self.fSomethingChanged = True
-
-            if not self.fContinueChecking: break
+        self._checkFiles(PLUGIN_VST3, "VST3", vst3Binaries, tool, isWine, self.fVst3Plugins)
 
         self.fLastCheckValue += self.fCurPercentValue
 
@@ -820,27 +864,25 @@ class SearchPluginsThread(QThread):
 
         if not self.fContinueChecking: return
 
-        for i in range(len(kitFiles)):
-            kit     = kitFiles[i]
-            percent = ( float(i) / len(kitFiles) ) * self.fCurPercentValue
-            self._pluginLook(self.fLastCheckValue + percent, kit)
-
-            if kitExtension == "gig":
-                plugins = checkFileGIG(kit, self.fToolNative)
-            elif kitExtension == "sf2":
-                plugins = checkFileSF2(kit, self.fToolNative)
-            elif kitExtension == "sfz":
-                plugins = checkFileSFZ(kit, self.fToolNative)
-            else:
-                plugins = None
+        if kitExtension == "gig":
+            self._checkFiles(PLUGIN_GIG, "GIG", kitFiles, self.fToolNative, False, self.fKitPlugins)
+        elif kitExtension == "sf2":
+            self._checkFiles(PLUGIN_SF2, "SF2", kitFiles, self.fToolNative, False, self.fKitPlugins)
+        elif kitExtension == "sfz":
+            self._checkFiles(PLUGIN_SFZ, "SFZ", kitFiles, self.fToolNative, False, self.fKitPlugins)
 
-            if plugins:
-                self.fKitPlugins.append(plugins)
-                self.fSomethingChanged = True
+        self.fLastCheckValue += self.fCurPercentValue
 
-            if not self.fContinueChecking: break
+    def _checkFiles(self, itype, stype, filenames, tool, isWine, pluginList, lookScale=1.0):
+        def fileLook(index, filename):
+            percent = ( float(index) / len(filenames) ) * self.fCurPercentValue
+            self._pluginLook((self.fLastCheckValue + percent) * lookScale, filename)
+            return self.fContinueChecking
 
-        self.fLastCheckValue += self.fCurPercentValue
+        for plugins in runCarlaDiscoveryScan(itype, stype, filenames, tool, isWine, fileLook):
+            if plugins:
+                pluginList.append(plugins)
+                self.fSomethingChanged = True
 
     def _pluginLook(self, percent, plugin):
         self.pluginLook.emit(percent, plugin)
@@ -46,11 +46,26 @@
 
 #include <iostream>
 
+#ifndef CARLA_OS_WIN
+# include <cerrno>
+# include <fcntl.h>
+# include <signal.h>
+# include <sys/wait.h>
+#endif
+
 #include "juce_core.h"
+using juce::Array;
 using juce::CharPointer_UTF8;
+using juce::CriticalSection;
 using juce::File;
+using juce::FileOutputStream;
+using juce::HashMap;
+using juce::ScopedLock;
 using juce::String;
 using juce::StringArray;
+using juce::TemporaryFile;
+using juce::Thread;
+using juce::Time;
 
 #define DISCOVERY_OUT(x, y) std::cout << "\ncarla-discovery::" << x << "::" << y << std::endl;
 
@@ -1641,19 +1656,784 @@ static void do_linuxsampler_check(const char* const filename, const char* const
 #endif
 }
 
-// ------------------------------ main entry point ------------------------------
+// ------------------------------ scan mode ------------------------------
+//
+// Checks many files at once, reading their paths from stdin (one per line).
+// Each file is checked by a separate carla-discovery process so crashes only affect that file,
+// several of them run in parallel.
+// Results are stored in a cache file together with the file modification time and size,
+// files that did not change since the last scan are not checked again.
+//
+// The output is the same as for a single file, with each file starting with a 'file' line.
+// Files that crashed or timed out get a 'crash' line and no 'exit' line.
+// SIGTERM cancels the scan, running checks are killed and nothing else is written.
+
+static const char* const  kScanCacheHeader   = "CARLA-DISCOVERY-CACHE-01";
+static const int          kScanMaxJobs       = 64;
+static const juce::uint32 kScanWorkerTimeout = 5*60*1000; // ms
+
+#ifndef CARLA_OS_WIN
+static volatile sig_atomic_t gScanCancelled = 0;
+
+static void scan_cancel_handler(int) noexcept
+{
+    gScanCancelled = 1;
+}
+#endif
 
-int main(int argc, char* argv[])
+static bool is_scan_cancelled() noexcept
 {
-    if (argc != 3)
+#ifdef CARLA_OS_WIN
+    // processes get terminated without notice here, the job object takes care of the checks
+    return false;
+#else
+    return gScanCancelled != 0;
+#endif
+}
+
+// Modification time and size of a file, or of all files inside a bundle
+static void get_scan_file_info(const File& file, juce::int64& mtime, juce::int64& size)
+{
+    mtime = file.getLastModificationTime().toMilliseconds();
+    size  = 0;
+
+    if (! file.isDirectory())
     {
-        carla_stdout("usage: %s <type> </path/to/plugin>", argv[0]);
-        return 1;
+        size = file.getSize();
+        return;
+    }
+
+    Array<File> files;
+    file.findChildFiles(files, File::findFiles, true);
+
+    for (int i=0, count=files.size(); i < count; ++i)
+    {
+        const File& child(files.getReference(i));
+
+        mtime  = std::max(mtime, child.getLastModificationTime().toMilliseconds());
+        size  += child.getSize() + 1;
+    }
+}
+
+class DiscoveryCache
+{
+public:
+    DiscoveryCache(const File& file)
+        : fFile(file),
+          fFilenames(),
+          fMTimes(),
+          fSizes(),
+          fOutputs(),
+          fIndexes(),
+          fLog(nullptr),
+          fLock()
+    {
+        StringArray lines;
+        fFile.readLines(lines);
+
+        if (lines.size() == 0 || lines[0] != kScanCacheHeader)
+            return;
+
+        // entries are appended as they are found, later ones replace older ones
+        for (int i=1, count=lines.size(); i+1 < count;)
+        {
+            if (! lines[i].startsWith("file::"))
+            {
+                ++i;
+                continue;
+            }
+
+            const String filename(lines[i].fromFirstOccurrenceOf("file::", false, false));
+
+            StringArray info;
+            info.addTokens(lines[i+1], ":", "");
+            info.removeEmptyStrings();
+
+            if (info.size() != 4 || info[0] != "info")
+                break;
+
+            const int numLines(info[3].getIntValue());
+
+            if (numLines < 0 || i+2+numLines > count)
+                break;
+
+            StringArray output;
+            for (int j=0; j < numLines; ++j)
+                output.add(lines[i+2+j]);
+
+            set(filename, info[1].getLargeIntValue(), info[2].getLargeIntValue(), output.joinIntoString("\n"));
+            i += 2 + numLines;
+        }
+    }
+
+    ~DiscoveryCache()
+    {
+        if (fLog != nullptr)
+        {
+            delete fLog;
+            fLog = nullptr;
+        }
+    }
+
+    bool get(const String& filename, const juce::int64 mtime, const juce::int64 size, String& output) const
+    {
+        const ScopedLock sl(fLock);
+
+        if (! fIndexes.contains(filename))
+            return false;
+
+        const int index(fIndexes[filename]);
+
+        if (fMTimes[index] != mtime || fSizes[index] != size)
+            return false;
+
+        output = fOutputs[index];
+        return true;
+    }
+
+    // add a new result and append it to the cache file right away, so an interrupted scan is not lost
+    void add(const String& filename, const juce::int64 mtime, const juce::int64 size, const String& output)
+    {
+        const ScopedLock sl(fLock);
+
+        set(filename, mtime, size, output);
+
+        if (fLog == nullptr)
+        {
+            if (! fFile.existsAsFile() || fFile.getSize() == 0)
+            {
+                fFile.getParentDirectory().createDirectory();
+                fFile.replaceWithText(String(kScanCacheHeader) + "\n");
+            }
+
+            fLog = new FileOutputStream(fFile);
+        }
+
+        if (fLog->failedToOpen())
+            return;
+
+        fLog->writeText(getEntryText(filename, mtime, size, output), false, false);
+        fLog->flush();
+    }
+
+    // rewrite the cache file with only the latest entry of each file still in use
+    void compact(const StringArray& filenames)
+    {
+        const ScopedLock sl(fLock);
+
+        if (fLog != nullptr)
+        {
+            delete fLog;
+            fLog = nullptr;
+        }
+
+        String text(kScanCacheHeader);
+        text += "\n";
+
+        for (int i=0, count=filenames.size(); i < count; ++i)
+        {
+            const String& filename(filenames[i]);
+
+            if (! fIndexes.contains(filename))
+                continue;
+
+            const int index(fIndexes[filename]);
+            text += getEntryText(filename, fMTimes[index], fSizes[index], fOutputs[index]);
+        }
+
+        fFile.getParentDirectory().createDirectory();
+
+        const TemporaryFile tmpFile(fFile);
+
+        if (tmpFile.getFile().replaceWithText(text))
+            tmpFile.overwriteTargetFileWithTemporary();
+    }
+
+private:
+    const File fFile;
+
+    StringArray         fFilenames;
+    Array<juce::int64>  fMTimes;
+    Array<juce::int64>  fSizes;
+    StringArray         fOutputs;
+    HashMap<String,int> fIndexes;
+
+    FileOutputStream* fLog;
+
+    // workers add results in parallel
+    CriticalSection fLock;
+
+    void set(const String& filename, const juce::int64 mtime, const juce::int64 size, const String& output)
+    {
+        if (fIndexes.contains(filename))
+        {
+            const int index(fIndexes[filename]);
+
+            fMTimes.set(index, mtime);
+            fSizes.set(index, size);
+            fOutputs.set(index, output);
+            return;
+        }
+
+        fIndexes.set(filename, fFilenames.size());
+        fFilenames.add(filename);
+        fMTimes.add(mtime);
+        fSizes.add(size);
+        fOutputs.add(output);
+    }
+
+    static String getEntryText(const String& filename, const juce::int64 mtime, const juce::int64 size, const String& output)
+    {
+        StringArray lines;
+        lines.addLines(output);
+
+        String text;
+        text << "file::" << filename << "\n";
+        text << "info::" << mtime << "::" << size << "::" << lines.size() << "\n";
+
+        if (lines.size() > 0)
+            text << lines.joinIntoString("\n") << "\n";
+
+        return text;
+    }
+
+    CARLA_DECLARE_NON_COPY_CLASS(DiscoveryCache)
+};
+
+// Discovery process for a single file, with its stdout captured
+class ScanProcess
+{
+public:
+    ScanProcess() noexcept
+#ifdef CARLA_OS_WIN
+        : fProcess(nullptr),
+          fReadPipe(nullptr),
+#else
+        : fPid(0),
+          fReadPipe(-1),
+#endif
+          fLock() {}
+
+    ~ScanProcess() noexcept
+    {
+        if (! waitForExit(0))
+        {
+            kill();
+            waitForExit(1000);
+        }
+
+        closePipe();
+    }
+
+    bool start(const String& executable, const String& stype, const String& filename)
+    {
+        // make sure other processes do not inherit this pipe
+        static CriticalSection sStartLock;
+        const ScopedLock sl(sStartLock);
+
+#ifdef CARLA_OS_WIN
+        SECURITY_ATTRIBUTES securityAttributes;
+        carla_zeroStruct(securityAttributes);
+        securityAttributes.nLength        = sizeof(SECURITY_ATTRIBUTES);
+        securityAttributes.bInheritHandle = TRUE;
+
+        HANDLE writePipe;
+        if (CreatePipe(&fReadPipe, &writePipe, &securityAttributes, 0) == FALSE)
+            return false;
+
+        SetHandleInformation(fReadPipe, HANDLE_FLAG_INHERIT, 0);
+
+        String command;
+        const String args[3] = { executable, stype, filename };
+
+        for (int i=0; i<3; ++i)
+        {
+            String arg(args[i]);
+
+            // same quoting as startProcess() in CarlaPipeUtils
+            if (arg.containsAnyOf("\" "))
+                arg = arg.replace("\"", "\\\"").quoted();
+
+            command << arg << ' ';
+        }
+
+        command = command.trim();
+
+        STARTUPINFOW startupInfo;
+        carla_zeroStruct(startupInfo);
+        startupInfo.cb         = sizeof(STARTUPINFOW);
+        startupInfo.dwFlags    = STARTF_USESTDHANDLES;
+        startupInfo.hStdInput  = INVALID_HANDLE_VALUE;
+        startupInfo.hStdOutput = writePipe;
+        startupInfo.hStdError  = GetStdHandle(STD_ERROR_HANDLE);
+
+        PROCESS_INFORMATION processInfo;
+        carla_zeroStruct(processInfo);
+
+        // started suspended, so it can be put in the job before doing anything
+        const bool started(CreateProcessW(nullptr, const_cast<LPWSTR>(command.toWideCharPointer()),
+                                          nullptr, nullptr, TRUE, CREATE_NO_WINDOW|CREATE_SUSPENDED, nullptr, nullptr,
+                                          &startupInfo, &processInfo) != FALSE);
+        CloseHandle(writePipe);
+
+        if (! started)
+        {
+            closePipe();
+            return false;
+        }
+
+        if (HANDLE const job = getKillOnCloseJob())
+            AssignProcessToJobObject(job, processInfo.hProcess);
+
+        ResumeThread(processInfo.hThread);
+        CloseHandle(processInfo.hThread);
+
+        const ScopedLock sl2(fLock);
+        fProcess = processInfo.hProcess;
+#else
+        int pipes[2];
+        if (::pipe(pipes) != 0)
+            return false;
+
+        ::fcntl(pipes[0], F_SETFD, FD_CLOEXEC);
+        ::fcntl(pipes[1], F_SETFD, FD_CLOEXEC);
+
+        const char* const argv[4] = { executable.toRawUTF8(), stype.toRawUTF8(), filename.toRawUTF8(), nullptr };
+
+        const pid_t pid = ::fork();
+
+        if (pid == 0)
+        {
+            // child process, stdout goes into the pipe
+            ::dup2(pipes[1], STDOUT_FILENO);
+            ::execv(argv[0], const_cast<char* const*>(argv));
+            ::_exit(1);
+        }
+
+        ::close(pipes[1]);
+
+        if (pid < 0)
+        {
+            ::close(pipes[0]);
+            return false;
+        }
+
+        fReadPipe = pipes[0];
+
+        const ScopedLock sl2(fLock);
+        fPid = pid;
+#endif
+        return true;
     }
 
-    const char* const stype    = argv[1];
-    const char* const filename = argv[2];
-    const PluginType  type     = getPluginTypeFromString(stype);
+    // read until the process closes its stdout (usually when it exits or gets killed)
+    String readAllOutput()
+    {
+        std::string output;
+        char buf[1024];
+
+        for (;;)
+        {
+#ifdef CARLA_OS_WIN
+            DWORD ret = 0;
+            if (ReadFile(fReadPipe, buf, sizeof(buf), &ret, nullptr) == FALSE || ret == 0)
+                break;
+#else
+            const ssize_t ret(::read(fReadPipe, buf, sizeof(buf)));
+
+            if (ret < 0 && errno == EINTR)
+                continue;
+            if (ret <= 0)
+                break;
+#endif
+            output.append(buf, static_cast<std::size_t>(ret));
+        }
+
+        closePipe();
+
+        return String(CharPointer_UTF8(output.c_str()));
+    }
+
+    // safe to call from another thread
+    void kill() noexcept
+    {
+        const ScopedLock sl(fLock);
+
+#ifdef CARLA_OS_WIN
+        if (fProcess != nullptr)
+            TerminateProcess(fProcess, 1);
+#else
+        if (fPid > 0)
+            ::kill(fPid, SIGKILL);
+#endif
+    }
+
+    bool waitForExit(const uint32_t timeOutMilliseconds) noexcept
+    {
+        const juce::uint32 timeoutEnd(Time::getMillisecondCounter() + timeOutMilliseconds);
+
+        for (;;)
+        {
+            {
+                const ScopedLock sl(fLock);
+
+#ifdef CARLA_OS_WIN
+                if (fProcess == nullptr)
+                    return true;
+
+                if (WaitForSingleObject(fProcess, 0) == WAIT_OBJECT_0)
+                {
+                    CloseHandle(fProcess);
+                    fProcess = nullptr;
+                    return true;
+                }
+#else
+                if (fPid <= 0)
+                    return true;
+
+                const pid_t ret(::waitpid(fPid, nullptr, WNOHANG));
+
+                if (ret == fPid || (ret < 0 && errno != EINTR))
+                {
+                    fPid = 0;
+                    return true;
+                }
+#endif
+            }
+
+            if (Time::getMillisecondCounter() >= timeoutEnd)
+                return false;
+
+            Thread::sleep(5);
+        }
+    }
+
+private:
+#ifdef CARLA_OS_WIN
+    HANDLE fProcess;
+    HANDLE fReadPipe;
+#else
+    pid_t fPid;
+    int   fReadPipe;
+#endif
+    CriticalSection fLock;
+
+#ifdef CARLA_OS_WIN
+    // checks are killed together with this process, even when it is terminated
+    static HANDLE getKillOnCloseJob() noexcept
+    {
+        static HANDLE sJob = nullptr;
+        static bool   sInitialized = false;
+
+        if (sInitialized)
+            return sJob;
+
+        sInitialized = true;
+        sJob = CreateJobObjectW(nullptr, nullptr);
+        CARLA_SAFE_ASSERT_RETURN(sJob != nullptr, nullptr);
+
+        JOBOBJECT_EXTENDED_LIMIT_INFORMATION info;
+        carla_zeroStruct(info);
+        info.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE;
+
+        if (SetInformationJobObject(sJob, JobObjectExtendedLimitInformation, &info, sizeof(info)) == FALSE)
+        {
+            CloseHandle(sJob);
+            sJob = nullptr;
+        }
+
+        return sJob;
+    }
+#endif
+
+    void closePipe() noexcept
+    {
+#ifdef CARLA_OS_WIN
+        if (fReadPipe != nullptr)
+        {
+            CloseHandle(fReadPipe);
+            fReadPipe = nullptr;
+        }
+#else
+        if (fReadPipe >= 0)
+        {
+            ::close(fReadPipe);
+            fReadPipe = -1;
+        }
+#endif
+    }
+
+    CARLA_DECLARE_NON_COPY_CLASS(ScanProcess)
+};
+
+class DiscoveryScanner
+{
+public:
+    DiscoveryScanner(const char* const stype, const File& cacheFile, const int numJobs)
+        : fType(stype),
+          fExecutable(File::getSpecialLocation(File::currentExecutableFile).getFullPathName()),
+          fCache(cacheFile),
+          fNumJobs(numJobs),
+          fFiles(),
+          fMTimes(),
+          fSizes(),
+          fNextFile(0),
+          fLock(),
+          fOutputLock() {}
+
+    void scan(const StringArray& filenames)
+    {
+        // send cached results first, only check the rest
+        for (int i=0, count=filenames.size(); i < count && ! is_scan_cancelled(); ++i)
+        {
+            const String& filename(filenames[i]);
+
+            juce::int64 mtime, size;
+            get_scan_file_info(File(filename), mtime, size);
+
+            String output;
+
+            if (fCache.get(filename, mtime, size, output))
+            {
+                printResult(filename, output, true, false);
+                continue;
+            }
+
+            fFiles.add(filename);
+            fMTimes.add(mtime);
+            fSizes.add(size);
+        }
+
+        const int numThreads(std::min(fNumJobs, fFiles.size()));
+
+        WorkerThread** const threads(new WorkerThread*[static_cast<uint>(std::max(numThreads, 1))]);
+
+        for (int i=0; i < numThreads; ++i)
+        {
+            threads[i] = new WorkerThread(this);
+            threads[i]->startThread();
+        }
+
+        // watchdog, kills stuck workers
+        for (bool running = numThreads > 0; running;)
+        {
+            Thread::sleep(100);
+
+            running = false;
+
+            const bool cancelled(is_scan_cancelled());
+
+            const ScopedLock sl(fLock);
+            const juce::uint32 now(Time::getMillisecondCounter());
+
+            for (int i=0; i < numThreads; ++i)
+            {
+                WorkerThread* const thread(threads[i]);
+
+                if (! thread->isThreadRunning())
+                    continue;
+
+                running = true;
+
+                if (thread->process == nullptr)
+                    continue;
+
+                if (cancelled)
+                {
+                    thread->process->kill();
+                }
+                else if (! thread->timedOut && now - thread->startTime > kScanWorkerTimeout)
+                {
+                    thread->timedOut = true;
+                    thread->process->kill();
+                }
+            }
+        }
+
+        for (int i=0; i < numThreads; ++i)
+            delete threads[i];
+        delete[] threads;
+
+        fCache.compact(filenames);
+    }
+
+private:
+    class WorkerThread : public Thread
+    {
+    public:
+        WorkerThread(DiscoveryScanner* const scanner)
+            : Thread("CarlaDiscoveryScan"),
+              process(nullptr),
+              startTime(0),
+              timedOut(false),
+              kScanner(scanner) {}
+
+        // protected by scanner lock
+        ScanProcess* process;
+        juce::uint32 startTime;
+        bool timedOut;
+
+    protected:
+        void run() override
+        {
+            kScanner->runWorker(this);
+        }
+
+    private:
+        DiscoveryScanner* const kScanner;
+
+        CARLA_DECLARE_NON_COPY_CLASS(WorkerThread)
+    };
+
+    const String fType;
+    const String fExecutable;
+
+    DiscoveryCache fCache;
+    const int fNumJobs;
+
+    // files that need to be checked
+    StringArray        fFiles;
+    Array<juce::int64> fMTimes;
+    Array<juce::int64> fSizes;
+    int                fNextFile;
+
+    CriticalSection fLock;
+    CriticalSection fOutputLock;
+
+    void runWorker(WorkerThread* const thread)
+    {
+        for (;;)
+        {
+            int index;
+
+            {
+                const ScopedLock sl(fLock);
+
+                if (fNextFile >= fFiles.size() || is_scan_cancelled())
+                    return;
+
+                index = fNextFile++;
+            }
+
+            const String& filename(fFiles[index]);
+
+            ScanProcess process;
+
+            if (! process.start(fExecutable, fType, filename))
+            {
+                const ScopedLock sl(fOutputLock);
+                DISCOVERY_OUT("file", filename.toRawUTF8());
+                DISCOVERY_OUT("error", "Failed to start discovery process");
+                continue;
+            }
+
+            {
+                const ScopedLock sl(fLock);
+                thread->process   = &process;
+                thread->startTime = Time::getMillisecondCounter();
+                thread->timedOut  = false;
+            }
+
+            const String output(process.readAllOutput());
+
+            // stdout is closed, the process should be gone soon
+            if (! process.waitForExit(1000))
+            {
+                process.kill();
+                process.waitForExit(1000);
+            }
+
+            bool timedOut;
+
+            {
+                const ScopedLock sl(fLock);
+                thread->process = nullptr;
+                timedOut = thread->timedOut;
+            }
+
+            // killed or not, results of a cancelled scan are neither kept nor written
+            if (is_scan_cancelled())
+                return;
+
+            StringArray lines;
+            lines.addLines(output);
+            lines.trim();
+            lines.removeEmptyStrings();
+
+            const String result(lines.joinIntoString("\n"));
+
+            // timeouts might not happen next time, don't keep them
+            if (! timedOut)
+                fCache.add(filename, fMTimes[index], fSizes[index], result);
+
+            printResult(filename, result, false, timedOut);
+        }
+    }
+
+    void printResult(const String& filename, const String& output, const bool cached, const bool timedOut)
+    {
+        const ScopedLock sl(fOutputLock);
+
+        DISCOVERY_OUT("file", filename.toRawUTF8());
+
+        if (cached)
+        {
+            DISCOVERY_OUT("cached", "true");
+        }
+
+        if (output.isNotEmpty())
+            std::cout << output.toRawUTF8() << std::endl;
+
+        if (timedOut)
+        {
+            DISCOVERY_OUT("crash", "timed out");
+        }
+        else if (! output.contains("carla-discovery::exit::"))
+        {
+            DISCOVERY_OUT("crash", "crashed");
+        }
+    }
+
+    CARLA_DECLARE_NON_COPY_CLASS(DiscoveryScanner)
+};
+
+static int do_scan(const char* const stype, const char* const cacheFilename, int numJobs)
+{
+    if (numJobs <= 0)
+        numJobs = juce::SystemStats::getNumCpus();
+    if (numJobs > kScanMaxJobs)
+        numJobs = kScanMaxJobs;
+
+    StringArray filenames;
+
+    for (std::string line; std::getline(std::cin, line);)
+    {
+        const String filename(String(CharPointer_UTF8(line.c_str())).trim());
+
+        if (filename.isNotEmpty() && ! filenames.contains(filename))
+            filenames.add(filename);
+    }
+
+#ifndef CARLA_OS_WIN
+    struct sigaction sterm;
+    carla_zeroStruct(sterm);
+    sterm.sa_handler = scan_cancel_handler;
+    sterm.sa_flags   = SA_RESTART;
+    sigemptyset(&sterm.sa_mask);
+    sigaction(SIGTERM, &sterm, nullptr);
+#endif
+
+    DiscoveryScanner scanner(stype, File(String(CharPointer_UTF8(cacheFilename))), numJobs);
+    scanner.scan(filenames);
+
+    return 0;
+}
+
+// ------------------------------ main entry point ------------------------------
+
+static int do_check(const char* const stype, const char* const filename)
+{
+    const PluginType type(getPluginTypeFromString(stype));
 
     CarlaString filenameCheck(filename);
     filenameCheck.toLower();
@@ -1773,4 +2553,24 @@ int main(int argc, char* argv[])
     return 0;
 }
 
+int main(int argc, char* argv[])
+{
+    if (argc >= 4 && std::strcmp(argv[1], "--scan") == 0)
+        return do_scan(argv[2], argv[3], (argc >= 5) ? std::atoi(argv[4]) : 0);
+
+    if (argc != 3)
+    {
+        carla_stdout("usage: %s <type> </path/to/plugin>", argv[0]);
+        carla_stdout("       %s --scan <type> </path/to/cache> [jobs] < list-of-files", argv[0]);
+        return 1;
+    }
+
+    const int ret(do_check(argv[1], argv[2]));
+
+    // lets the scan mode know we did not crash
+    DISCOVERY_OUT("exit", ret);
+
+    return ret;
+}
+
 // --------------------------------------------------------------------------
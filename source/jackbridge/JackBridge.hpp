@@ -398,6 +398,7 @@ JACKBRIDGE_API bool jackbridge_sem_init(void* sem) noexcept;
 JACKBRIDGE_API void jackbridge_sem_destroy(void* sem) noexcept;
 JACKBRIDGE_API void jackbridge_sem_post(void* sem) noexcept;
 JACKBRIDGE_API bool jackbridge_sem_timedwait(void* sem, uint msecs) noexcept;
+JACKBRIDGE_API bool jackbridge_sem_trywait(void* sem) noexcept;
 
 JACKBRIDGE_API bool  jackbridge_shm_is_valid(const void* shm) noexcept;
 JACKBRIDGE_API void  jackbridge_shm_init(void* shm) noexcept;
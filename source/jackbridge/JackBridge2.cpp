@@ -63,6 +63,17 @@ bool jackbridge_sem_timedwait(void* sem, uint msecs) noexcept
 #endif
 }
 
+bool jackbridge_sem_trywait(void* sem) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(sem != nullptr, false);
+
+#ifdef JACKBRIDGE_DUMMY
+    return false;
+#else
+    return carla_sem_trywait(*(carla_sem_t*)sem);
+#endif
+}
+
 // -----------------------------------------------------------------------------
 
 bool jackbridge_shm_is_valid(const void* shm) noexcept
@@ -130,6 +130,7 @@ const JackBridgeExportedFunctions* JACKBRIDGE_API jackbridge_get_exported_functi
     funcs.sem_destroy_ptr                      = jackbridge_sem_destroy;
     funcs.sem_post_ptr                         = jackbridge_sem_post;
     funcs.sem_timedwait_ptr                    = jackbridge_sem_timedwait;
+    funcs.sem_trywait_ptr                      = jackbridge_sem_trywait;
     funcs.shm_is_valid_ptr                     = jackbridge_shm_is_valid;
     funcs.shm_init_ptr                         = jackbridge_shm_init;
     funcs.shm_attach_ptr                       = jackbridge_shm_attach;
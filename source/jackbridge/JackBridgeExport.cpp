@@ -553,6 +553,11 @@ bool jackbridge_sem_timedwait(void* sem, uint msecs) noexcept
     return getBridgeInstance().sem_timedwait_ptr(sem, msecs);
 }
 
+bool jackbridge_sem_trywait(void* sem) noexcept
+{
+    return getBridgeInstance().sem_trywait_ptr(sem);
+}
+
 bool jackbridge_shm_is_valid(const void* shm) noexcept
 {
     return getBridgeInstance().shm_is_valid_ptr(shm);
@@ -113,6 +113,7 @@ typedef bool (JACKBRIDGE_API *jackbridgesym_sem_init)(void*);
 typedef void (JACKBRIDGE_API *jackbridgesym_sem_destroy)(void*);
 typedef void (JACKBRIDGE_API *jackbridgesym_sem_post)(void*);
 typedef bool (JACKBRIDGE_API *jackbridgesym_sem_timedwait)(void*, uint);
+typedef bool (JACKBRIDGE_API *jackbridgesym_sem_trywait)(void*);
 typedef bool (JACKBRIDGE_API *jackbridgesym_shm_is_valid)(const void*);
 typedef void (JACKBRIDGE_API *jackbridgesym_shm_init)(void*);
 typedef void (JACKBRIDGE_API *jackbridgesym_shm_attach)(void*, const char*);
@@ -217,6 +218,7 @@ struct _JackBridgeExportedFunctions {
     jackbridgesym_sem_destroy sem_destroy_ptr;
     jackbridgesym_sem_post sem_post_ptr;
     jackbridgesym_sem_timedwait sem_timedwait_ptr;
+    jackbridgesym_sem_trywait sem_trywait_ptr;
     jackbridgesym_shm_is_valid shm_is_valid_ptr;
     jackbridgesym_shm_init shm_init_ptr;
     jackbridgesym_shm_attach shm_attach_ptr;
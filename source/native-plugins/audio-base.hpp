@@ -0,0 +1,484 @@
+/*
+ * Carla Native Plugins
+ * Copyright (C) 2012-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the doc/GPL.txt file.
+ */
+
+#ifndef AUDIO_BASE_HPP_INCLUDED
+#define AUDIO_BASE_HPP_INCLUDED
+
+#include "CarlaMathUtils.hpp"
+#include "CarlaMutex.hpp"
+#include "CarlaSemUtils.hpp"
+#include "CarlaThread.hpp"
+#include "LinkedList.hpp"
+
+#include "juce_audio_formats.h"
+
+// -----------------------------------------------------------------------
+
+// files up to this length are fully loaded into RAM
+static const double kAudioPreloadMaxSeconds = 10.0;
+
+// streamed files keep this much audio read ahead
+static const double kAudioStreamRingSeconds = 2.0;
+
+// frames decoded at once by the reader thread
+static const uint32_t kAudioStreamChunkSize = 8192;
+
+class AudioFileStream;
+
+// -----------------------------------------------------------------------
+// Read-ahead thread, shared by all streamed files
+
+class AudioFileReaderThread : public CarlaThread
+{
+public:
+    static AudioFileReaderThread& getInstance()
+    {
+        static AudioFileReaderThread sThread;
+        return sThread;
+    }
+
+    void addStream(AudioFileStream* const stream) noexcept
+    {
+        {
+            const CarlaMutexLocker cml(fMutex);
+            fStreams.append(stream);
+        }
+
+        if (! isThreadRunning())
+            startThread();
+
+        wakeUp();
+    }
+
+    // waits for the stream to be done reading, if needed
+    void removeStream(AudioFileStream* const stream) noexcept
+    {
+        const CarlaMutexLocker cml(fMutex);
+        fStreams.removeOne(stream);
+    }
+
+    // realtime safe
+    void wakeUp() noexcept
+    {
+        if (__sync_bool_compare_and_swap(&fSignaled, 0, 1))
+            carla_sem_post(fSem);
+    }
+
+protected:
+    inline void run() override;
+
+private:
+    CarlaMutex fMutex;
+    LinkedList<AudioFileStream*> fStreams;
+
+    carla_sem_t fSem;
+    volatile int fSignaled;
+
+    AudioFileReaderThread() noexcept
+        : CarlaThread("AudioFileReaderThread"),
+          fMutex(),
+          fStreams(),
+          fSem(),
+          fSignaled(0)
+    {
+        carla_sem_create2(fSem);
+    }
+
+    ~AudioFileReaderThread() noexcept override
+    {
+        signalThreadShouldExit();
+        wakeUp();
+        stopThread(-1);
+
+        carla_sem_destroy2(fSem);
+    }
+
+    CARLA_DECLARE_NON_COPY_CLASS(AudioFileReaderThread)
+};
+
+// -----------------------------------------------------------------------
+// A stereo audio file being played back.
+//
+// Short files are loaded into RAM, longer ones are streamed: the reader thread
+// decodes ahead into a lock-free ring buffer, and the audio thread only copies
+// from it. Transport jumps outside the buffered range trigger a seek request.
+// While the transport is stopped the ring is kept filled at the current
+// position (pre-roll), so playback can start right away.
+
+class AudioFileStream
+{
+public:
+    // takes ownership of the reader
+    AudioFileStream(juce::AudioFormatReader* const reader, const double sampleRate)
+        : fReader(reader),
+          fLength(reader->lengthInSamples),
+          fPreloaded(reader->lengthInSamples <= static_cast<juce::int64>(sampleRate * kAudioPreloadMaxSeconds)),
+          fBuffer(),
+          fTmpBuffer(),
+          fRingSize(0),
+          fWriteIndex(0),
+          fReadIndex(0),
+          fSeekPos(0),
+          fSeekLoop(false),
+          fSeekGen(1),
+          fReadyGen(0),
+          fStartIndex(0),
+          fStartPos(0),
+          fFilePos(0),
+          fFileLoop(false),
+          fCurrentGen(0),
+          fWantedGen(1),
+          fSynced(false),
+          fNextPos(0),
+          fNextLoop(false)
+    {
+        if (fPreloaded)
+        {
+            fBuffer.setSize(2, static_cast<int>(fLength));
+            fReader->read(&fBuffer, 0, static_cast<int>(fLength), 0, true, true);
+            fReader = nullptr;
+            return;
+        }
+
+        fRingSize = carla_nextPowerOf2(static_cast<uint32_t>(sampleRate * kAudioStreamRingSeconds));
+        fBuffer.setSize(2, static_cast<int>(fRingSize));
+        fTmpBuffer.setSize(2, static_cast<int>(kAudioStreamChunkSize));
+
+        // initial seek request (fSeekGen = 1) is for the file start
+        AudioFileReaderThread::getInstance().addStream(this);
+    }
+
+    ~AudioFileStream()
+    {
+        if (! fPreloaded)
+            AudioFileReaderThread::getInstance().removeStream(this);
+    }
+
+    int64_t getLength() const noexcept
+    {
+        return fLength;
+    }
+
+    bool isPreloaded() const noexcept
+    {
+        return fPreloaded;
+    }
+
+    // -------------------------------------------------------------------
+    // audio thread
+
+    void process(float* const out1, float* const out2, const uint32_t frames, const uint64_t frame, const bool loop, const bool playing) noexcept
+    {
+        if (fLength <= 0 || (! loop && frame >= static_cast<uint64_t>(fLength)))
+        {
+            zeroFrames(out1, frames);
+            zeroFrames(out2, frames);
+            return;
+        }
+
+        const int64_t pos(loop ? static_cast<int64_t>(frame % static_cast<uint64_t>(fLength)) : static_cast<int64_t>(frame));
+
+        if (fPreloaded)
+        {
+            if (playing)
+                readPreloaded(out1, out2, frames, pos, loop);
+            else
+            {
+                zeroFrames(out1, frames);
+                zeroFrames(out2, frames);
+            }
+            return;
+        }
+
+        readStream(out1, out2, playing ? frames : 0, pos, loop);
+
+        if (! playing)
+        {
+            zeroFrames(out1, frames);
+            zeroFrames(out2, frames);
+        }
+    }
+
+    // -------------------------------------------------------------------
+    // reader thread, returns true if there is more to read
+
+    bool fillRing()
+    {
+        // handle seek requests
+        for (int gen = fSeekGen; gen != fCurrentGen; gen = fSeekGen)
+        {
+            __sync_synchronize();
+            const int64_t pos(fSeekPos);
+            const bool   loop(fSeekLoop);
+            __sync_synchronize();
+
+            if (gen != fSeekGen)
+                continue;
+
+            fCurrentGen = gen;
+            fFilePos    = pos;
+            fFileLoop   = loop;
+
+            fStartIndex = fWriteIndex;
+            fStartPos   = pos;
+            __sync_synchronize();
+            fReadyGen = gen;
+        }
+
+        if (! fFileLoop && fFilePos >= fLength)
+            return false;
+
+        const uint32_t writeIndex(fWriteIndex);
+        const uint32_t used(writeIndex - fReadIndex);
+
+        if (used >= fRingSize)
+            return false;
+
+        uint32_t frames(fRingSize - used);
+
+        if (frames > kAudioStreamChunkSize)
+            frames = kAudioStreamChunkSize;
+        if (static_cast<int64_t>(frames) > fLength - fFilePos)
+            frames = static_cast<uint32_t>(fLength - fFilePos);
+
+        fReader->read(&fTmpBuffer, 0, static_cast<int>(frames), fFilePos, true, true);
+
+        const uint32_t offset(writeIndex & (fRingSize - 1));
+        const uint32_t firstPart(std::min(frames, fRingSize - offset));
+
+        for (int c=0; c < 2; ++c)
+        {
+            float* const ring(fBuffer.getWritePointer(c));
+            const float* const tmp(fTmpBuffer.getReadPointer(c));
+
+            copyFrames(ring + offset, tmp, firstPart);
+
+            if (firstPart < frames)
+                copyFrames(ring, tmp + firstPart, frames - firstPart);
+        }
+
+        __sync_synchronize();
+        fWriteIndex = writeIndex + frames;
+
+        fFilePos += frames;
+
+        if (fFileLoop && fFilePos >= fLength)
+            fFilePos = 0;
+
+        return true;
+    }
+
+private:
+    juce::ScopedPointer<juce::AudioFormatReader> fReader;
+
+    const int64_t fLength;
+    const bool    fPreloaded;
+
+    // full file if preloaded, ring buffer otherwise
+    juce::AudioSampleBuffer fBuffer;
+    juce::AudioSampleBuffer fTmpBuffer;
+
+    // ring indexes, only ever increase (wrapping around)
+    uint32_t fRingSize;
+    volatile uint32_t fWriteIndex; // written by reader thread
+    volatile uint32_t fReadIndex;  // written by audio thread
+
+    // seek request, written by audio thread
+    int64_t fSeekPos;
+    bool    fSeekLoop;
+    volatile int fSeekGen;
+
+    // seek result, written by reader thread
+    volatile int fReadyGen;
+    uint32_t fStartIndex;
+    int64_t  fStartPos;
+
+    // reader thread state
+    int64_t fFilePos;
+    bool    fFileLoop;
+    int     fCurrentGen;
+
+    // audio thread state
+    int     fWantedGen;
+    bool    fSynced;
+    int64_t fNextPos; // file position at fReadIndex
+    bool    fNextLoop;
+
+    static void zeroFrames(float* const data, const uint32_t count) noexcept
+    {
+        juce::FloatVectorOperations::clear(data, static_cast<int>(count));
+    }
+
+    static void copyFrames(float* const dest, const float* const src, const uint32_t count) noexcept
+    {
+        juce::FloatVectorOperations::copy(dest, src, static_cast<int>(count));
+    }
+
+    void readPreloaded(float* const out1, float* const out2, const uint32_t frames, int64_t pos, const bool loop) noexcept
+    {
+        const float* const buf1(fBuffer.getReadPointer(0));
+        const float* const buf2(fBuffer.getReadPointer(1));
+
+        for (uint32_t done = 0; done < frames;)
+        {
+            if (pos >= fLength)
+            {
+                if (! loop)
+                {
+                    zeroFrames(out1 + done, frames - done);
+                    zeroFrames(out2 + done, frames - done);
+                    return;
+                }
+                pos = 0;
+            }
+
+            const uint32_t todo(static_cast<uint32_t>(std::min<int64_t>(frames - done, fLength - pos)));
+
+            copyFrames(out1 + done, buf1 + pos, todo);
+            copyFrames(out2 + done, buf2 + pos, todo);
+
+            done += todo;
+            pos  += todo;
+        }
+    }
+
+    void requestSeek(const int64_t pos, const bool loop) noexcept
+    {
+        fSynced   = false;
+        fSeekPos  = pos;
+        fSeekLoop = loop;
+        __sync_synchronize();
+        fSeekGen = ++fWantedGen;
+
+        AudioFileReaderThread::getInstance().wakeUp();
+    }
+
+    // 'frames' can be 0, to only prepare the ring for 'pos'
+    void readStream(float* const out1, float* const out2, const uint32_t frames, const int64_t pos, const bool loop) noexcept
+    {
+        if (! fSynced)
+        {
+            if (fReadyGen != fWantedGen)
+            {
+                // still seeking
+                zeroFrames(out1, frames);
+                zeroFrames(out2, frames);
+                return;
+            }
+
+            __sync_synchronize();
+            fReadIndex = fStartIndex;
+            fNextPos   = fStartPos;
+            fNextLoop  = fSeekLoop;
+            fSynced    = true;
+        }
+
+        uint32_t available(fWriteIndex - fReadIndex);
+        __sync_synchronize();
+
+        if (pos != fNextPos || loop != fNextLoop)
+        {
+            const int64_t skip(loop ? (pos - fNextPos + fLength) % fLength : pos - fNextPos);
+
+            // seek if position is not in the ring yet, reading ahead of the transport so we catch up
+            if (loop != fNextLoop || skip < 0 || skip >= static_cast<int64_t>(available))
+            {
+                int64_t seekPos(pos + static_cast<int64_t>(frames));
+
+                if (loop)
+                    seekPos %= fLength;
+
+                requestSeek(seekPos, loop);
+                zeroFrames(out1, frames);
+                zeroFrames(out2, frames);
+                return;
+            }
+
+            fReadIndex = fReadIndex + static_cast<uint32_t>(skip);
+            fNextPos   = pos;
+            available -= static_cast<uint32_t>(skip);
+        }
+
+        const uint32_t todo(std::min(frames, available));
+        const uint32_t offset(fReadIndex & (fRingSize - 1));
+        const uint32_t firstPart(std::min(todo, fRingSize - offset));
+
+        const float* const ring1(fBuffer.getReadPointer(0));
+        const float* const ring2(fBuffer.getReadPointer(1));
+
+        copyFrames(out1, ring1 + offset, firstPart);
+        copyFrames(out2, ring2 + offset, firstPart);
+
+        if (firstPart < todo)
+        {
+            copyFrames(out1 + firstPart, ring1, todo - firstPart);
+            copyFrames(out2 + firstPart, ring2, todo - firstPart);
+        }
+
+        // underrun or end of file
+        if (todo < frames)
+        {
+            zeroFrames(out1 + todo, frames - todo);
+            zeroFrames(out2 + todo, frames - todo);
+        }
+
+        __sync_synchronize();
+        fReadIndex = fReadIndex + todo;
+        fNextPos  += todo;
+
+        if (loop)
+            fNextPos %= fLength;
+
+        if (available - todo < fRingSize / 2)
+            AudioFileReaderThread::getInstance().wakeUp();
+    }
+
+    CARLA_DECLARE_NON_COPY_CLASS(AudioFileStream)
+};
+
+// -----------------------------------------------------------------------
+
+void AudioFileReaderThread::run()
+{
+    for (; ! shouldThreadExit();)
+    {
+        carla_sem_timedwait(fSem, 50);
+        __sync_bool_compare_and_swap(&fSignaled, 1, 0);
+
+        for (bool moreToRead = true; moreToRead && ! shouldThreadExit();)
+        {
+            moreToRead = false;
+
+            const CarlaMutexLocker cml(fMutex);
+
+            for (LinkedList<AudioFileStream*>::Itenerator it = fStreams.begin2(); it.valid(); it.next())
+            {
+                AudioFileStream* const stream(it.getValue(nullptr));
+                CARLA_SAFE_ASSERT_CONTINUE(stream != nullptr);
+
+                try {
+                    if (stream->fillRing())
+                        moreToRead = true;
+                } CARLA_SAFE_EXCEPTION("AudioFileStream::fillRing");
+            }
+        }
+    }
+}
+
+// -----------------------------------------------------------------------
+
+#endif // AUDIO_BASE_HPP_INCLUDED
@@ -16,11 +16,9 @@
  */
 
 #include "CarlaNative.hpp"
-
-#include "CarlaMutex.hpp"
 #include "CarlaString.hpp"
 
-#include "juce_audio_formats.h"
+#include "audio-base.hpp"
 
 using namespace juce;
 
@@ -41,22 +39,12 @@ public:
     AudioFilePlugin(const NativeHostDescriptor* const host)
         : NativePluginClass(host),
           fLoopMode(false),
-          fDoProcess(false),
-          fLength(0),
-          //fThread("AudioFilePluginThread"),
-          fReaderBuffer(),
-          fReaderMutex(),
-          fReader(),
-          fReaderSource()
-    {
-        fReaderBuffer.setSize(2, static_cast<int>(getBufferSize()));
-    }
+          fStreamMutex(),
+          fStream() {}
 
     ~AudioFilePlugin() override
     {
-        //fThread.stopThread(-1);
-        fReader       = nullptr;
-        fReaderSource = nullptr;
+        fStream = nullptr;
     }
 
 protected:
@@ -108,15 +96,8 @@ protected:
 
         const bool loopMode(value > 0.5f);
 
-        if (fLoopMode == loopMode)
-            return;
-
+        // the stream seeks by itself when loop mode changes
         fLoopMode = loopMode;
-
-        const CarlaMutexLocker cml(fReaderMutex);
-
-        if (fReaderSource != nullptr)
-            fReaderSource->setLooping(loopMode);
     }
 
     void setCustomData(const char* const key, const char* const value) override
@@ -136,48 +117,21 @@ protected:
     void process(float**, float** const outBuffer, const uint32_t frames, const NativeMidiEvent* const, const uint32_t) override
     {
         const NativeTimeInfo* const timePos(getTimeInfo());
-        const int iframes(static_cast<int>(frames));
 
         float* const out1(outBuffer[0]);
         float* const out2(outBuffer[1]);
 
-        if (fLength == 0 || ! fDoProcess)
-        {
-            //carla_stderr("P: no process");
-            FloatVectorOperations::clear(out1, iframes);
-            FloatVectorOperations::clear(out2, iframes);
-            return;
-        }
-
-        const int64_t nextReadPos(fLoopMode ? (static_cast<int64_t>(timePos->frame) % fLength) : static_cast<int64_t>(timePos->frame));
+        // only locked while a new file is being swapped in
+        const CarlaMutexTryLocker cmtl(fStreamMutex);
 
-        // not playing
-        if (! timePos->playing)
+        if (cmtl.wasNotLocked() || fStream == nullptr)
         {
-            //carla_stderr("P: not playing");
-            FloatVectorOperations::clear(out1, iframes);
-            FloatVectorOperations::clear(out2, iframes);
-
-            const CarlaMutexLocker cml(fReaderMutex);
-
-            if (fReaderSource != nullptr)
-                fReaderSource->setNextReadPosition(nextReadPos);
-
+            FloatVectorOperations::clear(out1, static_cast<int>(frames));
+            FloatVectorOperations::clear(out2, static_cast<int>(frames));
             return;
         }
 
-        const CarlaMutexLocker cml(fReaderMutex);
-
-        if (fReaderSource != nullptr)
-            fReaderSource->setNextReadPosition(nextReadPos);
-
-        if (fReader == nullptr)
-            return;
-
-        fReader->read(&fReaderBuffer, 0, iframes, nextReadPos, true, true);
-
-        FloatVectorOperations::copy(out1, fReaderBuffer.getReadPointer(0), iframes);
-        FloatVectorOperations::copy(out2, fReaderBuffer.getReadPointer(1), iframes);
+        fStream->process(out1, out2, frames, timePos->frame, fLoopMode, timePos->playing);
     }
 
     // -------------------------------------------------------------------
@@ -194,44 +148,22 @@ protected:
         uiClosed();
     }
 
-    // -------------------------------------------------------------------
-    // Plugin dispatcher calls
-
-    void bufferSizeChanged(const uint32_t bufferSize) override
-    {
-        fReaderBuffer.setSize(2, static_cast<int>(bufferSize));
-    }
-
 private:
-    bool fLoopMode;
-    bool fDoProcess;
-    int64_t fLength;
-
-    //TimeSliceThread fThread;
+    volatile bool fLoopMode;
 
-    AudioSampleBuffer fReaderBuffer;
-    CarlaMutex        fReaderMutex;
-
-    ScopedPointer<AudioFormatReader>       fReader;
-    ScopedPointer<AudioFormatReaderSource> fReaderSource;
+    CarlaMutex fStreamMutex;
+    ScopedPointer<AudioFileStream> fStream;
 
     void _loadAudioFile(const char* const filename)
     {
         carla_stdout("AudioFilePlugin::loadFilename(\"%s\")", filename);
 
-        fDoProcess = false;
-        fLength    = 0;
-
-        //fThread.stopThread(-1);
-
         {
-            fReaderMutex.lock();
-            AudioFormatReader*       const reader(fReader.release());
-            AudioFormatReaderSource* const readerSource(fReaderSource.release());
-            fReaderMutex.unlock();
+            fStreamMutex.lock();
+            AudioFileStream* const stream(fStream.release());
+            fStreamMutex.unlock();
 
-            delete readerSource;
-            delete reader;
+            delete stream;
         }
 
         const String jfilename = String(CharPointer_UTF8(filename));
@@ -242,37 +174,19 @@ private:
 
         AudioFormatManager& afm(getAudioFormatManagerInstance());
 
-        AudioFormat* const format(afm.findFormatForFileExtension(file.getFileExtension()));
-        CARLA_SAFE_ASSERT_RETURN(format != nullptr,);
-
-        if (MemoryMappedAudioFormatReader* const memReader = format->createMemoryMappedReader(file))
-        {
-            memReader->mapEntireFile();
-            fReader = memReader;
-
-            carla_stdout("Using memory mapped read file");
-        }
-        else
-        {
-            AudioFormatReader* const reader(afm.createReaderFor(file));
-            CARLA_SAFE_ASSERT_RETURN(reader != nullptr,);
+        AudioFormatReader* const reader(afm.createReaderFor(file));
+        CARLA_SAFE_ASSERT_RETURN(reader != nullptr,);
 
-            // this code can be used for very large files
-            //fThread.startThread();
-            //BufferingAudioReader* const bufferingReader(new BufferingAudioReader(reader, fThread, getSampleRate()*2));
-            //bufferingReader->setReadTimeout(50);
+        AudioFileStream* stream = nullptr;
 
-            AudioFormatReaderSource* const readerSource(new AudioFormatReaderSource(/*bufferingReader*/reader, false));
-            readerSource->setLooping(fLoopMode);
+        try {
+            stream = new AudioFileStream(reader, getSampleRate());
+        } CARLA_SAFE_EXCEPTION_RETURN("new AudioFileStream",);
 
-            fReaderSource = readerSource;
-            fReader       = reader;
-
-            carla_stdout("Using regular read file");
-        }
+        carla_stdout(stream->isPreloaded() ? "Using preloaded file" : "Using streamed file");
 
-        fLength    = fReader->lengthInSamples;
-        fDoProcess = true;
+        const CarlaMutexLocker cml(fStreamMutex);
+        fStream = stream;
     }
 
     PluginClassEND(AudioFilePlugin)
@@ -20,11 +20,12 @@
 
 #include "CarlaMIDI.h"
 #include "CarlaMutex.hpp"
-#include "LinkedList.hpp"
 
 #include "CarlaJuceUtils.hpp"
 #include "CarlaMathUtils.hpp"
 
+#include <algorithm>
+
 // -----------------------------------------------------------------------
 
 #define MAX_EVENT_DATA_SIZE          4
@@ -50,6 +51,16 @@ public:
 
 // -----------------------------------------------------------------------
 
+/*
+ * Time-sorted list of MIDI events, played back from the audio thread.
+ *
+ * Events are kept by value in one contiguous array, sorted by time (events with the same time keep insertion order).
+ * Every change publishes a read-only copy for playback, which the audio thread picks up without locking.
+ * Playback keeps a cursor into that copy and only does a binary search when the play position jumps,
+ * so each call costs O(log n) at most plus the events in the block.
+ *
+ * Use beginChanges() and endChanges() (or ScopedChanges) around large edits so the copy is only made once.
+ */
 class MidiPattern
 {
 public:
@@ -58,14 +69,29 @@ public:
           fMidiPort(0),
           fStartTime(0),
           fMutex(),
-          fData()
+          fEvents(nullptr),
+          fCount(0),
+          fCapacity(0),
+          fChangesDepth(0),
+          fNeedsSort(false),
+          fPending(nullptr),
+          fRetired(nullptr),
+          fPlaying(nullptr),
+          fCursor(0),
+          fCursorTime(0.0),
+          fCursorValid(false)
     {
         CARLA_SAFE_ASSERT(kPlayer != nullptr);
     }
 
     ~MidiPattern() noexcept
     {
-        clear();
+        if (fEvents != nullptr)
+            delete[] fEvents;
+
+        deleteEventList(fPending);
+        deleteEventList(fPlaying);
+        deleteRetired();
     }
 
     // -------------------------------------------------------------------
@@ -73,83 +99,96 @@ public:
 
     void addControl(const uint64_t time, const uint8_t channel, const uint8_t control, const uint8_t value)
     {
-        RawMidiEvent* const ctrlEvent(new RawMidiEvent());
-        ctrlEvent->time    = time;
-        ctrlEvent->size    = 3;
-        ctrlEvent->data[0] = uint8_t(MIDI_STATUS_CONTROL_CHANGE | (channel & MIDI_CHANNEL_BIT));
-        ctrlEvent->data[1] = control;
-        ctrlEvent->data[2] = value;
+        RawMidiEvent ctrlEvent;
+        ctrlEvent.time    = time;
+        ctrlEvent.size    = 3;
+        ctrlEvent.data[0] = uint8_t(MIDI_STATUS_CONTROL_CHANGE | (channel & MIDI_CHANNEL_BIT));
+        ctrlEvent.data[1] = control;
+        ctrlEvent.data[2] = value;
+        ctrlEvent.data[3] = 0;
 
         appendSorted(ctrlEvent);
     }
 
     void addChannelPressure(const uint64_t time, const uint8_t channel, const uint8_t pressure)
     {
-        RawMidiEvent* const pressureEvent(new RawMidiEvent());
-        pressureEvent->time    = time;
-        pressureEvent->size    = 2;
-        pressureEvent->data[0] = uint8_t(MIDI_STATUS_CHANNEL_PRESSURE | (channel & MIDI_CHANNEL_BIT));
-        pressureEvent->data[1] = pressure;
+        RawMidiEvent pressureEvent;
+        pressureEvent.time    = time;
+        pressureEvent.size    = 2;
+        pressureEvent.data[0] = uint8_t(MIDI_STATUS_CHANNEL_PRESSURE | (channel & MIDI_CHANNEL_BIT));
+        pressureEvent.data[1] = pressure;
+        pressureEvent.data[2] = 0;
+        pressureEvent.data[3] = 0;
 
         appendSorted(pressureEvent);
     }
 
     void addNote(const uint64_t time, const uint8_t channel, const uint8_t pitch, const uint8_t velocity, const uint32_t duration)
     {
+        const ScopedChanges sc(*this);
+
         addNoteOn(time, channel, pitch, velocity);
         addNoteOff(time+duration, channel, pitch, velocity);
     }
 
     void addNoteOn(const uint64_t time, const uint8_t channel, const uint8_t pitch, const uint8_t velocity)
     {
-        RawMidiEvent* const noteOnEvent(new RawMidiEvent());
-        noteOnEvent->time    = time;
-        noteOnEvent->size    = 3;
-        noteOnEvent->data[0] = uint8_t(MIDI_STATUS_NOTE_ON | (channel & MIDI_CHANNEL_BIT));
-        noteOnEvent->data[1] = pitch;
-        noteOnEvent->data[2] = velocity;
+        RawMidiEvent noteOnEvent;
+        noteOnEvent.time    = time;
+        noteOnEvent.size    = 3;
+        noteOnEvent.data[0] = uint8_t(MIDI_STATUS_NOTE_ON | (channel & MIDI_CHANNEL_BIT));
+        noteOnEvent.data[1] = pitch;
+        noteOnEvent.data[2] = velocity;
+        noteOnEvent.data[3] = 0;
 
         appendSorted(noteOnEvent);
     }
 
     void addNoteOff(const uint64_t time, const uint8_t channel, const uint8_t pitch, const uint8_t velocity = 0)
     {
-        RawMidiEvent* const noteOffEvent(new RawMidiEvent());
-        noteOffEvent->time    = time;
-        noteOffEvent->size    = 3;
-        noteOffEvent->data[0] = uint8_t(MIDI_STATUS_NOTE_OFF | (channel & MIDI_CHANNEL_BIT));
-        noteOffEvent->data[1] = pitch;
-        noteOffEvent->data[2] = velocity;
+        RawMidiEvent noteOffEvent;
+        noteOffEvent.time    = time;
+        noteOffEvent.size    = 3;
+        noteOffEvent.data[0] = uint8_t(MIDI_STATUS_NOTE_OFF | (channel & MIDI_CHANNEL_BIT));
+        noteOffEvent.data[1] = pitch;
+        noteOffEvent.data[2] = velocity;
+        noteOffEvent.data[3] = 0;
 
         appendSorted(noteOffEvent);
     }
 
     void addNoteAftertouch(const uint64_t time, const uint8_t channel, const uint8_t pitch, const uint8_t pressure)
     {
-        RawMidiEvent* const noteAfterEvent(new RawMidiEvent());
-        noteAfterEvent->time    = time;
-        noteAfterEvent->size    = 3;
-        noteAfterEvent->data[0] = uint8_t(MIDI_STATUS_POLYPHONIC_AFTERTOUCH | (channel & MIDI_CHANNEL_BIT));
-        noteAfterEvent->data[1] = pitch;
-        noteAfterEvent->data[2] = pressure;
+        RawMidiEvent noteAfterEvent;
+        noteAfterEvent.time    = time;
+        noteAfterEvent.size    = 3;
+        noteAfterEvent.data[0] = uint8_t(MIDI_STATUS_POLYPHONIC_AFTERTOUCH | (channel & MIDI_CHANNEL_BIT));
+        noteAfterEvent.data[1] = pitch;
+        noteAfterEvent.data[2] = pressure;
+        noteAfterEvent.data[3] = 0;
 
         appendSorted(noteAfterEvent);
     }
 
     void addProgram(const uint64_t time, const uint8_t channel, const uint8_t bank, const uint8_t program)
     {
-        RawMidiEvent* const bankEvent(new RawMidiEvent());
-        bankEvent->time    = time;
-        bankEvent->size    = 3;
-        bankEvent->data[0] = uint8_t(MIDI_STATUS_CONTROL_CHANGE | (channel & MIDI_CHANNEL_BIT));
-        bankEvent->data[1] = MIDI_CONTROL_BANK_SELECT;
-        bankEvent->data[2] = bank;
-
-        RawMidiEvent* const programEvent(new RawMidiEvent());
-        programEvent->time    = time;
-        programEvent->size    = 2;
-        programEvent->data[0] = uint8_t(MIDI_STATUS_PROGRAM_CHANGE | (channel & MIDI_CHANNEL_BIT));
-        programEvent->data[1] = program;
+        RawMidiEvent bankEvent;
+        bankEvent.time    = time;
+        bankEvent.size    = 3;
+        bankEvent.data[0] = uint8_t(MIDI_STATUS_CONTROL_CHANGE | (channel & MIDI_CHANNEL_BIT));
+        bankEvent.data[1] = MIDI_CONTROL_BANK_SELECT;
+        bankEvent.data[2] = bank;
+        bankEvent.data[3] = 0;
+
+        RawMidiEvent programEvent;
+        programEvent.time    = time;
+        programEvent.size    = 2;
+        programEvent.data[0] = uint8_t(MIDI_STATUS_PROGRAM_CHANGE | (channel & MIDI_CHANNEL_BIT));
+        programEvent.data[1] = program;
+        programEvent.data[2] = 0;
+        programEvent.data[3] = 0;
+
+        const ScopedChanges sc(*this);
 
         appendSorted(bankEvent);
         appendSorted(programEvent);
@@ -157,23 +196,27 @@ public:
 
     void addPitchbend(const uint64_t time, const uint8_t channel, const uint8_t lsb, const uint8_t msb)
     {
-        RawMidiEvent* const pressureEvent(new RawMidiEvent());
-        pressureEvent->time    = time;
-        pressureEvent->size    = 3;
-        pressureEvent->data[0] = uint8_t(MIDI_STATUS_PITCH_WHEEL_CONTROL | (channel & MIDI_CHANNEL_BIT));
-        pressureEvent->data[1] = lsb;
-        pressureEvent->data[2] = msb;
+        RawMidiEvent pressureEvent;
+        pressureEvent.time    = time;
+        pressureEvent.size    = 3;
+        pressureEvent.data[0] = uint8_t(MIDI_STATUS_PITCH_WHEEL_CONTROL | (channel & MIDI_CHANNEL_BIT));
+        pressureEvent.data[1] = lsb;
+        pressureEvent.data[2] = msb;
+        pressureEvent.data[3] = 0;
 
         appendSorted(pressureEvent);
     }
 
     void addRaw(const uint64_t time, const uint8_t* const data, const uint8_t size)
     {
-        RawMidiEvent* const rawEvent(new RawMidiEvent());
-        rawEvent->time = time;
-        rawEvent->size = size;
+        CARLA_SAFE_ASSERT_RETURN(size > 0 && size <= MAX_EVENT_DATA_SIZE,);
 
-        carla_copy<uint8_t>(rawEvent->data, data, size);
+        RawMidiEvent rawEvent;
+        carla_zeroStruct(rawEvent);
+        rawEvent.time = time;
+        rawEvent.size = size;
+
+        carla_copy<uint8_t>(rawEvent.data, data, size);
 
         appendSorted(rawEvent);
     }
@@ -185,21 +228,21 @@ public:
     {
         const CarlaMutexLocker sl(fMutex);
 
-        for (LinkedList<const RawMidiEvent*>::Itenerator it = fData.begin2(); it.valid(); it.next())
+        sortIfNeeded();
+
+        for (uint32_t i = findFirst(fEvents, fCount, static_cast<long double>(time)); i < fCount && fEvents[i].time == time; ++i)
         {
-            const RawMidiEvent* const rawMidiEvent(it.getValue(nullptr));
-            CARLA_SAFE_ASSERT_CONTINUE(rawMidiEvent != nullptr);
+            const RawMidiEvent& rawMidiEvent(fEvents[i]);
 
-            if (rawMidiEvent->time != time)
+            if (rawMidiEvent.size != size)
                 continue;
-            if (rawMidiEvent->size != size)
-                continue;
-            if (std::memcmp(rawMidiEvent->data, data, size) != 0)
+            if (std::memcmp(rawMidiEvent.data, data, size) != 0)
                 continue;
 
-            delete rawMidiEvent;
-            fData.remove(it);
+            std::memmove(fEvents+i, fEvents+i+1, sizeof(RawMidiEvent)*(fCount-i-1));
+            --fCount;
 
+            publish();
             return;
         }
 
@@ -213,12 +256,57 @@ public:
     {
         const CarlaMutexLocker sl(fMutex);
 
-        for (LinkedList<const RawMidiEvent*>::Itenerator it = fData.begin2(); it.valid(); it.next())
-            delete it.getValue(nullptr);
+        fCount     = 0;
+        fNeedsSort = false;
 
-        fData.clear();
+        publish();
     }
 
+    // -------------------------------------------------------------------
+    // group changes
+
+    /*
+     * Start a group of changes, playback keeps the previous events until the matching endChanges().
+     * Events added meanwhile are sorted once at the end.
+     */
+    void beginChanges() noexcept
+    {
+        const CarlaMutexLocker sl(fMutex);
+
+        ++fChangesDepth;
+    }
+
+    void endChanges() noexcept
+    {
+        const CarlaMutexLocker sl(fMutex);
+
+        CARLA_SAFE_ASSERT_RETURN(fChangesDepth > 0,);
+
+        if (--fChangesDepth == 0)
+            publish();
+    }
+
+    class ScopedChanges
+    {
+    public:
+        ScopedChanges(MidiPattern& pattern) noexcept
+            : fPattern(pattern)
+        {
+            fPattern.beginChanges();
+        }
+
+        ~ScopedChanges() noexcept
+        {
+            fPattern.endChanges();
+        }
+
+    private:
+        MidiPattern& fPattern;
+
+        CARLA_PREVENT_HEAP_ALLOCATION
+        CARLA_DECLARE_NON_COPY_CLASS(ScopedChanges)
+    };
+
     // -------------------------------------------------------------------
     // play on time
 
@@ -229,26 +317,43 @@ public:
 
     void play(long double timePosFrame, const double frames)
     {
-        if (! fMutex.tryLock())
+        // pick up the latest changes
+        if (EventList* const newList = exchangeEventList(fPending, nullptr))
+        {
+            retireEventList(fPlaying);
+            fPlaying     = newList;
+            fCursorValid = false;
+        }
+
+        const EventList* const list(fPlaying);
+
+        if (list == nullptr)
             return;
 
         if (fStartTime != 0)
             timePosFrame += static_cast<long double>(fStartTime);
 
-        for (LinkedList<const RawMidiEvent*>::Itenerator it = fData.begin2(); it.valid(); it.next())
+        // only search when not continuing from the previous call
+        uint32_t i = fCursor;
+
+        if (! fCursorValid || timePosFrame != fCursorTime)
+            i = findFirst(list->data, list->count, timePosFrame);
+
+        const long double endPosFrame(timePosFrame + frames);
+
+        for (; i < list->count; ++i)
         {
-            const RawMidiEvent* const rawMidiEvent(it.getValue(nullptr));
-            CARLA_SAFE_ASSERT_CONTINUE(rawMidiEvent != nullptr);
+            const RawMidiEvent* const rawMidiEvent(&list->data[i]);
 
-            if (timePosFrame > rawMidiEvent->time)
-                continue;
-            if (timePosFrame + frames <= rawMidiEvent->time)
-                continue;
+            if (endPosFrame <= rawMidiEvent->time)
+                break;
 
             kPlayer->writeMidiEvent(fMidiPort, static_cast<long double>(rawMidiEvent->time)-timePosFrame, rawMidiEvent);
         }
 
-        fMutex.unlock();
+        fCursor      = i;
+        fCursorTime  = endPosFrame;
+        fCursorValid = true;
     }
 
     // -------------------------------------------------------------------
@@ -265,16 +370,21 @@ public:
     }
 
     // -------------------------------------------------------------------
-    // special
+    // special, events are only valid while holding the lock
 
     const CarlaMutex& getLock() const noexcept
     {
         return fMutex;
     }
 
-    LinkedList<const RawMidiEvent*>::Itenerator iteneratorBegin() const noexcept
+    const RawMidiEvent* getEvents() const noexcept
+    {
+        return fEvents;
+    }
+
+    uint32_t getEventCount() const noexcept
     {
-        return fData.begin2();
+        return fCount;
     }
 
     // -------------------------------------------------------------------
@@ -288,19 +398,18 @@ public:
 
         const CarlaMutexLocker sl(fMutex);
 
-        if (fData.count() == 0)
+        if (fCount == 0)
             return nullptr;
 
-        char* const data((char*)std::calloc(1, fData.count()*maxMsgSize));
+        char* const data((char*)std::calloc(1, fCount*maxMsgSize));
         CARLA_SAFE_ASSERT_RETURN(data != nullptr, nullptr);
 
         char* dataWrtn = data;
         int wrtn;
 
-        for (LinkedList<const RawMidiEvent*>::Itenerator it = fData.begin2(); it.valid(); it.next())
+        for (uint32_t j=0; j < fCount; ++j)
         {
-            const RawMidiEvent* const rawMidiEvent(it.getValue(nullptr));
-            CARLA_SAFE_ASSERT_CONTINUE(rawMidiEvent != nullptr);
+            const RawMidiEvent* const rawMidiEvent(&fEvents[j]);
 
             wrtn = std::snprintf(dataWrtn, maxTimeSize+4, P_INT64 ":%i:", rawMidiEvent->time, rawMidiEvent->size);
             CARLA_SAFE_ASSERT_BREAK(wrtn > 0);
@@ -335,9 +444,9 @@ public:
         char    tmpBuf[24];
         ssize_t tmpSize;
 
-        clear();
+        const ScopedChanges sc(*this);
 
-        const CarlaMutexLocker sl(fMutex);
+        clear();
 
         for (; *dataRead != '\0';)
         {
@@ -407,46 +516,194 @@ public:
             for (int i=size; i<MAX_EVENT_DATA_SIZE; ++i)
                 midiEvent.data[i] = 0;
 
-            RawMidiEvent* const event(new RawMidiEvent());
-            carla_copyStruct(*event, midiEvent);
-            fData.append(event);
+            appendSorted(midiEvent);
         }
     }
 
     // -------------------------------------------------------------------
 
 private:
+    // read-only copy of the events, as seen by play()
+    struct EventList {
+        RawMidiEvent* data;
+        uint32_t count;
+        EventList* nextRetired;
+    };
+
     AbstractMidiPlayer* const kPlayer;
 
     uint8_t  fMidiPort;
     uint64_t fStartTime;
 
-    CarlaMutex fMutex;
-    LinkedList<const RawMidiEvent*> fData;
+    // editing side, protected by the mutex
+    CarlaMutex    fMutex;
+    RawMidiEvent* fEvents;
+    uint32_t      fCount;
+    uint32_t      fCapacity;
+    uint          fChangesDepth;
+    bool          fNeedsSort;
+
+    // handed to play() and back for deletion
+    EventList* volatile fPending;
+    EventList* volatile fRetired;
+
+    // playback side, only touched by play()
+    EventList*  fPlaying;
+    uint32_t    fCursor;
+    long double fCursorTime;
+    bool        fCursorValid;
+
+    static bool compareTime(const RawMidiEvent& a, const RawMidiEvent& b) noexcept
+    {
+        return a.time < b.time;
+    }
+
+    // index of the first event at or after 'time'
+    static uint32_t findFirst(const RawMidiEvent* const events, const uint32_t count, const long double time) noexcept
+    {
+        uint32_t first = 0, last = count;
+
+        for (; first < last;)
+        {
+            const uint32_t mid(first + (last - first) / 2);
+
+            if (static_cast<long double>(events[mid].time) < time)
+                first = mid + 1;
+            else
+                last = mid;
+        }
 
-    void appendSorted(const RawMidiEvent* const event)
+        return first;
+    }
+
+    void appendSorted(const RawMidiEvent& event)
     {
         const CarlaMutexLocker sl(fMutex);
 
-        if (fData.isEmpty())
+        if (fCount == fCapacity)
         {
-            fData.append(event);
-            return;
+            const uint32_t newCapacity(fCapacity > 0 ? fCapacity*2 : MIN_PREALLOCATED_EVENT_COUNT);
+
+            RawMidiEvent* const newEvents(new RawMidiEvent[newCapacity]);
+
+            if (fEvents != nullptr)
+            {
+                carla_copyStructs(newEvents, fEvents, fCount);
+                delete[] fEvents;
+            }
+
+            fEvents   = newEvents;
+            fCapacity = newCapacity;
         }
 
-        for (LinkedList<const RawMidiEvent*>::Itenerator it = fData.begin2(); it.valid(); it.next())
+        // most events come in order
+        if (fCount == 0 || fEvents[fCount-1].time <= event.time)
+        {
+            carla_copyStruct(fEvents[fCount++], event);
+        }
+        // many unordered events are sorted at once later
+        else if (fChangesDepth > 0)
+        {
+            carla_copyStruct(fEvents[fCount++], event);
+            fNeedsSort = true;
+        }
+        else
         {
-            const RawMidiEvent* const oldEvent(it.getValue(nullptr));
-            CARLA_SAFE_ASSERT_CONTINUE(oldEvent != nullptr);
+            sortIfNeeded();
 
-            if (event->time >= oldEvent->time)
-                continue;
+            // after all events with the same time
+            uint32_t i = findFirst(fEvents, fCount, static_cast<long double>(event.time));
+            for (; i < fCount && fEvents[i].time == event.time; ++i) {}
+
+            std::memmove(fEvents+i+1, fEvents+i, sizeof(RawMidiEvent)*(fCount-i));
+            carla_copyStruct(fEvents[i], event);
+            ++fCount;
+        }
+
+        publish();
+    }
+
+    void sortIfNeeded()
+    {
+        if (! fNeedsSort)
+            return;
+
+        std::stable_sort(fEvents, fEvents+fCount, compareTime);
+        fNeedsSort = false;
+    }
 
-            fData.insertAt(event, it);
+    // give play() a copy of the current events, must be called with the lock held
+    void publish() noexcept
+    {
+        if (fChangesDepth > 0)
             return;
+
+        deleteRetired();
+
+        EventList* list;
+
+        try {
+            sortIfNeeded();
+
+            list = new EventList;
+            list->data        = (fCount > 0) ? new RawMidiEvent[fCount] : nullptr;
+            list->count       = fCount;
+            list->nextRetired = nullptr;
+        } CARLA_SAFE_EXCEPTION_RETURN("MidiPattern::publish",);
+
+        if (fCount > 0)
+            carla_copyStructs(list->data, fEvents, fCount);
+
+        // not picked up yet, play() never saw it
+        deleteEventList(exchangeEventList(fPending, list));
+    }
+
+    // called from play(), list gets deleted on the next change
+    void retireEventList(EventList* const list) noexcept
+    {
+        if (list == nullptr)
+            return;
+
+        for (;;)
+        {
+            EventList* const head(fRetired);
+            list->nextRetired = head;
+
+            if (__sync_bool_compare_and_swap(&fRetired, head, list))
+                break;
         }
+    }
+
+    void deleteRetired() noexcept
+    {
+        for (EventList* list = exchangeEventList(fRetired, nullptr); list != nullptr;)
+        {
+            EventList* const next(list->nextRetired);
+            deleteEventList(list);
+            list = next;
+        }
+    }
+
+    static EventList* exchangeEventList(EventList* volatile& ptr, EventList* const value) noexcept
+    {
+        for (;;)
+        {
+            EventList* const old(ptr);
+
+            if (__sync_bool_compare_and_swap(&ptr, old, value))
+                return old;
+        }
+    }
+
+    static void deleteEventList(EventList* const list) noexcept
+    {
+        if (list == nullptr)
+            return;
+
+        if (list->data != nullptr)
+            delete[] list->data;
 
-        fData.append(event);
+        delete list;
     }
 
     CARLA_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiPattern)
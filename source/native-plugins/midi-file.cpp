@@ -139,6 +139,9 @@ private:
 
     void _loadMidiFile(const char* const filename)
     {
+        // playback switches to the new file once all events are in
+        const MidiPattern::ScopedChanges sc(fMidiOut);
+
         fMidiOut.clear();
 
         using namespace juce;
@@ -0,0 +1,291 @@
+/*
+ * Carla Base64 Tests
+ * Copyright (C) 2013-2014 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the doc/GPL.txt file.
+ */
+
+#include "CarlaBase64Utils.hpp"
+#include "CarlaString.hpp"
+
+#include <cctype>
+#include <ctime>
+
+// -----------------------------------------------------------------------
+// Compares the table-driven codec against the previous one (char-by-char
+// string appends, linear alphabet search per decoded character), using
+// random plugin chunks from 1 KB to 100 MB.
+
+static const std::size_t kChunkSizes[] = { 1024, 16*1024, 256*1024, 1024*1024, 10*1024*1024, 100*1024*1024 };
+
+// the old encoder used a stack buffer, which does not survive bigger chunks
+static const std::size_t kMaxLegacySize = 1024*1024;
+
+// -----------------------------------------------------------------------
+// old codec
+
+static const char* const kLegacyChars =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+    "abcdefghijklmnopqrstuvwxyz"
+    "0123456789+/";
+
+static uint8_t legacyFindIndex(const char c)
+{
+    for (uint8_t i=0; i<64; ++i)
+    {
+        if (kLegacyChars[i] == c)
+            return i;
+    }
+
+    return 0;
+}
+
+static CarlaString legacyEncode(const void* const data, const std::size_t dataSize)
+{
+    const uchar* bytesToEncode((const uchar*)data);
+
+    uint i=0;
+    uint charArray3[3], charArray4[4];
+
+    char strBuf[4096+1];
+    std::size_t strBufIndex = 0;
+
+    CarlaString ret;
+
+    for (std::size_t s=0; s<dataSize; ++s)
+    {
+        charArray3[i++] = *(bytesToEncode++);
+
+        if (i == 3)
+        {
+            charArray4[0] =  (charArray3[0] & 0xfc) >> 2;
+            charArray4[1] = ((charArray3[0] & 0x03) << 4) + ((charArray3[1] & 0xf0) >> 4);
+            charArray4[2] = ((charArray3[1] & 0x0f) << 2) + ((charArray3[2] & 0xc0) >> 6);
+            charArray4[3] =   charArray3[2] & 0x3f;
+
+            for (i=0; i<4; ++i)
+                strBuf[strBufIndex++] = kLegacyChars[charArray4[i]];
+
+            if (strBufIndex >= 4096-7)
+            {
+                strBuf[strBufIndex] = '\0';
+                strBufIndex = 0;
+                ret += strBuf;
+            }
+
+            i = 0;
+        }
+    }
+
+    if (i != 0)
+    {
+        for (uint j=i; j<3; ++j)
+            charArray3[j] = 0;
+
+        charArray4[0] =  (charArray3[0] & 0xfc) >> 2;
+        charArray4[1] = ((charArray3[0] & 0x03) << 4) + ((charArray3[1] & 0xf0) >> 4);
+        charArray4[2] = ((charArray3[1] & 0x0f) << 2) + ((charArray3[2] & 0xc0) >> 6);
+
+        for (uint j=0; j<i+1; ++j)
+            strBuf[strBufIndex++] = kLegacyChars[charArray4[j]];
+
+        for (; i++ < 3;)
+            strBuf[strBufIndex++] = '=';
+    }
+
+    strBuf[strBufIndex] = '\0';
+    ret += strBuf;
+
+    return ret;
+}
+
+static std::vector<uint8_t> legacyDecode(const char* const base64string)
+{
+    uint i=0;
+    uint charArray3[3], charArray4[4];
+
+    std::vector<uint8_t> ret;
+
+    for (std::size_t l=0, len=std::strlen(base64string); l<len; ++l)
+    {
+        const char c = base64string[l];
+
+        if (c == '\0' || c == '=')
+            break;
+        if (c == ' ' || c == '\n')
+            continue;
+        if (! (std::isalnum(c) || c == '+' || c == '/'))
+            continue;
+
+        charArray4[i++] = static_cast<uint>(c);
+
+        if (i == 4)
+        {
+            for (i=0; i<4; ++i)
+                charArray4[i] = legacyFindIndex(static_cast<char>(charArray4[i]));
+
+            charArray3[0] =  (charArray4[0] << 2)        + ((charArray4[1] & 0x30) >> 4);
+            charArray3[1] = ((charArray4[1] & 0xf) << 4) + ((charArray4[2] & 0x3c) >> 2);
+            charArray3[2] = ((charArray4[2] & 0x3) << 6) +   charArray4[3];
+
+            for (i=0; i<3; ++i)
+                ret.push_back(static_cast<uint8_t>(charArray3[i]));
+
+            i = 0;
+        }
+    }
+
+    if (i != 0)
+    {
+        for (uint j=0; j<i; ++j)
+            charArray4[j] = legacyFindIndex(static_cast<char>(charArray4[j]));
+
+        for (uint j=i; j<4; ++j)
+            charArray4[j] = 0;
+
+        charArray3[0] =  (charArray4[0] << 2)        + ((charArray4[1] & 0x30) >> 4);
+        charArray3[1] = ((charArray4[1] & 0xf) << 4) + ((charArray4[2] & 0x3c) >> 2);
+
+        for (uint j=0; j<i-1; ++j)
+            ret.push_back(static_cast<uint8_t>(charArray3[j]));
+    }
+
+    return ret;
+}
+
+// -----------------------------------------------------------------------
+
+static void fillRandom(uint8_t* const data, const std::size_t size) noexcept
+{
+    uint32_t seed = 0x12345678;
+
+    for (std::size_t i=0; i<size; ++i)
+    {
+        seed = seed * 1103515245U + 12345U;
+        data[i] = static_cast<uint8_t>(seed >> 24);
+    }
+}
+
+static void testRoundTrip()
+{
+    uint8_t data[300];
+    fillRandom(data, sizeof(data));
+
+    // every tail length, and blocks that straddle the vector kernels
+    for (std::size_t size=0; size <= sizeof(data); ++size)
+    {
+        const CarlaString encoded(CarlaString::asBase64(data, size));
+        CARLA_SAFE_ASSERT_BREAK(encoded.length() == carla_base64EncodedSize(size));
+
+        const CarlaString legacy(legacyEncode(data, size));
+        CARLA_SAFE_ASSERT_BREAK(encoded == legacy);
+
+        const std::vector<uint8_t> decoded(carla_getChunkFromBase64String(encoded));
+        CARLA_SAFE_ASSERT_BREAK(decoded.size() == size);
+        CARLA_SAFE_ASSERT_BREAK(size == 0 || std::memcmp(&decoded[0], data, size) == 0);
+        CARLA_SAFE_ASSERT_BREAK(decoded == legacyDecode(encoded));
+
+        // as written in project files, split in lines and indented
+        std::vector<char> split;
+        for (std::size_t i=0; i < encoded.length(); ++i)
+        {
+            if (i % 7 == 0)
+            {
+                split.push_back('\n');
+                split.push_back(' ');
+                split.push_back(' ');
+            }
+            split.push_back(encoded[i]);
+        }
+        split.push_back('\r');
+        split.push_back('\n');
+        split.push_back('\0');
+
+        const std::vector<uint8_t> decodedSplit(carla_getChunkFromBase64String(&split[0]));
+        CARLA_SAFE_ASSERT_BREAK(decodedSplit == decoded);
+    }
+
+    // known values
+    CARLA_SAFE_ASSERT(CarlaString::asBase64("Carla", 5) == "Q2FybGE=");
+    CARLA_SAFE_ASSERT(CarlaString::asBase64("Carla plugin host", 17) == "Q2FybGEgcGx1Z2luIGhvc3Q=");
+    CARLA_SAFE_ASSERT(carla_getChunkFromBase64String("Q2FybGE").size() == 5);
+    CARLA_SAFE_ASSERT(carla_getChunkFromBase64String("").empty());
+}
+
+// -----------------------------------------------------------------------
+
+static double getTime() noexcept
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return double(ts.tv_sec) + double(ts.tv_nsec) / 1000000000.0;
+}
+
+static double getMBs(const std::size_t size, const double elapsed) noexcept
+{
+    return double(size) / (1024.0*1024.0) / elapsed;
+}
+
+static void benchmark(const std::size_t size)
+{
+    uint8_t* const data(new uint8_t[size]);
+    fillRandom(data, size);
+
+    double start = getTime();
+    const CarlaString encoded(CarlaString::asBase64(data, size));
+    const double encodeTime = getTime() - start;
+
+    start = getTime();
+    const std::vector<uint8_t> decoded(carla_getChunkFromBase64String(encoded));
+    const double decodeTime = getTime() - start;
+
+    CARLA_SAFE_ASSERT(decoded.size() == size && std::memcmp(&decoded[0], data, size) == 0);
+
+    if (size <= kMaxLegacySize)
+    {
+        start = getTime();
+        const CarlaString legacyEncoded(legacyEncode(data, size));
+        const double legacyEncodeTime = getTime() - start;
+
+        start = getTime();
+        const std::vector<uint8_t> legacyDecoded(legacyDecode(legacyEncoded));
+        const double legacyDecodeTime = getTime() - start;
+
+        CARLA_SAFE_ASSERT(legacyEncoded == encoded);
+        CARLA_SAFE_ASSERT(legacyDecoded == decoded);
+
+        carla_stdout("%9lu bytes: encode %8.1f MB/s (old %6.1f), decode %8.1f MB/s (old %6.1f)",
+                     static_cast<ulong>(size),
+                     getMBs(size, encodeTime), getMBs(size, legacyEncodeTime),
+                     getMBs(size, decodeTime), getMBs(size, legacyDecodeTime));
+    }
+    else
+    {
+        carla_stdout("%9lu bytes: encode %8.1f MB/s,              decode %8.1f MB/s",
+                     static_cast<ulong>(size), getMBs(size, encodeTime), getMBs(size, decodeTime));
+    }
+
+    delete[] data;
+}
+
+int main()
+{
+    testRoundTrip();
+
+    for (std::size_t i=0; i < sizeof(kChunkSizes)/sizeof(kChunkSizes[0]); ++i)
+        benchmark(kChunkSizes[i]);
+
+    return 0;
+}
+
+// -----------------------------------------------------------------------
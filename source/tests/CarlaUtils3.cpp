@@ -108,6 +108,27 @@ static void test_CarlaLibUtils() noexcept
     assert(test4 == test5);
     lc.close(test5);
 
+    // keep-alive, unused lib is reused
+    void* const test6 = lc.open("/usr/lib/liblo.so");
+    lc.close(test6, 1);
+    void* const test7 = lc.open("/usr/lib/liblo.so");
+    assert(test6 == test7);
+    lc.close(test7, 1);
+
+    // keep-alive limit, oldest unused lib is closed
+    void* const test8 = lc.open("/usr/lib/liblrdf.so.0");
+    lc.close(test8, 1);
+
+    // preloaded libs stay open until released
+    const char* const preloadFiles[] = { "/usr/lib/liblo.so", "/libzzzzz...", nullptr };
+    lc.preload(preloadFiles);
+    void* const test9 = lc.open("/usr/lib/liblo.so");
+    lc.close(test9, 1);
+    lc.releasePreloaded(1);
+    void* const test10 = lc.open("/usr/lib/liblo.so");
+    assert(test9 == test10);
+    lc.close(test10);
+
     // open non-delete a few times, tests for cleanup on destruction
     lc.open("/usr/lib/liblrdf.so.0");
     lc.open("/usr/lib/liblrdf.so.0");
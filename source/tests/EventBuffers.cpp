@@ -0,0 +1,331 @@
+/*
+ * Carla Event Buffers Tests
+ * Copyright (C) 2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the doc/GPL.txt file.
+ */
+
+#ifdef NDEBUG
+# error Build this file with debug ON please
+#endif
+
+#include "CarlaEngine.hpp"
+#include "CarlaMIDI.h"
+#include "CarlaUtils.hpp"
+
+#include <cassert>
+#include <ctime>
+
+CARLA_BACKEND_USE_NAMESPACE
+
+// -----------------------------------------------------------------------
+// Compares the old null-terminated event buffers (zero everything, scan for
+// the first free slot on every write) against counted EngineEventBuffer,
+// using a dense MIDI block written by one plugin and read by the next.
+
+static const uint32_t kMaxEvents     = 512;
+static const uint32_t kEventsInBlock = 500;
+static const uint     kNumPeriods    = 20000;
+
+static double sSlotChecks = 0.0;
+
+static void fillNote(EngineEvent& event, const uint32_t i) noexcept
+{
+    event.type    = kEngineEventTypeMidi;
+    event.time    = i;
+    event.channel = 0;
+
+    event.midi.port    = 0;
+    event.midi.size    = 3;
+    event.midi.data[0] = (i % 2 == 0) ? MIDI_STATUS_NOTE_ON : MIDI_STATUS_NOTE_OFF;
+    event.midi.data[1] = static_cast<uint8_t>(i % 128);
+    event.midi.data[2] = 100;
+    event.midi.data[3] = 0;
+    event.midi.dataExt = nullptr;
+}
+
+// old scheme
+static bool writeNullTerminated(EngineEvent* const events, const uint32_t i) noexcept
+{
+    for (uint32_t j=0; j < kMaxEvents; ++j)
+    {
+        sSlotChecks += 1.0;
+
+        if (events[j].type != kEngineEventTypeNull)
+            continue;
+
+        fillNote(events[j], i);
+        return true;
+    }
+
+    return false;
+}
+
+static uint32_t countNullTerminated(const EngineEvent* const events) noexcept
+{
+    uint32_t i=0;
+
+    for (; i < kMaxEvents; ++i)
+    {
+        sSlotChecks += 1.0;
+
+        if (events[i].type == kEngineEventTypeNull)
+            break;
+    }
+
+    return i;
+}
+
+static uint32_t processNullTerminated(EngineEvent* const events) noexcept
+{
+    carla_zeroStructs(events, kMaxEvents);
+    sSlotChecks += kMaxEvents;
+
+    for (uint32_t i=0; i < kEventsInBlock; ++i)
+        writeNullTerminated(events, i);
+
+    uint32_t sum = 0;
+
+    for (uint32_t i=0, count=countNullTerminated(events); i < count; ++i)
+        sum += events[i].midi.data[1];
+
+    return sum;
+}
+
+// new scheme
+static uint32_t processCounted(EngineEventBuffer& buffer) noexcept
+{
+    buffer.clear();
+
+    for (uint32_t i=0; i < kEventsInBlock; ++i)
+    {
+        EngineEvent* const event(buffer.append());
+        assert(event != nullptr);
+
+        sSlotChecks += 1.0;
+        fillNote(*event, i);
+    }
+
+    uint32_t sum = 0;
+
+    for (uint32_t i=0; i < buffer.count; ++i)
+        sum += buffer.data[i].midi.data[1];
+
+    return sum;
+}
+
+// -----------------------------------------------------------------------
+// slots are reused between blocks, a failed append must not leave an old type behind
+
+static void testSlotReuse()
+{
+    EngineEventBuffer buffer;
+    assert(buffer.allocate(0));
+
+    fillNote(*buffer.append(), 0);
+    buffer.clear();
+
+    // control change without its data byte
+    const uint8_t cc[1] = { MIDI_STATUS_CONTROL_CHANGE };
+    assert(buffer.appendFromMidiData(0, 1, cc, 0) == nullptr);
+    assert(buffer.count == 0);
+
+    EngineEvent* const event(buffer.append());
+    assert(event != nullptr);
+    assert(event->type == kEngineEventTypeNull);
+
+    buffer.deallocate();
+}
+
+// -----------------------------------------------------------------------
+// long messages live in the arena and follow the events when copied
+
+static void testSysEx()
+{
+    uint8_t sysex[64];
+    sysex[0] = 0xF0; // SysEx start
+    for (uint8_t i=1; i < 63; ++i)
+        sysex[i] = i;
+    sysex[63] = 0xF7;
+
+    EngineEventBuffer out, in;
+    assert(out.allocate(4096));
+    assert(in.allocate(4096));
+    assert(out.capacity == 4096);
+
+    const uint8_t note[3] = { MIDI_STATUS_NOTE_ON, 60, 100 };
+    assert(out.appendFromMidiData(0, 3, note, 0) != nullptr);
+
+    const EngineEvent* const event(out.appendFromMidiData(10, sizeof(sysex), sysex, 0));
+    assert(event != nullptr);
+    assert(event->midi.size == sizeof(sysex));
+    assert(event->midi.dataExt >= out.arena && event->midi.dataExt < out.arena + out.arenaUsed);
+
+    // source data can go away now
+    carla_zeroBytes(sysex+1, 62);
+
+    in.copyFrom(out);
+    out.clear();
+
+    assert(in.count == 2);
+    assert(in.data[1].midi.dataExt >= in.arena && in.data[1].midi.dataExt < in.arena + in.arenaUsed);
+
+    for (uint8_t i=1; i < 63; ++i)
+        assert(in.data[1].midi.dataExt[i] == i);
+
+    // invalid MIDI does not take a slot
+    const uint8_t bad[1] = { 0x10 };
+    assert(in.appendFromMidiData(0, 1, bad, 0) == nullptr);
+    assert(in.count == 2);
+
+    // arena full
+    uint8_t big[255];
+    big[0] = 0xF0; // SysEx start
+    carla_zeroBytes(big+1, 254);
+
+    uint32_t added = 0;
+    for (; in.appendFromMidiData(0, sizeof(big), big, 0) != nullptr; ++added) {}
+
+    assert(added == (in.arenaSize - sizeof(sysex)) / sizeof(big));
+    assert(in.count == 2 + added);
+
+    in.deallocate();
+    out.deallocate();
+}
+
+// -----------------------------------------------------------------------
+// pass-through events merged with a plugin output, must stay ordered by time
+
+static void testMerge()
+{
+    EngineEventBuffer in, out;
+    assert(in.allocate(0));
+    assert(out.allocate(0));
+
+    // arpeggiator output on even frames, second plugin output on every 3rd frame
+    for (uint32_t i=0; i < 200; i += 2)
+        fillNote(*in.append(), i);
+
+    for (uint32_t i=0; i < 200; i += 3)
+    {
+        EngineEvent* const event(out.append());
+        fillNote(*event, i);
+        event->channel = 1;
+    }
+
+    uint8_t sysex[16] = { 0xF0 };
+    sysex[15] = 0xF7;
+    out.appendFromMidiData(199, sizeof(sysex), sysex, 0);
+
+    const uint32_t total(in.count + out.count);
+
+    in.mergeFrom(out);
+    out.clear();
+
+    assert(in.count == total);
+
+    for (uint32_t i=1; i < in.count; ++i)
+    {
+        const EngineEvent& prev(in.data[i-1]);
+        const EngineEvent& event(in.data[i]);
+
+        assert(prev.time <= event.time);
+
+        // same time, pass-through input comes first
+        if (prev.time == event.time) {
+            assert(prev.channel <= event.channel);
+        }
+
+        if (event.midi.size > EngineMidiEvent::kDataSize) {
+            assert(event.midi.dataExt >= in.arena && event.midi.dataExt < in.arena + in.arenaUsed);
+        }
+    }
+
+    // full buffer, the latest events of the merged buffer are dropped
+    for (uint32_t i=0; i < kMaxEvents; ++i)
+        fillNote(*out.append(), 300 + i);
+
+    assert(out.count == kMaxEvents);
+
+    in.mergeFrom(out);
+    assert(in.count == in.capacity);
+
+    in.deallocate();
+    out.deallocate();
+}
+
+// -----------------------------------------------------------------------
+
+static double getTime() noexcept
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return double(ts.tv_sec) + double(ts.tv_nsec) / 1000000000.0;
+}
+
+int main()
+{
+    EngineEvent* const events(new EngineEvent[kMaxEvents]);
+
+    EngineEventBuffer buffer;
+    assert(buffer.allocate(256));
+    assert(buffer.capacity == kMaxEvents);
+
+    // results must match
+    assert(processNullTerminated(events) == processCounted(buffer));
+    assert(buffer.count == kEventsInBlock);
+
+    // buffer full
+    for (uint32_t i=buffer.count; i < kMaxEvents; ++i)
+        assert(buffer.append() != nullptr);
+
+    assert(buffer.append() == nullptr);
+    assert(buffer.count == kMaxEvents);
+
+    testSlotReuse();
+    testSysEx();
+    testMerge();
+
+    uint32_t sum = 0;
+
+    // null terminated
+    sSlotChecks = 0.0;
+    double start = getTime();
+
+    for (uint i=0; i < kNumPeriods; ++i)
+        sum += processNullTerminated(events);
+
+    double elapsed = getTime() - start;
+    carla_stdout("null-terminated: %u events, %.2f us/period, %.0f slots touched/period",
+                 kEventsInBlock, elapsed * 1000000.0 / kNumPeriods, sSlotChecks / kNumPeriods);
+
+    // counted
+    sSlotChecks = 0.0;
+    start = getTime();
+
+    for (uint i=0; i < kNumPeriods; ++i)
+        sum -= processCounted(buffer);
+
+    elapsed = getTime() - start;
+    carla_stdout("counted:         %u events, %.2f us/period, %.0f slots touched/period",
+                 kEventsInBlock, elapsed * 1000000.0 / kNumPeriods, sSlotChecks / kNumPeriods);
+
+    assert(sum == 0);
+
+    buffer.deallocate();
+    delete[] events;
+
+    return 0;
+}
+
+// -----------------------------------------------------------------------
@@ -15,53 +15,237 @@
  * For a full copy of the GNU General Public License see the doc/GPL.txt file.
  */
 
+#ifdef NDEBUG
+# error Build this file with debug ON please
+#endif
+
 #include "CarlaPipeUtils.hpp"
+#include "CarlaMathUtils.hpp"
+
+#include <cassert>
+#include <ctime>
+
+// -----------------------------------------------------------------------
+// Runs itself as pipe client, which sends "control" messages as fast as the
+// server acknowledges them, first as text and then as binary frames.
+
+static const uint32_t kNumMessages = 200000;
+static const uint32_t kBatchSize   = 1000; // keeps the pipe from filling up
+
+static float valueForIndex(const uint32_t i) noexcept
+{
+    return static_cast<float>(i % 1000) / 8.0f;
+}
+
+static double getTime() noexcept
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return double(ts.tv_sec) + double(ts.tv_nsec) / 1000000000.0;
+}
+
+// -----------------------------------------------------------------------
+
+class PipeClient : public CarlaPipeClient
+{
+public:
+    PipeClient()
+        : CarlaPipeClient(),
+          fRunning(true),
+          fAcked(0),
+          fStart(false) {}
+
+    void run()
+    {
+        while (fRunning)
+        {
+            idlePipe();
+
+            if (! fStart)
+            {
+                carla_msleep(1);
+                continue;
+            }
+
+            fStart = false;
+            fAcked = 0;
+
+            writeConfigureMessage("key", "multi\nline");
+
+            for (uint32_t i=0; i < kNumMessages; ++i)
+            {
+                // wait for the server to catch up
+                while (i >= fAcked + kBatchSize && fRunning)
+                    idlePipe();
+
+                writeControlMessage(i % 100, valueForIndex(i));
+            }
+
+            lockPipe();
+            writeMessage("done\n");
+            flushMessages();
+            unlockPipe();
+        }
+    }
+
+    bool msgReceived(const char* const msg) noexcept override
+    {
+        if (std::strcmp(msg, "text") == 0 || std::strcmp(msg, "binary") == 0)
+        {
+            setPipeBinaryFraming(msg[0] == 'b');
+            fStart = true;
+        }
+        else if (std::strcmp(msg, "ack") == 0)
+        {
+            fAcked += kBatchSize;
+        }
+        else if (std::strcmp(msg, "quit") == 0)
+        {
+            fRunning = false;
+        }
+
+        return true;
+    }
+
+private:
+    bool fRunning;
+    uint32_t fAcked;
+    bool fStart;
+};
 
-static bool gStopNow = false;
+// -----------------------------------------------------------------------
 
-class ExternalPluginUI : public CarlaPipeServer
+class PipeServer : public CarlaPipeServer
 {
 public:
-    ExternalPluginUI()
+    PipeServer()
+        : CarlaPipeServer(),
+          fCount(0),
+          fErrors(0),
+          fDone(false) {}
+
+    void benchmark(const char* const mode)
     {
+        fCount  = 0;
+        fErrors = 0;
+        fDone   = false;
+
+        const double start(getTime());
+
+        lockPipe();
+        writeAndFixMessage(mode);
+        flushMessages();
+        unlockPipe();
+
+        while (! fDone && isPipeRunning())
+            idlePipe();
+
+        const double elapsed(getTime() - start);
+
+        assert(fDone);
+        assert(fCount == kNumMessages);
+        assert(fErrors == 0);
+
+        carla_stdout("%-6s %u messages in %.3f s, %.0f messages/s",
+                     mode, fCount, elapsed, double(fCount) / elapsed);
     }
 
-    void fail(const char* const error) override
+    void quit()
     {
-        carla_stderr2(error);
+        lockPipe();
+        writeMessage("quit\n");
+        flushMessages();
+        unlockPipe();
     }
 
     bool msgReceived(const char* const msg) noexcept override
     {
-        carla_stderr("msgReceived : %s", msg);
+        if (std::strcmp(msg, "control") == 0)
+        {
+            uint32_t index;
+            float value;
+
+            if (! readNextLineAsUInt(index) || ! readNextLineAsFloat(value) ||
+                index != fCount % 100 || carla_isNotEqual(value, valueForIndex(fCount)))
+                ++fErrors;
+
+            if (++fCount % kBatchSize == 0)
+            {
+                lockPipe();
+                writeMessage("ack\n");
+                flushMessages();
+                unlockPipe();
+            }
+
+            return true;
+        }
 
-        if (std::strcmp(msg, "exiting") == 0)
+        if (std::strcmp(msg, "configure") == 0)
         {
-            waitChildClose();
-            gStopNow = true;
+            const char* key;
+            const char* value;
+
+            if (! readNextLineAsString(key, false) || std::strcmp(key, "key") != 0)
+            {
+                ++fErrors;
+                return true;
+            }
+
+            if (! readNextLineAsString(value))
+            {
+                ++fErrors;
+                return true;
+            }
+
+            if (std::strcmp(value, "multi\nline") != 0)
+                ++fErrors;
+
+            delete[] value;
+            return true;
         }
 
+        if (std::strcmp(msg, "done") == 0)
+        {
+            fDone = true;
+            return true;
+        }
+
+        carla_stderr("PipeServer::msgReceived : %s", msg);
+        ++fErrors;
         return false;
     }
+
+private:
+    uint32_t fCount;
+    uint32_t fErrors;
+    bool fDone;
 };
 
-int main()
-{
-    ExternalPluginUI ui;
+// -----------------------------------------------------------------------
 
-    if (! ui.start("/home/falktx/FOSS/GIT-mine/Carla/bin/resources/carla-plugin", "44100.0", "Ui title here"))
+int main(int argc, const char* argv[])
+{
+    if (argc != 1)
     {
-        carla_stderr("failed to start");
-        return 1;
+        PipeClient client;
+        CARLA_SAFE_ASSERT_RETURN(client.initPipeClient(argv), 1);
+
+        client.run();
+        return 0;
     }
 
-    ui.writeMsg("show\n", 5);
+    PipeServer server;
+    CARLA_SAFE_ASSERT_RETURN(server.startPipeServer(argv[0], "client", "client"), 1);
 
-    for (int i=0; i < 500 && ! gStopNow; ++i)
-    {
-        ui.idle();
-        carla_msleep(10);
-    }
+    server.benchmark("text");
+    server.benchmark("binary");
+    server.quit();
 
     return 0;
 }
+
+// -----------------------------------------------------------------------
+
+#include "../utils/CarlaPipeUtils.cpp"
+
+// -----------------------------------------------------------------------
@@ -0,0 +1,314 @@
+/*
+ * Carla Post-Processing Tests
+ * Copyright (C) 2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the doc/GPL.txt file.
+ */
+
+#ifdef NDEBUG
+# error Build this file with debug ON please
+#endif
+
+#include "../backend/plugin/CarlaPluginInternal.hpp"
+
+#include "CarlaMathUtils.hpp"
+
+#include <cassert>
+#include <ctime>
+
+#if defined(__i386__) || defined(__x86_64__)
+# include <x86intrin.h>
+# define HAVE_RDTSC
+#endif
+
+// -----------------------------------------------------------------------
+// Compares the old per-format scalar post-processing loops (dry/wet,
+// balance with a stack copy of the left channel, volume and buffer copy)
+// against CarlaPlugin::ProtectedData::postProcessRT(), on a stereo plugin.
+
+CARLA_BACKEND_USE_NAMESPACE
+
+static const uint32_t kFrames     = 512;
+static const uint32_t kChannels   = 2;
+static const uint     kNumPeriods = 20000;
+
+struct Values {
+    float dryWet, volume, balanceLeft, balanceRight;
+};
+
+// old scheme, as found in CarlaPluginLADSPA before
+static void processOld(const Values& v, float* const* const in, float* const* const buf, float* const* const out, const uint32_t frames) noexcept
+{
+    const bool doDryWet  = carla_isNotEqual(v.dryWet, 1.0f);
+    const bool doBalance = ! (carla_isEqual(v.balanceLeft, -1.0f) && carla_isEqual(v.balanceRight, 1.0f));
+
+    bool isPair;
+    float bufValue, oldBufLeft[doBalance ? frames : 1];
+
+    for (uint32_t i=0; i < kChannels; ++i)
+    {
+        if (doDryWet)
+        {
+            for (uint32_t k=0; k < frames; ++k)
+            {
+                bufValue  = in[i][k];
+                buf[i][k] = (buf[i][k] * v.dryWet) + (bufValue * (1.0f - v.dryWet));
+            }
+        }
+
+        if (doBalance)
+        {
+            isPair = (i % 2 == 0);
+
+            if (isPair)
+                carla_copyFloats(oldBufLeft, buf[i], frames);
+
+            float balRangeL = (v.balanceLeft  + 1.0f)/2.0f;
+            float balRangeR = (v.balanceRight + 1.0f)/2.0f;
+
+            for (uint32_t k=0; k < frames; ++k)
+            {
+                if (isPair)
+                {
+                    buf[i][k]  = oldBufLeft[k] * (1.0f - balRangeL);
+                    buf[i][k] += buf[i+1][k]   * (1.0f - balRangeR);
+                }
+                else
+                {
+                    buf[i][k]  = buf[i][k]     * balRangeR;
+                    buf[i][k] += oldBufLeft[k] * balRangeL;
+                }
+            }
+        }
+
+        for (uint32_t k=0; k < frames; ++k)
+            out[i][k] = buf[i][k] * v.volume;
+    }
+}
+
+// the plugin data type is protected, this only makes it reachable
+class PostProcessingPlugin : public CarlaPlugin
+{
+public:
+    typedef CarlaPlugin::ProtectedData Data;
+};
+
+// plugin data of a stereo plugin that can use all of the post-processing
+struct TestPluginData {
+    PostProcessingPlugin::Data data;
+
+    TestPluginData(const Values& prev)
+        : data(nullptr, 0)
+    {
+        data.hints = PLUGIN_CAN_DRYWET|PLUGIN_CAN_VOLUME|PLUGIN_CAN_BALANCE;
+        data.audioIn.createNew(kChannels);
+        data.audioOut.createNew(kChannels);
+
+        data.postProc.prevDryWet       = prev.dryWet;
+        data.postProc.prevVolume       = prev.volume;
+        data.postProc.prevBalanceLeft  = prev.balanceLeft;
+        data.postProc.prevBalanceRight = prev.balanceRight;
+    }
+
+    ~TestPluginData()
+    {
+        data.audioIn.clear();
+        data.audioOut.clear();
+
+        // plugin data must be locked before being deleted
+        data.masterMutex.lock();
+        data.singleMutex.lock();
+    }
+
+    // new scheme, ramps from the values of the previous block
+    void process(const Values& v, float* const* const in, float* const* const buf, float* const* const out, const uint32_t frames) noexcept
+    {
+        data.postProc.dryWet       = v.dryWet;
+        data.postProc.volume       = v.volume;
+        data.postProc.balanceLeft  = v.balanceLeft;
+        data.postProc.balanceRight = v.balanceRight;
+
+        data.postProcessRT(nullptr, out, in, buf, 0, frames, false);
+    }
+};
+
+// -----------------------------------------------------------------------
+
+static float sIn[kChannels][kFrames];
+static float sBuf[kChannels][kFrames];
+static float sOut[kChannels][kFrames];
+static float sOutOld[kChannels][kFrames];
+
+static float* sInPtrs[kChannels]     = { sIn[0],     sIn[1]     };
+static float* sBufPtrs[kChannels]    = { sBuf[0],    sBuf[1]    };
+static float* sOutPtrs[kChannels]    = { sOut[0],    sOut[1]    };
+static float* sOutOldPtrs[kChannels] = { sOutOld[0], sOutOld[1] };
+
+static void fillBuffers() noexcept
+{
+    for (uint32_t k=0; k < kFrames; ++k)
+    {
+        sIn[0][k]  = std::sin(static_cast<float>(k) * 0.01f);
+        sIn[1][k]  = std::cos(static_cast<float>(k) * 0.02f);
+        sBuf[0][k] = sIn[0][k] * 0.5f + 0.1f;
+        sBuf[1][k] = sIn[1][k] * 0.25f - 0.1f;
+    }
+}
+
+static bool isClose(const float a, const float b) noexcept
+{
+    return std::abs(a - b) < 1e-5f;
+}
+
+// constant values must give the same result as before.
+// the old loops balanced the left channel against the right one before its dry/wet was applied,
+// so only compare when one of those is neutral.
+static void testSteady(const Values& v)
+{
+    TestPluginData plugin(v);
+
+    fillBuffers();
+    processOld(v, sInPtrs, sBufPtrs, sOutOldPtrs, kFrames);
+
+    fillBuffers();
+    plugin.process(v, sInPtrs, sBufPtrs, sOutPtrs, kFrames);
+
+    for (uint32_t i=0; i < kChannels; ++i)
+    {
+        for (uint32_t k=0; k < kFrames; ++k)
+            assert(isClose(sOut[i][k], sOutOld[i][k]));
+    }
+}
+
+// a jump ramps over one block and ends at the new value
+static void testRamp()
+{
+    const Values neutral = { 1.0f, 1.0f, -1.0f, 1.0f };
+    const Values muted   = { 1.0f, 0.0f, -1.0f, 1.0f };
+
+    for (uint32_t k=0; k < kFrames; ++k)
+        sBuf[0][k] = sBuf[1][k] = 1.0f;
+
+    {
+        TestPluginData plugin(neutral);
+        plugin.process(muted, sInPtrs, sBufPtrs, sOutPtrs, kFrames);
+
+        for (uint32_t k=1; k < kFrames; ++k)
+            assert(sOut[0][k] < sOut[0][k-1]);
+
+        assert(sOut[0][0] > 0.99f);
+        assert(isClose(sOut[0][kFrames-1], 0.0f));
+        assert(carla_isEqual(plugin.data.postProc.prevVolume, 0.0f));
+
+        // the next block starts where this one ended
+        plugin.process(muted, sInPtrs, sBufPtrs, sOutPtrs, kFrames);
+        assert(isClose(sOut[0][0], 0.0f));
+    }
+
+    // unaligned block size, scalar tail
+    {
+        TestPluginData plugin(neutral);
+        plugin.process(muted, sInPtrs, sBufPtrs, sOutPtrs, 13);
+
+        assert(isClose(sOut[1][12], 0.0f));
+        assert(isClose(sOut[1][5], 1.0f - 6.0f/13.0f));
+    }
+
+    // balance fully left, right input ends up in the left output
+    {
+        const Values left = { 1.0f, 1.0f, -1.0f, -1.0f };
+        TestPluginData plugin(left);
+
+        for (uint32_t k=0; k < kFrames; ++k)
+        {
+            sBuf[0][k] = 0.0f;
+            sBuf[1][k] = 1.0f;
+        }
+
+        plugin.process(left, sInPtrs, sBufPtrs, sOutPtrs, kFrames);
+
+        assert(isClose(sOut[0][100], 1.0f));
+        assert(isClose(sOut[1][100], 0.0f));
+    }
+}
+
+// -----------------------------------------------------------------------
+
+static double getTime() noexcept
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return double(ts.tv_sec) + double(ts.tv_nsec) / 1000000000.0;
+}
+
+static uint64_t getCycles() noexcept
+{
+#ifdef HAVE_RDTSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static void benchmark(const char* const name, const Values& v)
+{
+    const double samples(double(kNumPeriods) * kFrames * kChannels);
+    TestPluginData plugin(v);
+
+    fillBuffers();
+
+    double   start  = getTime();
+    uint64_t cycles = getCycles();
+
+    for (uint i=0; i < kNumPeriods; ++i)
+        processOld(v, sInPtrs, sBufPtrs, sOutOldPtrs, kFrames);
+
+    double elapsed = getTime() - start;
+    cycles = getCycles() - cycles;
+
+    carla_stdout("%-10s old: %.3f ns/sample, %.2f cycles/sample", name, elapsed * 1000000000.0 / samples, double(cycles) / samples);
+
+    fillBuffers();
+
+    start  = getTime();
+    cycles = getCycles();
+
+    for (uint i=0; i < kNumPeriods; ++i)
+        plugin.process(v, sInPtrs, sBufPtrs, sOutPtrs, kFrames);
+
+    elapsed = getTime() - start;
+    cycles = getCycles() - cycles;
+
+    carla_stdout("%-10s new: %.3f ns/sample, %.2f cycles/sample", name, elapsed * 1000000000.0 / samples, double(cycles) / samples);
+}
+
+int main()
+{
+    const Values neutral = { 1.0f,  1.0f, -1.0f, 1.0f };
+    const Values volume  = { 1.0f,  0.5f, -1.0f, 1.0f };
+    const Values all     = { 0.7f,  0.5f, -0.4f, 0.6f };
+
+    testSteady(neutral);
+    testSteady(volume);
+    testSteady(Values{ 0.7f, 0.5f, -1.0f, 1.0f });
+    testSteady(Values{ 1.0f, 0.5f, -0.4f, 0.6f });
+    testRamp();
+
+    benchmark("neutral", neutral);
+    benchmark("volume",  volume);
+    benchmark("all",     all);
+
+    return 0;
+}
+
+// -----------------------------------------------------------------------
@@ -0,0 +1,239 @@
+/*
+ * Carla Rack Buffers Tests
+ * Copyright (C) 2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the doc/GPL.txt file.
+ */
+
+#ifdef NDEBUG
+# error Build this file with debug ON please
+#endif
+
+#include "../backend/engine/CarlaEngineInternal.hpp"
+
+#include "CarlaPlugin.hpp"
+
+#include "CarlaHost.h"
+#include "CarlaUtils.hpp"
+
+#include <cassert>
+#include <cmath>
+#include <ctime>
+
+// -----------------------------------------------------------------------
+// Runs a chain of "bypass" plugins through the engine rack graph.
+// Each plugin only applies its volume, so the output of any combination of
+// enabled plugins is known, whichever buffers the rack picks for them.
+
+static const uint  kBufferSize = 512;
+static const uint  kNumPlugins = 16;
+static const uint  kNumPeriods = 20000;
+static const float kVolume     = 0.9f;
+
+CARLA_BACKEND_START_NAMESPACE
+
+class CarlaEngineDummy : public CarlaEngine
+{
+public:
+    CarlaEngineDummy()
+        : CarlaEngine(),
+          fIsRunning(false)
+    {
+    }
+
+    bool init(const char* const clientName) override
+    {
+        if (! pData->init(clientName))
+        {
+            close();
+            setLastError("Failed to init internal data");
+            return false;
+        }
+
+        pData->bufferSize = kBufferSize;
+        pData->sampleRate = 44100.0;
+
+        pData->graph.create(2, 2);
+
+        fIsRunning = true;
+        return true;
+    }
+
+    bool close() override
+    {
+        fIsRunning = false;
+        CarlaEngine::close();
+
+        pData->graph.destroy();
+        return true;
+    }
+
+    bool isRunning() const noexcept override
+    {
+        return fIsRunning;
+    }
+
+    bool isOffline() const noexcept override
+    {
+        return false;
+    }
+
+    EngineType getType() const noexcept override
+    {
+        return kEngineTypePlugin;
+    }
+
+    const char* getCurrentDriverName() const noexcept override
+    {
+        return "Dummy";
+    }
+
+    void process(const float* inBuf[2], float* outBuf[2], const uint32_t frames)
+    {
+        pData->events.in.clear();
+        pData->events.out.clear();
+
+        pData->graph.processRack(pData, inBuf, outBuf, frames);
+    }
+
+private:
+    bool fIsRunning;
+};
+
+CARLA_BACKEND_END_NAMESPACE
+
+// -----------------------------------------------------------------------
+
+CARLA_BACKEND_USE_NAMESPACE
+
+static double getTime() noexcept
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return double(ts.tv_sec) + double(ts.tv_nsec) / 1000000000.0;
+}
+
+static void fillInput(float* inBuf[2]) noexcept
+{
+    for (uint i=0; i < kBufferSize; ++i)
+    {
+        inBuf[0][i] = std::sin(float(i) * 0.01f);
+        inBuf[1][i] = std::cos(float(i) * 0.01f);
+    }
+}
+
+static void process(CarlaEngineDummy& eng, float* inBuf[2], float* outBuf[2])
+{
+    const float* inBufConst[2] = { inBuf[0], inBuf[1] };
+
+    fillInput(inBuf);
+    carla_fill<float>(outBuf[0], -1.0f, kBufferSize);
+    carla_fill<float>(outBuf[1], -1.0f, kBufferSize);
+
+    eng.process(inBufConst, outBuf, kBufferSize);
+}
+
+static void checkOutput(float* inBuf[2], float* outBuf[2], const uint enabledCount)
+{
+    const float gain(std::pow(kVolume, static_cast<float>(enabledCount)));
+
+    for (uint c=0; c < 2; ++c)
+    {
+        for (uint i=0; i < kBufferSize; ++i)
+        {
+            // no plugins enabled means silence, not a pass-through
+            const float expected(enabledCount != 0 ? inBuf[c][i] * gain : 0.0f);
+            assert(std::abs(outBuf[c][i] - expected) < 0.00001f);
+        }
+    }
+}
+
+int main()
+{
+    CarlaEngineDummy eng;
+    eng.setOption(ENGINE_OPTION_PROCESS_MODE, ENGINE_PROCESS_MODE_CONTINUOUS_RACK, nullptr);
+    eng.setOption(ENGINE_OPTION_PROCESS_THREADS, 0, nullptr);
+
+    CARLA_SAFE_ASSERT_RETURN(eng.init("RackBuffers"), 1);
+    assert(eng.getBufferSize() == kBufferSize);
+
+    for (uint i=0; i < kNumPlugins; ++i)
+    {
+        CARLA_SAFE_ASSERT_RETURN(eng.addPlugin(PLUGIN_INTERNAL, nullptr, "Bypass", "bypass", 0, nullptr), 1);
+
+        CarlaPlugin* const plugin(eng.getPlugin(i));
+        assert(plugin != nullptr);
+        assert(plugin->getAudioInCount() == 2);
+        assert(plugin->getAudioOutCount() == 2);
+
+        plugin->setVolume(kVolume, false, false);
+    }
+
+    assert(eng.getCurrentPluginCount() == kNumPlugins);
+
+    float* inBuf[2]  = { new float[kBufferSize], new float[kBufferSize] };
+    float* outBuf[2] = { new float[kBufferSize], new float[kBufferSize] };
+
+    // let the volume ramps settle
+    process(eng, inBuf, outBuf);
+
+    // every number of enabled plugins, both at the start and at the end of the chain
+    for (uint enabledCount=0; enabledCount <= kNumPlugins; ++enabledCount)
+    {
+        for (uint i=0; i < kNumPlugins; ++i)
+            eng.getPlugin(i)->setEnabled(i < enabledCount);
+
+        process(eng, inBuf, outBuf);
+        checkOutput(inBuf, outBuf, enabledCount);
+
+        for (uint i=0; i < kNumPlugins; ++i)
+            eng.getPlugin(i)->setEnabled(i >= kNumPlugins - enabledCount);
+
+        process(eng, inBuf, outBuf);
+        checkOutput(inBuf, outBuf, enabledCount);
+    }
+
+    // every other plugin
+    for (uint i=0; i < kNumPlugins; ++i)
+        eng.getPlugin(i)->setEnabled(i % 2 == 1);
+
+    process(eng, inBuf, outBuf);
+    checkOutput(inBuf, outBuf, kNumPlugins/2);
+
+    // benchmark the full chain
+    for (uint i=0; i < kNumPlugins; ++i)
+        eng.getPlugin(i)->setEnabled(true);
+
+    const double start(getTime());
+
+    for (uint i=0; i < kNumPeriods; ++i)
+        process(eng, inBuf, outBuf);
+
+    const double elapsed(getTime() - start);
+
+    checkOutput(inBuf, outBuf, kNumPlugins);
+
+    carla_stdout("rack: %u plugins, %.2f us/period", kNumPlugins, elapsed * 1000000.0 / kNumPeriods);
+
+    eng.close();
+
+    for (uint c=0; c < 2; ++c)
+    {
+        delete[] inBuf[c];
+        delete[] outBuf[c];
+    }
+
+    return 0;
+}
+
+// -----------------------------------------------------------------------
@@ -327,6 +327,22 @@ const char* EngineOption2Str(const EngineOption option) noexcept
         return "ENGINE_OPTION_PREVENT_BAD_BEHAVIOUR";
     case ENGINE_OPTION_FRONTEND_WIN_ID:
         return "ENGINE_OPTION_FRONTEND_WIN_ID";
+    case ENGINE_OPTION_PROCESS_THREADS:
+        return "ENGINE_OPTION_PROCESS_THREADS";
+    case ENGINE_OPTION_PIPELINED_BRIDGES:
+        return "ENGINE_OPTION_PIPELINED_BRIDGES";
+    case ENGINE_OPTION_LOAD_THREADS:
+        return "ENGINE_OPTION_LOAD_THREADS";
+    case ENGINE_OPTION_SAVE_CHUNKS_AS_BINARY:
+        return "ENGINE_OPTION_SAVE_CHUNKS_AS_BINARY";
+    case ENGINE_OPTION_LIBRARY_KEEP_ALIVE:
+        return "ENGINE_OPTION_LIBRARY_KEEP_ALIVE";
+    case ENGINE_OPTION_PRELOAD_LIBRARIES:
+        return "ENGINE_OPTION_PRELOAD_LIBRARIES";
+    case ENGINE_OPTION_PARAMETER_OUTPUT_RATE:
+        return "ENGINE_OPTION_PARAMETER_OUTPUT_RATE";
+    case ENGINE_OPTION_RACK_PIPELINE_STAGES:
+        return "ENGINE_OPTION_RACK_PIPELINE_STAGES";
     }
 
     carla_stderr("CarlaBackend::EngineOption2Str(%i) - invalid option", option);
@@ -1,6 +1,5 @@
 /*
- * Carla base64 utils, based on http://www.adp-gmbh.ch/cpp/common/base64.html
- * Copyright (C) 2004-2008 René Nyffenegger
+ * Carla base64 utils
  * Copyright (C) 2014 Filipe Coelho <falktx@falktx.com>
  *
  * This program is free software; you can redistribute it and/or
@@ -21,99 +20,286 @@
 
 #include "CarlaUtils.hpp"
 
-#include <cctype>
 #include <vector>
 
+#ifdef __SSE2__
+# include <emmintrin.h>
+#endif
+
 // -----------------------------------------------------------------------
 // Helpers
 
 namespace CarlaBase64Helpers {
 
-static const char* const kBase64Chars =
+static const char kEncodeTable[64+1] =
     "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
     "abcdefghijklmnopqrstuvwxyz"
     "0123456789+/";
 
+// special values in kDecodeTable, everything below 64 is a valid character
+static const uint8_t kDecodeEnd     = 0xfd; // '=' and '\0'
+static const uint8_t kDecodeSkip    = 0xfe; // whitespace
+static const uint8_t kDecodeInvalid = 0xff;
+
+static const uint8_t kDecodeTable[256] = {
+    0xfd, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfe, 0xfe, 0xff, 0xff, 0xfe, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xfe, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x3e, 0xff, 0xff, 0xff, 0x3f,
+    0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0xff, 0xff, 0xff, 0xfd, 0xff, 0xff,
+    0xff, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e,
+    0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30, 0x31, 0x32, 0x33, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+};
+
+#ifdef __SSE2__
+/*
+ * Encode 12 bytes into 16 characters.
+ */
 static inline
-uint8_t findBase64CharIndex(const char c)
+void encodeBlockSSE2(const uint8_t* const src, char* const dst) noexcept
 {
-    static const uint8_t kBase64CharsLen(static_cast<uint8_t>(std::strlen(kBase64Chars)));
+    // one 24-bit group per 32-bit lane
+    const __m128i groups(_mm_setr_epi32(
+        static_cast<int>((uint32_t(src[0]) << 16) | (uint32_t(src[ 1]) << 8) | src[ 2]),
+        static_cast<int>((uint32_t(src[3]) << 16) | (uint32_t(src[ 4]) << 8) | src[ 5]),
+        static_cast<int>((uint32_t(src[6]) << 16) | (uint32_t(src[ 7]) << 8) | src[ 8]),
+        static_cast<int>((uint32_t(src[9]) << 16) | (uint32_t(src[10]) << 8) | src[11])));
 
-    for (uint8_t i=0; i<kBase64CharsLen; ++i)
-    {
-        if (kBase64Chars[i] == c)
-            return i;
-    }
+    // split into 4 6-bit indices per lane, first one in the lowest byte
+    const __m128i indices(_mm_or_si128(
+        _mm_or_si128(_mm_srli_epi32(groups, 18),
+                     _mm_and_si128(_mm_srli_epi32(groups, 4), _mm_set1_epi32(0x00003f00))),
+        _mm_or_si128(_mm_and_si128(_mm_slli_epi32(groups, 10), _mm_set1_epi32(0x003f0000)),
+                     _mm_and_si128(_mm_slli_epi32(groups, 24), _mm_set1_epi32(0x3f000000)))));
+
+    // map indices to the alphabet: 'A' + i, then adjust for each range above 'Z'
+    __m128i chars(_mm_add_epi8(indices, _mm_set1_epi8('A')));
+    chars = _mm_add_epi8(chars, _mm_and_si128(_mm_cmpgt_epi8(indices, _mm_set1_epi8(25)), _mm_set1_epi8(6)));
+    chars = _mm_add_epi8(chars, _mm_and_si128(_mm_cmpgt_epi8(indices, _mm_set1_epi8(51)), _mm_set1_epi8(-75)));
+    chars = _mm_add_epi8(chars, _mm_and_si128(_mm_cmpeq_epi8(indices, _mm_set1_epi8(62)), _mm_set1_epi8(-15)));
+    chars = _mm_add_epi8(chars, _mm_and_si128(_mm_cmpeq_epi8(indices, _mm_set1_epi8(63)), _mm_set1_epi8(-12)));
 
-    carla_stderr2("findBase64CharIndex('%c') - failed", c);
-    return 0;
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), chars);
 }
 
+/*
+ * Decode 16 characters into 12 bytes.
+ * Returns false without writing anything if any of the characters is not in the alphabet.
+ */
 static inline
-bool isBase64Char(const char c)
+bool decodeBlockSSE2(const char* const src, uint8_t* const dst) noexcept
 {
-    return (std::isalnum(c) || (c == '+') || (c == '/'));
+    const __m128i chars(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src)));
+
+    // non-ASCII characters are negative and fail all ranges
+    const __m128i isUpper(_mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('A'-1)), _mm_cmplt_epi8(chars, _mm_set1_epi8('Z'+1))));
+    const __m128i isLower(_mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('a'-1)), _mm_cmplt_epi8(chars, _mm_set1_epi8('z'+1))));
+    const __m128i isDigit(_mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('0'-1)), _mm_cmplt_epi8(chars, _mm_set1_epi8('9'+1))));
+    const __m128i isPlus (_mm_cmpeq_epi8(chars, _mm_set1_epi8('+')));
+    const __m128i isSlash(_mm_cmpeq_epi8(chars, _mm_set1_epi8('/')));
+
+    const __m128i valid(_mm_or_si128(_mm_or_si128(isUpper, isLower), _mm_or_si128(_mm_or_si128(isDigit, isPlus), isSlash)));
+
+    if (_mm_movemask_epi8(valid) != 0xffff)
+        return false;
+
+    const __m128i offsets(_mm_or_si128(
+        _mm_or_si128(_mm_and_si128(isUpper, _mm_set1_epi8(-65)), _mm_and_si128(isLower, _mm_set1_epi8(-71))),
+        _mm_or_si128(_mm_and_si128(isDigit, _mm_set1_epi8(4)),
+                     _mm_or_si128(_mm_and_si128(isPlus, _mm_set1_epi8(19)), _mm_and_si128(isSlash, _mm_set1_epi8(16))))));
+
+    const __m128i values(_mm_add_epi8(chars, offsets));
+
+    // merge pairs of 6-bit values into 12 bits, then pairs of those into 24 bits per lane
+    const __m128i pairs(_mm_or_si128(_mm_slli_epi16(_mm_and_si128(values, _mm_set1_epi16(0x00ff)), 6), _mm_srli_epi16(values, 8)));
+    const __m128i groups(_mm_or_si128(_mm_slli_epi32(_mm_and_si128(pairs, _mm_set1_epi32(0x0000ffff)), 12), _mm_srli_epi32(pairs, 16)));
+
+    uint32_t lanes[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), groups);
+
+    for (uint i=0; i<4; ++i)
+    {
+        dst[i*3+0] = static_cast<uint8_t>(lanes[i] >> 16);
+        dst[i*3+1] = static_cast<uint8_t>(lanes[i] >> 8);
+        dst[i*3+2] = static_cast<uint8_t>(lanes[i]);
+    }
+
+    return true;
 }
+#endif
 
 } // namespace CarlaBase64Helpers
 
 // -----------------------------------------------------------------------
 
+/*
+ * Size of the base64 string for 'dataSize' bytes, without the null terminator.
+ */
 static inline
-std::vector<uint8_t> carla_getChunkFromBase64String(const char* const base64string)
+std::size_t carla_base64EncodedSize(const std::size_t dataSize) noexcept
 {
-    CARLA_SAFE_ASSERT_RETURN(base64string != nullptr, std::vector<uint8_t>());
+    return (dataSize + 2) / 3 * 4;
+}
 
-    uint i=0, j=0;
-    uint charArray3[3], charArray4[4];
+/*
+ * Encode 'dataSize' bytes from 'data' as base64.
+ * 'encoded' must have room for carla_base64EncodedSize(dataSize) + 1 characters, the string is null terminated.
+ * Returns the string length.
+ */
+static inline
+std::size_t carla_base64Encode(const void* const data, const std::size_t dataSize, char* const encoded) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(data != nullptr || dataSize == 0, 0);
+    CARLA_SAFE_ASSERT_RETURN(encoded != nullptr, 0);
+
+    using namespace CarlaBase64Helpers;
+
+    const uint8_t* src(static_cast<const uint8_t*>(data));
+    const uint8_t* const srcEnd(src + dataSize);
+    char* dst(encoded);
 
-    std::vector<uint8_t> ret;
-    ret.reserve(std::strlen(base64string)*3/4 + 4);
+#ifdef __SSE2__
+    for (; srcEnd - src >= 12; src += 12, dst += 16)
+        encodeBlockSSE2(src, dst);
+#endif
 
-    for (std::size_t l=0, len=std::strlen(base64string); l<len; ++l)
+    for (; srcEnd - src >= 3; src += 3, dst += 4)
     {
-        const char c = base64string[l];
+        const uint32_t group((uint32_t(src[0]) << 16) | (uint32_t(src[1]) << 8) | src[2]);
 
-        if (c == '\0' || c == '=')
-            break;
-        if (c == ' ' || c == '\n')
-            continue;
+        dst[0] = kEncodeTable[group >> 18];
+        dst[1] = kEncodeTable[(group >> 12) & 0x3f];
+        dst[2] = kEncodeTable[(group >> 6) & 0x3f];
+        dst[3] = kEncodeTable[group & 0x3f];
+    }
 
-         CARLA_SAFE_ASSERT_CONTINUE(CarlaBase64Helpers::isBase64Char(c));
+    if (const std::size_t rest = static_cast<std::size_t>(srcEnd - src))
+    {
+        const uint32_t group((uint32_t(src[0]) << 16) | (rest == 2 ? uint32_t(src[1]) << 8 : 0));
 
-        charArray4[i++] = static_cast<uint>(c);
+        dst[0] = kEncodeTable[group >> 18];
+        dst[1] = kEncodeTable[(group >> 12) & 0x3f];
+        dst[2] = (rest == 2) ? kEncodeTable[(group >> 6) & 0x3f] : '=';
+        dst[3] = '=';
+        dst += 4;
+    }
 
-        if (i == 4)
+    *dst = '\0';
+    return static_cast<std::size_t>(dst - encoded);
+}
+
+/*
+ * Maximum number of bytes decoded from a base64 string of 'length' characters.
+ */
+static inline
+std::size_t carla_base64DecodedMaxSize(const std::size_t length) noexcept
+{
+    return (length + 3) / 4 * 3;
+}
+
+/*
+ * Decode up to 'length' characters of the base64 string 'base64string'.
+ * Whitespace is ignored, decoding stops at padding or a null character.
+ * 'decoded' must have room for carla_base64DecodedMaxSize(length) bytes.
+ * Returns the number of bytes written.
+ */
+static inline
+std::size_t carla_base64Decode(const char* const base64string, const std::size_t length, uint8_t* const decoded) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(base64string != nullptr, 0);
+    CARLA_SAFE_ASSERT_RETURN(decoded != nullptr, 0);
+
+    using namespace CarlaBase64Helpers;
+
+    uint8_t* dst(decoded);
+    uint32_t group = 0;
+    uint     count = 0;
+
+#ifdef __SSE2__
+    // characters before this one are known to not form a full block, see below
+    std::size_t scalarUntil = 0;
+#endif
+
+    for (std::size_t i=0; i < length;)
+    {
+#ifdef __SSE2__
+        if (count == 0 && i >= scalarUntil && i + 16 <= length)
         {
-            for (i=0; i<4; ++i)
-                charArray4[i] = CarlaBase64Helpers::findBase64CharIndex(static_cast<char>(charArray4[i]));
+            if (decodeBlockSSE2(base64string + i, dst))
+            {
+                i   += 16;
+                dst += 12;
+                continue;
+            }
+
+            // whitespace or end somewhere in this block
+            scalarUntil = i + 16;
+        }
+#endif
 
-            charArray3[0] =  (charArray4[0] << 2)        + ((charArray4[1] & 0x30) >> 4);
-            charArray3[1] = ((charArray4[1] & 0xf) << 4) + ((charArray4[2] & 0x3c) >> 2);
-            charArray3[2] = ((charArray4[2] & 0x3) << 6) +   charArray4[3];
+        const char    c(base64string[i++]);
+        const uint8_t value(kDecodeTable[static_cast<uint8_t>(c)]);
 
-            for (i=0; i<3; ++i)
-                ret.push_back(static_cast<uint8_t>(charArray3[i]));
+        if (value < 64)
+        {
+            group = (group << 6) | value;
 
-            i = 0;
+            if (++count == 4)
+            {
+                dst[0] = static_cast<uint8_t>(group >> 16);
+                dst[1] = static_cast<uint8_t>(group >> 8);
+                dst[2] = static_cast<uint8_t>(group);
+                dst   += 3;
+                group  = 0;
+                count  = 0;
+            }
+            continue;
         }
+
+        if (value == kDecodeSkip)
+            continue;
+        if (value == kDecodeEnd)
+            break;
+
+        carla_stderr2("carla_base64Decode() - invalid character '%c'", c);
     }
 
-    if (i != 0)
+    // leftover characters, 2 or 3 make 1 or 2 bytes
+    if (count == 2)
     {
-        for (j=0; j<i && j<4; ++j)
-            charArray4[j] = CarlaBase64Helpers::findBase64CharIndex(static_cast<char>(charArray4[j]));
+        *dst++ = static_cast<uint8_t>(group >> 4);
+    }
+    else if (count == 3)
+    {
+        *dst++ = static_cast<uint8_t>(group >> 10);
+        *dst++ = static_cast<uint8_t>(group >> 2);
+    }
+
+    return static_cast<std::size_t>(dst - decoded);
+}
 
-        for (j=i; j<4; ++j)
-            charArray4[j] = 0;
+// -----------------------------------------------------------------------
 
-        charArray3[0] =  (charArray4[0] << 2)        + ((charArray4[1] & 0x30) >> 4);
-        charArray3[1] = ((charArray4[1] & 0xf) << 4) + ((charArray4[2] & 0x3c) >> 2);
-        charArray3[2] = ((charArray4[2] & 0x3) << 6) +   charArray4[3];
+static inline
+std::vector<uint8_t> carla_getChunkFromBase64String(const char* const base64string)
+{
+    CARLA_SAFE_ASSERT_RETURN(base64string != nullptr, std::vector<uint8_t>());
 
-        for (j=0; i>0 && j<i-1; j++)
-            ret.push_back(static_cast<uint8_t>(charArray3[j]));
-    }
+    const std::size_t length(std::strlen(base64string));
+
+    std::vector<uint8_t> ret(carla_base64DecodedMaxSize(length));
+
+    if (! ret.empty())
+        ret.resize(carla_base64Decode(base64string, length, &ret[0]));
 
     return ret;
 }
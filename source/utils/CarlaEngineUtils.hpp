@@ -28,10 +28,15 @@
 CARLA_BACKEND_START_NAMESPACE
 
 // -----------------------------------------------------------------------
-// Maximum internal pre-allocated events
+// Minimum internal pre-allocated events, grows with the engine buffer size
 
 const ushort kMaxEngineEventInternalCount = 512;
 
+// -----------------------------------------------------------------------
+// Minimum internal pre-allocated bytes for long MIDI messages (SysEx), per event buffer
+
+const uint kMinEngineEventArenaSize = 16384;
+
 // -----------------------------------------------------------------------
 
 static inline
@@ -119,55 +124,36 @@ const char* EngineControlEventType2Str(const EngineControlEventType type) noexce
 // -----------------------------------------------------------------------
 
 static inline
-void fillEngineEventsFromJuceMidiBuffer(EngineEvent engineEvents[kMaxEngineEventInternalCount], const juce::MidiBuffer& midiBuffer)
+void fillEngineEventsFromJuceMidiBuffer(EngineEventBuffer& engineEvents, const juce::MidiBuffer& midiBuffer)
 {
     const uint8_t* midiData;
     int numBytes, sampleNumber;
-    ushort engineEventIndex = 0;
-
-    for (ushort i=0; i < kMaxEngineEventInternalCount; ++i)
-    {
-        const EngineEvent& engineEvent(engineEvents[i]);
-
-        if (engineEvent.type != kEngineEventTypeNull)
-            continue;
-
-        engineEventIndex = i;
-        break;
-    }
 
-    for (juce::MidiBuffer::Iterator midiBufferIterator(midiBuffer); midiBufferIterator.getNextEvent(midiData, numBytes, sampleNumber) && engineEventIndex < kMaxEngineEventInternalCount;)
+    for (juce::MidiBuffer::Iterator midiBufferIterator(midiBuffer); midiBufferIterator.getNextEvent(midiData, numBytes, sampleNumber);)
     {
         CARLA_SAFE_ASSERT_CONTINUE(numBytes > 0);
         CARLA_SAFE_ASSERT_CONTINUE(sampleNumber >= 0);
         CARLA_SAFE_ASSERT_CONTINUE(numBytes < 0xFF /* uint8_t max */);
 
-        EngineEvent& engineEvent(engineEvents[engineEventIndex++]);
-
-        engineEvent.time = static_cast<uint32_t>(sampleNumber);
-        engineEvent.fillFromMidiData(static_cast<uint8_t>(numBytes), midiData, 0);
+        engineEvents.appendFromMidiData(static_cast<uint32_t>(sampleNumber), static_cast<uint8_t>(numBytes), midiData, 0);
     }
 }
 
 // -----------------------------------------------------------------------
 
 static inline
-void fillJuceMidiBufferFromEngineEvents(juce::MidiBuffer& midiBuffer, const EngineEvent engineEvents[kMaxEngineEventInternalCount])
+void fillJuceMidiBufferFromEngineEvents(juce::MidiBuffer& midiBuffer, const EngineEventBuffer& engineEvents)
 {
     uint8_t        size     = 0;
     uint8_t        mdata[3] = { 0, 0, 0 };
     const uint8_t* mdataPtr = mdata;
     uint8_t        mdataTmp[EngineMidiEvent::kDataSize];
 
-    for (ushort i=0; i < kMaxEngineEventInternalCount; ++i)
+    for (uint32_t i=0; i < engineEvents.count; ++i)
     {
-        const EngineEvent& engineEvent(engineEvents[i]);
+        const EngineEvent& engineEvent(engineEvents.data[i]);
 
-        if (engineEvent.type == kEngineEventTypeNull)
-        {
-            break;
-        }
-        else if (engineEvent.type == kEngineEventTypeControl)
+        if (engineEvent.type == kEngineEventTypeControl)
         {
             const EngineControlEvent& ctrlEvent(engineEvent.ctrl);
 
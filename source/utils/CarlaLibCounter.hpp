@@ -20,151 +20,413 @@
 
 #include "CarlaLibUtils.hpp"
 #include "CarlaMutex.hpp"
-#include "LinkedList.hpp"
+#include "CarlaThread.hpp"
 
 // -----------------------------------------------------------------------
 
+/*
+ * Reference counted cache of opened libraries.
+ *
+ * Libraries are found by filename (on open) or handle (on close) through hash tables.
+ * When the last user closes a library it can be kept loaded for a while ('keepAlive' in close()),
+ * the most recently closed ones are kept and reused if the same library is opened again.
+ *
+ * Libraries can also be preloaded in a background thread, see preload().
+ */
 class LibCounter
 {
 public:
     LibCounter() noexcept
         : fMutex(),
-          fLibs() {}
+          fUnusedFirst(nullptr),
+          fUnusedLast(nullptr),
+          fUnusedCount(0),
+          fPreloader(this)
+    {
+        carla_zeroPointers(fByName, kNumBuckets);
+        carla_zeroPointers(fByLib, kNumBuckets);
+    }
 
     ~LibCounter() noexcept
     {
+        releasePreloaded(0);
+
         // might have some leftovers
-        for (LinkedList<Lib>::Itenerator it = fLibs.begin2(); it.valid(); it.next())
+        for (uint i=0; i < kNumBuckets; ++i)
         {
-            static Lib libFallback = { nullptr, nullptr, 0, false };
-
-            Lib& lib(it.getValue(libFallback));
-            CARLA_SAFE_ASSERT_CONTINUE(lib.count > 0);
-            CARLA_SAFE_ASSERT_CONTINUE(lib.lib != nullptr);
+            for (Lib* lib = fByName[i]; lib != nullptr;)
+            {
+                Lib* const next(lib->nextByName);
+                CARLA_SAFE_ASSERT(lib->lib != nullptr);
 
-            // all libs should be closed by now except those explicitly marked non-delete
-            CARLA_SAFE_ASSERT(! lib.canDelete);
+                // all libs should be closed by now except those explicitly marked non-delete or kept alive
+                CARLA_SAFE_ASSERT(lib->count == 0 || ! lib->canDelete);
 
-            if (! lib_close(lib.lib))
-                carla_stderr("LibCounter cleanup failed, reason:\n%s", lib_error(lib.filename));
+                if (! lib_close(lib->lib))
+                    carla_stderr("LibCounter cleanup failed, reason:\n%s", lib_error(lib->filename));
 
-            lib.lib = nullptr;
+                delete[] lib->filename;
+                delete lib;
 
-            if (lib.filename != nullptr)
-            {
-                delete[] lib.filename;
-                lib.filename = nullptr;
+                lib = next;
             }
-        }
 
-        fLibs.clear();
+            fByName[i] = nullptr;
+            fByLib[i]  = nullptr;
+        }
     }
 
     lib_t open(const char* const filename, const bool canDelete = true) noexcept
     {
         CARLA_SAFE_ASSERT_RETURN(filename != nullptr && filename[0] != '\0', nullptr);
 
-        // try duplicating filename first, it can throw
-        const char* dfilename = nullptr;
+        const uint32_t hash(getHash(filename));
 
-        try {
-            dfilename = carla_strdup(filename);
-        } CARLA_SAFE_EXCEPTION_RETURN("LibCounter::open", nullptr);
+        {
+            const CarlaMutexLocker cml(fMutex);
 
-        const CarlaMutexLocker cml(fMutex);
+            if (Lib* const lib = findByName(filename, hash))
+                return reuse(lib, canDelete);
+        }
 
-        for (LinkedList<Lib>::Itenerator it = fLibs.begin2(); it.valid(); it.next())
-        {
-            static Lib libFallback = { nullptr, nullptr, 0, false };
+        // allocate first, it can throw
+        Lib* lib;
 
-            Lib& lib(it.getValue(libFallback));
-            CARLA_SAFE_ASSERT_CONTINUE(lib.count > 0);
-            CARLA_SAFE_ASSERT_CONTINUE(lib.filename != nullptr);
+        try {
+            lib = new Lib;
+        } CARLA_SAFE_EXCEPTION_RETURN("LibCounter::open", nullptr);
 
-            if (std::strcmp(lib.filename, filename) == 0)
-            {
-                // will not be needed
-                delete[] dfilename;
+        lib->filename = carla_strdup_safe(filename);
 
-                ++lib.count;
-                return lib.lib;
-            }
+        if (lib->filename == nullptr)
+        {
+            delete lib;
+            return nullptr;
         }
 
+        // open outside the lock, this might take a while
         const lib_t libPtr(lib_open(filename));
 
         if (libPtr == nullptr)
         {
-            delete[] dfilename;
+            delete[] lib->filename;
+            delete lib;
             return nullptr;
         }
 
-        Lib lib;
-        lib.lib       = libPtr;
-        lib.filename  = dfilename;
-        lib.count     = 1;
-        lib.canDelete = canDelete;
+        lib->lib        = libPtr;
+        lib->hash       = hash;
+        lib->count      = 1;
+        lib->canDelete  = canDelete;
+        lib->nextByName = nullptr;
+        lib->nextByLib  = nullptr;
+        lib->prevUnused = nullptr;
+        lib->nextUnused = nullptr;
 
-        if (fLibs.append(lib))
-            return libPtr;
+        const CarlaMutexLocker cml(fMutex);
 
-        delete[] dfilename;
-        return nullptr;
+        // opened by someone else meanwhile, drop our extra reference
+        if (Lib* const oldLib = findByName(filename, hash))
+        {
+            lib_close(libPtr);
+            delete[] lib->filename;
+            delete lib;
+
+            return reuse(oldLib, canDelete);
+        }
+
+        Lib*& nameBucket(fByName[hash & kBucketMask]);
+        lib->nextByName = nameBucket;
+        nameBucket = lib;
+
+        Lib*& libBucket(fByLib[getHash(libPtr) & kBucketMask]);
+        lib->nextByLib = libBucket;
+        libBucket = lib;
+
+        return libPtr;
     }
 
-    bool close(const lib_t libPtr) noexcept
+    /*
+     * Release a library.
+     * If unused afterwards it stays loaded until 'keepAlive' more recently closed libraries are kept.
+     */
+    bool close(const lib_t libPtr, const uint keepAlive = 0) noexcept
     {
         CARLA_SAFE_ASSERT_RETURN(libPtr != nullptr, false);
 
         const CarlaMutexLocker cml(fMutex);
 
-        for (LinkedList<Lib>::Itenerator it = fLibs.begin2(); it.valid(); it.next())
+        Lib* const lib(findByLib(libPtr));
+
+        if (lib == nullptr)
         {
-            static Lib libFallback = { nullptr, nullptr, 0, false };
+            carla_safe_assert("invalid lib pointer", __FILE__, __LINE__);
+            return false;
+        }
 
-            Lib& lib(it.getValue(libFallback));
-            CARLA_SAFE_ASSERT_CONTINUE(lib.count > 0);
-            CARLA_SAFE_ASSERT_CONTINUE(lib.lib != nullptr);
+        CARLA_SAFE_ASSERT_RETURN(lib->count > 0, false);
 
-            if (lib.lib != libPtr)
-                continue;
+        if (lib->count == 1 && ! lib->canDelete)
+            return true;
 
-            if (lib.count == 1 && ! lib.canDelete)
-                return true;
+        if (--lib->count > 0)
+            return true;
 
-            if (--lib.count == 0)
-            {
-                if (! lib_close(lib.lib))
-                    carla_stderr("LibCounter::close() failed, reason:\n%s", lib_error(lib.filename));
+        if (keepAlive > 0)
+        {
+            appendUnused(lib);
+            trimUnused(keepAlive);
+        }
+        else
+        {
+            destroy(lib);
+        }
 
-                lib.lib = nullptr;
+        return true;
+    }
 
-                if (lib.filename != nullptr)
-                {
-                    delete[] lib.filename;
-                    lib.filename = nullptr;
-                }
+    // -------------------------------------------------------------------
 
-                fLibs.remove(it);
-            }
+    /*
+     * Start opening a list of libraries in a background thread, 'filenames' is null-terminated.
+     * They are kept open until releasePreloaded() is called, so the next open() for them is fast.
+     */
+    void preload(const char* const* const filenames) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(filenames != nullptr,);
 
-            return true;
+        releasePreloaded(0);
+
+        uint count = 0;
+        for (; filenames[count] != nullptr; ++count) {}
+
+        if (count == 0)
+            return;
+
+        try {
+            fPreloader.filenames = new const char*[count];
+            fPreloader.libs      = new lib_t[count];
+        } CARLA_SAFE_EXCEPTION_RETURN("LibCounter::preload",);
+
+        for (uint i=0; i < count; ++i)
+        {
+            fPreloader.filenames[i] = carla_strdup_safe(filenames[i]);
+            fPreloader.libs[i]      = nullptr;
+        }
+
+        fPreloader.count = count;
+        fPreloader.startThread();
+    }
+
+    /*
+     * Stop preloading and release all preloaded libraries, see close() for 'keepAlive'.
+     */
+    void releasePreloaded(const uint keepAlive) noexcept
+    {
+        fPreloader.stopThread(-1);
+
+        for (uint i=0; i < fPreloader.count; ++i)
+        {
+            if (fPreloader.libs[i] != nullptr)
+                close(fPreloader.libs[i], keepAlive);
+
+            delete[] fPreloader.filenames[i];
+        }
+
+        if (fPreloader.filenames != nullptr)
+        {
+            delete[] fPreloader.filenames;
+            fPreloader.filenames = nullptr;
         }
 
-        carla_safe_assert("invalid lib pointer", __FILE__, __LINE__);
-        return false;
+        if (fPreloader.libs != nullptr)
+        {
+            delete[] fPreloader.libs;
+            fPreloader.libs = nullptr;
+        }
+
+        fPreloader.count = 0;
     }
 
 private:
+    static const uint kNumBuckets = 256;
+    static const uint kBucketMask = kNumBuckets - 1;
+
     struct Lib {
         lib_t lib;
         const char* filename;
+        uint32_t hash;
         int count;
         bool canDelete;
+        Lib* nextByName;
+        Lib* nextByLib;
+        Lib* prevUnused; // unused libs kept alive, oldest first
+        Lib* nextUnused;
+    };
+
+    class Preloader : public CarlaThread
+    {
+    public:
+        Preloader(LibCounter* const counter) noexcept
+            : CarlaThread("CarlaLibPreloader"),
+              filenames(nullptr),
+              libs(nullptr),
+              count(0),
+              kCounter(counter) {}
+
+        const char** filenames;
+        lib_t* libs;
+        uint count;
+
+    protected:
+        void run() noexcept override
+        {
+            for (uint i=0; i < count && ! shouldThreadExit(); ++i)
+            {
+                if (filenames[i] != nullptr)
+                    libs[i] = kCounter->open(filenames[i]);
+            }
+        }
+
+    private:
+        LibCounter* const kCounter;
+
+        CARLA_DECLARE_NON_COPY_CLASS(Preloader)
     };
 
     CarlaMutex fMutex;
-    LinkedList<Lib> fLibs;
+
+    Lib* fByName[kNumBuckets];
+    Lib* fByLib[kNumBuckets];
+
+    Lib* fUnusedFirst;
+    Lib* fUnusedLast;
+    uint fUnusedCount;
+
+    Preloader fPreloader;
+
+    // FNV-1a
+    static uint32_t getHash(const char* filename) noexcept
+    {
+        uint32_t hash = 2166136261U;
+
+        for (; *filename != '\0'; ++filename)
+        {
+            hash ^= static_cast<uint8_t>(*filename);
+            hash *= 16777619U;
+        }
+
+        return hash;
+    }
+
+    static uint32_t getHash(const lib_t libPtr) noexcept
+    {
+        const uintptr_t value(reinterpret_cast<uintptr_t>(libPtr));
+        return static_cast<uint32_t>(value ^ (value >> 12));
+    }
+
+    Lib* findByName(const char* const filename, const uint32_t hash) const noexcept
+    {
+        for (Lib* lib = fByName[hash & kBucketMask]; lib != nullptr; lib = lib->nextByName)
+        {
+            if (lib->hash == hash && std::strcmp(lib->filename, filename) == 0)
+                return lib;
+        }
+
+        return nullptr;
+    }
+
+    Lib* findByLib(const lib_t libPtr) const noexcept
+    {
+        for (Lib* lib = fByLib[getHash(libPtr) & kBucketMask]; lib != nullptr; lib = lib->nextByLib)
+        {
+            // different filenames can give the same handle, skip those kept alive
+            if (lib->lib == libPtr && lib->count > 0)
+                return lib;
+        }
+
+        return nullptr;
+    }
+
+    lib_t reuse(Lib* const lib, const bool canDelete) noexcept
+    {
+        if (lib->count == 0)
+            removeUnused(lib);
+
+        if (! canDelete)
+            lib->canDelete = false;
+
+        ++lib->count;
+        return lib->lib;
+    }
+
+    void appendUnused(Lib* const lib) noexcept
+    {
+        lib->prevUnused = fUnusedLast;
+        lib->nextUnused = nullptr;
+
+        if (fUnusedLast != nullptr)
+            fUnusedLast->nextUnused = lib;
+        else
+            fUnusedFirst = lib;
+
+        fUnusedLast = lib;
+        ++fUnusedCount;
+    }
+
+    void removeUnused(Lib* const lib) noexcept
+    {
+        if (lib->prevUnused != nullptr)
+            lib->prevUnused->nextUnused = lib->nextUnused;
+        else
+            fUnusedFirst = lib->nextUnused;
+
+        if (lib->nextUnused != nullptr)
+            lib->nextUnused->prevUnused = lib->prevUnused;
+        else
+            fUnusedLast = lib->prevUnused;
+
+        lib->prevUnused = lib->nextUnused = nullptr;
+        --fUnusedCount;
+    }
+
+    void trimUnused(const uint keepAlive) noexcept
+    {
+        for (; fUnusedCount > keepAlive;)
+        {
+            Lib* const lib(fUnusedFirst);
+            removeUnused(lib);
+            destroy(lib);
+        }
+    }
+
+    // unload and forget a library, must be unused
+    void destroy(Lib* const lib) noexcept
+    {
+        for (Lib** it = &fByName[lib->hash & kBucketMask]; *it != nullptr; it = &(*it)->nextByName)
+        {
+            if (*it != lib)
+                continue;
+            *it = lib->nextByName;
+            break;
+        }
+
+        for (Lib** it = &fByLib[getHash(lib->lib) & kBucketMask]; *it != nullptr; it = &(*it)->nextByLib)
+        {
+            if (*it != lib)
+                continue;
+            *it = lib->nextByLib;
+            break;
+        }
+
+        if (! lib_close(lib->lib))
+            carla_stderr("LibCounter::close() failed, reason:\n%s", lib_error(lib->filename));
+
+        delete[] lib->filename;
+        delete lib;
+    }
+
+    CARLA_DECLARE_NON_COPY_CLASS(LibCounter)
 };
 
 // -----------------------------------------------------------------------
@@ -116,6 +116,124 @@ uint32_t lv2_atom_total_size(const LV2_Atom_MidiEvent& midiEv)
     return static_cast<uint32_t>(sizeof(LV2_Atom)) + midiEv.atom.size;
 }
 
+// -----------------------------------------------------------------------
+// Atom URID translation, used when a host and a bridged UI map some URIs to different URIDs
+
+struct Lv2AtomTypeURIDs {
+    LV2_URID Blank;
+    LV2_URID Object;
+    LV2_URID Property;
+    LV2_URID Resource;
+    LV2_URID Sequence;
+    LV2_URID Tuple;
+    LV2_URID URID;
+    LV2_URID Vector;
+};
+
+/*
+ * Pass every URID inside an atom (including nested ones) through 'translate', replacing it in place.
+ * 'translate' must return URIDs it doesn't know unchanged, and keep the basic atom types the same.
+ * Nested atoms are only followed while they fit in 'maxSize'.
+ */
+template<typename Translator>
+static inline
+void lv2_atom_translate_urids(LV2_Atom* const atom, const uint32_t maxSize, const Lv2AtomTypeURIDs& types, const Translator& translate) noexcept
+{
+    if (maxSize < sizeof(LV2_Atom) || lv2_atom_total_size(atom) > maxSize)
+        return;
+
+    atom->type = translate(atom->type);
+
+    uint8_t* const bodyStart((uint8_t*)LV2_ATOM_BODY(atom));
+
+    if (atom->type == types.URID)
+    {
+        if (atom->size < sizeof(LV2_URID))
+            return;
+
+        LV2_Atom_URID* const uridAtom((LV2_Atom_URID*)atom);
+        uridAtom->body = translate(uridAtom->body);
+    }
+    else if (atom->type == types.Blank || atom->type == types.Object || atom->type == types.Resource)
+    {
+        if (atom->size < sizeof(LV2_Atom_Object_Body))
+            return;
+
+        LV2_Atom_Object_Body* const body((LV2_Atom_Object_Body*)bodyStart);
+        body->id    = translate(body->id);
+        body->otype = translate(body->otype);
+
+        for (LV2_Atom_Property_Body* prop = const_cast<LV2_Atom_Property_Body*>(lv2_atom_object_begin(body));
+             ! lv2_atom_object_is_end(body, atom->size, prop);
+             prop = const_cast<LV2_Atom_Property_Body*>(lv2_atom_object_next(prop)))
+        {
+            const uint32_t left(atom->size - static_cast<uint32_t>((uint8_t*)prop - bodyStart));
+
+            if (left < sizeof(LV2_Atom_Property_Body))
+                break;
+
+            prop->key     = translate(prop->key);
+            prop->context = translate(prop->context);
+            lv2_atom_translate_urids(&prop->value, left - 2*sizeof(uint32_t), types, translate);
+        }
+    }
+    else if (atom->type == types.Property)
+    {
+        if (atom->size < sizeof(LV2_Atom_Property_Body))
+            return;
+
+        LV2_Atom_Property_Body* const body((LV2_Atom_Property_Body*)bodyStart);
+        body->key     = translate(body->key);
+        body->context = translate(body->context);
+        lv2_atom_translate_urids(&body->value, atom->size - 2*sizeof(uint32_t), types, translate);
+    }
+    else if (atom->type == types.Tuple)
+    {
+        for (LV2_Atom* it = (LV2_Atom*)bodyStart;
+             ! lv2_atom_tuple_is_end(bodyStart, atom->size, it);
+             it = const_cast<LV2_Atom*>(lv2_atom_tuple_next(it)))
+        {
+            lv2_atom_translate_urids(it, atom->size - static_cast<uint32_t>((uint8_t*)it - bodyStart), types, translate);
+        }
+    }
+    else if (atom->type == types.Sequence)
+    {
+        if (atom->size < sizeof(LV2_Atom_Sequence_Body))
+            return;
+
+        LV2_Atom_Sequence_Body* const body((LV2_Atom_Sequence_Body*)bodyStart);
+        body->unit = translate(body->unit);
+
+        for (LV2_Atom_Event* ev = const_cast<LV2_Atom_Event*>(lv2_atom_sequence_begin(body));
+             ! lv2_atom_sequence_is_end(body, atom->size, ev);
+             ev = const_cast<LV2_Atom_Event*>(lv2_atom_sequence_next(ev)))
+        {
+            const uint32_t left(atom->size - static_cast<uint32_t>((uint8_t*)ev - bodyStart));
+
+            if (left < sizeof(LV2_Atom_Event))
+                break;
+
+            lv2_atom_translate_urids(&ev->body, left - sizeof(ev->time), types, translate);
+        }
+    }
+    else if (atom->type == types.Vector)
+    {
+        if (atom->size < sizeof(LV2_Atom_Vector_Body))
+            return;
+
+        LV2_Atom_Vector_Body* const body((LV2_Atom_Vector_Body*)bodyStart);
+        body->child_type = translate(body->child_type);
+
+        if (body->child_type != types.URID || body->child_size != sizeof(LV2_URID))
+            return;
+
+        LV2_URID* const urids((LV2_URID*)(body + 1));
+
+        for (uint32_t i=0, count=(atom->size - static_cast<uint32_t>(sizeof(LV2_Atom_Vector_Body)))/sizeof(LV2_URID); i < count; ++i)
+            urids[i] = translate(urids[i]);
+    }
+}
+
 // -----------------------------------------------------------------------
 // Our LV2 World class
 
@@ -23,6 +23,10 @@
 #include <cmath>
 #include <limits>
 
+#ifdef __SSE__
+# include <xmmintrin.h>
+#endif
+
 // --------------------------------------------------------------------------------------------------------------------
 // math functions (base)
 
@@ -200,6 +204,115 @@ void carla_zeroFloats(float floats[], const std::size_t count) noexcept
     std::memset(floats, 0, count*sizeof(float));
 }
 
+// --------------------------------------------------------------------------------------------------------------------
+// gain ramps, the gain for frame 'i' is 'gain + step*i'
+
+/*
+ * Multiply float array values by a gain ramp, 'dest' and 'src' can be the same.
+ */
+static inline
+void carla_multiplyFloatsWithRamp(float dest[], const float src[], const std::size_t count, const float gain, const float step) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(dest != nullptr,);
+    CARLA_SAFE_ASSERT_RETURN(src != nullptr,);
+
+    std::size_t i=0;
+
+#ifdef __SSE__
+    const __m128 steps(_mm_set1_ps(step*4.0f));
+    __m128 gains(_mm_setr_ps(gain, gain+step, gain+step*2.0f, gain+step*3.0f));
+
+    for (; i+4 <= count; i += 4)
+    {
+        _mm_storeu_ps(dest+i, _mm_mul_ps(_mm_loadu_ps(src+i), gains));
+        gains = _mm_add_ps(gains, steps);
+    }
+#endif
+
+    for (; i<count; ++i)
+        dest[i] = src[i] * (gain + step*static_cast<float>(i));
+}
+
+/*
+ * Mix a dry signal into a wet one, 'mix' ramps from 0 (dry only) to 1 (wet only).
+ * 'dest' and 'wet' can be the same.
+ */
+static inline
+void carla_mixFloatsWithRamp(float dest[], const float wet[], const float dry[], const std::size_t count, const float mix, const float step) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(dest != nullptr,);
+    CARLA_SAFE_ASSERT_RETURN(wet != nullptr,);
+    CARLA_SAFE_ASSERT_RETURN(dry != nullptr,);
+
+    std::size_t i=0;
+
+#ifdef __SSE__
+    const __m128 steps(_mm_set1_ps(step*4.0f));
+    __m128 mixes(_mm_setr_ps(mix, mix+step, mix+step*2.0f, mix+step*3.0f));
+
+    for (; i+4 <= count; i += 4)
+    {
+        const __m128 d(_mm_loadu_ps(dry+i));
+        _mm_storeu_ps(dest+i, _mm_add_ps(d, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(wet+i), d), mixes)));
+        mixes = _mm_add_ps(mixes, steps);
+    }
+#endif
+
+    for (; i<count; ++i)
+        dest[i] = dry[i] + (wet[i] - dry[i]) * (mix + step*static_cast<float>(i));
+}
+
+/*
+ * Apply left and right balance to a stereo pair, in place.
+ * Balance values go from -1 to 1, the neutral setting is left = -1 and right = 1.
+ */
+static inline
+void carla_balanceFloatsWithRamp(float left[], float right[], const std::size_t count,
+                                 const float balanceLeft, const float stepLeft,
+                                 const float balanceRight, const float stepRight) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(left != nullptr,);
+    CARLA_SAFE_ASSERT_RETURN(right != nullptr,);
+
+    // how much of each input goes to the right output
+    const float rangeL((balanceLeft  + 1.0f) * 0.5f);
+    const float rangeR((balanceRight + 1.0f) * 0.5f);
+    const float rangeStepL(stepLeft  * 0.5f);
+    const float rangeStepR(stepRight * 0.5f);
+
+    std::size_t i=0;
+
+#ifdef __SSE__
+    const __m128 one(_mm_set1_ps(1.0f));
+    const __m128 stepsL(_mm_set1_ps(rangeStepL*4.0f));
+    const __m128 stepsR(_mm_set1_ps(rangeStepR*4.0f));
+    __m128 rangesL(_mm_setr_ps(rangeL, rangeL+rangeStepL, rangeL+rangeStepL*2.0f, rangeL+rangeStepL*3.0f));
+    __m128 rangesR(_mm_setr_ps(rangeR, rangeR+rangeStepR, rangeR+rangeStepR*2.0f, rangeR+rangeStepR*3.0f));
+
+    for (; i+4 <= count; i += 4)
+    {
+        const __m128 l(_mm_loadu_ps(left+i));
+        const __m128 r(_mm_loadu_ps(right+i));
+
+        _mm_storeu_ps(left+i,  _mm_add_ps(_mm_mul_ps(l, _mm_sub_ps(one, rangesL)), _mm_mul_ps(r, _mm_sub_ps(one, rangesR))));
+        _mm_storeu_ps(right+i, _mm_add_ps(_mm_mul_ps(r, rangesR), _mm_mul_ps(l, rangesL)));
+
+        rangesL = _mm_add_ps(rangesL, stepsL);
+        rangesR = _mm_add_ps(rangesR, stepsR);
+    }
+#endif
+
+    for (; i<count; ++i)
+    {
+        const float l(left[i]), r(right[i]);
+        const float balRangeL(rangeL + rangeStepL*static_cast<float>(i));
+        const float balRangeR(rangeR + rangeStepR*static_cast<float>(i));
+
+        left[i]  = l * (1.0f - balRangeL) + r * (1.0f - balRangeR);
+        right[i] = r * balRangeR          + l * balRangeL;
+    }
+}
+
 // --------------------------------------------------------------------------------------------------------------------
 // Missing functions in OSX.
 
@@ -49,6 +49,13 @@
 # define INVALID_PIPE_VALUE -1
 #endif
 
+// initial size of the read buffer, grows if a single line is bigger than half of it
+static const std::size_t kReadBufferSize = 0x10000;
+
+// markers of binary frames for numbers, followed by 4 or 8 bytes in native byte order
+static const char kPipeFrame32 = '\x01';
+static const char kPipeFrame64 = '\x02';
+
 #ifdef CARLA_OS_WIN
 // -----------------------------------------------------------------------
 // win32 stuff
@@ -92,7 +99,12 @@ ssize_t ReadFileNonBlock(const HANDLE pipeh, const HANDLE cancelh, void* const b
     OverlappedEvent over;
 
     if (::ReadFile(pipeh, buf, numBytes, nullptr /*&dsize*/, &over.over) != FALSE)
-        return static_cast<ssize_t>(dsize);
+    {
+        // reads are buffered, so the real size matters
+        if (::GetOverlappedResult(pipeh, &over.over, &dsize, FALSE) != FALSE)
+            return static_cast<ssize_t>(dsize);
+        return -1;
+    }
 
     if (::GetLastError() == ERROR_IO_PENDING)
     {
@@ -104,7 +116,7 @@ ssize_t ReadFileNonBlock(const HANDLE pipeh, const HANDLE cancelh, void* const b
             return -1;
         }
 
-        if (::GetOverlappedResult(pipeh, &over.over, nullptr /*&dsize*/, FALSE) != FALSE)
+        if (::GetOverlappedResult(pipeh, &over.over, &dsize, FALSE) != FALSE)
             return static_cast<ssize_t>(dsize);
     }
 
@@ -186,6 +198,23 @@ uint32_t getMillisecondCounter() noexcept
     return now;
 }
 
+// -----------------------------------------------------------------------
+// switchToCNumericLocale
+
+// set LC_NUMERIC to "C", returns the previous locale (to be restored and deleted) or null if nothing changed
+static inline
+const char* switchToCNumericLocale() noexcept
+{
+    const char* const locale(::setlocale(LC_NUMERIC, nullptr));
+
+    if (locale == nullptr || std::strcmp(locale, "C") == 0 || std::strcmp(locale, "POSIX") == 0)
+        return nullptr;
+
+    const char* const oldLocale(carla_strdup_safe(locale));
+    ::setlocale(LC_NUMERIC, "C");
+    return oldLocale;
+}
+
 // -----------------------------------------------------------------------
 // startProcess
 
@@ -483,12 +512,23 @@ struct CarlaPipeCommon::PrivateData {
     // read functions must only be called in context of idlePipe()
     bool isReading;
 
+    // write numbers as binary frames, see setPipeBinaryFraming()
+    bool binaryFraming;
+
     // common write lock
     CarlaMutex writeLock;
 
-    // temporary buffers for _readline()
-    mutable char        tmpBuf[0xff+1];
-    mutable CarlaString tmpStr;
+    // buffered reads, lines are returned in-place.
+    // pending data is [readBufHead, readBufTail), readBufScan is where the search for the next '\n' continues.
+    char*       readBuf;
+    std::size_t readBufSize;
+    std::size_t readBufHead;
+    std::size_t readBufScan;
+    std::size_t readBufTail;
+
+    // the message given to msgReceived() points into the read buffer,
+    // if the buffer has to be replaced while reading the old one is kept here until msgReceived() returns.
+    char* readBufRetired;
 
     PrivateData() noexcept
 #ifdef CARLA_OS_WIN
@@ -500,9 +540,14 @@ struct CarlaPipeCommon::PrivateData {
           pipeRecv(INVALID_PIPE_VALUE),
           pipeSend(INVALID_PIPE_VALUE),
           isReading(false),
+          binaryFraming(false),
           writeLock(),
-          tmpBuf(),
-          tmpStr()
+          readBuf(nullptr),
+          readBufSize(0),
+          readBufHead(0),
+          readBufScan(0),
+          readBufTail(0),
+          readBufRetired(nullptr)
     {
 #ifdef CARLA_OS_WIN
         carla_zeroStruct(processInfo);
@@ -513,8 +558,6 @@ struct CarlaPipeCommon::PrivateData {
             cancelEvent = ::CreateEvent(nullptr, FALSE, FALSE, nullptr);
         } CARLA_SAFE_EXCEPTION("CreateEvent");
 #endif
-
-        carla_zeroChars(tmpBuf, 0xff+1);
     }
 
     ~PrivateData() noexcept
@@ -526,6 +569,185 @@ struct CarlaPipeCommon::PrivateData {
             cancelEvent = INVALID_HANDLE_VALUE;
         }
 #endif
+
+        releaseRetiredReadBuffer();
+
+        if (readBuf != nullptr)
+        {
+            delete[] readBuf;
+            readBuf = nullptr;
+        }
+    }
+
+    // -------------------------------------------------------------------
+    // read buffer
+
+    // drop any pending data, used when the pipes are closed
+    void clearReadBuffer() noexcept
+    {
+        readBufHead = readBufScan = readBufTail = 0;
+    }
+
+    void releaseRetiredReadBuffer() noexcept
+    {
+        if (readBufRetired != nullptr)
+        {
+            delete[] readBufRetired;
+            readBufRetired = nullptr;
+        }
+    }
+
+    // make space at the end of the read buffer, keeping the pending data
+    bool makeRoomInReadBuffer() noexcept
+    {
+        const std::size_t pending(readBufTail - readBufHead);
+        std::size_t newSize(readBufSize != 0 ? readBufSize : kReadBufferSize);
+
+        // a single line that doesn't fit, grow
+        if (pending > newSize/2)
+            newSize *= 2;
+
+        if (readBuf != nullptr && newSize == readBufSize && ! isReading)
+        {
+            std::memmove(readBuf, readBuf + readBufHead, pending);
+        }
+        else
+        {
+            char* newBuf;
+
+            try {
+                newBuf = new char[newSize];
+            } CARLA_SAFE_EXCEPTION_RETURN("CarlaPipeCommon::makeRoomInReadBuffer()", false);
+
+            if (pending != 0)
+                std::memcpy(newBuf, readBuf + readBufHead, pending);
+
+            // only the first buffer of a message needs to be kept, it's the one holding the message itself
+            if (isReading && readBufRetired == nullptr)
+                readBufRetired = readBuf;
+            else if (readBuf != nullptr)
+                delete[] readBuf;
+
+            readBuf     = newBuf;
+            readBufSize = newSize;
+        }
+
+        readBufScan -= readBufHead;
+        readBufHead  = 0;
+        readBufTail  = pending;
+        return true;
+    }
+
+    // read as much as currently available from the pipe
+    bool readIntoBuffer() noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(pipeRecv != INVALID_PIPE_VALUE, false);
+
+        if (readBufTail == readBufSize && ! makeRoomInReadBuffer())
+            return false;
+
+        ssize_t ret;
+
+        try {
+#ifdef CARLA_OS_WIN
+            ret = ::ReadFileNonBlock(pipeRecv, cancelEvent, readBuf + readBufTail, readBufSize - readBufTail);
+#else
+            ret = ::read(pipeRecv, readBuf + readBufTail, readBufSize - readBufTail);
+#endif
+        } CARLA_SAFE_EXCEPTION_RETURN("CarlaPipeCommon::readIntoBuffer() - read", false);
+
+        if (ret <= 0)
+            return false;
+
+        readBufTail += static_cast<std::size_t>(ret);
+        return true;
+    }
+
+    // take the next complete line from the read buffer, without copying
+    char* takeLineFromBuffer() noexcept
+    {
+        if (readBufScan == readBufTail)
+            return nullptr;
+
+        char* const end(static_cast<char*>(std::memchr(readBuf + readBufScan, '\n', readBufTail - readBufScan)));
+
+        if (end == nullptr)
+        {
+            readBufScan = readBufTail;
+            return nullptr;
+        }
+
+        char* const line(readBuf + readBufHead);
+        *end = '\0';
+
+        // '\r' is used to escape newlines inside a message
+        for (char* c = std::strchr(line, '\r'); c != nullptr; c = std::strchr(c+1, '\r'))
+            *c = '\n';
+
+        readBufHead = readBufScan = static_cast<std::size_t>(end - readBuf) + 1;
+        return line;
+    }
+
+    char* readline() noexcept
+    {
+        for (;;)
+        {
+            if (char* const line = takeLineFromBuffer())
+                return line;
+
+            if (! readIntoBuffer())
+                return nullptr;
+        }
+    }
+
+    /*
+     * Read the next number, sent either as a text line or as a binary frame of @a frameSize bytes.
+     * On success @a line is the text line, or null if the frame was copied into @a frame.
+     */
+    bool readNumber(const char*& line, void* const frame, const std::size_t frameSize, const uint32_t timeOutMilliseconds = 50) noexcept
+    {
+        const uint32_t timeoutEnd(getMillisecondCounter() + timeOutMilliseconds);
+
+        for (;;)
+        {
+            if (readBufHead != readBufTail)
+            {
+                const char marker(readBuf[readBufHead]);
+
+                if (marker == kPipeFrame32 || marker == kPipeFrame64)
+                {
+                    const std::size_t size(marker == kPipeFrame32 ? 4 : 8);
+
+                    if (readBufTail - readBufHead > size)
+                    {
+                        const char* const data(readBuf + readBufHead + 1);
+                        readBufHead = readBufScan = readBufHead + size + 1;
+
+                        CARLA_SAFE_ASSERT_RETURN(size == frameSize, false);
+
+                        std::memcpy(frame, data, size);
+                        line = nullptr;
+                        return true;
+                    }
+                }
+                else if (const char* const msg = takeLineFromBuffer())
+                {
+                    line = msg;
+                    return true;
+                }
+            }
+
+            if (readIntoBuffer())
+                continue;
+
+            if (getMillisecondCounter() >= timeoutEnd)
+                break;
+
+            carla_msleep(5);
+        }
+
+        carla_stderr("readlineblock timed out");
+        return false;
     }
 
     CARLA_DECLARE_NON_COPY_STRUCT(PrivateData)
@@ -556,18 +778,19 @@ bool CarlaPipeCommon::isPipeRunning() const noexcept
 void CarlaPipeCommon::idlePipe(const bool onlyOnce) noexcept
 {
     const char* locale = nullptr;
+    bool checkedLocale = onlyOnce;
 
     for (;;)
     {
-        const char* const msg(_readline());
+        const char* const msg(_readline(false));
 
         if (msg == nullptr)
             break;
 
-        if (locale == nullptr && ! onlyOnce)
+        if (! checkedLocale)
         {
-            locale = carla_strdup_safe(::setlocale(LC_NUMERIC, nullptr));
-            ::setlocale(LC_NUMERIC, "C");
+            locale = switchToCNumericLocale();
+            checkedLocale = true;
         }
 
         pData->isReading = true;
@@ -577,8 +800,7 @@ void CarlaPipeCommon::idlePipe(const bool onlyOnce) noexcept
         } CARLA_SAFE_EXCEPTION("msgReceived");
 
         pData->isReading = false;
-
-        delete[] msg;
+        pData->releaseRetiredReadBuffer();
 
         if (onlyOnce)
             break;
@@ -591,6 +813,13 @@ void CarlaPipeCommon::idlePipe(const bool onlyOnce) noexcept
     }
 }
 
+void CarlaPipeCommon::setPipeBinaryFraming(const bool enabled) noexcept
+{
+    const CarlaMutexLocker cml(pData->writeLock);
+
+    pData->binaryFraming = enabled;
+}
+
 // -------------------------------------------------------------------
 
 void CarlaPipeCommon::lockPipe() const noexcept
@@ -619,30 +848,33 @@ bool CarlaPipeCommon::readNextLineAsBool(bool& value) const noexcept
 {
     CARLA_SAFE_ASSERT_RETURN(pData->isReading, false);
 
-    if (const char* const msg = _readlineblock())
-    {
-        value = (std::strcmp(msg, "true") == 0);
-        delete[] msg;
-        return true;
-    }
+    const char* msg;
+    int32_t frame;
 
-    return false;
+    if (! pData->readNumber(msg, &frame, sizeof(int32_t)))
+        return false;
+
+    value = (msg != nullptr) ? (std::strcmp(msg, "true") == 0) : (frame != 0);
+    return true;
 }
 
 bool CarlaPipeCommon::readNextLineAsByte(uint8_t& value) const noexcept
 {
     CARLA_SAFE_ASSERT_RETURN(pData->isReading, false);
 
-    if (const char* const msg = _readlineblock())
-    {
-        int tmp = std::atoi(msg);
-        delete[] msg;
+    const char* msg;
+    int32_t tmp;
 
-        if (tmp >= 0 && tmp <= 0xFF)
-        {
-            value = static_cast<uint8_t>(tmp);
-            return true;
-        }
+    if (! pData->readNumber(msg, &tmp, sizeof(int32_t)))
+        return false;
+
+    if (msg != nullptr)
+        tmp = std::atoi(msg);
+
+    if (tmp >= 0 && tmp <= 0xFF)
+    {
+        value = static_cast<uint8_t>(tmp);
+        return true;
     }
 
     return false;
@@ -652,101 +884,111 @@ bool CarlaPipeCommon::readNextLineAsInt(int32_t& value) const noexcept
 {
     CARLA_SAFE_ASSERT_RETURN(pData->isReading, false);
 
-    if (const char* const msg = _readlineblock())
-    {
+    const char* msg;
+
+    if (! pData->readNumber(msg, &value, sizeof(int32_t)))
+        return false;
+
+    if (msg != nullptr)
         value = std::atoi(msg);
-        delete[] msg;
-        return true;
-    }
 
-    return false;
+    return true;
 }
 
 bool CarlaPipeCommon::readNextLineAsUInt(uint32_t& value) const noexcept
 {
     CARLA_SAFE_ASSERT_RETURN(pData->isReading, false);
 
-    if (const char* const msg = _readlineblock())
+    const char* msg;
+
+    if (! pData->readNumber(msg, &value, sizeof(uint32_t)))
+        return false;
+
+    if (msg != nullptr)
     {
-        int32_t tmp = std::atoi(msg);
-        delete[] msg;
+        const int32_t tmp = std::atoi(msg);
 
-        if (tmp >= 0)
-        {
-            value = static_cast<uint32_t>(tmp);
-            return true;
-        }
+        if (tmp < 0)
+            return false;
+
+        value = static_cast<uint32_t>(tmp);
     }
 
-    return false;
+    return true;
 }
 
 bool CarlaPipeCommon::readNextLineAsLong(int64_t& value) const noexcept
 {
     CARLA_SAFE_ASSERT_RETURN(pData->isReading, false);
 
-    if (const char* const msg = _readlineblock())
-    {
+    const char* msg;
+
+    if (! pData->readNumber(msg, &value, sizeof(int64_t)))
+        return false;
+
+    if (msg != nullptr)
         value = std::atol(msg);
-        delete[] msg;
-        return true;
-    }
 
-    return false;
+    return true;
 }
 
 bool CarlaPipeCommon::readNextLineAsULong(uint64_t& value) const noexcept
 {
     CARLA_SAFE_ASSERT_RETURN(pData->isReading, false);
 
-    if (const char* const msg = _readlineblock())
+    const char* msg;
+
+    if (! pData->readNumber(msg, &value, sizeof(uint64_t)))
+        return false;
+
+    if (msg != nullptr)
     {
-        int64_t tmp = std::atol(msg);
-        delete[] msg;
+        const int64_t tmp = std::atol(msg);
 
-        if (tmp >= 0)
-        {
-            value = static_cast<uint64_t>(tmp);
-            return true;
-        }
+        if (tmp < 0)
+            return false;
+
+        value = static_cast<uint64_t>(tmp);
     }
 
-    return false;
+    return true;
 }
 
 bool CarlaPipeCommon::readNextLineAsFloat(float& value) const noexcept
 {
     CARLA_SAFE_ASSERT_RETURN(pData->isReading, false);
 
-    if (const char* const msg = _readlineblock())
-    {
+    const char* msg;
+
+    if (! pData->readNumber(msg, &value, sizeof(float)))
+        return false;
+
+    if (msg != nullptr)
         value = static_cast<float>(std::atof(msg));
-        delete[] msg;
-        return true;
-    }
 
-    return false;
+    return true;
 }
 
 bool CarlaPipeCommon::readNextLineAsDouble(double& value) const noexcept
 {
     CARLA_SAFE_ASSERT_RETURN(pData->isReading, false);
 
-    if (const char* const msg = _readlineblock())
-    {
+    const char* msg;
+
+    if (! pData->readNumber(msg, &value, sizeof(double)))
+        return false;
+
+    if (msg != nullptr)
         value = std::atof(msg);
-        delete[] msg;
-        return true;
-    }
 
-    return false;
+    return true;
 }
 
-bool CarlaPipeCommon::readNextLineAsString(const char*& value) const noexcept
+bool CarlaPipeCommon::readNextLineAsString(const char*& value, const bool allocateString) const noexcept
 {
     CARLA_SAFE_ASSERT_RETURN(pData->isReading, false);
 
-    if (const char* const msg = _readlineblock())
+    if (const char* const msg = _readlineblock(allocateString))
     {
         value = msg;
         return true;
@@ -852,20 +1094,13 @@ void CarlaPipeCommon::writeErrorMessage(const char* const error) const noexcept
 
 void CarlaPipeCommon::writeControlMessage(const uint32_t index, const float value) const noexcept
 {
-    char tmpBuf[0xff+1];
-    tmpBuf[0xff] = '\0';
-
     const CarlaMutexLocker cml(pData->writeLock);
-    const ScopedLocale csl;
 
     _writeMsgBuffer("control\n", 8);
 
     {
-        std::snprintf(tmpBuf, 0xff, "%i\n", index);
-        _writeMsgBuffer(tmpBuf, std::strlen(tmpBuf));
-
-        std::snprintf(tmpBuf, 0xff, "%f\n", value);
-        _writeMsgBuffer(tmpBuf, std::strlen(tmpBuf));
+        _writeMsgInt(static_cast<int32_t>(index));
+        _writeMsgFloat(value);
     }
 
     flushMessages();
@@ -890,16 +1125,12 @@ void CarlaPipeCommon::writeConfigureMessage(const char* const key, const char* c
 
 void CarlaPipeCommon::writeProgramMessage(const uint32_t index) const noexcept
 {
-    char tmpBuf[0xff+1];
-    tmpBuf[0xff] = '\0';
-
     const CarlaMutexLocker cml(pData->writeLock);
 
     _writeMsgBuffer("program\n", 8);
 
     {
-        std::snprintf(tmpBuf, 0xff, "%i\n", index);
-        _writeMsgBuffer(tmpBuf, std::strlen(tmpBuf));
+        _writeMsgInt(static_cast<int32_t>(index));
     }
 
     flushMessages();
@@ -907,19 +1138,13 @@ void CarlaPipeCommon::writeProgramMessage(const uint32_t index) const noexcept
 
 void CarlaPipeCommon::writeMidiProgramMessage(const uint32_t bank, const uint32_t program) const noexcept
 {
-    char tmpBuf[0xff+1];
-    tmpBuf[0xff] = '\0';
-
     const CarlaMutexLocker cml(pData->writeLock);
 
-    _writeMsgBuffer("midiprogram\n", 8);
+    _writeMsgBuffer("midiprogram\n", 12);
 
     {
-        std::snprintf(tmpBuf, 0xff, "%i\n", bank);
-        _writeMsgBuffer(tmpBuf, std::strlen(tmpBuf));
-
-        std::snprintf(tmpBuf, 0xff, "%i\n", program);
-        _writeMsgBuffer(tmpBuf, std::strlen(tmpBuf));
+        _writeMsgInt(static_cast<int32_t>(bank));
+        _writeMsgInt(static_cast<int32_t>(program));
     }
 
     flushMessages();
@@ -931,25 +1156,15 @@ void CarlaPipeCommon::writeMidiNoteMessage(const bool onOff, const uint8_t chann
     CARLA_SAFE_ASSERT_RETURN(note < MAX_MIDI_NOTE,);
     CARLA_SAFE_ASSERT_RETURN(velocity < MAX_MIDI_VALUE,);
 
-    char tmpBuf[0xff+1];
-    tmpBuf[0xff] = '\0';
-
     const CarlaMutexLocker cml(pData->writeLock);
 
     _writeMsgBuffer("note\n", 5);
 
     {
-        std::snprintf(tmpBuf, 0xff, "%s\n", bool2str(onOff));
-        _writeMsgBuffer(tmpBuf, std::strlen(tmpBuf));
-
-        std::snprintf(tmpBuf, 0xff, "%i\n", channel);
-        _writeMsgBuffer(tmpBuf, std::strlen(tmpBuf));
-
-        std::snprintf(tmpBuf, 0xff, "%i\n", note);
-        _writeMsgBuffer(tmpBuf, std::strlen(tmpBuf));
-
-        std::snprintf(tmpBuf, 0xff, "%i\n", velocity);
-        _writeMsgBuffer(tmpBuf, std::strlen(tmpBuf));
+        _writeMsgBool(onOff);
+        _writeMsgInt(channel);
+        _writeMsgInt(note);
+        _writeMsgInt(velocity);
     }
 
     flushMessages();
@@ -959,9 +1174,6 @@ void CarlaPipeCommon::writeLv2AtomMessage(const uint32_t index, const LV2_Atom*
 {
     CARLA_SAFE_ASSERT_RETURN(atom != nullptr,);
 
-    char tmpBuf[0xff+1];
-    tmpBuf[0xff] = '\0';
-
     const uint32_t atomTotalSize(lv2_atom_total_size(atom));
     CarlaString base64atom(CarlaString::asBase64(atom, atomTotalSize));
 
@@ -970,11 +1182,8 @@ void CarlaPipeCommon::writeLv2AtomMessage(const uint32_t index, const LV2_Atom*
     _writeMsgBuffer("atom\n", 5);
 
     {
-        std::snprintf(tmpBuf, 0xff, "%i\n", index);
-        _writeMsgBuffer(tmpBuf, std::strlen(tmpBuf));
-
-        std::snprintf(tmpBuf, 0xff, "%i\n", atomTotalSize);
-        _writeMsgBuffer(tmpBuf, std::strlen(tmpBuf));
+        _writeMsgInt(static_cast<int32_t>(index));
+        _writeMsgInt(static_cast<int32_t>(atomTotalSize));
 
         writeAndFixMessage(base64atom.buffer());
     }
@@ -987,16 +1196,12 @@ void CarlaPipeCommon::writeLv2UridMessage(const uint32_t urid, const char* const
     CARLA_SAFE_ASSERT_RETURN(urid != 0,);
     CARLA_SAFE_ASSERT_RETURN(uri != nullptr && uri[0] != '\0',);
 
-    char tmpBuf[0xff+1];
-    tmpBuf[0xff] = '\0';
-
     const CarlaMutexLocker cml(pData->writeLock);
 
     _writeMsgBuffer("urid\n", 5);
 
     {
-        std::snprintf(tmpBuf, 0xff, "%i\n", urid);
-        _writeMsgBuffer(tmpBuf, std::strlen(tmpBuf));
+        _writeMsgInt(static_cast<int32_t>(urid));
 
         writeAndFixMessage(uri);
     }
@@ -1007,67 +1212,27 @@ void CarlaPipeCommon::writeLv2UridMessage(const uint32_t urid, const char* const
 // -------------------------------------------------------------------
 
 // internal
-const char* CarlaPipeCommon::_readline() const noexcept
+const char* CarlaPipeCommon::_readline(const bool allocReturn) const noexcept
 {
     CARLA_SAFE_ASSERT_RETURN(pData->pipeRecv != INVALID_PIPE_VALUE, nullptr);
 
-    char    c;
-    char*   ptr = pData->tmpBuf;
-    ssize_t ret;
+    const char* const line(pData->readline());
 
-    pData->tmpStr.clear();
-
-    for (int i=0; i<0xff; ++i)
-    {
-        try {
-#ifdef CARLA_OS_WIN
-            //ret = ::ReadFileBlock(pData->pipeRecv, &c, 1);
-            ret = ::ReadFileNonBlock(pData->pipeRecv, pData->cancelEvent, &c, 1);
-#else
-            ret = ::read(pData->pipeRecv, &c, 1);
-#endif
-        } CARLA_SAFE_EXCEPTION_BREAK("CarlaPipeCommon::readline() - read");
-
-        if (ret != 1 || c == '\n')
-            break;
-
-        if (c == '\r')
-            c = '\n';
-
-        *ptr++ = c;
-
-        if (i+1 == 0xff)
-        {
-            i = 0;
-            *ptr = '\0';
-            pData->tmpStr += pData->tmpBuf;
-            ptr = pData->tmpBuf;
-        }
-    }
-
-    if (ptr != pData->tmpBuf)
-    {
-        *ptr = '\0';
-        pData->tmpStr += pData->tmpBuf;
-    }
-    else if (pData->tmpStr.isEmpty() && ret != 1)
-    {
-        // some error
-        return nullptr;
-    }
+    if (line == nullptr || ! allocReturn)
+        return line;
 
     try {
-        return pData->tmpStr.dup();
+        return carla_strdup(line);
     } CARLA_SAFE_EXCEPTION_RETURN("CarlaPipeCommon::readline() - dup", nullptr);
 }
 
-const char* CarlaPipeCommon::_readlineblock(const uint32_t timeOutMilliseconds) const noexcept
+const char* CarlaPipeCommon::_readlineblock(const bool allocReturn, const uint32_t timeOutMilliseconds) const noexcept
 {
     const uint32_t timeoutEnd(getMillisecondCounter() + timeOutMilliseconds);
 
     for (;;)
     {
-        if (const char* const msg = _readline())
+        if (const char* const msg = _readline(allocReturn))
             return msg;
 
         if (getMillisecondCounter() >= timeoutEnd)
@@ -1080,6 +1245,48 @@ const char* CarlaPipeCommon::_readlineblock(const uint32_t timeOutMilliseconds)
     return nullptr;
 }
 
+bool CarlaPipeCommon::_writeMsgBool(const bool value) const noexcept
+{
+    if (pData->binaryFraming)
+        return _writeMsgInt(value ? 1 : 0);
+
+    return value ? _writeMsgBuffer("true\n", 5) : _writeMsgBuffer("false\n", 6);
+}
+
+bool CarlaPipeCommon::_writeMsgInt(const int32_t value) const noexcept
+{
+    char tmpBuf[0xff+1];
+
+    if (pData->binaryFraming)
+    {
+        tmpBuf[0] = kPipeFrame32;
+        std::memcpy(tmpBuf+1, &value, sizeof(int32_t));
+        return _writeMsgBuffer(tmpBuf, sizeof(int32_t)+1);
+    }
+
+    tmpBuf[0xff] = '\0';
+    std::snprintf(tmpBuf, 0xff, "%i\n", value);
+    return _writeMsgBuffer(tmpBuf, std::strlen(tmpBuf));
+}
+
+bool CarlaPipeCommon::_writeMsgFloat(const float value) const noexcept
+{
+    char tmpBuf[0xff+1];
+
+    if (pData->binaryFraming)
+    {
+        tmpBuf[0] = kPipeFrame32;
+        std::memcpy(tmpBuf+1, &value, sizeof(float));
+        return _writeMsgBuffer(tmpBuf, sizeof(float)+1);
+    }
+
+    const ScopedLocale csl;
+
+    tmpBuf[0xff] = '\0';
+    std::snprintf(tmpBuf, 0xff, "%f\n", value);
+    return _writeMsgBuffer(tmpBuf, std::strlen(tmpBuf));
+}
+
 bool CarlaPipeCommon::_writeMsgBuffer(const char* const msg, const std::size_t size) const noexcept
 {
     // TESTING remove later (replace with trylock scope)
@@ -1444,6 +1651,7 @@ void CarlaPipeServer::closePipeServer() noexcept
         try { ::close      (pData->pipeRecv); } CARLA_SAFE_EXCEPTION("close(pData->pipeRecv)");
 #endif
         pData->pipeRecv = INVALID_PIPE_VALUE;
+        pData->clearReadBuffer();
     }
 
     if (pData->pipeSend != INVALID_PIPE_VALUE)
@@ -1578,6 +1786,7 @@ void CarlaPipeClient::closePipeClient() noexcept
         try { ::close      (pData->pipeRecv); } CARLA_SAFE_EXCEPTION("close(pData->pipeRecv)");
 #endif
         pData->pipeRecv = INVALID_PIPE_VALUE;
+        pData->clearReadBuffer();
     }
 
     if (pData->pipeSend != INVALID_PIPE_VALUE)
@@ -1641,10 +1850,7 @@ ScopedEnvVar::~ScopedEnvVar() noexcept
 // -----------------------------------------------------------------------
 
 ScopedLocale::ScopedLocale() noexcept
-    : fLocale(carla_strdup_safe(::setlocale(LC_NUMERIC, nullptr)))
-{
-    ::setlocale(LC_NUMERIC, "C");
-}
+    : fLocale(switchToCNumericLocale()) {}
 
 ScopedLocale::~ScopedLocale() noexcept
 {
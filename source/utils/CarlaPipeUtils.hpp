@@ -71,6 +71,13 @@ public:
      */
     void idlePipe(const bool onlyOnce = false) noexcept;
 
+    /*!
+     * Write the numbers of prepared messages as binary frames instead of text lines.
+     * Frames are always understood by the readNextLineAs* functions, so this can be enabled
+     * when the other side of the pipe is a CarlaPipeCommon too, but not for plain line readers.
+     */
+    void setPipeBinaryFraming(const bool enabled) noexcept;
+
     // -------------------------------------------------------------------
     // write lock
 
@@ -97,6 +104,7 @@ public:
 
     // -------------------------------------------------------------------
     // read lines, must only be called in the context of msgReceived()
+    // numbers can be sent as text lines or binary frames, see setPipeBinaryFraming()
 
     /*!
      * Read the next line as a boolean.
@@ -140,9 +148,10 @@ public:
 
     /*!
      * Read the next line as a string.
-     * @note: @a value must be deleted if valid.
+     * @note: @a value must be deleted if valid and @a allocateString is true.
+     *        Otherwise it points into the read buffer and is only valid until the next read.
      */
-    bool readNextLineAsString(const char*& value) const noexcept;
+    bool readNextLineAsString(const char*& value, const bool allocateString = true) const noexcept;
 
     // -------------------------------------------------------------------
     // write messages, must be locked before calling
@@ -221,14 +230,23 @@ protected:
     // -------------------------------------------------------------------
 
     /*! @internal */
-    const char* _readline() const noexcept;
+    const char* _readline(const bool allocReturn) const noexcept;
 
     /*! @internal */
-    const char* _readlineblock(const uint32_t timeOutMilliseconds = 50) const noexcept;
+    const char* _readlineblock(const bool allocReturn, const uint32_t timeOutMilliseconds = 50) const noexcept;
 
     /*! @internal */
     bool _writeMsgBuffer(const char* const msg, const std::size_t size) const noexcept;
 
+    /*! @internal */
+    bool _writeMsgBool(const bool value) const noexcept;
+
+    /*! @internal */
+    bool _writeMsgInt(const int32_t value) const noexcept;
+
+    /*! @internal */
+    bool _writeMsgFloat(const float value) const noexcept;
+
     CARLA_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CarlaPipeCommon)
 };
 
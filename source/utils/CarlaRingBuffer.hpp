@@ -134,7 +134,8 @@ public:
         // nothing to commit?
         CARLA_SAFE_ASSERT_RETURN(fBuffer->head != fBuffer->wrtn, false);
 
-        // all ok
+        // all ok, make sure data is visible before the new head
+        __sync_synchronize();
         fBuffer->head = fBuffer->wrtn;
         return true;
     }
@@ -336,6 +337,9 @@ protected:
         const uint32_t tail(fBuffer->tail);
         const uint32_t wrap((head > tail) ? 0 : fBuffer->size);
 
+        // do not read data older than head
+        __sync_synchronize();
+
         if (size > wrap + head - tail)
         {
             if (! fErrorReading)
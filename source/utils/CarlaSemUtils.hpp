@@ -34,7 +34,7 @@ struct carla_sem_t { char dummy; };
 # include <syscall.h>
 # include <sys/time.h>
 # include <linux/futex.h>
-struct carla_sem_t { int count; };
+struct carla_sem_t { int count; int waiters; };
 #else
 # include <cerrno>
 # include <semaphore.h>
@@ -62,7 +62,8 @@ bool carla_sem_create2(carla_sem_t& sem) noexcept
 #elif defined(CARLA_OS_MAC)
     return false; // TODO
 #elif defined(CARLA_USE_FUTEXES)
-    sem.count = 0;
+    sem.count   = 0;
+    sem.waiters = 0;
     return true;
 #else
     return (::sem_init(&sem.sem, 1, 0) == 0);
@@ -129,12 +130,32 @@ void carla_sem_post(carla_sem_t& sem) noexcept
 #elif defined(CARLA_USE_FUTEXES)
     const bool unlocked = __sync_bool_compare_and_swap(&sem.count, 0, 1);
     CARLA_SAFE_ASSERT_RETURN(unlocked,);
-    ::syscall(__NR_futex, &sem.count, FUTEX_WAKE, 1, nullptr, nullptr, 0);
+
+    // no need to enter the kernel if nobody is sleeping (e.g. the other side is spinning)
+    if (__sync_fetch_and_add(&sem.waiters, 0) != 0)
+        ::syscall(__NR_futex, &sem.count, FUTEX_WAKE, 1, nullptr, nullptr, 0);
 #else
     ::sem_post(&sem.sem);
 #endif
 }
 
+/*
+ * Try to lock a semaphore without waiting.
+ */
+static inline
+bool carla_sem_trywait(carla_sem_t& sem) noexcept
+{
+#if defined(CARLA_OS_WIN)
+    return (::WaitForSingleObject(sem.handle, 0) == WAIT_OBJECT_0);
+#elif defined(CARLA_OS_MAC)
+    return false; // TODO
+#elif defined(CARLA_USE_FUTEXES)
+    return __sync_bool_compare_and_swap(&sem.count, 1, 0);
+#else
+    return (::sem_trywait(&sem.sem) == 0);
+#endif
+}
+
 /*
  * Wait for a semaphore (lock).
  */
@@ -148,22 +169,46 @@ bool carla_sem_timedwait(carla_sem_t& sem, const uint msecs) noexcept
 #elif defined(CARLA_OS_MAC)
     return false; // TODO
 #elif defined(CARLA_USE_FUTEXES)
-    timespec timeout;
-    timeout.tv_sec  = static_cast<time_t>(msecs / 1000);
-    timeout.tv_nsec = static_cast<time_t>(msecs % 1000);
+    // futex timeouts are relative, keep the deadline so retries don't wait longer than msecs
+    timespec deadline;
+    ::clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec  += static_cast<time_t>(msecs / 1000);
+    deadline.tv_nsec += static_cast<long>((msecs % 1000) * 1000000);
+
+    if (deadline.tv_nsec >= 1000000000)
+    {
+        deadline.tv_sec  += 1;
+        deadline.tv_nsec -= 1000000000;
+    }
 
     for (; ! __sync_bool_compare_and_swap(&sem.count, 1, 0);)
     {
-        if (::syscall(__NR_futex, &sem.count, FUTEX_WAIT, 0, &timeout, nullptr, 0) == 0)
+        timespec timeout;
+        ::clock_gettime(CLOCK_MONOTONIC, &timeout);
+        timeout.tv_sec  = deadline.tv_sec  - timeout.tv_sec;
+        timeout.tv_nsec = deadline.tv_nsec - timeout.tv_nsec;
+
+        if (timeout.tv_nsec < 0)
         {
-            __sync_fetch_and_sub(&sem.count, 1);
-            return true;
+            timeout.tv_sec  -= 1;
+            timeout.tv_nsec += 1000000000;
         }
 
-        //if (errno == EAGAIN)
-        //   continue;
+        // deadline passed, last chance
+        if (timeout.tv_sec < 0)
+            return __sync_bool_compare_and_swap(&sem.count, 1, 0);
 
-        return false;
+        __sync_fetch_and_add(&sem.waiters, 1);
+        const long ret = ::syscall(__NR_futex, &sem.count, FUTEX_WAIT, 0, &timeout, nullptr, 0);
+        const int  err = errno;
+        __sync_fetch_and_sub(&sem.waiters, 1);
+
+        // woken up or posted before we went to sleep, try again
+        if (ret == 0 || err == EAGAIN || err == EINTR)
+            continue;
+
+        // timed out, last chance
+        return __sync_bool_compare_and_swap(&sem.count, 1, 0);
     }
 
     return true;
@@ -174,7 +219,13 @@ bool carla_sem_timedwait(carla_sem_t& sem, const uint msecs) noexcept
     timespec timeout;
     ::clock_gettime(CLOCK_REALTIME, &timeout);
     timeout.tv_sec  += static_cast<time_t>(msecs / 1000);
-    timeout.tv_nsec += static_cast<time_t>(msecs % 1000);
+    timeout.tv_nsec += static_cast<time_t>((msecs % 1000) * 1000000);
+
+    if (timeout.tv_nsec >= 1000000000)
+    {
+        timeout.tv_sec  += 1;
+        timeout.tv_nsec -= 1000000000;
+    }
 
     try {
         return (::sem_timedwait(&sem.sem, &timeout) == 0);
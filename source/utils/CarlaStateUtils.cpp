@@ -24,11 +24,18 @@
 #include <string>
 
 using juce::MemoryOutputStream;
+using juce::OutputStream;
 using juce::String;
 using juce::XmlElement;
 
 CARLA_BACKEND_START_NAMESPACE
 
+// smaller binary chunks are kept inline as base64
+static const std::size_t kMinChunkSizeForChunkStream = 4096;
+
+// binary chunks are aligned to this in the chunk stream
+static const juce::int64 kChunkStreamAlignment = 16;
+
 // -----------------------------------------------------------------------
 // getNewLineSplittedString
 
@@ -200,6 +207,10 @@ CarlaStateSave::CarlaStateSave() noexcept
       currentMidiBank(-1),
       currentMidiProgram(-1),
       chunk(nullptr),
+      chunkData(nullptr),
+      chunkSize(0),
+      chunkOffset(0),
+      chunkChecksum(0),
       parameters(),
       customData() {}
 
@@ -241,6 +252,11 @@ void CarlaStateSave::clear() noexcept
         chunk = nullptr;
     }
 
+    chunkData     = nullptr;
+    chunkSize     = 0;
+    chunkOffset   = 0;
+    chunkChecksum = 0;
+
     uniqueId = 0;
     options  = 0x0;
 
@@ -480,6 +496,46 @@ bool CarlaStateSave::fillFromXmlElement(const XmlElement* const xmlElement)
                 {
                     chunk = carla_strdup(text.toRawUTF8());
                 }
+                else if (tag.equalsIgnoreCase("chunkref") || tag.equalsIgnoreCase("chunk-ref"))
+                {
+                    bool hasChecksum = false;
+
+                    for (XmlElement* xmlSubData = xmlData->getFirstChildElement(); xmlSubData != nullptr; xmlSubData = xmlSubData->getNextElement())
+                    {
+                        const String& cTag(xmlSubData->getTagName());
+                        const String  cText(xmlSubData->getAllSubText().trim());
+
+                        if (cTag.equalsIgnoreCase("offset"))
+                        {
+                            const juce::int64 offset(cText.getLargeIntValue());
+                            if (offset > 0)
+                                chunkOffset = static_cast<uint64_t>(offset);
+                        }
+                        else if (cTag.equalsIgnoreCase("size"))
+                        {
+                            const juce::int64 size(cText.getLargeIntValue());
+                            if (size > 0)
+                                chunkSize = static_cast<std::size_t>(size);
+                        }
+                        else if (cTag.equalsIgnoreCase("checksum"))
+                        {
+                            const juce::int64 checksum(cText.getLargeIntValue());
+                            if (checksum >= 0 && checksum <= 0xffffffffLL)
+                            {
+                                chunkChecksum = static_cast<uint32_t>(checksum);
+                                hasChecksum   = true;
+                            }
+                        }
+                    }
+
+                    if (chunkOffset == 0 || chunkSize == 0 || ! hasChecksum)
+                    {
+                        carla_stderr("Reading ChunkRef property failed, missing data");
+                        chunkOffset   = 0;
+                        chunkSize     = 0;
+                        chunkChecksum = 0;
+                    }
+                }
             }
         }
     }
@@ -490,7 +546,7 @@ bool CarlaStateSave::fillFromXmlElement(const XmlElement* const xmlElement)
 // -----------------------------------------------------------------------
 // fillXmlStringFromStateSave
 
-void CarlaStateSave::dumpToMemoryStream(MemoryOutputStream& content) const
+void CarlaStateSave::dumpToMemoryStream(MemoryOutputStream& content, OutputStream* const chunkStream) const
 {
     {
         MemoryOutputStream infoXml;
@@ -662,7 +718,42 @@ void CarlaStateSave::dumpToMemoryStream(MemoryOutputStream& content) const
         content << customDataXml;
     }
 
-    if (chunk != nullptr && chunk[0] != '\0')
+    if (chunkData != nullptr && chunkSize >= kMinChunkSizeForChunkStream && chunkStream != nullptr)
+    {
+        const juce::int64 offset((chunkStream->getPosition() + kChunkStreamAlignment - 1) & ~(kChunkStreamAlignment - 1));
+
+        for (juce::int64 i=chunkStream->getPosition(); i < offset; ++i)
+            chunkStream->writeByte(0);
+
+        if (chunkStream->write(chunkData, chunkSize))
+        {
+            MemoryOutputStream chunkXml;
+
+            chunkXml << "\n   <ChunkRef>\n";
+            chunkXml << "    <Offset>"   << offset                                                           << "</Offset>\n";
+            chunkXml << "    <Size>"     << static_cast<juce::int64>(chunkSize)                              << "</Size>\n";
+            chunkXml << "    <Checksum>" << static_cast<juce::int64>(getChunkChecksum(chunkData, chunkSize)) << "</Checksum>\n";
+            chunkXml << "   </ChunkRef>\n";
+
+            content << chunkXml;
+        }
+        else
+        {
+            carla_stderr2("Failed to write plugin chunk to chunk stream, chunk not saved");
+        }
+    }
+    else if (chunkData != nullptr && chunkSize > 0)
+    {
+        MemoryOutputStream chunkXml, chunkSplt;
+        getNewLineSplittedString(chunkSplt, CarlaString::asBase64(chunkData, chunkSize).buffer());
+
+        chunkXml << "\n   <Chunk>\n";
+        chunkXml << chunkSplt;
+        chunkXml << "\n   </Chunk>\n";
+
+        content << chunkXml;
+    }
+    else if (chunk != nullptr && chunk[0] != '\0')
     {
         MemoryOutputStream chunkXml, chunkSplt;
         getNewLineSplittedString(chunkSplt, chunk);
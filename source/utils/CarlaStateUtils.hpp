@@ -86,6 +86,13 @@ struct CarlaStateSave {
     int32_t     currentMidiProgram;
     const char* chunk;
 
+    // binary chunk, used instead of 'chunk' when set, not owned.
+    // points to plugin data when saving, or to the mapped project chunk file when loading (see <ChunkRef>).
+    const void* chunkData;
+    std::size_t chunkSize;
+    uint64_t    chunkOffset;
+    uint32_t    chunkChecksum;
+
     ParameterList parameters;
     CustomDataList customData;
 
@@ -94,11 +101,32 @@ struct CarlaStateSave {
     void clear() noexcept;
 
     bool fillFromXmlElement(const juce::XmlElement* const xmlElement);
-    void dumpToMemoryStream(juce::MemoryOutputStream& stream) const;
+
+    /*
+     * Write the state as XML.
+     * If 'chunkStream' is not null, large binary chunks are written there instead of inline as base64.
+     */
+    void dumpToMemoryStream(juce::MemoryOutputStream& stream, juce::OutputStream* const chunkStream = nullptr) const;
 
     CARLA_DECLARE_NON_COPY_STRUCT(CarlaStateSave)
 };
 
+// FNV-1a, stored in <ChunkRef> so chunks that do not match the project are not restored
+static inline
+uint32_t getChunkChecksum(const void* const data, const std::size_t size) noexcept
+{
+    const uint8_t* const bytes(static_cast<const uint8_t*>(data));
+    uint32_t checksum = 2166136261U;
+
+    for (std::size_t i=0; i < size; ++i)
+    {
+        checksum ^= bytes[i];
+        checksum *= 16777619U;
+    }
+
+    return checksum;
+}
+
 static inline
 juce::String xmlSafeString(const char* const cstring, const bool toXml)
 {
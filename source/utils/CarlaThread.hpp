@@ -104,9 +104,9 @@ public:
             CARLA_SAFE_ASSERT_RETURN(handle != 0, false);
 #endif
             pthread_detach(handle);
-            _copyFrom(handle);
 
-            // wait for thread to start
+            // wait for thread to start, it sets its own handle
+            // (copying it here would race with short-lived threads that already finished)
             fLock.lock();
 
             return true;
@@ -204,6 +204,39 @@ public:
 #endif
     }
 
+    /*
+     * Returns the realtime (SCHED_FIFO or SCHED_RR) priority of the caller thread, or 0 if it does not use one.
+     */
+    static int getCurrentThreadRealtimePriority() noexcept
+    {
+#ifndef CARLA_OS_WIN
+        int policy;
+        struct sched_param param;
+        carla_zeroStruct(param);
+
+        if (pthread_getschedparam(pthread_self(), &policy, &param) == 0 && (policy == SCHED_FIFO || policy == SCHED_RR))
+            return param.sched_priority;
+#endif
+        return 0;
+    }
+
+    /*
+     * Changes the scheduling of the caller thread to SCHED_FIFO with 'priority', or back to regular scheduling if 0.
+     */
+    static bool setCurrentThreadRealtimePriority(const int priority) noexcept
+    {
+#ifndef CARLA_OS_WIN
+        struct sched_param param;
+        carla_zeroStruct(param);
+        param.sched_priority = priority;
+
+        return (pthread_setschedparam(pthread_self(), priority > 0 ? SCHED_FIFO : SCHED_OTHER, &param) == 0);
+#else
+        // unused
+        return (priority == 0);
+#endif
+    }
+
     // -------------------------------------------------------------------
 
 private:
@@ -257,6 +290,7 @@ private:
     void _runEntryPoint() noexcept
     {
         // report ready
+        _copyFrom(pthread_self());
         fLock.unlock();
 
         setCurrentThreadName(fName);
@@ -119,7 +119,7 @@ public:
 
     // -------------------------------------------------------------------
 
-    // NOTE: must have been locked before
+    // NOTE: must have been locked before, unless this is the only reader
     bool get(const LV2_Atom*& atom, uint32_t& portIndex) noexcept
     {
         if (const LV2_Atom* const retAtom = readAtom(portIndex))
@@ -0,0 +1,282 @@
+/*
+ * LV2 URID Table
+ * Copyright (C) 2012-2015 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the doc/GPL.txt file.
+ */
+
+#ifndef LV2_URID_TABLE_HPP_INCLUDED
+#define LV2_URID_TABLE_HPP_INCLUDED
+
+#include "CarlaMathUtils.hpp"
+#include "CarlaMutex.hpp"
+
+#include "lv2/urid.h"
+
+// -----------------------------------------------------------------------
+// Lv2UridTable class
+
+/*
+ * URI <-> URID table, meant to be shared between many plugin instances.
+ *
+ * URIs are found through an open-addressing hash table and URIDs index a contiguous array of strings.
+ * Lookups never lock, so unmap() and map() of already known URIs are realtime safe.
+ * Only adding a new URI takes the mutex.
+ *
+ * Arrays are never shrunk or freed while the table is alive, when they grow the old
+ * ones are kept around so that concurrent readers always see valid memory.
+ */
+class Lv2UridTable
+{
+public:
+    /*
+     * Constructor.
+     * URIDs from 0 to 'reservedCount'-1 are reserved for the caller (0 is always invalid).
+     */
+    Lv2UridTable(const uint32_t reservedCount) noexcept
+        : fMutex(),
+          fStrings(nullptr),
+          fSlots(nullptr),
+          fCount(reservedCount > 0 ? reservedCount : 1)
+    {
+        const uint32_t capacity(carla_nextPowerOf2(fCount + kInitialSize));
+
+        fStrings = newStrings(capacity, nullptr);
+        fSlots   = newSlots(capacity*2, nullptr);
+    }
+
+    ~Lv2UridTable() noexcept
+    {
+        if (fStrings != nullptr)
+        {
+            for (uint32_t i=0; i < fCount; ++i)
+            {
+                if (fStrings->data[i] != nullptr)
+                    delete[] fStrings->data[i];
+            }
+        }
+
+        for (Strings* strings = fStrings; strings != nullptr;)
+        {
+            Strings* const prev(strings->prev);
+            delete[] strings->data;
+            delete strings;
+            strings = prev;
+        }
+
+        for (Slots* slots = fSlots; slots != nullptr;)
+        {
+            Slots* const prev(slots->prev);
+            delete[] slots->data;
+            delete slots;
+            slots = prev;
+        }
+    }
+
+    // -------------------------------------------------------------------
+
+    /*
+     * Get the URID for 'uri', adding it to the table if needed.
+     * Returns 0 on failure.
+     */
+    LV2_URID map(const char* const uri) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(uri != nullptr && uri[0] != '\0', 0);
+        CARLA_SAFE_ASSERT_RETURN(fStrings != nullptr && fSlots != nullptr, 0);
+
+        const uint32_t hash(getHash(uri));
+
+        if (const LV2_URID urid = find(uri, hash))
+            return urid;
+
+        const CarlaMutexLocker cml(fMutex);
+
+        // someone might have added it meanwhile
+        if (const LV2_URID urid = find(uri, hash))
+            return urid;
+
+        const uint32_t urid(fCount);
+
+        if (urid >= fStrings->capacity)
+        {
+            Strings* const strings(newStrings(fStrings->capacity*2, fStrings));
+            CARLA_SAFE_ASSERT_RETURN(strings != nullptr, 0);
+
+            __sync_synchronize();
+            fStrings = strings;
+        }
+
+        const char* const uriCopy(carla_strdup_safe(uri));
+        CARLA_SAFE_ASSERT_RETURN(uriCopy != nullptr, 0);
+
+        fStrings->data[urid] = uriCopy;
+
+        // keep hash table at most half full
+        if ((urid+1)*2 > fSlots->mask+1)
+        {
+            Slots* const slots(newSlots((fSlots->mask+1)*2, fSlots));
+            CARLA_SAFE_ASSERT_RETURN(slots != nullptr, 0);
+
+            for (uint32_t i=1; i < urid; ++i)
+            {
+                if (const char* const oldUri = fStrings->data[i])
+                    insert(slots, getHash(oldUri), i);
+            }
+
+            __sync_synchronize();
+            fSlots = slots;
+        }
+
+        __sync_synchronize();
+        insert(fSlots, hash, urid);
+
+        __sync_synchronize();
+        fCount = urid + 1;
+
+        return urid;
+    }
+
+    /*
+     * Get the URI for 'urid'.
+     * Returns null if invalid or reserved.
+     */
+    const char* unmap(const LV2_URID urid) const noexcept
+    {
+        if (urid >= fCount)
+            return nullptr;
+
+        __sync_synchronize();
+        return fStrings->data[urid];
+    }
+
+    /*
+     * Number of URIDs in use, including the reserved ones.
+     */
+    uint32_t getCount() const noexcept
+    {
+        return fCount;
+    }
+
+    // -------------------------------------------------------------------
+
+private:
+    static const uint32_t kInitialSize = 256;
+
+    struct Strings {
+        const char** data;
+        uint32_t capacity;
+        Strings* prev;
+    };
+
+    struct Slots {
+        volatile uint32_t* data; // 0 means empty
+        uint32_t mask;
+        Slots* prev;
+    };
+
+    CarlaMutex fMutex;
+    Strings* volatile fStrings;
+    Slots* volatile fSlots;
+    volatile uint32_t fCount;
+
+    // FNV-1a
+    static uint32_t getHash(const char* uri) noexcept
+    {
+        uint32_t hash = 2166136261U;
+
+        for (; *uri != '\0'; ++uri)
+        {
+            hash ^= static_cast<uint8_t>(*uri);
+            hash *= 16777619U;
+        }
+
+        return hash;
+    }
+
+    LV2_URID find(const char* const uri, const uint32_t hash) const noexcept
+    {
+        const Slots* const slots(fSlots);
+        __sync_synchronize();
+
+        for (uint32_t i = hash & slots->mask;; i = (i + 1) & slots->mask)
+        {
+            const uint32_t urid(slots->data[i]);
+
+            if (urid == 0)
+                return 0;
+
+            __sync_synchronize();
+
+            if (std::strcmp(fStrings->data[urid], uri) == 0)
+                return urid;
+        }
+    }
+
+    static void insert(Slots* const slots, const uint32_t hash, const uint32_t urid) noexcept
+    {
+        uint32_t i = hash & slots->mask;
+
+        for (; slots->data[i] != 0; i = (i + 1) & slots->mask) {}
+
+        slots->data[i] = urid;
+    }
+
+    static Strings* newStrings(const uint32_t capacity, const Strings* const old) noexcept
+    {
+        Strings* strings;
+
+        try {
+            strings = new Strings;
+            strings->data = new const char*[capacity];
+        } CARLA_SAFE_EXCEPTION_RETURN("Lv2UridTable::newStrings", nullptr);
+
+        strings->capacity = capacity;
+        strings->prev     = const_cast<Strings*>(old);
+
+        if (old != nullptr)
+        {
+            carla_copy<const char*>(strings->data, old->data, old->capacity);
+            carla_fill<const char*>(strings->data + old->capacity, nullptr, capacity - old->capacity);
+        }
+        else
+        {
+            carla_fill<const char*>(strings->data, nullptr, capacity);
+        }
+
+        return strings;
+    }
+
+    static Slots* newSlots(const uint32_t size, Slots* const old) noexcept
+    {
+        Slots* slots;
+
+        try {
+            slots = new Slots;
+            slots->data = new uint32_t[size];
+        } CARLA_SAFE_EXCEPTION_RETURN("Lv2UridTable::newSlots", nullptr);
+
+        for (uint32_t i=0; i < size; ++i)
+            slots->data[i] = 0;
+
+        slots->mask = size - 1;
+        slots->prev = old;
+
+        return slots;
+    }
+
+    CARLA_DECLARE_NON_COPY_CLASS(Lv2UridTable)
+};
+
+// -----------------------------------------------------------------------
+
+#endif // LV2_URID_TABLE_HPP_INCLUDED